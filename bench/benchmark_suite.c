@@ -0,0 +1,416 @@
+/* posix_spawn, clock_gettime and the directory functions are POSIX */
+#define _POSIX_C_SOURCE 200809L
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Times the compiler and the runtime end to end on a corpus of L# programs: every `.ls` file in the corpus directory,
+ * every directory in it with a `main.ls` that grabs the other chunks, and a generated program with a large amount of
+ * declarations. Each program is compiled and run once to warm the caches up, then `ITERATIONS` more times, and the
+ * median, 95th percentile and throughput of those runs are reported. The medians are compared with a baseline, and any
+ * that grew by more than the threshold fail the run.
+ */
+
+#define DEFAULT_ITERATIONS 21
+#define DEFAULT_THRESHOLD 0.10
+#define MAXIMUM_PROGRAMS 64
+#define MAXIMUM_PATH 512
+#define GENERATED_DECLARATION_COUNT 20000
+
+extern char** environ;
+
+static const char* compiler_path = "bin/lsc.exe";
+static const char* runtime_path = "bin/lsr.exe";
+static const char* corpus_directory = "bench/corpus";
+static const char* work_directory = "build/bench/corpus";
+
+/// @brief A program of the corpus, and where its bytecode is written.
+typedef struct
+{
+    char name[64];
+    char source_path[MAXIMUM_PATH];
+    char bytecode_path[MAXIMUM_PATH];
+    /// @brief The size of the source of every chunk of the program.
+    long source_size;
+} PROGRAM;
+
+/// @brief The timings of compiling or running a program.
+typedef struct
+{
+    char name[64];
+    const char* tool;
+    double median;
+    double p95;
+    /// @brief The size of the input, the source or the bytecode, processed per second at the median.
+    double throughput;
+    /// @brief The median of the baseline, or a negative number if the baseline doesn't have this benchmark.
+    double baseline_median;
+} RESULT;
+
+static double get_seconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static int compare_doubles(const void* left, const void* right)
+{
+    double difference = *(const double*)left - *(const double*)right;
+    return (difference > 0) - (difference < 0);
+}
+
+static int compare_programs(const void* left, const void* right)
+{
+    return strcmp(((const PROGRAM*)left)->name, ((const PROGRAM*)right)->name);
+}
+
+/// @brief Gets the sample at a percentile of the sorted samples, by the nearest rank.
+static double get_percentile(const double* sorted_samples, int count, double percentile)
+{
+    int rank = (int)(percentile * count);
+    rank += rank < percentile * count ? 1 : 0;
+    return sorted_samples[rank > 0 ? rank - 1 : 0];
+}
+
+static long get_file_size(const char* path)
+{
+    struct stat status;
+    return stat(path, &status) == 0 ? (long)status.st_size : 0;
+}
+
+/// @brief Runs a tool with its output thrown away, and waits for it.
+/// @return `true` if the tool exited successfully, `false` otherwise.
+static bool run_tool(char* const* arguments)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    pid_t process;
+    int status = 0;
+    bool is_spawned = posix_spawn(&process, arguments[0], &actions, NULL, arguments, environ) == 0;
+    posix_spawn_file_actions_destroy(&actions);
+    if (is_spawned == false || waitpid(process, &status, 0) != process)
+    {
+        return false;
+    }
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/// @brief Times a tool over the warm-up run and every iteration.
+/// @return `true` if every run succeeded, `false` otherwise.
+static bool time_tool(char* const* arguments, int iterations, double* samples)
+{
+    if (run_tool(arguments) == false)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < iterations; i++)
+    {
+        double start = get_seconds();
+        if (run_tool(arguments) == false)
+        {
+            return false;
+        }
+        samples[i] = get_seconds() - start;
+    }
+    qsort(samples, iterations, sizeof(double), compare_doubles);
+
+    return true;
+}
+
+/// @brief Adds up the size of every `.ls` file in a directory.
+static long get_chunks_size(const char* directory_path)
+{
+    DIR* directory = opendir(directory_path);
+    if (directory == NULL)
+    {
+        return 0;
+    }
+
+    long size = 0;
+    struct dirent* entry;
+    while ((entry = readdir(directory)) != NULL)
+    {
+        char path[MAXIMUM_PATH];
+        size_t length = strlen(entry->d_name);
+        if (length <= 3 || strcmp(entry->d_name + length - 3, ".ls") != 0)
+        {
+            continue;
+        }
+
+        /* a path too long to join can't be opened either, so it adds nothing */
+        int path_length = snprintf(path, sizeof(path), "%s/%s", directory_path, entry->d_name);
+        if (path_length > 0 && path_length < (int)sizeof(path))
+        {
+            size += get_file_size(path);
+        }
+    }
+    closedir(directory);
+
+    return size;
+}
+
+static void add_program(PROGRAM* programs, int* program_count, const char* name, const char* source_path, long source_size)
+{
+    if (*program_count >= MAXIMUM_PROGRAMS)
+    {
+        return;
+    }
+
+    PROGRAM* program = &programs[(*program_count)++];
+    snprintf(program->name, sizeof(program->name), "%s", name);
+    snprintf(program->source_path, sizeof(program->source_path), "%s", source_path);
+    snprintf(program->bytecode_path, sizeof(program->bytecode_path), "%s/%s.lbc", work_directory, name);
+    program->source_size = source_size;
+}
+
+/// @brief Finds the programs of the corpus directory: every `.ls` file, and every directory with a `main.ls`.
+static void find_corpus_programs(PROGRAM* programs, int* program_count)
+{
+    DIR* directory = opendir(corpus_directory);
+    if (directory == NULL)
+    {
+        fprintf(stderr, "Cannot open the \"%s\" corpus directory.\n", corpus_directory);
+        return;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(directory)) != NULL)
+    {
+        char path[MAXIMUM_PATH];
+        size_t length = strlen(entry->d_name);
+        if (length > 3 && strcmp(entry->d_name + length - 3, ".ls") == 0)
+        {
+            char name[64];
+            snprintf(name, sizeof(name), "%.*s", (int)(length - 3), entry->d_name);
+            snprintf(path, sizeof(path), "%s/%s", corpus_directory, entry->d_name);
+            add_program(programs, program_count, name, path, get_file_size(path));
+            continue;
+        }
+
+        struct stat status;
+        snprintf(path, sizeof(path), "%s/%s/main.ls", corpus_directory, entry->d_name);
+        if (entry->d_name[0] != '.' && stat(path, &status) == 0)
+        {
+            char chunks_path[MAXIMUM_PATH];
+            snprintf(chunks_path, sizeof(chunks_path), "%s/%s", corpus_directory, entry->d_name);
+            add_program(programs, program_count, entry->d_name, path, get_chunks_size(chunks_path));
+        }
+    }
+    closedir(directory);
+}
+
+/// @brief Writes a program of many declarations, each built from the ones before it, into the work directory.
+static bool generate_declarations(char* path, size_t path_size)
+{
+    snprintf(path, path_size, "%s/declarations.ls", work_directory);
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    /* every third declaration is a text, every other one builds on the number before it */
+    fprintf(file, "number d0 = 1\n");
+    for (int i = 1; i < GENERATED_DECLARATION_COUNT; i++)
+    {
+        if (i % 3 == 0)
+        {
+            fprintf(file, "text s%d = 'declaration %d'\n", i, i);
+        }
+        else
+        {
+            fprintf(file, "number d%d = d%d + %d\n", i, i % 3 == 1 && i > 1 ? i - 2 : i - 1, i % 7);
+        }
+    }
+    fprintf(file, "info('declarations done')");
+
+    return fclose(file) == 0;
+}
+
+/// @brief Reads the median of a benchmark from a baseline file written by `write_baseline`.
+/// @return The median in seconds, or a negative number if the baseline doesn't have it.
+static double find_baseline_median(const char* baseline, const char* name, const char* tool)
+{
+    char pattern[128];
+    snprintf(pattern, sizeof(pattern), "\"name\": \"%s\", \"tool\": \"%s\"", name, tool);
+    const char* entry = baseline != NULL ? strstr(baseline, pattern) : NULL;
+    const char* median = entry != NULL ? strstr(entry, "\"median_ms\":") : NULL;
+    const char* entry_end = entry != NULL ? strchr(entry, '}') : NULL;
+    if (median == NULL || (entry_end != NULL && median > entry_end))
+    {
+        return -1;
+    }
+
+    return strtod(median + strlen("\"median_ms\":"), NULL) / 1e3;
+}
+
+static char* read_baseline(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return NULL;
+    }
+
+    long size = get_file_size(path);
+    char* contents = (char*)malloc((size_t)size + 1);
+    size_t length = contents != NULL ? fread(contents, 1, (size_t)size, file) : 0;
+    fclose(file);
+    if (contents != NULL)
+    {
+        contents[length] = '\0';
+    }
+
+    return contents;
+}
+
+static bool write_baseline(const char* path, const RESULT* results, int result_count, int iterations)
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Cannot open \"%s\" to write the baseline.\n", path);
+        return false;
+    }
+
+    fprintf(file, "{\n  \"iterations\": %d,\n  \"benchmarks\": [\n", iterations);
+    for (int i = 0; i < result_count; i++)
+    {
+        fprintf(file, "    { \"name\": \"%s\", \"tool\": \"%s\", \"median_ms\": %.4f, \"p95_ms\": %.4f, \"throughput_mb_s\": %.3f }%s\n",
+            results[i].name, results[i].tool, results[i].median * 1e3, results[i].p95 * 1e3, results[i].throughput / 1e6, i + 1 < result_count ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+
+    return fclose(file) == 0;
+}
+
+/// @brief Times compiling or running a program, and compares its median with the baseline.
+static bool measure(RESULT* result, const char* name, const char* tool, char* const* arguments, long input_size, int iterations, const char* baseline)
+{
+    double* samples = (double*)malloc(iterations * sizeof(double));
+    bool is_timed = samples != NULL && time_tool(arguments, iterations, samples);
+    if (is_timed == true)
+    {
+        snprintf(result->name, sizeof(result->name), "%s", name);
+        result->tool = tool;
+        result->median = get_percentile(samples, iterations, 0.5);
+        result->p95 = get_percentile(samples, iterations, 0.95);
+        result->throughput = input_size / result->median;
+        result->baseline_median = find_baseline_median(baseline, name, tool);
+    }
+    else
+    {
+        fprintf(stderr, "Failed to %s \"%s\" with \"%s\".\n", strcmp(tool, "lsc") == 0 ? "compile" : "run", name, arguments[0]);
+    }
+    free(samples);
+
+    return is_timed;
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = DEFAULT_ITERATIONS;
+    double threshold = DEFAULT_THRESHOLD;
+    const char* baseline_path = "bench/baseline.json";
+    const char* new_baseline_path = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--iterations=", 13) == 0) iterations = atoi(argv[i] + 13);
+        else if (strncmp(argv[i], "--threshold=", 12) == 0) threshold = strtod(argv[i] + 12, NULL);
+        else if (strncmp(argv[i], "--baseline=", 11) == 0) baseline_path = argv[i] + 11;
+        else if (strncmp(argv[i], "--write-baseline=", 17) == 0) new_baseline_path = argv[i] + 17;
+        else if (strncmp(argv[i], "--lsc=", 6) == 0) compiler_path = argv[i] + 6;
+        else if (strncmp(argv[i], "--lsr=", 6) == 0) runtime_path = argv[i] + 6;
+        else
+        {
+            fprintf(stderr, "Usage: %s [--iterations=N] [--threshold=F] [--baseline=path] [--write-baseline=path] [--lsc=path] [--lsr=path]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (iterations < 1)
+    {
+        iterations = DEFAULT_ITERATIONS;
+    }
+
+    if (mkdir("build", 0755) != 0 && errno != EEXIST)
+    {
+        return 1;
+    }
+    mkdir("build/bench", 0755);
+    mkdir(work_directory, 0755);
+
+    PROGRAM programs[MAXIMUM_PROGRAMS];
+    int program_count = 0;
+    find_corpus_programs(programs, &program_count);
+    qsort(programs, program_count, sizeof(PROGRAM), compare_programs);
+    char generated_path[MAXIMUM_PATH];
+    if (generate_declarations(generated_path, sizeof(generated_path)) == true)
+    {
+        add_program(programs, &program_count, "declarations", generated_path, get_file_size(generated_path));
+    }
+
+    /* without a baseline, or while writing a new one, nothing is compared */
+    char* baseline = new_baseline_path == NULL ? read_baseline(baseline_path) : NULL;
+    RESULT results[MAXIMUM_PROGRAMS * 2];
+    int result_count = 0;
+    bool is_measured = true;
+    for (int i = 0; i < program_count && is_measured == true; i++)
+    {
+        PROGRAM* program = &programs[i];
+        char output_option[] = "-o";
+        char* compile_arguments[] = { (char*)compiler_path, program->source_path, output_option, program->bytecode_path, NULL };
+        char* run_arguments[] = { (char*)runtime_path, program->bytecode_path, NULL };
+
+        is_measured = measure(&results[result_count++], program->name, "lsc", compile_arguments, program->source_size, iterations, baseline)
+            && measure(&results[result_count++], program->name, "lsr", run_arguments, get_file_size(program->bytecode_path), iterations, baseline);
+    }
+    free(baseline);
+    if (is_measured == false)
+    {
+        return 1;
+    }
+
+    int regression_count = 0;
+    printf("%-14s %-4s %12s %12s %14s %10s\n", "program", "tool", "median (ms)", "p95 (ms)", "throughput", "baseline");
+    for (int i = 0; i < result_count; i++)
+    {
+        const RESULT* result = &results[i];
+        char comparison[32] = "-";
+        if (result->baseline_median > 0)
+        {
+            double change = result->median / result->baseline_median - 1;
+            bool is_regression = change > threshold;
+            regression_count += is_regression == true ? 1 : 0;
+            snprintf(comparison, sizeof(comparison), "%+.1f%%%s", change * 100, is_regression == true ? " !" : "");
+        }
+        printf("%-14s %-4s %12.3f %12.3f %9.2f MB/s %10s\n", result->name, result->tool, result->median * 1e3, result->p95 * 1e3, result->throughput / 1e6, comparison);
+    }
+
+    if (new_baseline_path != NULL)
+    {
+        return write_baseline(new_baseline_path, results, result_count, iterations) == true ? 0 : 1;
+    }
+    if (regression_count > 0)
+    {
+        printf("%d benchmark(s) regressed by more than %.0f%% against \"%s\".\n", regression_count, threshold * 100, baseline_path);
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
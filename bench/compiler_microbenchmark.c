@@ -0,0 +1,311 @@
+/* clock_gettime is POSIX */
+#define _POSIX_C_SOURCE 200809L
+#include "../src/compiler/lsc.h"
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * Drives each phase of the compiler on its own, on generated sources from 1 KB up to `--max-size` bytes in steps of ten:
+ * the lexer per token, the parser and the bytecode generator per syntax tree node, and the symbol table per insert and
+ * lookup. Each phase is repeated until it has run for `MINIMUM_SECONDS` and the median repetition is reported, with the
+ * allocations `safe_malloc` made per unit and the peak resident set size of the process so far. A phase that took
+ * longer than `PHASE_BUDGET_SECONDS` once is skipped for the larger sources, so a phase that doesn't scale doesn't hold
+ * up the rest.
+ */
+
+#define MINIMUM_SIZE 1000
+#define DEFAULT_MAXIMUM_SIZE 10000000
+#define MINIMUM_SECONDS 0.1
+#define MAXIMUM_REPETITIONS 101
+#define PHASE_BUDGET_SECONDS 3.0
+
+/// @brief The phases that are measured, in the order they run.
+typedef enum
+{
+    PHASE_LEXER,
+    PHASE_PARSER,
+    PHASE_CODEGEN,
+    PHASE_SYMBOL_INSERT,
+    PHASE_SYMBOL_LOOKUP,
+    PHASE_COUNT
+} PHASE;
+
+static const char* phase_names[PHASE_COUNT] = { "lexer", "parser", "codegen", "symbol insert", "symbol lookup" };
+static const char* phase_units[PHASE_COUNT] = { "token", "node", "node", "insert", "lookup" };
+
+/// @brief The inputs of every phase for one source size, built once and reused by every repetition.
+typedef struct
+{
+    char* source;
+    token** tokens;
+    size_t token_count;
+    abstract_syntax_node* ast;
+    size_t node_count;
+    char** names;
+    size_t name_count;
+    symbol_table* symbols;
+} INPUTS;
+
+static double get_seconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static int compare_doubles(const void* left, const void* right)
+{
+    double difference = *(const double*)left - *(const double*)right;
+    return (difference > 0) - (difference < 0);
+}
+
+/// @brief Generates L# source of about `size` bytes, shaped like generated programs: declarations that build on each
+/// other, reassignments, text constants and logging calls.
+static char* generate_source(size_t size)
+{
+    char* source = (char*)safe_malloc(size + 128);
+    size_t length = (size_t)snprintf(source, size + 128, "number n0 = 1\n");
+    for (int i = 1; length < size; i++)
+    {
+        char line[128];
+        int line_length;
+        switch (i % 4)
+        {
+            case 0: line_length = snprintf(line, sizeof(line), "number n%d = n%d + %d * %d\n", i, i - 4, i % 9, i % 5 + 1); break;
+            case 1: line_length = snprintf(line, sizeof(line), "text t%d = 'message %d of the generated source'\n", i, i); break;
+            case 2: line_length = snprintf(line, sizeof(line), "info(t%d)\n", i - 1); break;
+            default: line_length = snprintf(line, sizeof(line), "n%d = n%d - (%d / 2)\n", i - 3, i - 3, i % 11 + 1); break;
+        }
+        if (length + (size_t)line_length > size)
+        {
+            break;
+        }
+        memcpy(source + length, line, (size_t)line_length);
+        length += (size_t)line_length;
+    }
+    source[length] = '\0';
+
+    return source;
+}
+
+static size_t count_ast_nodes(const abstract_syntax_node* node)
+{
+    if (node == NULL)
+    {
+        return 0;
+    }
+
+    size_t count = 1;
+    switch (node->type)
+    {
+        case AST_NODE_PROGRAM:
+            for (int i = 0; i < node->data.program_node.statement_count; i++)
+            {
+                count += count_ast_nodes(node->data.program_node.statements[i]);
+            }
+            break;
+        case AST_NODE_STATEMENT: count += count_ast_nodes(node->data.statement_node.statement); break;
+        case AST_NODE_DECLARATION: count += count_ast_nodes(node->data.declaration_node.expression); break;
+        case AST_NODE_ASSIGNMENT: count += count_ast_nodes(node->data.assignment.expression); break;
+        case AST_NODE_RETURN_STATEMENT: count += count_ast_nodes(node->data.return_statement_node.expression); break;
+        case AST_NODE_BINARY_OP:
+            count += count_ast_nodes(node->data.binary_operation.left) + count_ast_nodes(node->data.binary_operation.right);
+            break;
+        case AST_NODE_FUNCTION_CALL:
+            for (int i = 0; i < node->data.function_call.argument_count; i++)
+            {
+                count += count_ast_nodes(node->data.function_call.arguments[i]);
+            }
+            break;
+        default: break;
+    }
+
+    return count;
+}
+
+/// @brief Runs one repetition of a phase on the inputs, leaving the inputs as they were.
+static void run_phase(PHASE phase, INPUTS* inputs)
+{
+    switch (phase)
+    {
+        case PHASE_LEXER:
+        {
+            size_t token_count;
+            free_tokens(get_tokens(inputs->source, &token_count));
+            break;
+        }
+        case PHASE_PARSER:
+        {
+            free_ast(get_abstract_syntax_tree(inputs->tokens, inputs->token_count));
+            break;
+        }
+        case PHASE_CODEGEN:
+        {
+            bytecode_generator* generator = create_bytecode_generator();
+            generate_bytecode(generator, inputs->ast);
+            free_bytecode_generator(generator);
+            break;
+        }
+        case PHASE_SYMBOL_INSERT:
+        {
+            /* as big a table as the bytecode generator uses */
+            symbol_table* symbols = create_symbol_table(100);
+            for (size_t i = 0; i < inputs->name_count; i++)
+            {
+                insert_symbol(symbols, inputs->names[i], SYMBOL_VARIABLE, (int)i);
+            }
+            free_symbol_table(symbols);
+            break;
+        }
+        case PHASE_SYMBOL_LOOKUP:
+        {
+            for (size_t i = 0; i < inputs->name_count; i++)
+            {
+                lookup_symbol(inputs->symbols, inputs->names[i]);
+            }
+            break;
+        }
+        default: break;
+    }
+}
+
+static size_t get_unit_count(PHASE phase, const INPUTS* inputs)
+{
+    switch (phase)
+    {
+        case PHASE_LEXER: return inputs->token_count;
+        case PHASE_PARSER:
+        case PHASE_CODEGEN: return inputs->node_count;
+        default: return inputs->name_count;
+    }
+}
+
+/// @brief Measures a phase, and prints a row for it.
+/// @return The time the slowest repetition took, in seconds.
+static double measure_phase(PHASE phase, size_t size, INPUTS* inputs)
+{
+    double samples[MAXIMUM_REPETITIONS];
+    int repetitions = 0;
+    double total = 0;
+    uint64_t allocations = 0;
+    while (repetitions < MAXIMUM_REPETITIONS && (total < MINIMUM_SECONDS || repetitions < 1))
+    {
+        allocation_statistics before, after;
+        get_allocation_statistics(&before);
+        double start = get_seconds();
+        run_phase(phase, inputs);
+        samples[repetitions] = get_seconds() - start;
+        get_allocation_statistics(&after);
+        allocations = after.count - before.count;
+        total += samples[repetitions++];
+    }
+    qsort(samples, repetitions, sizeof(double), compare_doubles);
+
+    size_t units = get_unit_count(phase, inputs);
+    double per_unit = units > 0 ? 1.0 / units : 0;
+    printf("%10zu  %-14s %10zu %-7s %10.1f %12.2f %10.1f MB %6d\n", size, phase_names[phase], units, phase_units[phase],
+        samples[repetitions / 2] * 1e9 * per_unit, allocations * per_unit, (double)get_peak_resident_size() / 1e6, repetitions);
+    fflush(stdout);
+
+    return samples[repetitions - 1];
+}
+
+/// @brief Builds the inputs of every phase that is still measured for a source of `size` bytes.
+static void create_inputs(INPUTS* inputs, size_t size, const bool* is_skipped)
+{
+    memset(inputs, 0, sizeof(INPUTS));
+    inputs->source = generate_source(size);
+    if (is_skipped[PHASE_PARSER] == false || is_skipped[PHASE_CODEGEN] == false)
+    {
+        inputs->tokens = get_tokens(inputs->source, &inputs->token_count);
+    }
+    else
+    {
+        /* the lexer is still measured, it counts its own tokens */
+        token** tokens = get_tokens(inputs->source, &inputs->token_count);
+        free_tokens(tokens);
+    }
+    if (is_skipped[PHASE_CODEGEN] == false && inputs->tokens != NULL)
+    {
+        inputs->ast = get_abstract_syntax_tree(inputs->tokens, inputs->token_count);
+        inputs->node_count = count_ast_nodes(inputs->ast);
+    }
+
+    /* one name for every declaration the source would have */
+    inputs->name_count = size / 32;
+    inputs->names = (char**)safe_malloc((inputs->name_count > 0 ? inputs->name_count : 1) * sizeof(char*));
+    inputs->symbols = create_symbol_table(100);
+    for (size_t i = 0; i < inputs->name_count; i++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "variable_%zu", i);
+        inputs->names[i] = duplicate_string(name);
+        insert_symbol(inputs->symbols, name, SYMBOL_VARIABLE, (int)i);
+    }
+}
+
+static void free_inputs(INPUTS* inputs)
+{
+    safe_free(inputs->source);
+    if (inputs->tokens != NULL)
+    {
+        free_tokens(inputs->tokens);
+    }
+    if (inputs->ast != NULL)
+    {
+        free_ast(inputs->ast);
+    }
+    for (size_t i = 0; i < inputs->name_count; i++)
+    {
+        safe_free(inputs->names[i]);
+    }
+    safe_free(inputs->names);
+    free_symbol_table(inputs->symbols);
+}
+
+int main(int argc, char** argv)
+{
+    size_t maximum_size = DEFAULT_MAXIMUM_SIZE;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--max-size=", 11) == 0)
+        {
+            maximum_size = (size_t)strtoull(argv[i] + 11, NULL, 10);
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [--max-size=BYTES]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    count_allocations();
+    bool is_skipped[PHASE_COUNT] = { false };
+    printf("%10s  %-14s %18s %10s %12s %13s %6s\n", "size (B)", "phase", "units", "ns/unit", "allocs/unit", "peak RSS", "runs");
+    for (size_t size = MINIMUM_SIZE; size <= maximum_size; size *= 10)
+    {
+        INPUTS inputs;
+        create_inputs(&inputs, size, is_skipped);
+        for (int phase = 0; phase < PHASE_COUNT; phase++)
+        {
+            if (is_skipped[phase] == true)
+            {
+                printf("%10zu  %-14s %18s\n", size, phase_names[phase], "skipped");
+                continue;
+            }
+
+            /* a phase that needs inputs an earlier phase didn't get to build is skipped too */
+            if ((phase == PHASE_PARSER && inputs.tokens == NULL) || (phase == PHASE_CODEGEN && inputs.ast == NULL))
+            {
+                is_skipped[phase] = true;
+                printf("%10zu  %-14s %18s\n", size, phase_names[phase], "skipped");
+                continue;
+            }
+
+            is_skipped[phase] = measure_phase((PHASE)phase, size, &inputs) > PHASE_BUDGET_SECONDS;
+        }
+        free_inputs(&inputs);
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "../src/compiler/lsc.h"
+#include "../src/runtime/virtual_machine/virtual_machine.h"
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * Compares raw and compressed .lbc files of a generated program with a large string table: the size of each file,
+ * how long the runtime takes to load it, and how fast its sections decompress.
+ */
+
+#define STATEMENT_COUNT 20000
+#define ITERATIONS 51
+
+static const char* raw_path = "bin/compressbench-raw.lbc";
+static const char* compressed_path = "bin/compressbench-compressed.lbc";
+
+static double get_seconds()
+{
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static int compare_doubles(const void* left, const void* right)
+{
+    double difference = *(const double*)left - *(const double*)right;
+    return (difference > 0) - (difference < 0);
+}
+
+static double get_median(double* samples, int count)
+{
+    qsort(samples, count, sizeof(double), compare_doubles);
+    return samples[count / 2];
+}
+
+/// @brief Generates L# source that logs many similar, but distinct, messages, like generated programs do.
+static char* generate_source()
+{
+    static const char* subjects[] = { "request", "session", "payment", "shipment", "account" };
+    static const char* outcomes[] = { "was accepted by the gateway", "is waiting for a retry", "failed validation", "completed successfully" };
+
+    size_t capacity = (size_t)STATEMENT_COUNT * 96;
+    char* source = (char*)safe_malloc(capacity);
+    size_t length = 0;
+    for (int i = 0; i < STATEMENT_COUNT; i++)
+    {
+        length += (size_t)snprintf(source + length, capacity - length, "info('%s %d of worker %d %s')\n",
+            subjects[i % 5], i, i % 17, outcomes[i % 4]);
+    }
+
+    return source;
+}
+
+static size_t compile_to_file(const char* source, bool compress_sections, const char* path)
+{
+    compiler_options options;
+    create_compiler_options(&options);
+    options.compress_sections = compress_sections;
+
+    size_t size;
+    unsigned char* bytecode = lsc_compile_to_buffer(source, &options, NULL, &size);
+    if (bytecode == NULL || lsc_write_bytecode_to_path(bytecode, size, path) == false)
+    {
+        fprintf(stderr, "Failed to write \"%s\".\n", path);
+        exit(1);
+    }
+    safe_free(bytecode);
+
+    return size;
+}
+
+/// @brief Measures the median time it takes to load a bytecode file into a virtual machine.
+static double measure_load(const char* path)
+{
+    double samples[ITERATIONS];
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        virtual_machine vm;
+        double start = get_seconds();
+        create_virtual_machine(&vm);
+        if (load_bytecode_from_file(&vm, path) == false)
+        {
+            exit(1);
+        }
+        free_virtual_machine(&vm);
+        samples[i] = get_seconds() - start;
+    }
+
+    return get_median(samples, ITERATIONS);
+}
+
+/// @brief Measures how fast the compressed sections of a bytecode file decompress, in bytes of output per second.
+static double measure_decompression(const char* path)
+{
+    mapped_file file;
+    bytecode_container container;
+    if (map_file(path, &file) == false || read_bytecode_container(file.data, file.size, &container) != BYTECODE_FILE_VALID)
+    {
+        exit(1);
+    }
+
+    double samples[ITERATIONS];
+    size_t decompressed_size = 0;
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        decompressed_size = 0;
+        double start = get_seconds();
+        for (int j = 0; j < container.section_count; j++)
+        {
+            const bytecode_section* section = &container.sections[j];
+            if ((section->flags & BYTECODE_SECTION_COMPRESSED) == 0)
+            {
+                continue;
+            }
+
+            unsigned char* allocation;
+            size_t size;
+            if (load_bytecode_section(&container, section, SIZE_MAX, &allocation, &size) == NULL)
+            {
+                exit(1);
+            }
+            safe_free(allocation);
+            decompressed_size += size;
+        }
+        samples[i] = get_seconds() - start;
+    }
+    unmap_file(&file);
+
+    return decompressed_size / get_median(samples, ITERATIONS);
+}
+
+int main()
+{
+    char* source = generate_source();
+    size_t raw_size = compile_to_file(source, false, raw_path);
+    size_t compressed_size = compile_to_file(source, true, compressed_path);
+    safe_free(source);
+
+    double raw_load = measure_load(raw_path);
+    double compressed_load = measure_load(compressed_path);
+    double throughput = measure_decompression(compressed_path);
+
+    printf("%-12s %12s %14s\n", "file", "size (bytes)", "load (median)");
+    printf("%-12s %12zu %11.3f ms\n", "raw", raw_size, raw_load * 1e3);
+    printf("%-12s %12zu %11.3f ms\n", "compressed", compressed_size, compressed_load * 1e3);
+    printf("compression ratio: %.2fx, decompression: %.0f MB/s\n", (double)raw_size / compressed_size, throughput / 1e6);
+
+    return 0;
+}
\ No newline at end of file
@@ -1,9 +1,28 @@
 #include "bytecode_generator.h"
-
-static int increment_object_count(bytecode_generator* generator)
+/* included here rather than in the header, the optimizer passes depend on the generator */
+#include "../optimizer/dead_code_eliminator.h"
+#include "../optimizer/peephole_optimizer.h"
+#include "../optimizer/variable_allocator.h"
+#include "../ir/build_ir.h"
+#include "../ir/lower_ir.h"
+#include "../ir/optimize_ir.h"
+
+/// @brief Emits a builtin logging instruction, or only pops its argument if its level is below the minimum log level.
+static void emit_builtin_log(bytecode_generator* generator, instruction log_instruction, int argument_count)
 {
-    generator->object_count++;
-    return generator->object_count;
+    log_level level;
+    if (get_builtin_log_level(log_instruction.op_code, &level) == false || level >= generator->minimum_log_level)
+    {
+        emit_instruction(generator, log_instruction);
+        return;
+    }
+
+    /* the argument was already evaluated, dead code elimination drops it if that had no side effects */
+    if (argument_count > 0)
+    {
+        emit_instruction(generator, (instruction){OP_POP, {0}, OP_TYPE_NULL});
+    }
+    generator->elided_log_call_count++;
 }
 
 bytecode_generator* create_bytecode_generator()
@@ -11,8 +30,15 @@ bytecode_generator* create_bytecode_generator()
     bytecode_generator* generator = (bytecode_generator*)safe_malloc(sizeof(bytecode_generator));
     generator->instruction_capacity = 16;
     generator->instructions = (instruction*)safe_malloc(generator->instruction_capacity * sizeof(instruction));
+    generator->locations = (source_location*)safe_malloc(generator->instruction_capacity * sizeof(source_location));
     generator->instruction_count = 0;
+    generator->location = (source_location){ 0, 0, 0 };
     generator->symbols = create_symbol_table(100);
+    generator->variable_count = 0;
+    generator->function_count = 0;
+    generator->minimum_log_level = LOG_LEVEL_DEBUG;
+    generator->elided_log_call_count = 0;
+    generator->error_count = 0;
     generator->object_capacity = 100;
     generator->object_count = 0;
     generator->objects = (char**)safe_malloc(generator->object_capacity * sizeof(char*));
@@ -25,8 +51,10 @@ void emit_instruction(bytecode_generator* generator, instruction new_instruction
     {
         generator->instruction_capacity *= 2;
         generator->instructions = (instruction*)realloc(generator->instructions, generator->instruction_capacity * sizeof(instruction));
+        generator->locations = (source_location*)realloc(generator->locations, generator->instruction_capacity * sizeof(source_location));
     }
 
+    generator->locations[generator->instruction_count] = generator->location;
     generator->instructions[generator->instruction_count++] = new_instruction;
 }
 
@@ -52,11 +80,68 @@ int add_object(bytecode_generator* generator, char* object)
         return -1;
     }
 
-    /* assign the duplicate to the object array at the previous index */
+    /* assign the duplicate to the next free index */
     generator->objects[generator->object_count] = copy_of_object;
 
     /* return the index of the object */
-    return generator->object_count;
+    return generator->object_count++;
+}
+
+int remove_instructions(bytecode_generator* generator, const bool* removed)
+{
+    int instruction_count = generator->instruction_count;
+    instruction* instructions = generator->instructions;
+
+    /* map every old index (and one past the end) to its index after removal */
+    int* new_indices = (int*)safe_malloc((instruction_count + 1) * sizeof(int));
+    int new_count = 0;
+    for (int i = 0; i < instruction_count; i++)
+    {
+        new_indices[i] = new_count;
+        if (removed[i] == false)
+        {
+            new_count++;
+        }
+    }
+    new_indices[instruction_count] = new_count;
+
+    /* nothing to do if no instruction was flagged */
+    if (new_count == instruction_count)
+    {
+        safe_free(new_indices);
+        return 0;
+    }
+
+    /* fix up the jumps while the old indices are still valid, a jump to a removed instruction lands on the next kept one */
+    for (int i = 0; i < instruction_count; i++)
+    {
+        if (removed[i] == true || is_jump_op_code(instructions[i].op_code) == false)
+        {
+            continue;
+        }
+
+        int target = get_jump_target(instructions, i);
+        if (target < 0 || target > instruction_count)
+        {
+            log_error("Compiler error: Jump at instruction %d targets %d, which is outside of the program.", i, target);
+            continue;
+        }
+        instructions[i].operand.jump.jump_offset = new_indices[target] - (new_indices[i] + 1);
+    }
+
+    /* compact the kept instructions to the front */
+    for (int i = 0; i < instruction_count; i++)
+    {
+        if (removed[i] == false)
+        {
+            instructions[new_indices[i]] = instructions[i];
+            generator->locations[new_indices[i]] = generator->locations[i];
+        }
+    }
+    generator->instruction_count = new_count;
+
+    safe_free(new_indices);
+    return instruction_count - new_count;
 }
 
 void generate_bytecode(bytecode_generator* generator, abstract_syntax_node* node)
@@ -67,6 +152,13 @@ void generate_bytecode(bytecode_generator* generator, abstract_syntax_node* node
         return;
     }
 
+    /* instructions are compiled from the innermost node that records where it was parsed */
+    source_location outer_location = generator->location;
+    if (node->line > 0)
+    {
+        generator->location = (source_location){ 0, node->line, node->column };
+    }
+
     /* generate bytecode for each type of abstract syntax node */
     switch (node->type)
     {
@@ -88,9 +180,20 @@ void generate_bytecode(bytecode_generator* generator, abstract_syntax_node* node
         case AST_NODE_ASSIGNMENT:
         {
             generate_bytecode(generator, node->data.assignment.expression);
-            int variable_index = generator->variable_count++;
-            insert_symbol(generator->symbols, node->data.assignment.variable_name, SYMBOL_VARIABLE, variable_index);
-            emit_instruction(generator, (instruction){OP_STORE_VAR, {.variable = {variable_index}}});
+
+            /* assigning to a declared variable reuses its slot, only new names get one */
+            symbol* variable_symbol = lookup_symbol(generator->symbols, node->data.assignment.variable_name);
+            int variable_index;
+            if (variable_symbol != NULL && variable_symbol->type == SYMBOL_VARIABLE)
+            {
+                variable_index = variable_symbol->index;
+            }
+            else
+            {
+                variable_index = generator->variable_count++;
+                insert_symbol(generator->symbols, node->data.assignment.variable_name, SYMBOL_VARIABLE, variable_index);
+            }
+            emit_instruction(generator, (instruction){OP_STORE_VAR, {.variable = {variable_index}}, OP_TYPE_VARIABLE});
             break;
         }
         case AST_NODE_CONTRACT_DEFINITION:
@@ -146,11 +249,9 @@ void generate_bytecode(bytecode_generator* generator, abstract_syntax_node* node
 
             inst->op_code = OP_LOAD_CONST;
             inst->op_type = OP_TYPE_TEXT;
-            inst->operand.i = generator->object_count;
+            inst->operand.i = string_index;
             emit_instruction(generator, *inst);
 
-            increment_object_count(generator);
-
             break;
         }
         case AST_NODE_TEMPLATE_STRING:
@@ -172,6 +273,21 @@ void generate_bytecode(bytecode_generator* generator, abstract_syntax_node* node
              */
             break;
         }
+        case AST_NODE_IDENTIFIER:
+        {
+            /* variables are read from the slot that their declaration was given */
+            symbol* variable_symbol = lookup_symbol(generator->symbols, node->data.identifier_node.identifier_name);
+            if (variable_symbol == NULL || variable_symbol->type != SYMBOL_VARIABLE)
+            {
+                log_error("Compiler error: \"%s\" is used before it is declared.", node->data.identifier_node.identifier_name);
+                generator->error_count++;
+                break;
+            }
+
+            variable_info variable = { variable_symbol->index, variable_symbol->type };
+            emit_instruction(generator, (instruction){OP_LOAD_VAR, {.variable = variable}, OP_TYPE_VARIABLE});
+            break;
+        }
         case AST_NODE_BINARY_OP:
         {
             generate_bytecode(generator, node->data.binary_operation.left);
@@ -233,22 +349,22 @@ void generate_bytecode(bytecode_generator* generator, abstract_syntax_node* node
             if (strcmp(node->data.function_call.function_name, "error") == 0)
             {
                 instruction log_instr = {OP_BUILTIN_ERROR, {0}, OP_TYPE_NULL};
-                emit_instruction(generator, log_instr);
+                emit_builtin_log(generator, log_instr, node->data.function_call.argument_count);
             }
             else if (strcmp(node->data.function_call.function_name, "warning") == 0)
             {
                 instruction log_instr = {OP_BUILTIN_WARNING, {0}, OP_TYPE_NULL};
-                emit_instruction(generator, log_instr);
+                emit_builtin_log(generator, log_instr, node->data.function_call.argument_count);
             }
             else if (strcmp(node->data.function_call.function_name, "debug") == 0)
             {
                 instruction log_instr = {OP_BUILTIN_DEBUG, {0}, OP_TYPE_NULL};
-                emit_instruction(generator, log_instr);
+                emit_builtin_log(generator, log_instr, node->data.function_call.argument_count);
             }
             else if (strcmp(node->data.function_call.function_name, "info") == 0)
             {
                 instruction log_instr = {OP_BUILTIN_INFO, {0}, OP_TYPE_NULL};
-                emit_instruction(generator, log_instr);
+                emit_builtin_log(generator, log_instr, node->data.function_call.argument_count);
             }
             /* handle all other functions */
             else
@@ -261,7 +377,8 @@ void generate_bytecode(bytecode_generator* generator, abstract_syntax_node* node
         }
         case AST_NODE_GRAB_STATEMENT:
         {
-            if (add_object(generator, node->data.grab_statement_node.module_name) == -1)
+            int module_name_index = add_object(generator, node->data.grab_statement_node.module_name);
+            if (module_name_index == -1)
             {
                 log_error("Compiler error: Unable to allocate memory for grab statement.");
                 break;
@@ -277,12 +394,10 @@ void generate_bytecode(bytecode_generator* generator, abstract_syntax_node* node
 
             inst->op_code = OP_GRAB;
             inst->op_type = OP_TYPE_TEXT;
-            inst->operand.i = generator->object_count;
+            inst->operand.i = module_name_index;
 
             emit_instruction(generator, *inst);
 
-            increment_object_count(generator);
-
             break;
         }
         case AST_NODE_ERROR:
@@ -296,66 +411,184 @@ void generate_bytecode(bytecode_generator* generator, abstract_syntax_node* node
             exit(1);
         }
     }
+    generator->location = outer_location;
 }
 
-instruction* compile_ast_to_bytecode(abstract_syntax_node* ast, int* instruction_count, const char* output_filename)
+unsigned char* compile_ast_to_bytecode(abstract_syntax_node* ast, const compiler_options* options, optimization_statistics* statistics, size_t* size)
 {
     bytecode_generator* generator = create_bytecode_generator();
+    generator->minimum_log_level = options->minimum_log_level;
 
-    generate_bytecode(generator, ast);
-    *instruction_count = generator->instruction_count;
-    instruction* instructions = generator->instructions;
+    if (options->optimization_level >= 2)
+    {
+        /* go through the SSA intermediate representation, which gets rid of redundant values before any bytecode exists */
+        begin_compiler_pass(COMPILER_PASS_GENERATE);
+        ir_function* function = build_ir(ast, options->minimum_log_level, &generator->elided_log_call_count);
+        end_compiler_pass(COMPILER_PASS_GENERATE);
+        if (function == NULL)
+        {
+            free_bytecode_generator(generator);
+            *size = 0;
+            return NULL;
+        }
 
-    write_bytecode_to_file(instructions, *instruction_count, generator->objects, generator->object_count, output_filename);
-    safe_free(generator);
+        begin_compiler_pass(COMPILER_PASS_OPTIMIZE);
+        optimize_ir(function, statistics);
+        end_compiler_pass(COMPILER_PASS_OPTIMIZE);
+        if (options->dump_ir == true)
+        {
+            print_ir_function(function);
+        }
+        begin_compiler_pass(COMPILER_PASS_GENERATE);
+        lower_ir(function, generator);
+        free_ir_function(function);
+        end_compiler_pass(COMPILER_PASS_GENERATE);
+    }
+    else
+    {
+        begin_compiler_pass(COMPILER_PASS_GENERATE);
+        generate_bytecode(generator, ast);
+        end_compiler_pass(COMPILER_PASS_GENERATE);
+    }
+
+    /* the bytecode of a program with errors would run past them, so none is written */
+    if (generator->error_count > 0)
+    {
+        log_error("Compiler error: Found %d error(s) while generating bytecode.", generator->error_count);
+        free_bytecode_generator(generator);
+        *size = 0;
+        return NULL;
+    }
+
+    if (statistics != NULL)
+    {
+        statistics->instructions_before = generator->instruction_count;
+        statistics->log_calls_elided = generator->elided_log_call_count;
+    }
+
+    /* optimize the emitted instructions before they are written */
+    if (options->optimization_level >= 1)
+    {
+        begin_compiler_pass(COMPILER_PASS_OPTIMIZE);
+        optimize_peephole(generator, statistics);
+        eliminate_dead_code(generator, statistics);
+        allocate_variable_slots(generator, statistics);
+        /* variables that now share a slot can turn copies into self-assignments */
+        optimize_peephole(generator, statistics);
+        /* the peephole rules can leave a value that is computed only to be popped */
+        eliminate_dead_code(generator, statistics);
+        /* only now is it known which strings are still loaded */
+        remove_unused_objects(generator, statistics);
+        end_compiler_pass(COMPILER_PASS_OPTIMIZE);
+    }
+    if (statistics != NULL)
+    {
+        statistics->instructions_after = generator->instruction_count;
+    }
+
+    const char* source_path = options->input_path != NULL ? options->input_path : "";
+    begin_compiler_pass(COMPILER_PASS_SERIALIZE);
+    unsigned char* bytecode = serialize_bytecode(generator->instructions, generator->instruction_count, generator->objects, generator->object_count, generator->variable_count,
+        generator->locations, &source_path, 1, options, size);
+    end_compiler_pass(COMPILER_PASS_SERIALIZE);
+    free_bytecode_generator(generator);
 
-    return instructions;
+    return bytecode;
 }
 
-void write_bytecode_to_file(instruction* instructions, int instruction_count,char** objects, int object_count, const char* filename)
+/// @brief Appends a null-terminated key and value to the metadata section.
+static size_t append_metadata(char* metadata, size_t length, const char* key, const char* value)
 {
-    /* open the file in binary write mode */
-    FILE* file = fopen(filename, "wb");
-    if (file == NULL)
+    size_t key_length = strlen(key) + 1;
+    size_t value_length = strlen(value) + 1;
+    if (metadata != NULL)
     {
-        log_error("Compiler error: Error opening IL file for writing.");
-        return;
+        memcpy(metadata + length, key, key_length);
+        memcpy(metadata + length + key_length, value, value_length);
     }
 
-    /* write object_count */
-    fwrite(&object_count, sizeof(int), 1, file);
+    return length + key_length + value_length;
+}
+
+/// @brief Fills the metadata section, or only measures it when `metadata` is `NULL`.
+static size_t write_metadata(char* metadata, const compiler_options* options)
+{
+    char optimization_level[8];
+    snprintf(optimization_level, sizeof(optimization_level), "%d", options->optimization_level);
 
-    /* write objects */
+    size_t length = append_metadata(metadata, 0, "compiler", "lsc " LSC_VERSION);
+    length = append_metadata(metadata, length, "source", options->input_path != NULL ? options->input_path : "");
+    return append_metadata(metadata, length, "optimization_level", optimization_level);
+}
+
+unsigned char* serialize_bytecode(instruction* instructions, int instruction_count, char** objects, int object_count, int variable_count, const source_location* locations, const char* const* files, int file_count, const compiler_options* options, size_t* size)
+{
+    /* every string view points at its text in the strings section, null terminators included so the runtime can use them as they are */
+    uint32_t strings_size = 0;
     for (int i = 0; i < object_count; i++)
     {
-        int string_length = strlen(objects[i]);
-        fwrite(&string_length, sizeof(int), 1, file);
-        fwrite(objects[i], sizeof(char), string_length, file);
+        strings_size += (uint32_t)strlen(objects[i]) + 1;
+    }
+    unsigned char* constants = (unsigned char*)safe_malloc((object_count > 0 ? object_count : 1) * BYTECODE_STRING_SIZE);
+    char* strings = (char*)safe_malloc(strings_size > 0 ? strings_size : 1);
+    uint32_t string_offset = 0;
+    for (int i = 0; i < object_count; i++)
+    {
+        bytecode_string view = { string_offset, (uint32_t)strlen(objects[i]) };
+        encode_bytecode_string(&view, constants + (size_t)i * BYTECODE_STRING_SIZE);
+        memcpy(strings + string_offset, objects[i], view.length + 1);
+        string_offset += view.length + 1;
     }
 
-    /* write instruction count */
-    fwrite(&instruction_count, sizeof(int), 1, file);
-
-    /* write instructions */
+    unsigned char* code = (unsigned char*)safe_malloc((instruction_count > 0 ? instruction_count : 1) * BYTECODE_INSTRUCTION_SIZE);
     for (int i = 0; i < instruction_count; i++)
     {
-        fwrite(&instructions[i].op_code, sizeof(op_code), 1, file);
-        
-        /* write out size of operand */
-        size_t size_of_operand = sizeof(size_t);
-        fwrite(&size_of_operand, sizeof(size_t), 1, file);
-        /* write out operand itself */
-        fwrite(&instructions[i].operand, sizeof(instructions[i].operand), 1, file);
-        
-        fwrite(&instructions[i].op_type, sizeof(op_type), 1, file);
+        encode_bytecode_instruction(&instructions[i], code + (size_t)i * BYTECODE_INSTRUCTION_SIZE);
+    }
+
+    size_t metadata_size = write_metadata(NULL, options);
+    char* metadata = (char*)safe_malloc(metadata_size);
+    write_metadata(metadata, options);
+
+    /* the line table goes in a section of its own, so the code the runtime runs doesn't grow */
+    uint32_t row_count = 0;
+    size_t debug_info_size = 0;
+    unsigned char* debug_info = locations != NULL ? encode_line_table(locations, instruction_count, files, file_count, &row_count, &debug_info_size) : NULL;
+
+    /* the metadata is never compressed, so tools can read it without a decompressor */
+    uint32_t flags = options->compress_sections == true ? BYTECODE_SECTION_COMPRESSED : 0;
+    bytecode_section sections[] =
+    {
+        { BYTECODE_SECTION_CODE, flags, 0, (uint32_t)instruction_count * BYTECODE_INSTRUCTION_SIZE, (uint32_t)instruction_count, 0, code },
+        { BYTECODE_SECTION_CONSTANTS, flags, 0, (uint32_t)object_count * BYTECODE_STRING_SIZE, (uint32_t)object_count, 0, constants },
+        { BYTECODE_SECTION_STRINGS, flags, 0, strings_size, (uint32_t)object_count, 0, strings },
+        { BYTECODE_SECTION_METADATA, 0, 0, (uint32_t)metadata_size, 3, 0, metadata },
+        { BYTECODE_SECTION_DEBUG, flags, 0, (uint32_t)debug_info_size, row_count, 0, debug_info },
+    };
+    int section_count = sizeof(sections) / sizeof(sections[0]) - (debug_info == NULL ? 1 : 0);
+    unsigned char* bytecode = pack_bytecode_container(variable_count, sections, section_count, size);
+    if (debug_info != NULL)
+    {
+        safe_free(debug_info);
     }
+    safe_free(code);
+    safe_free(constants);
+    safe_free(strings);
+    safe_free(metadata);
 
-    fclose(file);
+    return bytecode;
 }
 
 void free_bytecode_generator(bytecode_generator* generator)
 {
-    safe_free_collection((void**)generator->instructions);
+    /* instructions are stored by value, only the objects are separate allocations */
+    safe_free(generator->instructions);
+    safe_free(generator->locations);
+    for (int i = 0; i < generator->object_count; i++)
+    {
+        safe_free(generator->objects[i]);
+    }
+    safe_free(generator->objects);
     free_symbol_table(generator->symbols);
     safe_free(generator);
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #ifndef BYTECODE_GENERATOR
 #define BYTECODE_GENERATOR
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -7,8 +8,13 @@
 #include "../../core/extensions/memory_extensions.h"
 #include "../../core/logger/logger.h"
 #include "../../core/types/bytecode.h"
+#include "../../core/types/bytecode_file.h"
+#include "../../core/types/line_table.h"
 #include "../../core/types/symbol_table.h"
+#include "../optimizer/optimization_statistics.h"
+#include "../timing/pass_timings.h"
 #include "../types/abstract_syntax_tree.h"
+#include "../types/compiler_options.h"
 
 /// @struct bytecode_generator
 /// @brief The bytecode generator that compiles the abstract syntax tree into L# instructions.
@@ -17,11 +23,21 @@ typedef struct bytecode_generator bytecode_generator;
 struct bytecode_generator
 {
     instruction* instructions;
+    /// @brief Where in the source every instruction was compiled from, kept in step with `instructions` by every pass.
+    source_location* locations;
     int instruction_count;
     int instruction_capacity;
+    /// @brief Where in the source the instructions being emitted are compiled from.
+    source_location location;
     symbol_table* symbols;
     int variable_count;
     int function_count;
+    /// @brief Calls to builtin logging functions below this level are not emitted.
+    log_level minimum_log_level;
+    /// @brief The amount of builtin logging calls that were left out because of the `minimum_log_level`.
+    int elided_log_call_count;
+    /// @brief The amount of errors found while generating bytecode, a program with any is not compiled.
+    int error_count;
     char** objects;
     int object_count;
     int object_capacity;
@@ -31,7 +47,7 @@ struct bytecode_generator
 /// @return A new bytecode generator.
 bytecode_generator* create_bytecode_generator();
 
-/// @brief Adds the `new_instruction` to the `generator`.
+/// @brief Adds the `new_instruction` to the `generator`, compiled from the current location of the `generator`.
 /// @param generator The `bytecode_generator` to add an instruction to.
 /// @param instruction The `new_instruction` to add to the bytecode generator.
 void emit_instruction(bytecode_generator* generator, instruction new_instruction);
@@ -42,25 +58,38 @@ void emit_instruction(bytecode_generator* generator, instruction new_instruction
 /// @return The index of the added object, or `-1` if adding was unsuccessful.
 int add_object(bytecode_generator* generator, char* object);
 
+/// @brief Removes every instruction flagged in `removed` from the `generator`, and fixes up the jump offsets of the instructions that remain.
+/// @param generator The `bytecode_generator` to remove instructions from.
+/// @param removed A flag for each instruction in the generator, `true` if the instruction should be removed.
+/// @return The amount of instructions that were removed.
+int remove_instructions(bytecode_generator* generator, const bool* removed);
+
 /// @brief Generates bytecode for the abstract syntax `node`.
 /// @param generator The `bytecode_generator` to add the generated bytecode to.
 /// @param node The abstract syntax node that will have bytecode generated for it.
 void generate_bytecode(bytecode_generator* generator, abstract_syntax_node* node);
 
-/// @brief Compiles an abstract syntax tree into bytecode.
+/// @brief Compiles an abstract syntax tree into optimized bytecode, and serializes it into an .lbc file held in memory.
 /// @param ast The abstract syntax tree to compile into bytecode.
-/// @param instruction_count The amount of instructions.
-/// @param output_filename The name of the file the bytecode will be written to.
-/// @return A collection of `instruction` in bytecode.
-instruction* compile_ast_to_bytecode(abstract_syntax_node* ast, int* instruction_count, const char* output_filename);
+/// @param options The compiler options, which are recorded in the metadata of the file.
+/// @param statistics The optimization statistics to fill while optimizing, can be `NULL`.
+/// @param size The size of the serialized file.
+/// @return The serialized .lbc file, which the caller frees, or `NULL` if compiling fails.
+unsigned char* compile_ast_to_bytecode(abstract_syntax_node* ast, const compiler_options* options, optimization_statistics* statistics, size_t* size);
 
-/// @brief Writes the bytecode `instructions` to the `filename` provided.
-/// @param instructions A collection of bytecode instructions to write to the bytecode file.
-/// @param instruction_count The number of bytecode instructions that will be written.
-/// @param objects A collection of objects to write to the bytecode file.
-/// @param object_count The number of objects that will be written.
-/// @param filename The name of the file to write the bytecode instructions to.
-void write_bytecode_to_file(instruction* instructions, int instruction_count, char** objects, int object_count, const char* filename);
+/// @brief Serializes the bytecode `instructions` and `objects` into one contiguous .lbc container.
+/// @param instructions A collection of bytecode instructions to serialize.
+/// @param instruction_count The number of bytecode instructions.
+/// @param objects A collection of objects to serialize.
+/// @param object_count The number of objects.
+/// @param variable_count The number of variable slots the program needs.
+/// @param locations Where in the source every instruction was compiled from, which is written to the debug info section, can be `NULL`.
+/// @param files The path of every source file the `locations` refer to.
+/// @param file_count The number of source files.
+/// @param options The compiler options, which are recorded in the metadata of the file.
+/// @param size The size of the serialized file.
+/// @return The serialized .lbc file, which the caller frees.
+unsigned char* serialize_bytecode(instruction* instructions, int instruction_count, char** objects, int object_count, int variable_count, const source_location* locations, const char* const* files, int file_count, const compiler_options* options, size_t* size);
 
 /// @brief Deallocates the memory used for the `generator`.
 /// @param generator The `bytecode_generator` to free.
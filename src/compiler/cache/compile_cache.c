@@ -0,0 +1,193 @@
+/* mkdir, getpid and directory listings are POSIX, which strict C17 hides unless asked for */
+#define _POSIX_C_SOURCE 200809L
+#include "compile_cache.h"
+#include "../lsc.h"
+
+/// @brief The most characters a path inside the cache directory can have.
+#define CACHE_PATH_CAPACITY 4096
+
+/// @brief The file in the cache directory that counts hits and misses.
+#define CACHE_STATISTICS_NAME "statistics"
+
+/// @brief Both hashes of a cache key, which are built together.
+typedef struct
+{
+    uint64_t hash;
+    uint32_t checksum;
+} KEY_BUILDER;
+
+/// @brief Adds a piece to a cache key, preceded by its size so two pieces can never run into each other.
+static void add_to_key(KEY_BUILDER* builder, const void* data, size_t size)
+{
+    uint64_t piece_size = size;
+    builder->hash = update_fnv1a64(builder->hash, &piece_size, sizeof(piece_size));
+    builder->hash = update_fnv1a64(builder->hash, data, size);
+    builder->checksum = update_crc32c(builder->checksum, &piece_size, sizeof(piece_size));
+    builder->checksum = update_crc32c(builder->checksum, data, size);
+}
+
+void get_compile_cache_key(const char* source, const compiler_options* options, char key[COMPILE_CACHE_KEY_LENGTH + 1])
+{
+    /* everything that changes the bytecode, options that only print something don't */
+    char description[128];
+    int description_length = snprintf(description, sizeof(description), "lsc %s; format %d.%d; O%d; log level %d; compress %d",
+        LSC_VERSION, BYTECODE_VERSION_MAJOR, BYTECODE_VERSION_MINOR, options->optimization_level,
+        (int)options->minimum_log_level, options->compress_sections == true ? 1 : 0);
+
+    /* the source path is written to the metadata section */
+    const char* input_path = options->input_path != NULL ? options->input_path : "";
+
+    KEY_BUILDER builder = { FNV1A64_OFFSET_BASIS, 0 };
+    add_to_key(&builder, description, (size_t)description_length);
+    add_to_key(&builder, input_path, strlen(input_path));
+    add_to_key(&builder, source, strlen(source));
+
+    snprintf(key, COMPILE_CACHE_KEY_LENGTH + 1, "%016" PRIx64 "%08" PRIx32, builder.hash, builder.checksum);
+}
+
+static bool get_cache_path(char* path, const char* directory, const char* name)
+{
+    int length = snprintf(path, CACHE_PATH_CAPACITY, "%s/%s", directory, name);
+    return length > 0 && length < CACHE_PATH_CAPACITY;
+}
+
+bool find_cached_bytecode(const char* directory, const char* key, mapped_file* bytecode)
+{
+    char name[COMPILE_CACHE_KEY_LENGTH + 8];
+    snprintf(name, sizeof(name), "%s.lbc", key);
+    char path[CACHE_PATH_CAPACITY];
+    if (get_cache_path(path, directory, name) == false || map_file(path, bytecode) == false)
+    {
+        return false;
+    }
+
+    /* a damaged file is treated as missing, so compiling again replaces it */
+    bytecode_container container;
+    if (read_bytecode_container(bytecode->data, bytecode->size, &container) != BYTECODE_FILE_VALID)
+    {
+        unmap_file(bytecode);
+        return false;
+    }
+
+    return true;
+}
+
+bool store_cached_bytecode(const char* directory, const char* key, const unsigned char* bytecode, size_t size)
+{
+    if (mkdir(directory, 0777) != 0 && errno != EEXIST)
+    {
+        log_warning("Compiler warning: Cannot create the compile cache directory \"%s\".", directory);
+        return false;
+    }
+
+    char name[COMPILE_CACHE_KEY_LENGTH + 8];
+    snprintf(name, sizeof(name), "%s.lbc", key);
+    char path[CACHE_PATH_CAPACITY];
+    if (get_cache_path(path, directory, name) == false || lsc_replace_bytecode_file(bytecode, size, path) == false)
+    {
+        log_warning("Compiler warning: Cannot write to the compile cache directory \"%s\".", directory);
+        return false;
+    }
+
+    return true;
+}
+
+/// @brief Reads the hit and miss counts of a cache, which are zero if it has none yet.
+static void read_lookup_counts(const char* directory, compile_cache_statistics* statistics)
+{
+    statistics->hits = 0;
+    statistics->misses = 0;
+
+    char path[CACHE_PATH_CAPACITY];
+    FILE* file = get_cache_path(path, directory, CACHE_STATISTICS_NAME) == true ? fopen(path, "r") : NULL;
+    if (file == NULL)
+    {
+        return;
+    }
+    if (fscanf(file, "hits %" SCNu64 "\nmisses %" SCNu64, &statistics->hits, &statistics->misses) != 2)
+    {
+        statistics->hits = 0;
+        statistics->misses = 0;
+    }
+    fclose(file);
+}
+
+void record_compile_cache_lookup(const char* directory, bool is_hit)
+{
+    compile_cache_statistics statistics;
+    read_lookup_counts(directory, &statistics);
+    if (is_hit == true)
+    {
+        statistics.hits++;
+    }
+    else
+    {
+        statistics.misses++;
+    }
+
+    /* the counts are a report, not a ledger, concurrent compilations may lose a count but never leave a torn file */
+    char path[CACHE_PATH_CAPACITY];
+    char temporary_path[CACHE_PATH_CAPACITY];
+    char temporary_name[64];
+    snprintf(temporary_name, sizeof(temporary_name), CACHE_STATISTICS_NAME ".%ld.tmp", (long)getpid());
+    if (get_cache_path(path, directory, CACHE_STATISTICS_NAME) == false || get_cache_path(temporary_path, directory, temporary_name) == false)
+    {
+        return;
+    }
+
+    FILE* file = fopen(temporary_path, "w");
+    if (file == NULL)
+    {
+        return;
+    }
+    fprintf(file, "hits %" PRIu64 "\nmisses %" PRIu64 "\n", statistics.hits, statistics.misses);
+    if (fclose(file) != 0 || rename(temporary_path, path) != 0)
+    {
+        remove(temporary_path);
+    }
+}
+
+/// @brief Determines if a file in the cache directory is a cached bytecode file, and not a temporary or the statistics.
+static bool is_cache_entry_name(const char* name)
+{
+    size_t length = strlen(name);
+    return length == COMPILE_CACHE_KEY_LENGTH + 4 && strcmp(name + COMPILE_CACHE_KEY_LENGTH, ".lbc") == 0;
+}
+
+void read_compile_cache_statistics(const char* directory, compile_cache_statistics* statistics)
+{
+    read_lookup_counts(directory, statistics);
+    statistics->entry_count = 0;
+    statistics->total_size = 0;
+
+    DIR* listing = opendir(directory);
+    if (listing == NULL)
+    {
+        return;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(listing)) != NULL)
+    {
+        char path[CACHE_PATH_CAPACITY];
+        struct stat status;
+        if (is_cache_entry_name(entry->d_name) == false || get_cache_path(path, directory, entry->d_name) == false || stat(path, &status) != 0)
+        {
+            continue;
+        }
+        statistics->entry_count++;
+        statistics->total_size += (uint64_t)status.st_size;
+    }
+    closedir(listing);
+}
+
+void print_compile_cache_statistics(const char* directory, int hits, int misses)
+{
+    compile_cache_statistics statistics;
+    read_compile_cache_statistics(directory, &statistics);
+
+    uint64_t lookups = statistics.hits + statistics.misses;
+    double hit_rate = lookups > 0 ? 100.0 * statistics.hits / lookups : 0.0;
+    log_info("Compile cache: %d hit(s) and %d miss(es) in this compilation.\n   %" PRIu64 " hit(s) and %" PRIu64 " miss(es) so far (%.1f%% hit rate), %" PRIu64 " file(s) taking %" PRIu64 " bytes in \"%s\".",
+        hits, misses, statistics.hits, statistics.misses, hit_rate, statistics.entry_count, statistics.total_size, directory);
+}
\ No newline at end of file
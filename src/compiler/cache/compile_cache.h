@@ -0,0 +1,82 @@
+#ifndef COMPILE_CACHE
+#define COMPILE_CACHE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../../core/extensions/hash_extensions.h"
+#include "../../core/file/map_file.h"
+#include "../../core/logger/logger.h"
+#include "../../core/types/bytecode_file.h"
+#include "../types/compiler_options.h"
+
+/**
+ * The compile cache is a directory of .lbc files named by a key of everything that decides their contents: the
+ * compiler version, the bytecode format version, the options that change the bytecode, the source path that goes in the
+ * metadata, and the source itself. Every chunk of a program is looked up on its own. A file is only ever added under
+ * its final name by renaming it into place, so a reader never sees half of one.
+ */
+
+/// @brief The amount of characters in a cache key, a 64-bit FNV-1a hash and a CRC32C checksum in hexadecimal.
+#define COMPILE_CACHE_KEY_LENGTH 24
+
+/// @struct compile_cache_statistics
+/// @brief How well a compile cache has served the compilations that used it.
+typedef struct compile_cache_statistics compile_cache_statistics;
+
+struct compile_cache_statistics
+{
+    /// @brief The amount of compilations served from the cache.
+    uint64_t hits;
+    /// @brief The amount of compilations that had to compile, and added their bytecode to the cache.
+    uint64_t misses;
+    /// @brief The amount of bytecode files in the cache.
+    uint64_t entry_count;
+    /// @brief The combined size of the bytecode files in the cache.
+    uint64_t total_size;
+};
+
+/// @brief Builds the cache key of compiling `source` with `options`.
+/// @param source The null-terminated L# source code.
+/// @param options The compiler options.
+/// @param key The `COMPILE_CACHE_KEY_LENGTH` characters of the key, and a null terminator.
+void get_compile_cache_key(const char* source, const compiler_options* options, char key[COMPILE_CACHE_KEY_LENGTH + 1]);
+
+/// @brief Finds the bytecode file cached under a `key`, and maps it into memory.
+/// @param directory The cache directory.
+/// @param key The cache key.
+/// @param bytecode The cached bytecode file, which the caller unmaps.
+/// @return `true` if an intact bytecode file is cached under the `key`, `false` otherwise.
+bool find_cached_bytecode(const char* directory, const char* key, mapped_file* bytecode);
+
+/// @brief Adds a bytecode file to the cache under a `key`, creating the cache directory if it doesn't exist.
+/// @param directory The cache directory.
+/// @param key The cache key.
+/// @param bytecode The compiled .lbc file.
+/// @param size The size of the file.
+/// @return `true` if the file was added, `false` otherwise.
+bool store_cached_bytecode(const char* directory, const char* key, const unsigned char* bytecode, size_t size);
+
+/// @brief Counts a compilation that used the cache.
+/// @param directory The cache directory.
+/// @param is_hit `true` if the compilation was served from the cache, `false` otherwise.
+void record_compile_cache_lookup(const char* directory, bool is_hit);
+
+/// @brief Reads how well a compile cache has served compilations so far, and how much it holds.
+/// @param directory The cache directory.
+/// @param statistics The compile cache statistics to fill.
+void read_compile_cache_statistics(const char* directory, compile_cache_statistics* statistics);
+
+/// @brief Logs how many chunks of this compilation were served from the cache, and the statistics of the cache, as an informational message.
+/// @param directory The cache directory.
+/// @param hits The amount of chunks of this compilation served from the cache.
+/// @param misses The amount of chunks of this compilation that had to be compiled.
+void print_compile_cache_statistics(const char* directory, int hits, int misses);
+
+#endif
\ No newline at end of file
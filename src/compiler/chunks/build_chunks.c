@@ -0,0 +1,583 @@
+/* stat, mkdir and getpid are POSIX, which strict C17 hides unless asked for */
+#define _POSIX_C_SOURCE 200809L
+#include "build_chunks.h"
+#include "../lsc.h"
+
+/// @brief The first line of every manifest, a manifest of another version is ignored.
+#define CHUNK_MANIFEST_HEADER "lsc chunk manifest 1"
+
+/// @brief The most characters a module name in a manifest can have.
+#define MODULE_NAME_CAPACITY 256
+
+/// @brief What a build directory recorded about a chunk the last time it was built.
+typedef struct
+{
+    char* module_name;
+    char source_key[COMPILE_CACHE_KEY_LENGTH + 1];
+    char build_key[COMPILE_CACHE_KEY_LENGTH + 1];
+    char** grabs;
+    int grab_count;
+} MANIFEST_ENTRY;
+
+typedef struct
+{
+    char* module_name;
+    char* source_path;
+    char source_key[COMPILE_CACHE_KEY_LENGTH + 1];
+    char build_key[COMPILE_CACHE_KEY_LENGTH + 1];
+    /// @brief Every module the chunk grabs, chunks and runtime modules alike.
+    char** grabs;
+    int grab_count;
+    /// @brief `true` once the chunks it grabs are built, and it is built itself.
+    bool is_built;
+    /// @brief The compiled unit of the chunk.
+    unsigned char* bytecode;
+    size_t size;
+} CHUNK;
+
+typedef struct
+{
+    const compiler_options* options;
+    /// @brief The directory chunk files are looked up in.
+    char* root;
+    optimization_statistics* statistics;
+    chunk_build_statistics* build_statistics;
+    MANIFEST_ENTRY* manifest;
+    int manifest_count;
+    /// @brief Every chunk found so far, in the order they finished building, which is the order they run in.
+    CHUNK** chunks;
+    int chunk_count;
+    int chunk_capacity;
+    /// @brief Every chunk found so far, including the ones still waiting for the chunks they grab.
+    CHUNK** found;
+    int found_count;
+    int found_capacity;
+} CHUNK_BUILDER;
+
+static char* copy_text(const char* text)
+{
+    size_t length = strlen(text);
+    char* copy = (char*)safe_malloc(length + 1);
+    memcpy(copy, text, length + 1);
+
+    return copy;
+}
+
+static void free_texts(char** texts, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        safe_free(texts[i]);
+    }
+    if (texts != NULL)
+    {
+        safe_free(texts);
+    }
+}
+
+/// @brief Appends a chunk to a growing list of chunks.
+static void append_chunk(CHUNK*** chunks, int* count, int* capacity, CHUNK* chunk)
+{
+    if (*count == *capacity)
+    {
+        *capacity = *capacity > 0 ? *capacity * 2 : 8;
+        *chunks = (CHUNK**)realloc(*chunks, *capacity * sizeof(CHUNK*));
+    }
+    (*chunks)[(*count)++] = chunk;
+}
+
+/// @brief Determines if a grabbed name can be a chunk file, so a name can never reach outside of the root directory.
+static bool is_module_name(const char* name)
+{
+    if (name[0] == '\0' || strlen(name) >= MODULE_NAME_CAPACITY)
+    {
+        return false;
+    }
+    for (const char* character = name; *character != '\0'; character++)
+    {
+        bool is_allowed = (*character >= 'a' && *character <= 'z') || (*character >= 'A' && *character <= 'Z')
+            || (*character >= '0' && *character <= '9') || *character == '_' || *character == '-';
+        if (is_allowed == false)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// @brief Builds the path of a file in a directory, which the caller frees.
+static char* join_path(const char* directory, const char* name, const char* extension)
+{
+    size_t capacity = strlen(directory) + strlen(name) + strlen(extension) + 2;
+    char* path = (char*)safe_malloc(capacity);
+    snprintf(path, capacity, "%s/%s%s", directory, name, extension);
+
+    return path;
+}
+
+/// @brief Gets the path of the chunk file of a module, or `NULL` if the module has none and is left for the runtime.
+static char* find_chunk_file(const CHUNK_BUILDER* builder, const char* module_name)
+{
+    if (is_module_name(module_name) == false)
+    {
+        return NULL;
+    }
+
+    char* path = join_path(builder->root, module_name, ".ls");
+    struct stat status;
+    if (stat(path, &status) != 0 || S_ISREG(status.st_mode) == false)
+    {
+        safe_free(path);
+        return NULL;
+    }
+
+    return path;
+}
+
+static void read_manifest(CHUNK_BUILDER* builder)
+{
+    builder->manifest = NULL;
+    builder->manifest_count = 0;
+    if (builder->options->build_directory == NULL)
+    {
+        return;
+    }
+
+    char* path = join_path(builder->options->build_directory, CHUNK_MANIFEST_NAME, "");
+    FILE* file = fopen(path, "r");
+    safe_free(path);
+    if (file == NULL)
+    {
+        return;
+    }
+
+    char line[64];
+    if (fgets(line, sizeof(line), file) == NULL || strcmp(line, CHUNK_MANIFEST_HEADER "\n") != 0)
+    {
+        fclose(file);
+        return;
+    }
+
+    /* a manifest that doesn't read cleanly only costs a full build, so reading stops at the first entry that doesn't */
+    int capacity = 0;
+    char module_name[MODULE_NAME_CAPACITY];
+    MANIFEST_ENTRY entry;
+    while (fscanf(file, " chunk %255s %24s %24s %d", module_name, entry.source_key, entry.build_key, &entry.grab_count) == 4)
+    {
+        if (entry.grab_count < 0 || entry.grab_count > 65536)
+        {
+            break;
+        }
+        entry.grabs = (char**)safe_malloc((entry.grab_count > 0 ? entry.grab_count : 1) * sizeof(char*));
+        int grab_count = 0;
+        char grab[MODULE_NAME_CAPACITY];
+        while (grab_count < entry.grab_count && fscanf(file, " %255s", grab) == 1)
+        {
+            entry.grabs[grab_count++] = copy_text(grab);
+        }
+        if (grab_count < entry.grab_count)
+        {
+            free_texts(entry.grabs, grab_count);
+            break;
+        }
+
+        if (builder->manifest_count == capacity)
+        {
+            capacity = capacity > 0 ? capacity * 2 : 8;
+            builder->manifest = (MANIFEST_ENTRY*)realloc(builder->manifest, capacity * sizeof(MANIFEST_ENTRY));
+        }
+        entry.module_name = copy_text(module_name);
+        builder->manifest[builder->manifest_count++] = entry;
+    }
+    fclose(file);
+}
+
+static void write_manifest(const CHUNK_BUILDER* builder)
+{
+    char* path = join_path(builder->options->build_directory, CHUNK_MANIFEST_NAME, "");
+    size_t capacity = strlen(path) + 32;
+    char* temporary_path = (char*)safe_malloc(capacity);
+    snprintf(temporary_path, capacity, "%s.%ld.tmp", path, (long)getpid());
+
+    FILE* file = fopen(temporary_path, "w");
+    if (file != NULL)
+    {
+        fprintf(file, CHUNK_MANIFEST_HEADER "\n");
+        for (int i = 0; i < builder->chunk_count; i++)
+        {
+            const CHUNK* chunk = builder->chunks[i];
+            fprintf(file, "chunk %s %s %s %d", chunk->module_name, chunk->source_key, chunk->build_key, chunk->grab_count);
+            for (int j = 0; j < chunk->grab_count; j++)
+            {
+                fprintf(file, " %s", chunk->grabs[j]);
+            }
+            fprintf(file, "\n");
+        }
+    }
+    if (file == NULL || fclose(file) != 0 || rename(temporary_path, path) != 0)
+    {
+        remove(temporary_path);
+        log_warning("Compiler warning: Cannot write the chunk manifest \"%s\".", path);
+    }
+    safe_free(temporary_path);
+    safe_free(path);
+}
+
+static const MANIFEST_ENTRY* find_manifest_entry(const CHUNK_BUILDER* builder, const char* module_name)
+{
+    for (int i = 0; i < builder->manifest_count; i++)
+    {
+        if (strcmp(builder->manifest[i].module_name, module_name) == 0)
+        {
+            return &builder->manifest[i];
+        }
+    }
+
+    return NULL;
+}
+
+static CHUNK* find_chunk(const CHUNK_BUILDER* builder, const char* module_name)
+{
+    for (int i = 0; i < builder->found_count; i++)
+    {
+        if (strcmp(builder->found[i]->module_name, module_name) == 0)
+        {
+            return builder->found[i];
+        }
+    }
+
+    return NULL;
+}
+
+/// @brief Compiles a chunk, or copies its unit out of the compile cache.
+static bool compile_chunk(CHUNK_BUILDER* builder, CHUNK* chunk, const char* source)
+{
+    compiler_options options = *builder->options;
+    options.input_path = chunk->source_path;
+
+    /* --dump-ir and --opt-stats report on compiling itself, so they always compile */
+    bool is_cache_used = options.cache_directory != NULL && options.dump_ir == false && options.print_optimization_statistics == false;
+    mapped_file cached_bytecode;
+    bool is_cached = false;
+    if (is_cache_used == true)
+    {
+        begin_compiler_pass(COMPILER_PASS_CACHE);
+        is_cached = find_cached_bytecode(options.cache_directory, chunk->source_key, &cached_bytecode);
+        end_compiler_pass(COMPILER_PASS_CACHE);
+    }
+    if (is_cached == true)
+    {
+        chunk->size = cached_bytecode.size;
+        chunk->bytecode = (unsigned char*)safe_malloc(chunk->size);
+        memcpy(chunk->bytecode, cached_bytecode.data, chunk->size);
+        unmap_file(&cached_bytecode);
+        record_compile_cache_lookup(options.cache_directory, true);
+        builder->build_statistics->cache_hits++;
+        return true;
+    }
+
+    optimization_statistics statistics;
+    create_optimization_statistics(&statistics);
+    chunk->bytecode = lsc_compile_to_buffer(source, &options, &statistics, &chunk->size);
+    if (chunk->bytecode == NULL)
+    {
+        log_error("Compiler error: Failed to compile chunk \"%s\".", chunk->source_path);
+        return false;
+    }
+    if (builder->statistics != NULL)
+    {
+        add_optimization_statistics(builder->statistics, &statistics);
+    }
+
+    if (is_cache_used == true)
+    {
+        begin_compiler_pass(COMPILER_PASS_CACHE);
+        store_cached_bytecode(options.cache_directory, chunk->source_key, chunk->bytecode, chunk->size);
+        record_compile_cache_lookup(options.cache_directory, false);
+        builder->build_statistics->cache_misses++;
+        end_compiler_pass(COMPILER_PASS_CACHE);
+    }
+
+    return true;
+}
+
+/// @brief Copies the unit of a chunk out of the build directory, if it is still there and intact.
+static bool reuse_chunk(CHUNK* chunk, const char* build_directory)
+{
+    char* path = join_path(build_directory, chunk->module_name, ".lbc");
+    mapped_file unit;
+    bool is_mapped = map_file(path, &unit);
+    safe_free(path);
+    if (is_mapped == false)
+    {
+        return false;
+    }
+
+    bytecode_container container;
+    bool is_intact = read_bytecode_container(unit.data, unit.size, &container) == BYTECODE_FILE_VALID;
+    if (is_intact == true)
+    {
+        chunk->size = unit.size;
+        chunk->bytecode = (unsigned char*)safe_malloc(chunk->size);
+        memcpy(chunk->bytecode, unit.data, chunk->size);
+    }
+    unmap_file(&unit);
+
+    return is_intact;
+}
+
+/// @brief Computes the build key of a chunk from its source key and the build keys of the chunks it grabs.
+static void get_build_key(const CHUNK_BUILDER* builder, CHUNK* chunk, CHUNK** dependencies)
+{
+    size_t capacity = COMPILE_CACHE_KEY_LENGTH + 1;
+    for (int i = 0; i < chunk->grab_count; i++)
+    {
+        capacity += strlen(chunk->grabs[i]) + COMPILE_CACHE_KEY_LENGTH + 3;
+    }
+
+    /* a grab the runtime provides is part of the key too, so adding a chunk file for it rebuilds the chunk */
+    char* description = (char*)safe_malloc(capacity);
+    size_t length = (size_t)snprintf(description, capacity, "%s", chunk->source_key);
+    for (int i = 0; i < chunk->grab_count; i++)
+    {
+        length += (size_t)snprintf(description + length, capacity - length, " %s=%s", chunk->grabs[i],
+            dependencies[i] != NULL ? dependencies[i]->build_key : "runtime");
+    }
+
+    compiler_options options = *builder->options;
+    options.input_path = chunk->source_path;
+    get_compile_cache_key(description, &options, chunk->build_key);
+    safe_free(description);
+}
+
+/// @brief Builds a chunk after the chunks it grabs, and adds it to the chunks in the order they run.
+/// @return The built chunk, or `NULL` if it or a chunk it grabs can't be built.
+static CHUNK* build_chunk(CHUNK_BUILDER* builder, const char* module_name, const char* source_path)
+{
+    CHUNK* chunk = find_chunk(builder, module_name);
+    if (chunk != NULL)
+    {
+        if (chunk->is_built == false)
+        {
+            log_error("Compiler error: Chunk \"%s\" grabs itself, through the chunks it grabs.", module_name);
+            return NULL;
+        }
+        return chunk;
+    }
+
+    chunk = (CHUNK*)safe_malloc(sizeof(CHUNK));
+    chunk->module_name = copy_text(module_name);
+    chunk->source_path = copy_text(source_path);
+    chunk->grabs = NULL;
+    chunk->grab_count = 0;
+    chunk->is_built = false;
+    chunk->bytecode = NULL;
+    chunk->size = 0;
+    append_chunk(&builder->found, &builder->found_count, &builder->found_capacity, chunk);
+
+    begin_compiler_pass(COMPILER_PASS_READ);
+    char* source = read_file(source_path);
+    end_compiler_pass(COMPILER_PASS_READ);
+    compiler_options options = *builder->options;
+    options.input_path = source_path;
+    get_compile_cache_key(source, &options, chunk->source_key);
+
+    /* an unchanged source grabs the same modules, so only a changed one is compiled to learn what it grabs */
+    const MANIFEST_ENTRY* previous = find_manifest_entry(builder, module_name);
+    bool is_source_changed = previous == NULL || strcmp(previous->source_key, chunk->source_key) != 0;
+    bool is_built = true;
+    bool is_compiled = false;
+    if (is_source_changed == false)
+    {
+        chunk->grab_count = previous->grab_count;
+        chunk->grabs = (char**)safe_malloc((chunk->grab_count > 0 ? chunk->grab_count : 1) * sizeof(char*));
+        for (int i = 0; i < chunk->grab_count; i++)
+        {
+            chunk->grabs[i] = copy_text(previous->grabs[i]);
+        }
+    }
+    else
+    {
+        is_compiled = true;
+        is_built = compile_chunk(builder, chunk, source) == true
+            && (chunk->grabs = read_bytecode_grabs(chunk->bytecode, chunk->size, &chunk->grab_count)) != NULL;
+    }
+
+    CHUNK** dependencies = (CHUNK**)safe_malloc((chunk->grab_count > 0 ? chunk->grab_count : 1) * sizeof(CHUNK*));
+    for (int i = 0; i < chunk->grab_count && is_built == true; i++)
+    {
+        char* dependency_path = find_chunk_file(builder, chunk->grabs[i]);
+        dependencies[i] = NULL;
+        if (dependency_path != NULL)
+        {
+            dependencies[i] = build_chunk(builder, chunk->grabs[i], dependency_path);
+            is_built = dependencies[i] != NULL;
+            safe_free(dependency_path);
+        }
+    }
+
+    /* a chunk whose source is unchanged is still compiled again when a chunk it depends on changed */
+    if (is_built == true)
+    {
+        get_build_key(builder, chunk, dependencies);
+        bool is_reusable = is_source_changed == false && strcmp(previous->build_key, chunk->build_key) == 0;
+        if (chunk->bytecode == NULL && (is_reusable == false || reuse_chunk(chunk, builder->options->build_directory) == false))
+        {
+            is_compiled = true;
+            is_built = compile_chunk(builder, chunk, source);
+        }
+    }
+    safe_free(dependencies);
+    safe_free(source);
+    if (is_built == false)
+    {
+        return NULL;
+    }
+
+    /* a unit that was reused is already in the build directory */
+    if (is_compiled == true)
+    {
+        builder->build_statistics->compiled_count++;
+        if (builder->options->build_directory != NULL)
+        {
+            char* unit_path = join_path(builder->options->build_directory, chunk->module_name, ".lbc");
+            if (lsc_replace_bytecode_file(chunk->bytecode, chunk->size, unit_path) == false)
+            {
+                log_warning("Compiler warning: Cannot write the unit of chunk \"%s\" to \"%s\".", module_name, unit_path);
+            }
+            safe_free(unit_path);
+        }
+    }
+
+    chunk->is_built = true;
+    append_chunk(&builder->chunks, &builder->chunk_count, &builder->chunk_capacity, chunk);
+    return chunk;
+}
+
+/// @brief Links the built chunks into one program that runs each where it is first grabbed, a program of a single chunk is its unit as it is.
+static unsigned char* link_chunks(CHUNK_BUILDER* builder, size_t* size)
+{
+    CHUNK* entry = builder->chunks[builder->chunk_count - 1];
+    if (builder->chunk_count == 1)
+    {
+        unsigned char* bytecode = entry->bytecode;
+        *size = entry->size;
+        entry->bytecode = NULL;
+        return bytecode;
+    }
+
+    bytecode_unit* units = (bytecode_unit*)safe_malloc(builder->chunk_count * sizeof(bytecode_unit));
+    int unit_count = 0;
+    for (; unit_count < builder->chunk_count; unit_count++)
+    {
+        const CHUNK* chunk = builder->chunks[unit_count];
+        if (read_bytecode_unit(chunk->bytecode, chunk->size, chunk->module_name, &units[unit_count]) == false)
+        {
+            log_error("Compiler error: The unit of chunk \"%s\" is corrupt.", chunk->source_path);
+            break;
+        }
+    }
+
+    unsigned char* bytecode = NULL;
+    if (unit_count == builder->chunk_count)
+    {
+        bytecode = link_bytecode_units(units, unit_count, builder->options, size);
+    }
+    for (int i = 0; i < unit_count; i++)
+    {
+        free_bytecode_unit(&units[i]);
+    }
+    safe_free(units);
+
+    return bytecode;
+}
+
+/// @brief Bundles the units of the built chunks into an archive, in the order they run, with the entry chunk last.
+static unsigned char* archive_chunks(const CHUNK_BUILDER* builder, size_t* size)
+{
+    bytecode_archive_module* modules = (bytecode_archive_module*)safe_malloc(builder->chunk_count * sizeof(bytecode_archive_module));
+    for (int i = 0; i < builder->chunk_count; i++)
+    {
+        modules[i] = (bytecode_archive_module){ builder->chunks[i]->module_name, builder->chunks[i]->bytecode, builder->chunks[i]->size };
+    }
+    unsigned char* archive = pack_bytecode_archive(modules, builder->chunk_count, builder->chunk_count - 1, size);
+    safe_free(modules);
+
+    return archive;
+}
+
+static void free_chunk_builder(CHUNK_BUILDER* builder)
+{
+    for (int i = 0; i < builder->found_count; i++)
+    {
+        CHUNK* chunk = builder->found[i];
+        safe_free(chunk->module_name);
+        safe_free(chunk->source_path);
+        free_texts(chunk->grabs, chunk->grab_count);
+        if (chunk->bytecode != NULL)
+        {
+            safe_free(chunk->bytecode);
+        }
+        safe_free(chunk);
+    }
+    for (int i = 0; i < builder->manifest_count; i++)
+    {
+        safe_free(builder->manifest[i].module_name);
+        free_texts(builder->manifest[i].grabs, builder->manifest[i].grab_count);
+    }
+    free(builder->manifest);
+    free(builder->found);
+    free(builder->chunks);
+    safe_free(builder->root);
+}
+
+void create_chunk_build_statistics(chunk_build_statistics* statistics)
+{
+    statistics->chunk_count = 0;
+    statistics->compiled_count = 0;
+    statistics->cache_hits = 0;
+    statistics->cache_misses = 0;
+}
+
+unsigned char* build_chunks(const compiler_options* options, optimization_statistics* statistics, chunk_build_statistics* build_statistics, size_t* size)
+{
+    *size = 0;
+    if (options->build_directory != NULL && mkdir(options->build_directory, 0777) != 0 && errno != EEXIST)
+    {
+        log_error("Compiler error: Cannot create the build directory \"%s\".", options->build_directory);
+        return NULL;
+    }
+
+    /* chunks are looked up next to the entry file, which is a chunk named after its file */
+    const char* separator = strrchr(options->input_path, '/');
+    const char* file_name = separator != NULL ? separator + 1 : options->input_path;
+    size_t root_length = separator != NULL ? (size_t)(separator - options->input_path) : 1;
+    size_t name_length = strcspn(file_name, ".");
+
+    CHUNK_BUILDER builder = { options, NULL, statistics, build_statistics, NULL, 0, NULL, 0, 0, NULL, 0, 0 };
+    builder.root = (char*)safe_malloc(root_length + 1);
+    memcpy(builder.root, separator != NULL ? options->input_path : ".", root_length);
+    builder.root[root_length] = '\0';
+    char* entry_name = (char*)safe_malloc(name_length + 1);
+    memcpy(entry_name, file_name, name_length);
+    entry_name[name_length] = '\0';
+    read_manifest(&builder);
+
+    unsigned char* bytecode = NULL;
+    if (build_chunk(&builder, entry_name, options->input_path) != NULL)
+    {
+        build_statistics->chunk_count = builder.chunk_count;
+        if (options->build_directory != NULL)
+        {
+            write_manifest(&builder);
+        }
+        begin_compiler_pass(COMPILER_PASS_LINK);
+        bytecode = options->write_archive == true ? archive_chunks(&builder, size) : link_chunks(&builder, size);
+        end_compiler_pass(COMPILER_PASS_LINK);
+    }
+    safe_free(entry_name);
+    free_chunk_builder(&builder);
+
+    return bytecode;
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef BUILD_CHUNKS
+#define BUILD_CHUNKS
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../../core/extensions/memory_extensions.h"
+#include "../../core/file/map_file.h"
+#include "../../core/logger/logger.h"
+#include "../../core/types/bytecode_archive.h"
+#include "../cache/compile_cache.h"
+#include "../file/read_file.h"
+#include "../linker/link_bytecode.h"
+#include "../optimizer/optimization_statistics.h"
+#include "../timing/pass_timings.h"
+#include "../types/compiler_options.h"
+
+/**
+ * A program is made of chunks: the entry file, and every `<module>.ls` file next to it that a chunk grabs. A grab of a
+ * module without such a file is left for the runtime, like `grab io`. Every chunk is compiled to its own bytecode unit,
+ * and the units are linked so each chunk runs once, after the chunks it grabs. With an archive, the units are bundled
+ * as they are instead, and the runtime runs each chunk the first time it is grabbed.
+ *
+ * With a build directory, the units are kept there as `<module>.lbc`, along with a manifest of what each was built
+ * from: the key of its source, the modules it grabs, and a build key over its source key and the build keys of the
+ * chunks it grabs. A chunk is only compiled again when its build key changes, which happens when its source or any
+ * chunk it depends on, however indirectly, changes.
+ */
+
+/// @brief The name of the manifest in a build directory.
+#define CHUNK_MANIFEST_NAME "manifest"
+
+/// @struct chunk_build_statistics
+/// @brief What building the chunks of a program took.
+typedef struct chunk_build_statistics chunk_build_statistics;
+
+struct chunk_build_statistics
+{
+    /// @brief The amount of chunks in the program.
+    int chunk_count;
+    /// @brief The amount of chunks that were compiled, instead of reused from the build directory.
+    int compiled_count;
+    /// @brief The amount of compiled chunks served from the compile cache.
+    int cache_hits;
+    /// @brief The amount of compiled chunks that weren't in the compile cache.
+    int cache_misses;
+};
+
+/// @brief Fills `statistics` with zeroed counts.
+/// @param statistics The chunk build statistics to reset.
+void create_chunk_build_statistics(chunk_build_statistics* statistics);
+
+/// @brief Compiles the entry file in `options` and every chunk it grabs, and links them into one .lbc file or bundles them into an .lba archive.
+/// @param options The compiler options, with the entry file and optionally a build and cache directory.
+/// @param statistics The optimization statistics to add the counts of every compiled chunk to, can be `NULL`.
+/// @param build_statistics The chunk build statistics to fill.
+/// @param size The size of the linked file or archive.
+/// @return The linked .lbc file or the archive, which the caller frees, or `NULL` if a chunk can't be compiled.
+unsigned char* build_chunks(const compiler_options* options, optimization_statistics* statistics, chunk_build_statistics* build_statistics, size_t* size);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,575 @@
+#include "build_ir.h"
+
+/**
+ * SSA form is built directly from the abstract syntax tree with the algorithm from
+ * "Simple and Efficient Construction of Static Single Assignment Form" (Braun et al.):
+ * every block remembers the current definition of each variable, reads that miss look
+ * through the predecessors, and phis are only placed where definitions actually merge.
+ */
+
+/// @struct ir_builder
+/// @brief The state of the IR builder while it walks the abstract syntax tree.
+typedef struct ir_builder ir_builder;
+
+struct ir_builder
+{
+    ir_function* function;
+    ir_block* current_block;
+    /// @brief Maps variable names to a dense variable number.
+    symbol_table* variables;
+    int variable_count;
+    /// @brief Maps function names to the index used by `IR_CALL`.
+    symbol_table* functions;
+    int function_count;
+    /// @brief Calls to builtin logging functions below this level are left out.
+    log_level minimum_log_level;
+    int* elided_log_call_count;
+    /// @brief The amount of errors found while building, a program with any is not compiled.
+    int error_count;
+};
+
+static ir_value* read_variable(ir_builder* builder, int variable, ir_block* block);
+
+static ir_value* create_undefined_value(ir_builder* builder, ir_block* block)
+{
+    return create_ir_value(builder->function, block, IR_UNDEFINED, IR_TYPE_NONE);
+}
+
+static void write_variable(int variable, ir_block* block, ir_value* value)
+{
+    if (variable >= block->definition_capacity)
+    {
+        int old_capacity = block->definition_capacity;
+        int new_capacity = old_capacity == 0 ? 16 : old_capacity;
+        while (new_capacity <= variable)
+        {
+            new_capacity *= 2;
+        }
+
+        block->definitions = (ir_value**)realloc(block->definitions, new_capacity * sizeof(ir_value*));
+        if (block->definitions == NULL)
+        {
+            log_error("Compiler error: Unable to grow IR variable definitions.");
+            exit(-1);
+        }
+        for (int i = old_capacity; i < new_capacity; i++)
+        {
+            block->definitions[i] = NULL;
+        }
+        block->definition_capacity = new_capacity;
+    }
+
+    block->definitions[variable] = value;
+}
+
+static ir_type get_phi_type(ir_value* phi)
+{
+    ir_type type = IR_TYPE_NONE;
+    for (int i = 0; i < phi->operand_count; i++)
+    {
+        ir_value* operand = resolve_ir_value(phi->operands[i]);
+        if (operand == phi)
+        {
+            continue;
+        }
+        if (type == IR_TYPE_NONE)
+        {
+            type = operand->type;
+        }
+        else if (type != operand->type)
+        {
+            return IR_TYPE_UNKNOWN;
+        }
+    }
+
+    return type == IR_TYPE_NONE ? IR_TYPE_UNKNOWN : type;
+}
+
+/// @brief Forwards a phi whose operands are all the same value (or the phi itself) to that value.
+static ir_value* try_remove_trivial_phi(ir_builder* builder, ir_value* phi)
+{
+    ir_value* same = NULL;
+    for (int i = 0; i < phi->operand_count; i++)
+    {
+        ir_value* operand = resolve_ir_value(phi->operands[i]);
+        if (operand == same || operand == phi)
+        {
+            continue;
+        }
+        if (same != NULL)
+        {
+            /* the phi merges at least two values */
+            phi->type = get_phi_type(phi);
+            return phi;
+        }
+        same = operand;
+    }
+
+    if (same == NULL)
+    {
+        /* the phi is unreachable or only refers to itself */
+        same = create_undefined_value(builder, builder->function->blocks[0]);
+    }
+
+    phi->replacement = same;
+    phi->is_removed = true;
+    return same;
+}
+
+static ir_value* add_phi_operands(ir_builder* builder, int variable, ir_value* phi)
+{
+    ir_block* block = phi->block;
+    for (int i = 0; i < block->predecessor_count; i++)
+    {
+        add_ir_operand(phi, read_variable(builder, variable, block->predecessors[i]));
+    }
+
+    return try_remove_trivial_phi(builder, phi);
+}
+
+static ir_value* read_variable_recursive(ir_builder* builder, int variable, ir_block* block)
+{
+    ir_value* value = NULL;
+    if (block->is_sealed == false)
+    {
+        /* not every predecessor is known yet, the operands are filled in by seal_block */
+        value = create_ir_phi(builder->function, block, variable);
+    }
+    else if (block->predecessor_count == 0)
+    {
+        value = create_undefined_value(builder, block);
+    }
+    else if (block->predecessor_count == 1)
+    {
+        value = read_variable(builder, variable, block->predecessors[0]);
+    }
+    else
+    {
+        /* write the phi first to break cycles through loops */
+        ir_value* phi = create_ir_phi(builder->function, block, variable);
+        write_variable(variable, block, phi);
+        value = add_phi_operands(builder, variable, phi);
+    }
+
+    write_variable(variable, block, value);
+    return value;
+}
+
+static ir_value* read_variable(ir_builder* builder, int variable, ir_block* block)
+{
+    if (variable < block->definition_capacity && block->definitions[variable] != NULL)
+    {
+        return resolve_ir_value(block->definitions[variable]);
+    }
+
+    return read_variable_recursive(builder, variable, block);
+}
+
+/// @brief Marks that every predecessor of the `block` is known, and completes the phis that were created before that.
+static void seal_block(ir_builder* builder, ir_block* block)
+{
+    int incomplete_phi_count = block->phi_count;
+    for (int i = 0; i < incomplete_phi_count; i++)
+    {
+        ir_value* phi = block->phis[i];
+        if (phi->is_removed == false && phi->operand_count == 0)
+        {
+            add_phi_operands(builder, phi->variable, phi);
+        }
+    }
+
+    block->is_sealed = true;
+}
+
+static ir_type get_declared_type(const char* type_name)
+{
+    if (strcmp(type_name, "number") == 0)
+    {
+        return IR_TYPE_NUMBER;
+    }
+    if (strcmp(type_name, "text") == 0)
+    {
+        return IR_TYPE_TEXT;
+    }
+    if (strcmp(type_name, "bit") == 0)
+    {
+        return IR_TYPE_BIT;
+    }
+
+    return IR_TYPE_UNKNOWN;
+}
+
+/// @brief Gives a declared name a new variable, which hides the one an earlier declaration of the name was given,
+/// like the bytecode generator gives it a new slot.
+static int declare_variable(ir_builder* builder, const char* name)
+{
+    int variable = builder->variable_count++;
+    insert_symbol(builder->variables, name, SYMBOL_VARIABLE, variable);
+    return variable;
+}
+
+static int get_variable(ir_builder* builder, const char* name, bool should_create)
+{
+    symbol* variable_symbol = lookup_symbol(builder->variables, name);
+    if (variable_symbol != NULL)
+    {
+        return variable_symbol->index;
+    }
+
+    if (should_create == false)
+    {
+        return -1;
+    }
+
+    return declare_variable(builder, name);
+}
+
+static ir_value* build_expression(ir_builder* builder, abstract_syntax_node* node);
+
+static ir_value* build_constant_number(ir_builder* builder, double number)
+{
+    ir_value* value = create_ir_value(builder->function, builder->current_block, IR_CONST_NUMBER, IR_TYPE_NUMBER);
+    value->constant.number = number;
+    return value;
+}
+
+static ir_value* build_default_value(ir_builder* builder, ir_type type)
+{
+    switch (type)
+    {
+        case IR_TYPE_NUMBER:
+        {
+            return build_constant_number(builder, 0);
+        }
+        case IR_TYPE_TEXT:
+        {
+            ir_value* value = create_ir_value(builder->function, builder->current_block, IR_CONST_TEXT, IR_TYPE_TEXT);
+            value->constant.text = "";
+            return value;
+        }
+        case IR_TYPE_BIT:
+        {
+            ir_value* value = create_ir_value(builder->function, builder->current_block, IR_CONST_BIT, IR_TYPE_BIT);
+            value->constant.bit = false;
+            return value;
+        }
+        default:
+        {
+            return create_undefined_value(builder, builder->current_block);
+        }
+    }
+}
+
+/// @brief Builds the value stored into a variable, keeping a copy when it comes straight from another variable so the declared type is kept.
+static ir_value* build_stored_value(ir_builder* builder, abstract_syntax_node* expression, ir_type declared_type)
+{
+    ir_value* value = build_expression(builder, expression);
+    if (value == NULL)
+    {
+        return NULL;
+    }
+
+    if (expression->type == AST_NODE_IDENTIFIER)
+    {
+        ir_value* copy = create_ir_value(builder->function, builder->current_block, IR_COPY, declared_type == IR_TYPE_UNKNOWN ? value->type : declared_type);
+        add_ir_operand(copy, value);
+        return copy;
+    }
+
+    return value;
+}
+
+static log_level get_ir_builtin_log_level(ir_opcode opcode)
+{
+    switch (opcode)
+    {
+        case IR_BUILTIN_INFO: return LOG_LEVEL_INFO;
+        case IR_BUILTIN_WARNING: return LOG_LEVEL_WARNING;
+        case IR_BUILTIN_ERROR: return LOG_LEVEL_ERROR;
+        default: return LOG_LEVEL_DEBUG;
+    }
+}
+
+static ir_value* build_function_call(ir_builder* builder, abstract_syntax_node* node)
+{
+    const char* function_name = node->data.function_call.function_name;
+    ir_opcode opcode = IR_CALL;
+    if (strcmp(function_name, "error") == 0)
+    {
+        opcode = IR_BUILTIN_ERROR;
+    }
+    else if (strcmp(function_name, "warning") == 0)
+    {
+        opcode = IR_BUILTIN_WARNING;
+    }
+    else if (strcmp(function_name, "debug") == 0)
+    {
+        opcode = IR_BUILTIN_DEBUG;
+    }
+    else if (strcmp(function_name, "info") == 0)
+    {
+        opcode = IR_BUILTIN_INFO;
+    }
+
+    /* arguments are evaluated before the call, in order */
+    int argument_count = node->data.function_call.argument_count;
+    ir_value** arguments = (ir_value**)safe_malloc((argument_count + 1) * sizeof(ir_value*));
+    for (int i = 0; i < argument_count; i++)
+    {
+        arguments[i] = build_expression(builder, node->data.function_call.arguments[i]);
+    }
+
+    /* a logging call below the minimum level disappears, dead code elimination decides if its arguments can go too */
+    log_level builtin_level = get_ir_builtin_log_level(opcode);
+    if (opcode != IR_CALL && builtin_level < builder->minimum_log_level)
+    {
+        if (builder->elided_log_call_count != NULL)
+        {
+            (*builder->elided_log_call_count)++;
+        }
+        safe_free(arguments);
+        return create_undefined_value(builder, builder->current_block);
+    }
+
+    ir_value* call = create_ir_value(builder->function, builder->current_block, opcode, IR_TYPE_NONE);
+    for (int i = 0; i < argument_count; i++)
+    {
+        if (arguments[i] != NULL)
+        {
+            add_ir_operand(call, arguments[i]);
+        }
+    }
+    safe_free(arguments);
+
+    if (opcode == IR_CALL)
+    {
+        call->type = IR_TYPE_UNKNOWN;
+        call->constant.function_index = builder->function_count++;
+        insert_symbol(builder->functions, function_name, SYMBOL_FUNCTION, call->constant.function_index);
+    }
+
+    return call;
+}
+
+/// @brief Makes the values built from now on carry the source location of a node, if it has one.
+static void locate_ir_values(ir_builder* builder, const abstract_syntax_node* node)
+{
+    if (node->line > 0)
+    {
+        builder->function->line = node->line;
+        builder->function->column = node->column;
+    }
+}
+
+static ir_value* build_expression_value(ir_builder* builder, abstract_syntax_node* node)
+{
+    switch (node->type)
+    {
+        case AST_NODE_NUMBER_LITERAL:
+        {
+            return build_constant_number(builder, node->data.number_literal.value);
+        }
+        case AST_NODE_STRING_LITERAL:
+        {
+            ir_value* value = create_ir_value(builder->function, builder->current_block, IR_CONST_TEXT, IR_TYPE_TEXT);
+            value->constant.text = node->data.string_literal.value;
+            return value;
+        }
+        case AST_NODE_BIT_LITERAL:
+        {
+            ir_value* value = create_ir_value(builder->function, builder->current_block, IR_CONST_BIT, IR_TYPE_BIT);
+            value->constant.bit = node->data.bit_literal.value;
+            return value;
+        }
+        case AST_NODE_IDENTIFIER:
+        {
+            int variable = get_variable(builder, node->data.identifier_node.identifier_name, false);
+            if (variable == -1)
+            {
+                log_error("Compiler error: \"%s\" is used before it is declared.", node->data.identifier_node.identifier_name);
+                builder->error_count++;
+                return create_undefined_value(builder, builder->current_block);
+            }
+            return read_variable(builder, variable, builder->current_block);
+        }
+        case AST_NODE_BINARY_OP:
+        {
+            ir_value* left = build_expression(builder, node->data.binary_operation.left);
+            ir_value* right = build_expression(builder, node->data.binary_operation.right);
+            if (left == NULL || right == NULL)
+            {
+                return NULL;
+            }
+
+            ir_opcode opcode;
+            switch (*node->data.binary_operation.op_symbol)
+            {
+                case '+': opcode = IR_ADD; break;
+                case '-': opcode = IR_SUB; break;
+                case '*': opcode = IR_MUL; break;
+                case '/': opcode = IR_DIV; break;
+                default:
+                    log_error("[build_ir]: unknown binary operator.");
+                    return NULL;
+            }
+
+            ir_type type = (left->type == IR_TYPE_NUMBER && right->type == IR_TYPE_NUMBER) ? IR_TYPE_NUMBER : IR_TYPE_UNKNOWN;
+            ir_value* value = create_ir_value(builder->function, builder->current_block, opcode, type);
+            add_ir_operand(value, left);
+            add_ir_operand(value, right);
+            return value;
+        }
+        case AST_NODE_FUNCTION_CALL:
+        {
+            return build_function_call(builder, node);
+        }
+        case AST_NODE_ERROR:
+        {
+            log_error("Compiler error %d: %s", node->data.error_node.code, node->data.error_node.message);
+            return NULL;
+        }
+        default:
+        {
+            /* contracts, template strings and arrays aren't compiled yet */
+            return NULL;
+        }
+    }
+}
+
+static ir_value* build_expression(ir_builder* builder, abstract_syntax_node* node)
+{
+    if (node == NULL)
+    {
+        return NULL;
+    }
+
+    /* an expression without a location of its own is located where the one around it is */
+    int outer_line = builder->function->line;
+    int outer_column = builder->function->column;
+    locate_ir_values(builder, node);
+    ir_value* value = build_expression_value(builder, node);
+    builder->function->line = outer_line;
+    builder->function->column = outer_column;
+
+    return value;
+}
+
+static void build_statement(ir_builder* builder, abstract_syntax_node* node)
+{
+    if (node == NULL)
+    {
+        return;
+    }
+
+    int outer_line = builder->function->line;
+    int outer_column = builder->function->column;
+    locate_ir_values(builder, node);
+    switch (node->type)
+    {
+        case AST_NODE_STATEMENT:
+        {
+            build_statement(builder, node->data.statement_node.statement);
+            break;
+        }
+        case AST_NODE_DECLARATION:
+        {
+            ir_type declared_type = get_declared_type(node->data.declaration_node.type_name);
+            /* the name is declared before its initializer is built, so the initializer already reads the new variable */
+            int variable = declare_variable(builder, node->data.declaration_node.variable_name);
+
+            ir_value* value = node->data.declaration_node.expression != NULL
+                ? build_stored_value(builder, node->data.declaration_node.expression, declared_type)
+                : build_default_value(builder, declared_type);
+            if (value != NULL)
+            {
+                write_variable(variable, builder->current_block, value);
+            }
+            break;
+        }
+        case AST_NODE_ASSIGNMENT:
+        {
+            int variable = get_variable(builder, node->data.assignment.variable_name, true);
+            ir_value* value = build_stored_value(builder, node->data.assignment.expression, IR_TYPE_UNKNOWN);
+            if (value != NULL)
+            {
+                write_variable(variable, builder->current_block, value);
+            }
+            break;
+        }
+        case AST_NODE_RETURN_STATEMENT:
+        {
+            ir_value* result = build_expression(builder, node->data.return_statement_node.expression);
+            ir_value* return_value = create_ir_value(builder->function, builder->current_block, IR_RETURN, IR_TYPE_NONE);
+            if (result != NULL)
+            {
+                add_ir_operand(return_value, result);
+            }
+            break;
+        }
+        case AST_NODE_GRAB_STATEMENT:
+        {
+            ir_value* grab = create_ir_value(builder->function, builder->current_block, IR_GRAB, IR_TYPE_NONE);
+            grab->constant.text = node->data.grab_statement_node.module_name;
+            break;
+        }
+        case AST_NODE_CONTRACT_DEFINITION:
+        {
+            /**
+             * TODO: Implement contract handling here
+             */
+            break;
+        }
+        default:
+        {
+            /* expression statements are built for their side effects */
+            build_expression(builder, node);
+            break;
+        }
+    }
+    builder->function->line = outer_line;
+    builder->function->column = outer_column;
+}
+
+ir_function* build_ir(abstract_syntax_node* ast, log_level minimum_log_level, int* elided_log_call_count)
+{
+    if (ast == NULL || ast->type != AST_NODE_PROGRAM)
+    {
+        log_error("Compiler error: The IR can only be built from a program node.");
+        return NULL;
+    }
+
+    ir_builder builder;
+    builder.function = create_ir_function();
+    builder.variables = create_symbol_table(100);
+    builder.variable_count = 0;
+    builder.functions = create_symbol_table(100);
+    builder.function_count = 0;
+    builder.minimum_log_level = minimum_log_level;
+    builder.elided_log_call_count = elided_log_call_count;
+    builder.error_count = 0;
+
+    /* the entry block has no predecessors, so it is sealed from the start */
+    builder.current_block = create_ir_block(builder.function);
+    seal_block(&builder, builder.current_block);
+
+    for (int i = 0; i < ast->data.program_node.statement_count; i++)
+    {
+        build_statement(&builder, ast->data.program_node.statements[i]);
+    }
+
+    create_ir_value(builder.function, builder.current_block, IR_HALT, IR_TYPE_NONE);
+
+    free_symbol_table(builder.variables);
+    free_symbol_table(builder.functions);
+
+    /* the bytecode of a program with errors would run past them, so none is built */
+    if (builder.error_count > 0)
+    {
+        log_error("Compiler error: Found %d error(s) while building the IR.", builder.error_count);
+        free_ir_function(builder.function);
+        return NULL;
+    }
+
+    count_ir_uses(builder.function);
+    return builder.function;
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#ifndef BUILD_IR
+#define BUILD_IR
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../core/extensions/memory_extensions.h"
+#include "../../core/logger/logger.h"
+#include "../../core/types/symbol_table.h"
+#include "../types/abstract_syntax_tree.h"
+#include "ir.h"
+
+/// @brief Builds the SSA form intermediate representation of an abstract syntax tree.
+/// @param ast The abstract syntax tree of an L# program.
+/// @param minimum_log_level Calls to builtin logging functions below this level are left out, their arguments are still built.
+/// @param elided_log_call_count Incremented for every builtin logging call that was left out, can be `NULL`.
+/// @return An IR function that holds the whole program, or `NULL` if building failed.
+ir_function* build_ir(abstract_syntax_node* ast, log_level minimum_log_level, int* elided_log_call_count);
+
+#endif
\ No newline at end of file
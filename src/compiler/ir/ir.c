@@ -0,0 +1,332 @@
+#include "ir.h"
+
+/// @brief Grows a dynamic array of pointers so it can hold one more element.
+static void** grow_pointer_array(void** array, int count, int* capacity)
+{
+    if (count < *capacity)
+    {
+        return array;
+    }
+
+    *capacity = (*capacity == 0) ? 4 : *capacity * 2;
+    void** grown_array = (void**)realloc(array, *capacity * sizeof(void*));
+    if (grown_array == NULL)
+    {
+        log_error("Compiler error: Unable to grow IR array to %d elements.", *capacity);
+        exit(-1);
+    }
+
+    return grown_array;
+}
+
+ir_function* create_ir_function()
+{
+    ir_function* function = (ir_function*)safe_malloc(sizeof(ir_function));
+    function->blocks = NULL;
+    function->block_count = 0;
+    function->block_capacity = 0;
+    function->values = NULL;
+    function->value_count = 0;
+    function->value_capacity = 0;
+    function->line = 0;
+    function->column = 0;
+    return function;
+}
+
+ir_block* create_ir_block(ir_function* function)
+{
+    ir_block* block = (ir_block*)safe_malloc(sizeof(ir_block));
+    block->id = function->block_count;
+    block->phis = NULL;
+    block->phi_count = 0;
+    block->phi_capacity = 0;
+    block->values = NULL;
+    block->value_count = 0;
+    block->value_capacity = 0;
+    block->predecessors = NULL;
+    block->predecessor_count = 0;
+    block->predecessor_capacity = 0;
+    block->is_sealed = false;
+    block->definitions = NULL;
+    block->definition_capacity = 0;
+    block->immediate_dominator = NULL;
+
+    function->blocks = (ir_block**)grow_pointer_array((void**)function->blocks, function->block_count, &function->block_capacity);
+    function->blocks[function->block_count++] = block;
+    return block;
+}
+
+void add_ir_block_edge(ir_block* from, ir_block* to)
+{
+    to->predecessors = (ir_block**)grow_pointer_array((void**)to->predecessors, to->predecessor_count, &to->predecessor_capacity);
+    to->predecessors[to->predecessor_count++] = from;
+}
+
+static ir_value* allocate_ir_value(ir_function* function, ir_block* block, ir_opcode opcode, ir_type type)
+{
+    ir_value* value = (ir_value*)safe_malloc(sizeof(ir_value));
+    value->id = function->value_count;
+    value->opcode = opcode;
+    value->type = type;
+    value->block = block;
+    value->operands = NULL;
+    value->operand_count = 0;
+    value->operand_capacity = 0;
+    value->constant.number = 0;
+    value->targets[0] = NULL;
+    value->targets[1] = NULL;
+    value->variable = -1;
+    value->replacement = NULL;
+    value->use_count = 0;
+    value->is_removed = false;
+    value->line = function->line;
+    value->column = function->column;
+
+    function->values = (ir_value**)grow_pointer_array((void**)function->values, function->value_count, &function->value_capacity);
+    function->values[function->value_count++] = value;
+    return value;
+}
+
+ir_value* create_ir_value(ir_function* function, ir_block* block, ir_opcode opcode, ir_type type)
+{
+    ir_value* value = allocate_ir_value(function, block, opcode, type);
+    block->values = (ir_value**)grow_pointer_array((void**)block->values, block->value_count, &block->value_capacity);
+    block->values[block->value_count++] = value;
+    return value;
+}
+
+ir_value* create_ir_phi(ir_function* function, ir_block* block, int variable)
+{
+    ir_value* phi = allocate_ir_value(function, block, IR_PHI, IR_TYPE_UNKNOWN);
+    phi->variable = variable;
+    block->phis = (ir_value**)grow_pointer_array((void**)block->phis, block->phi_count, &block->phi_capacity);
+    block->phis[block->phi_count++] = phi;
+    return phi;
+}
+
+void add_ir_operand(ir_value* value, ir_value* operand)
+{
+    value->operands = (ir_value**)grow_pointer_array((void**)value->operands, value->operand_count, &value->operand_capacity);
+    value->operands[value->operand_count++] = operand;
+}
+
+ir_value* resolve_ir_value(ir_value* value)
+{
+    while (value != NULL && value->replacement != NULL)
+    {
+        value = value->replacement;
+    }
+
+    return value;
+}
+
+static void count_ir_value_uses(ir_value* value)
+{
+    if (value->is_removed == true)
+    {
+        return;
+    }
+
+    for (int i = 0; i < value->operand_count; i++)
+    {
+        value->operands[i] = resolve_ir_value(value->operands[i]);
+        value->operands[i]->use_count++;
+    }
+}
+
+void count_ir_uses(ir_function* function)
+{
+    for (int i = 0; i < function->value_count; i++)
+    {
+        function->values[i]->use_count = 0;
+    }
+
+    for (int block_index = 0; block_index < function->block_count; block_index++)
+    {
+        ir_block* block = function->blocks[block_index];
+        for (int i = 0; i < block->phi_count; i++)
+        {
+            count_ir_value_uses(block->phis[i]);
+        }
+        for (int i = 0; i < block->value_count; i++)
+        {
+            count_ir_value_uses(block->values[i]);
+        }
+    }
+}
+
+bool is_ir_terminator(ir_opcode opcode)
+{
+    return opcode == IR_JUMP || opcode == IR_BRANCH || opcode == IR_HALT;
+}
+
+int get_ir_successors(ir_block* block, ir_block** successors)
+{
+    if (block->value_count == 0 || is_ir_terminator(block->values[block->value_count - 1]->opcode) == false)
+    {
+        return 0;
+    }
+
+    ir_value* terminator = block->values[block->value_count - 1];
+    int successor_count = 0;
+    for (int i = 0; i < 2; i++)
+    {
+        if (terminator->targets[i] != NULL)
+        {
+            successors[successor_count++] = terminator->targets[i];
+        }
+    }
+
+    return successor_count;
+}
+
+bool is_ir_value_pure(ir_value* value)
+{
+    switch (value->opcode)
+    {
+        case IR_CONST_NUMBER:
+        case IR_CONST_TEXT:
+        case IR_CONST_BIT:
+        case IR_UNDEFINED:
+        case IR_COPY:
+        case IR_PHI:
+            return true;
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        {
+            /* the runtime reports an error for anything but two numbers */
+            return resolve_ir_value(value->operands[0])->type == IR_TYPE_NUMBER
+                && resolve_ir_value(value->operands[1])->type == IR_TYPE_NUMBER;
+        }
+        case IR_DIV:
+        {
+            /* dividing is only pure when the divisor is known to not be zero */
+            ir_value* divisor = resolve_ir_value(value->operands[1]);
+            return resolve_ir_value(value->operands[0])->type == IR_TYPE_NUMBER
+                && divisor->opcode == IR_CONST_NUMBER
+                && divisor->constant.number != 0.0;
+        }
+        default:
+            return false;
+    }
+}
+
+const char* get_ir_opcode_name(ir_opcode opcode)
+{
+    switch (opcode)
+    {
+        case IR_CONST_NUMBER: return "const_number";
+        case IR_CONST_TEXT: return "const_text";
+        case IR_CONST_BIT: return "const_bit";
+        case IR_UNDEFINED: return "undefined";
+        case IR_ADD: return "add";
+        case IR_SUB: return "sub";
+        case IR_MUL: return "mul";
+        case IR_DIV: return "div";
+        case IR_COPY: return "copy";
+        case IR_PHI: return "phi";
+        case IR_BUILTIN_ERROR: return "builtin_error";
+        case IR_BUILTIN_WARNING: return "builtin_warning";
+        case IR_BUILTIN_DEBUG: return "builtin_debug";
+        case IR_BUILTIN_INFO: return "builtin_info";
+        case IR_CALL: return "call";
+        case IR_GRAB: return "grab";
+        case IR_RETURN: return "return";
+        case IR_JUMP: return "jump";
+        case IR_BRANCH: return "branch";
+        case IR_HALT: return "halt";
+        default: return "unknown";
+    }
+}
+
+const char* get_ir_type_name(ir_type type)
+{
+    switch (type)
+    {
+        case IR_TYPE_NONE: return "none";
+        case IR_TYPE_NUMBER: return "number";
+        case IR_TYPE_TEXT: return "text";
+        case IR_TYPE_BIT: return "bit";
+        case IR_TYPE_UNKNOWN: return "unknown";
+        default: return "invalid";
+    }
+}
+
+static void print_ir_value(ir_value* value)
+{
+    if (value->is_removed == true)
+    {
+        return;
+    }
+
+    printf("    v%d: %s = %s", value->id, get_ir_type_name(value->type), get_ir_opcode_name(value->opcode));
+    switch (value->opcode)
+    {
+        case IR_CONST_NUMBER: printf(" %g", value->constant.number); break;
+        case IR_CONST_TEXT: printf(" '%s'", value->constant.text); break;
+        case IR_GRAB: printf(" %s", value->constant.text); break;
+        case IR_CONST_BIT: printf(" %s", value->constant.bit ? "on" : "off"); break;
+        case IR_CALL: printf(" #%d", value->constant.function_index); break;
+        default: break;
+    }
+
+    for (int i = 0; i < value->operand_count; i++)
+    {
+        printf("%s v%d", i == 0 ? "" : ",", resolve_ir_value(value->operands[i])->id);
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        if (value->targets[i] != NULL)
+        {
+            printf(" -> b%d", value->targets[i]->id);
+        }
+    }
+    printf("\n");
+}
+
+void print_ir_function(ir_function* function)
+{
+    for (int block_index = 0; block_index < function->block_count; block_index++)
+    {
+        ir_block* block = function->blocks[block_index];
+        printf("  b%d:", block->id);
+        for (int i = 0; i < block->predecessor_count; i++)
+        {
+            printf("%s b%d", i == 0 ? " preds" : ",", block->predecessors[i]->id);
+        }
+        printf("\n");
+
+        for (int i = 0; i < block->phi_count; i++)
+        {
+            print_ir_value(block->phis[i]);
+        }
+        for (int i = 0; i < block->value_count; i++)
+        {
+            print_ir_value(block->values[i]);
+        }
+    }
+}
+
+void free_ir_function(ir_function* function)
+{
+    for (int i = 0; i < function->value_count; i++)
+    {
+        free(function->values[i]->operands);
+        safe_free(function->values[i]);
+    }
+    free(function->values);
+
+    for (int i = 0; i < function->block_count; i++)
+    {
+        ir_block* block = function->blocks[i];
+        free(block->phis);
+        free(block->values);
+        free(block->predecessors);
+        free(block->definitions);
+        safe_free(block);
+    }
+    free(function->blocks);
+
+    safe_free(function);
+}
\ No newline at end of file
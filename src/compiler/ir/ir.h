@@ -0,0 +1,208 @@
+#ifndef IR
+#define IR
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../../core/extensions/memory_extensions.h"
+#include "../../core/logger/logger.h"
+
+/// @enum ir_opcode
+/// @brief A collection of operations in the L# intermediate representation.
+typedef enum ir_opcode
+{
+    IR_CONST_NUMBER,
+    IR_CONST_TEXT,
+    IR_CONST_BIT,
+    IR_UNDEFINED,
+    IR_ADD,
+    IR_SUB,
+    IR_MUL,
+    IR_DIV,
+    IR_COPY,
+    IR_PHI,
+    IR_BUILTIN_ERROR,
+    IR_BUILTIN_WARNING,
+    IR_BUILTIN_DEBUG,
+    IR_BUILTIN_INFO,
+    IR_CALL,
+    IR_GRAB,
+    IR_RETURN,
+    IR_JUMP,
+    IR_BRANCH,
+    IR_HALT
+} ir_opcode;
+
+/// @enum ir_type
+/// @brief The L# type of the value an IR instruction produces.
+typedef enum ir_type
+{
+    IR_TYPE_NONE,
+    IR_TYPE_NUMBER,
+    IR_TYPE_TEXT,
+    IR_TYPE_BIT,
+    IR_TYPE_UNKNOWN
+} ir_type;
+
+/// @struct ir_value
+/// @brief A single static assignment: an IR instruction and the value it produces.
+typedef struct ir_value ir_value;
+
+/// @struct ir_block
+/// @brief A basic block, a straight-line run of IR instructions that ends in a terminator.
+typedef struct ir_block ir_block;
+
+/// @struct ir_function
+/// @brief A control flow graph of basic blocks.
+typedef struct ir_function ir_function;
+
+struct ir_value
+{
+    /// @brief A unique, dense number for the value within its function.
+    int id;
+    ir_opcode opcode;
+    ir_type type;
+    /// @brief The block that contains this value.
+    ir_block* block;
+    ir_value** operands;
+    int operand_count;
+    int operand_capacity;
+
+    /// @brief The payload of constants and operations that carry one.
+    union
+    {
+        double number;
+        const char* text;
+        bool bit;
+        int function_index;
+    } constant;
+
+    /// @brief The blocks a terminator transfers control to.
+    ir_block* targets[2];
+
+    /// @brief For a phi, the source variable it merges.
+    int variable;
+    /// @brief The value every use of this value should be forwarded to, or `NULL`.
+    ir_value* replacement;
+    /// @brief The amount of operands that refer to this value, kept up to date by `count_ir_uses`.
+    int use_count;
+    bool is_removed;
+    /// @brief The line and column of the source the value was built from, or 0 if it isn't known.
+    int line;
+    int column;
+};
+
+struct ir_block
+{
+    int id;
+    /// @brief The phi values at the top of the block, in the order they were created.
+    ir_value** phis;
+    int phi_count;
+    int phi_capacity;
+    /// @brief The non-phi values of the block, the last one is the terminator once the block is finished.
+    ir_value** values;
+    int value_count;
+    int value_capacity;
+    ir_block** predecessors;
+    int predecessor_count;
+    int predecessor_capacity;
+    /// @brief `true` once every predecessor of the block is known.
+    bool is_sealed;
+    /// @brief The current definition of every source variable in this block, used while building SSA form.
+    ir_value** definitions;
+    int definition_capacity;
+    /// @brief The block that immediately dominates this block, or `NULL` for the entry block.
+    ir_block* immediate_dominator;
+};
+
+struct ir_function
+{
+    ir_block** blocks;
+    int block_count;
+    int block_capacity;
+    /// @brief Every value ever created, indexed by id, so they can be freed together.
+    ir_value** values;
+    int value_count;
+    int value_capacity;
+    /// @brief The line and column of the source that new values are built from, or 0 if it isn't known.
+    int line;
+    int column;
+};
+
+/// @brief Creates an empty `ir_function`.
+/// @return A new IR function.
+ir_function* create_ir_function();
+
+/// @brief Creates an empty block and adds it to the `function`.
+/// @param function The IR function to add the block to.
+/// @return The new block.
+ir_block* create_ir_block(ir_function* function);
+
+/// @brief Records that control can flow from the `from` block to the `to` block.
+/// @param from The predecessor block.
+/// @param to The successor block.
+void add_ir_block_edge(ir_block* from, ir_block* to);
+
+/// @brief Creates a value and appends it to the end of the `block`.
+/// @param function The IR function that owns the value.
+/// @param block The block to append the value to.
+/// @param opcode The operation of the value.
+/// @param type The type of the value.
+/// @return The new value.
+ir_value* create_ir_value(ir_function* function, ir_block* block, ir_opcode opcode, ir_type type);
+
+/// @brief Creates a phi value at the top of the `block`.
+/// @param function The IR function that owns the value.
+/// @param block The block to add the phi to.
+/// @param variable The source variable the phi merges.
+/// @return The new phi.
+ir_value* create_ir_phi(ir_function* function, ir_block* block, int variable);
+
+/// @brief Adds the `operand` to the end of the `value` operands.
+/// @param value The value to add an operand to.
+/// @param operand The value being used.
+void add_ir_operand(ir_value* value, ir_value* operand);
+
+/// @brief Follows the replacements of the `value` to the value it was forwarded to.
+/// @param value The value to resolve.
+/// @return The value that should be used in place of `value`.
+ir_value* resolve_ir_value(ir_value* value);
+
+/// @brief Rewrites every operand of the `function` to its resolved value, and recounts how often each value is used.
+/// @param function The IR function to update.
+void count_ir_uses(ir_function* function);
+
+/// @brief Determines if the `opcode` ends a basic block.
+/// @param opcode The IR operation to check.
+/// @return `true` if the `opcode` is a terminator, `false` otherwise.
+bool is_ir_terminator(ir_opcode opcode);
+
+/// @brief Gets the blocks the terminator of the `block` can transfer control to.
+/// @param block The block to get the successors of.
+/// @param successors An array of at least two blocks to fill.
+/// @return The amount of successors, `0` if the block has no terminator or halts.
+int get_ir_successors(ir_block* block, ir_block** successors);
+
+/// @brief Determines if the `value` can be removed, moved or merged with an equal value without changing what the program does.
+/// @param value The value to check.
+/// @return `true` if computing the value has no side effects and can't fail, `false` otherwise.
+bool is_ir_value_pure(ir_value* value);
+
+/// @brief Gets a human-readable name of the `opcode`.
+/// @param opcode The IR operation to get a name for.
+/// @return The name of the `opcode`.
+const char* get_ir_opcode_name(ir_opcode opcode);
+
+/// @brief Gets a human-readable name of the `type`.
+/// @param type The IR type to get a name for.
+/// @return The name of the `type`.
+const char* get_ir_type_name(ir_type type);
+
+/// @brief Prints every block and value of the `function`.
+/// @param function The IR function to print.
+void print_ir_function(ir_function* function);
+
+/// @brief Deallocates the memory used for the `function`, its blocks and its values.
+/// @param function The IR function to free.
+void free_ir_function(ir_function* function);
+
+#endif
\ No newline at end of file
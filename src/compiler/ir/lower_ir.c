@@ -0,0 +1,434 @@
+#include "lower_ir.h"
+
+/**
+ * Lowering turns the IR back into stack bytecode. Constants are loaded again at every use,
+ * pure values used once in their own block are computed right where they are used, and
+ * every other value that is used gets a temporary variable slot. Phis also get a slot that
+ * every predecessor stores into before it jumps, which the variable allocator packs later.
+ */
+
+/// @struct ir_lowering
+/// @brief The state of the lowering while it emits bytecode for an IR function.
+typedef struct ir_lowering ir_lowering;
+
+struct ir_lowering
+{
+    ir_function* function;
+    bytecode_generator* generator;
+    /// @brief The variable slot of every value, indexed by id, or `-1` if it has none.
+    int* slots;
+    /// @brief `true` for every value, indexed by id, that is computed where it is used.
+    bool* is_inlined;
+    /// @brief The index of the first instruction of every block, indexed by id.
+    int* block_starts;
+    /// @brief The jump instructions that have to be pointed at the start of a block.
+    int* jump_indices;
+    ir_block** jump_targets;
+    int jump_count;
+    int jump_capacity;
+    /// @brief Maps text constants to their object index, so each string is only added once.
+    symbol_table* text_objects;
+};
+
+static void emit_value(ir_lowering* lowering, ir_value* value);
+
+static bool is_ir_constant(ir_value* value)
+{
+    return value->opcode == IR_CONST_NUMBER
+        || value->opcode == IR_CONST_TEXT
+        || value->opcode == IR_CONST_BIT
+        || value->opcode == IR_UNDEFINED;
+}
+
+/// @brief Determines if the bytecode for the `value` leaves its result on the stack.
+static bool is_ir_value_on_stack(ir_value* value)
+{
+    switch (value->opcode)
+    {
+        case IR_CONST_NUMBER:
+        case IR_CONST_TEXT:
+        case IR_CONST_BIT:
+        case IR_UNDEFINED:
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_DIV:
+        case IR_COPY:
+        case IR_PHI:
+            return true;
+        default:
+            /* builtins, calls and grabs don't push a result in the runtime yet */
+            return false;
+    }
+}
+
+static int get_text_object(ir_lowering* lowering, const char* text)
+{
+    symbol* text_symbol = lookup_symbol(lowering->text_objects, text);
+    if (text_symbol != NULL)
+    {
+        return text_symbol->index;
+    }
+
+    int object_index = add_object(lowering->generator, (char*)text);
+    if (object_index != -1)
+    {
+        insert_symbol(lowering->text_objects, text, SYMBOL_TEXT, object_index);
+    }
+
+    return object_index;
+}
+
+static void emit_jump(ir_lowering* lowering, op_code jump_op_code, ir_block* target)
+{
+    if (lowering->jump_count >= lowering->jump_capacity)
+    {
+        lowering->jump_capacity = (lowering->jump_capacity == 0) ? 8 : lowering->jump_capacity * 2;
+        lowering->jump_indices = (int*)realloc(lowering->jump_indices, lowering->jump_capacity * sizeof(int));
+        lowering->jump_targets = (ir_block**)realloc(lowering->jump_targets, lowering->jump_capacity * sizeof(ir_block*));
+        if (lowering->jump_indices == NULL || lowering->jump_targets == NULL)
+        {
+            log_error("Compiler error: Unable to grow the IR jump list.");
+            exit(-1);
+        }
+    }
+
+    /* the offset is patched once every block has been placed */
+    lowering->jump_indices[lowering->jump_count] = lowering->generator->instruction_count;
+    lowering->jump_targets[lowering->jump_count++] = target;
+    emit_instruction(lowering->generator, (instruction){jump_op_code, {.jump = {0}}, OP_TYPE_NULL});
+}
+
+static void emit_load_slot(ir_lowering* lowering, int slot)
+{
+    emit_instruction(lowering->generator, (instruction){OP_LOAD_VAR, {.variable = {slot}}, OP_TYPE_VARIABLE});
+}
+
+static void emit_store_slot(ir_lowering* lowering, int slot)
+{
+    emit_instruction(lowering->generator, (instruction){OP_STORE_VAR, {.variable = {slot}}, OP_TYPE_VARIABLE});
+}
+
+/// @brief Pushes the value of the `operand` onto the stack where it is used.
+static void emit_operand(ir_lowering* lowering, ir_value* operand)
+{
+    operand = resolve_ir_value(operand);
+    if (is_ir_constant(operand) == true || lowering->is_inlined[operand->id] == true)
+    {
+        emit_value(lowering, operand);
+    }
+    else if (lowering->slots[operand->id] != -1)
+    {
+        emit_load_slot(lowering, lowering->slots[operand->id]);
+    }
+    else
+    {
+        /* the operand doesn't produce a runtime value */
+        emit_instruction(lowering->generator, (instruction){OP_LOAD_CONST, {0}, OP_TYPE_NULL});
+    }
+}
+
+static void emit_operands(ir_lowering* lowering, ir_value* value)
+{
+    for (int i = 0; i < value->operand_count; i++)
+    {
+        emit_operand(lowering, value->operands[i]);
+    }
+}
+
+/// @brief Makes the instructions emitted from now on carry the source location of a value, if it has one.
+static void locate_instructions(bytecode_generator* generator, const ir_value* value)
+{
+    if (value->line > 0)
+    {
+        generator->location = (source_location){0, value->line, value->column};
+    }
+}
+
+/// @brief Emits the bytecode that computes the `value`, leaving its result on the stack if it has one.
+static void emit_value(ir_lowering* lowering, ir_value* value)
+{
+    bytecode_generator* generator = lowering->generator;
+    source_location outer_location = generator->location;
+    locate_instructions(generator, value);
+    switch (value->opcode)
+    {
+        case IR_CONST_NUMBER:
+        {
+            emit_instruction(generator, (instruction){OP_LOAD_CONST, {.d = value->constant.number}, OP_TYPE_NUMBER});
+            break;
+        }
+        case IR_CONST_TEXT:
+        {
+            emit_instruction(generator, (instruction){OP_LOAD_CONST, {.i = get_text_object(lowering, value->constant.text)}, OP_TYPE_TEXT});
+            break;
+        }
+        case IR_CONST_BIT:
+        {
+            emit_instruction(generator, (instruction){OP_LOAD_CONST, {.b = value->constant.bit}, OP_TYPE_BIT});
+            break;
+        }
+        case IR_UNDEFINED:
+        {
+            emit_instruction(generator, (instruction){OP_LOAD_CONST, {0}, OP_TYPE_NULL});
+            break;
+        }
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_DIV:
+        {
+            emit_operands(lowering, value);
+            op_code opcode = value->opcode == IR_ADD ? OP_ADD
+                : value->opcode == IR_SUB ? OP_SUB
+                : value->opcode == IR_MUL ? OP_MUL
+                : OP_DIV;
+            emit_instruction(generator, (instruction){opcode, {0}});
+            break;
+        }
+        case IR_COPY:
+        {
+            emit_operands(lowering, value);
+            break;
+        }
+        case IR_BUILTIN_ERROR:
+        case IR_BUILTIN_WARNING:
+        case IR_BUILTIN_DEBUG:
+        case IR_BUILTIN_INFO:
+        {
+            emit_operands(lowering, value);
+            op_code opcode = value->opcode == IR_BUILTIN_ERROR ? OP_BUILTIN_ERROR
+                : value->opcode == IR_BUILTIN_WARNING ? OP_BUILTIN_WARNING
+                : value->opcode == IR_BUILTIN_DEBUG ? OP_BUILTIN_DEBUG
+                : OP_BUILTIN_INFO;
+            emit_instruction(generator, (instruction){opcode, {0}, OP_TYPE_NULL});
+            break;
+        }
+        case IR_CALL:
+        {
+            emit_operands(lowering, value);
+            emit_instruction(generator, (instruction){OP_CALL, {.call = {value->constant.function_index}}});
+            break;
+        }
+        case IR_GRAB:
+        {
+            emit_instruction(generator, (instruction){OP_GRAB, {.i = get_text_object(lowering, value->constant.text)}, OP_TYPE_TEXT});
+            break;
+        }
+        case IR_RETURN:
+        {
+            emit_operands(lowering, value);
+            emit_instruction(generator, (instruction){OP_RETURN, {0}});
+            break;
+        }
+        case IR_HALT:
+        {
+            emit_instruction(generator, (instruction){OP_HALT, {0}});
+            break;
+        }
+        default:
+        {
+            log_error("Compiler error: Unable to lower IR operation \"%s\".", get_ir_opcode_name(value->opcode));
+            break;
+        }
+    }
+    generator->location = outer_location;
+}
+
+/// @brief Stores the phi operands that flow along the edge from `block` into the phis of `target`.
+static void emit_phi_copies(ir_lowering* lowering, ir_block* block, ir_block* target)
+{
+    int predecessor_index = -1;
+    for (int i = 0; i < target->predecessor_count; i++)
+    {
+        if (target->predecessors[i] == block)
+        {
+            predecessor_index = i;
+            break;
+        }
+    }
+    if (predecessor_index == -1)
+    {
+        return;
+    }
+
+    /* every operand is pushed before any phi is stored, so phis that read each other see the old values */
+    int copy_count = 0;
+    for (int i = 0; i < target->phi_count; i++)
+    {
+        ir_value* phi = target->phis[i];
+        if (phi->is_removed == false && lowering->slots[phi->id] != -1)
+        {
+            emit_operand(lowering, phi->operands[predecessor_index]);
+            copy_count++;
+        }
+    }
+    for (int i = target->phi_count - 1; i >= 0 && copy_count > 0; i--)
+    {
+        ir_value* phi = target->phis[i];
+        if (phi->is_removed == false && lowering->slots[phi->id] != -1)
+        {
+            emit_store_slot(lowering, lowering->slots[phi->id]);
+            copy_count--;
+        }
+    }
+}
+
+static void emit_terminator(ir_lowering* lowering, ir_block* block, ir_value* terminator)
+{
+    switch (terminator->opcode)
+    {
+        case IR_JUMP:
+        {
+            emit_phi_copies(lowering, block, terminator->targets[0]);
+            emit_jump(lowering, OP_JMP, terminator->targets[0]);
+            break;
+        }
+        case IR_BRANCH:
+        {
+            /**
+             * targets[0] is taken when the condition is on, targets[1] when it is off.
+             * Each edge gets its own copies, which splits critical edges in place.
+             */
+            emit_operands(lowering, terminator);
+            int branch_index = lowering->generator->instruction_count;
+            emit_instruction(lowering->generator, (instruction){OP_JMP_IF_FALSE, {.jump = {0}}, OP_TYPE_NULL});
+
+            emit_phi_copies(lowering, block, terminator->targets[0]);
+            emit_jump(lowering, OP_JMP, terminator->targets[0]);
+
+            lowering->generator->instructions[branch_index].operand.jump.jump_offset = lowering->generator->instruction_count - (branch_index + 1);
+            emit_phi_copies(lowering, block, terminator->targets[1]);
+            emit_jump(lowering, OP_JMP, terminator->targets[1]);
+            break;
+        }
+        default:
+        {
+            emit_value(lowering, terminator);
+            break;
+        }
+    }
+}
+
+/// @brief Decides which values are computed where they are used, and gives a slot to every other value that is used.
+static void assign_value_locations(ir_lowering* lowering)
+{
+    ir_function* function = lowering->function;
+
+    /* find the only user of every value that is used once */
+    ir_value** single_users = (ir_value**)safe_malloc((function->value_count + 1) * sizeof(ir_value*));
+    for (int i = 0; i < function->value_count; i++)
+    {
+        single_users[i] = NULL;
+        lowering->slots[i] = -1;
+        lowering->is_inlined[i] = false;
+    }
+    for (int i = 0; i < function->value_count; i++)
+    {
+        ir_value* value = function->values[i];
+        if (value->is_removed == true)
+        {
+            continue;
+        }
+        for (int j = 0; j < value->operand_count; j++)
+        {
+            ir_value* operand = resolve_ir_value(value->operands[j]);
+            if (operand->use_count == 1)
+            {
+                single_users[operand->id] = value;
+            }
+        }
+    }
+
+    for (int i = 0; i < function->value_count; i++)
+    {
+        ir_value* value = function->values[i];
+        if (value->is_removed == true || value->use_count == 0 || is_ir_constant(value) == true || is_ir_value_on_stack(value) == false)
+        {
+            continue;
+        }
+
+        /* phi operands are read at the end of a predecessor, so only a user in the same block can compute the value in place */
+        ir_value* user = single_users[i];
+        if (value->opcode != IR_PHI && is_ir_value_pure(value) == true && user != NULL && user->opcode != IR_PHI && user->block == value->block)
+        {
+            lowering->is_inlined[i] = true;
+            continue;
+        }
+
+        lowering->slots[i] = lowering->generator->variable_count++;
+    }
+
+    safe_free(single_users);
+}
+
+int lower_ir(ir_function* function, bytecode_generator* generator)
+{
+    ir_lowering lowering;
+    lowering.function = function;
+    lowering.generator = generator;
+    lowering.slots = (int*)safe_malloc((function->value_count + 1) * sizeof(int));
+    lowering.is_inlined = (bool*)safe_malloc((function->value_count + 1) * sizeof(bool));
+    lowering.block_starts = (int*)safe_malloc((function->block_count + 1) * sizeof(int));
+    lowering.jump_indices = NULL;
+    lowering.jump_targets = NULL;
+    lowering.jump_count = 0;
+    lowering.jump_capacity = 0;
+    lowering.text_objects = create_symbol_table(100);
+
+    int first_instruction = generator->instruction_count;
+    assign_value_locations(&lowering);
+
+    for (int block_index = 0; block_index < function->block_count; block_index++)
+    {
+        ir_block* block = function->blocks[block_index];
+        lowering.block_starts[block->id] = generator->instruction_count;
+
+        for (int i = 0; i < block->value_count; i++)
+        {
+            ir_value* value = block->values[i];
+            if (value->is_removed == true || is_ir_constant(value) == true || lowering.is_inlined[value->id] == true)
+            {
+                continue;
+            }
+
+            locate_instructions(generator, value);
+            if (i == block->value_count - 1 && is_ir_terminator(value->opcode) == true)
+            {
+                emit_terminator(&lowering, block, value);
+                continue;
+            }
+
+            /* pure values that nothing uses would only be popped again */
+            if (value->use_count == 0 && is_ir_value_pure(value) == true)
+            {
+                continue;
+            }
+
+            emit_value(&lowering, value);
+            if (lowering.slots[value->id] != -1)
+            {
+                emit_store_slot(&lowering, lowering.slots[value->id]);
+            }
+            else if (is_ir_value_on_stack(value) == true)
+            {
+                emit_instruction(generator, (instruction){OP_POP, {0}});
+            }
+        }
+    }
+
+    for (int i = 0; i < lowering.jump_count; i++)
+    {
+        int index = lowering.jump_indices[i];
+        generator->instructions[index].operand.jump.jump_offset = lowering.block_starts[lowering.jump_targets[i]->id] - (index + 1);
+    }
+
+    free(lowering.jump_indices);
+    free(lowering.jump_targets);
+    free_symbol_table(lowering.text_objects);
+    safe_free(lowering.slots);
+    safe_free(lowering.is_inlined);
+    safe_free(lowering.block_starts);
+
+    return generator->instruction_count - first_instruction;
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#ifndef LOWER_IR
+#define LOWER_IR
+#include <stdbool.h>
+#include <stdlib.h>
+#include "../../core/extensions/memory_extensions.h"
+#include "../../core/logger/logger.h"
+#include "../../core/types/bytecode.h"
+#include "../../core/types/symbol_table.h"
+#include "../bytecode_generator/bytecode_generator.h"
+#include "ir.h"
+
+/// @brief Emits stack bytecode for the `function` into the `generator`.
+/// @param function The IR function to lower, its use counts have to be up to date.
+/// @param generator The `bytecode_generator` to emit the instructions, objects and variable slots into.
+/// @return The amount of instructions that were emitted.
+int lower_ir(ir_function* function, bytecode_generator* generator);
+
+#endif
\ No newline at end of file
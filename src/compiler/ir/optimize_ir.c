@@ -0,0 +1,468 @@
+#include "optimize_ir.h"
+
+/// @brief The fewest buckets in the table of available expressions, which grows with the function and is always a power of two.
+#define MINIMUM_AVAILABLE_EXPRESSION_BUCKETS 256
+
+/// @struct available_expression
+/// @brief A value that is available to replace equal values in the blocks it dominates.
+typedef struct available_expression available_expression;
+
+struct available_expression
+{
+    ir_value* value;
+    struct available_expression* next;
+};
+
+/// @struct available_expression_table
+/// @brief A hash table of available expressions, scoped to the dominator tree walk.
+typedef struct available_expression_table available_expression_table;
+
+struct available_expression_table
+{
+    available_expression** buckets;
+    /// @brief The amount of buckets minus one, to mask a hash with.
+    uint64_t bucket_mask;
+    /// @brief Every entry that was added, in order, so a scope can be popped.
+    available_expression* entries;
+    /// @brief The bucket of every entry, in the same order as `entries`.
+    unsigned int* entry_buckets;
+    int entry_count;
+};
+
+static void add_reverse_postorder(ir_block* block, bool* visited, ir_block** order, int* order_count)
+{
+    visited[block->id] = true;
+
+    ir_block* successors[2];
+    int successor_count = get_ir_successors(block, successors);
+    for (int i = 0; i < successor_count; i++)
+    {
+        if (visited[successors[i]->id] == false)
+        {
+            add_reverse_postorder(successors[i], visited, order, order_count);
+        }
+    }
+
+    /* blocks are added in postorder, the caller walks the array backwards */
+    order[(*order_count)++] = block;
+}
+
+static ir_block* intersect_dominators(ir_block* first, ir_block* second, const int* postorder_numbers)
+{
+    while (first != second)
+    {
+        while (postorder_numbers[first->id] < postorder_numbers[second->id])
+        {
+            first = first->immediate_dominator;
+        }
+        while (postorder_numbers[second->id] < postorder_numbers[first->id])
+        {
+            second = second->immediate_dominator;
+        }
+    }
+
+    return first;
+}
+
+void compute_ir_dominators(ir_function* function)
+{
+    if (function->block_count == 0)
+    {
+        return;
+    }
+
+    /* "A Simple, Fast Dominance Algorithm" (Cooper, Harvey and Kennedy) */
+    bool* visited = (bool*)safe_malloc(function->block_count * sizeof(bool));
+    int* postorder_numbers = (int*)safe_malloc(function->block_count * sizeof(int));
+    ir_block** postorder = (ir_block**)safe_malloc(function->block_count * sizeof(ir_block*));
+    int postorder_count = 0;
+    for (int i = 0; i < function->block_count; i++)
+    {
+        visited[i] = false;
+        postorder_numbers[i] = -1;
+        function->blocks[i]->immediate_dominator = NULL;
+    }
+
+    ir_block* entry = function->blocks[0];
+    add_reverse_postorder(entry, visited, postorder, &postorder_count);
+    for (int i = 0; i < postorder_count; i++)
+    {
+        postorder_numbers[postorder[i]->id] = i;
+    }
+
+    entry->immediate_dominator = entry;
+    bool changed = true;
+    while (changed == true)
+    {
+        changed = false;
+        for (int i = postorder_count - 2; i >= 0; i--)
+        {
+            ir_block* block = postorder[i];
+            ir_block* new_dominator = NULL;
+            for (int j = 0; j < block->predecessor_count; j++)
+            {
+                ir_block* predecessor = block->predecessors[j];
+                if (predecessor->immediate_dominator == NULL)
+                {
+                    /* not processed yet, or unreachable */
+                    continue;
+                }
+                new_dominator = new_dominator == NULL
+                    ? predecessor
+                    : intersect_dominators(predecessor, new_dominator, postorder_numbers);
+            }
+
+            if (block->immediate_dominator != new_dominator)
+            {
+                block->immediate_dominator = new_dominator;
+                changed = true;
+            }
+        }
+    }
+    entry->immediate_dominator = NULL;
+
+    safe_free(visited);
+    safe_free(postorder_numbers);
+    safe_free(postorder);
+}
+
+static int propagate_copies(ir_function* function)
+{
+    int propagated_count = 0;
+    for (int i = 0; i < function->value_count; i++)
+    {
+        ir_value* value = function->values[i];
+        if (value->is_removed == false && value->opcode == IR_COPY)
+        {
+            /* the runtime is dynamically typed, so a copy never changes the value */
+            value->replacement = value->operands[0];
+            value->is_removed = true;
+            propagated_count++;
+        }
+    }
+
+    return propagated_count;
+}
+
+static int remove_trivial_phis(ir_function* function)
+{
+    int removed_count = 0;
+    bool changed = true;
+    while (changed == true)
+    {
+        changed = false;
+        for (int block_index = 0; block_index < function->block_count; block_index++)
+        {
+            ir_block* block = function->blocks[block_index];
+            for (int i = 0; i < block->phi_count; i++)
+            {
+                ir_value* phi = block->phis[i];
+                if (phi->is_removed == true)
+                {
+                    continue;
+                }
+
+                ir_value* same = NULL;
+                bool is_trivial = true;
+                for (int j = 0; j < phi->operand_count; j++)
+                {
+                    ir_value* operand = resolve_ir_value(phi->operands[j]);
+                    if (operand == phi || operand == same)
+                    {
+                        continue;
+                    }
+                    if (same != NULL)
+                    {
+                        is_trivial = false;
+                        break;
+                    }
+                    same = operand;
+                }
+
+                /* a phi that only refers to itself is left for dead code elimination */
+                if (is_trivial == true && same != NULL)
+                {
+                    phi->replacement = same;
+                    phi->is_removed = true;
+                    removed_count++;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    return removed_count;
+}
+
+static bool is_common_subexpression_candidate(ir_value* value)
+{
+    return value->is_removed == false
+        && value->opcode != IR_PHI
+        && value->opcode != IR_COPY
+        && is_ir_value_pure(value);
+}
+
+static unsigned int hash_ir_value(ir_value* value, uint64_t bucket_mask)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    hash = (hash ^ (uint64_t)value->opcode) * 1099511628211ULL;
+    switch (value->opcode)
+    {
+        case IR_CONST_NUMBER:
+        {
+            uint64_t bits;
+            memcpy(&bits, &value->constant.number, sizeof(bits));
+            hash = (hash ^ bits) * 1099511628211ULL;
+            break;
+        }
+        case IR_CONST_TEXT:
+        {
+            for (const char* character = value->constant.text; *character != '\0'; character++)
+            {
+                hash = (hash ^ (unsigned char)*character) * 1099511628211ULL;
+            }
+            break;
+        }
+        case IR_CONST_BIT:
+        {
+            hash = (hash ^ (uint64_t)value->constant.bit) * 1099511628211ULL;
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+
+    for (int i = 0; i < value->operand_count; i++)
+    {
+        hash = (hash ^ (uint64_t)resolve_ir_value(value->operands[i])->id) * 1099511628211ULL;
+    }
+
+    /* whole numbers differ only in the high bits of a double, so those are mixed into the bits the mask keeps */
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    return (unsigned int)(hash & bucket_mask);
+}
+
+static bool are_ir_values_equal(ir_value* first, ir_value* second)
+{
+    if (first->opcode != second->opcode || first->operand_count != second->operand_count)
+    {
+        return false;
+    }
+
+    switch (first->opcode)
+    {
+        case IR_CONST_NUMBER:
+        {
+            /* compare the bits so 0 and -0 stay apart */
+            return memcmp(&first->constant.number, &second->constant.number, sizeof(double)) == 0;
+        }
+        case IR_CONST_TEXT:
+        {
+            return strcmp(first->constant.text, second->constant.text) == 0;
+        }
+        case IR_CONST_BIT:
+        {
+            return first->constant.bit == second->constant.bit;
+        }
+        default:
+        {
+            break;
+        }
+    }
+
+    for (int i = 0; i < first->operand_count; i++)
+    {
+        if (resolve_ir_value(first->operands[i]) != resolve_ir_value(second->operands[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// @brief Replaces the values of the `block` that equal a value available from a dominating block, then visits the blocks it immediately dominates.
+static int eliminate_block_subexpressions(ir_function* function, ir_block* block, available_expression_table* table)
+{
+    int eliminated_count = 0;
+    int scope_start = table->entry_count;
+
+    for (int i = 0; i < block->value_count; i++)
+    {
+        ir_value* value = block->values[i];
+        if (is_common_subexpression_candidate(value) == false)
+        {
+            continue;
+        }
+
+        unsigned int bucket = hash_ir_value(value, table->bucket_mask);
+        ir_value* available_value = NULL;
+        for (available_expression* entry = table->buckets[bucket]; entry != NULL; entry = entry->next)
+        {
+            if (are_ir_values_equal(entry->value, value) == true)
+            {
+                available_value = entry->value;
+                break;
+            }
+        }
+
+        if (available_value != NULL)
+        {
+            value->replacement = available_value;
+            value->is_removed = true;
+            eliminated_count++;
+            continue;
+        }
+
+        available_expression* entry = &table->entries[table->entry_count];
+        entry->value = value;
+        entry->next = table->buckets[bucket];
+        table->buckets[bucket] = entry;
+        table->entry_buckets[table->entry_count++] = bucket;
+    }
+
+    for (int i = 0; i < function->block_count; i++)
+    {
+        if (function->blocks[i]->immediate_dominator == block)
+        {
+            eliminated_count += eliminate_block_subexpressions(function, function->blocks[i], table);
+        }
+    }
+
+    /* leaving the block, its values no longer dominate what is visited next */
+    while (table->entry_count > scope_start)
+    {
+        unsigned int bucket = table->entry_buckets[--table->entry_count];
+        table->buckets[bucket] = table->buckets[bucket]->next;
+    }
+
+    return eliminated_count;
+}
+
+static int eliminate_common_subexpressions(ir_function* function)
+{
+    if (function->block_count == 0)
+    {
+        return 0;
+    }
+
+    compute_ir_dominators(function);
+
+    /* at least a bucket for every value, so chains stay short however large the function is */
+    size_t bucket_count = MINIMUM_AVAILABLE_EXPRESSION_BUCKETS;
+    while (bucket_count < (size_t)function->value_count)
+    {
+        bucket_count <<= 1;
+    }
+
+    available_expression_table table;
+    table.buckets = (available_expression**)safe_malloc(bucket_count * sizeof(available_expression*));
+    for (size_t i = 0; i < bucket_count; i++)
+    {
+        table.buckets[i] = NULL;
+    }
+    table.bucket_mask = bucket_count - 1;
+    table.entries = (available_expression*)safe_malloc((function->value_count + 1) * sizeof(available_expression));
+    table.entry_buckets = (unsigned int*)safe_malloc((function->value_count + 1) * sizeof(unsigned int));
+    table.entry_count = 0;
+
+    int eliminated_count = eliminate_block_subexpressions(function, function->blocks[0], &table);
+
+    safe_free(table.buckets);
+    safe_free(table.entries);
+    safe_free(table.entry_buckets);
+    return eliminated_count;
+}
+
+static void mark_live_value(ir_value* value, bool* is_live)
+{
+    value = resolve_ir_value(value);
+    if (is_live[value->id] == true)
+    {
+        return;
+    }
+
+    is_live[value->id] = true;
+    for (int i = 0; i < value->operand_count; i++)
+    {
+        mark_live_value(value->operands[i], is_live);
+    }
+}
+
+static int eliminate_dead_values(ir_function* function)
+{
+    /* mark everything reachable from a value with side effects, then sweep the rest */
+    bool* is_live = (bool*)safe_malloc((function->value_count + 1) * sizeof(bool));
+    for (int i = 0; i < function->value_count; i++)
+    {
+        is_live[i] = false;
+    }
+
+    for (int i = 0; i < function->value_count; i++)
+    {
+        ir_value* value = function->values[i];
+        if (value->is_removed == false && is_ir_value_pure(value) == false)
+        {
+            mark_live_value(value, is_live);
+        }
+    }
+
+    int removed_count = 0;
+    for (int i = 0; i < function->value_count; i++)
+    {
+        ir_value* value = function->values[i];
+        if (value->is_removed == false && is_live[i] == false)
+        {
+            value->is_removed = true;
+            removed_count++;
+        }
+    }
+
+    safe_free(is_live);
+    return removed_count;
+}
+
+static int count_ir_values(ir_function* function)
+{
+    int value_count = 0;
+    for (int i = 0; i < function->value_count; i++)
+    {
+        if (function->values[i]->is_removed == false)
+        {
+            value_count++;
+        }
+    }
+
+    return value_count;
+}
+
+int optimize_ir(ir_function* function, optimization_statistics* statistics)
+{
+    int values_before = count_ir_values(function);
+
+    int copies_propagated = propagate_copies(function);
+    int phis_removed = remove_trivial_phis(function);
+    int common_subexpressions = eliminate_common_subexpressions(function);
+    /* merged values can leave phis that only merge one value */
+    phis_removed += remove_trivial_phis(function);
+    int dead_values = eliminate_dead_values(function);
+
+    count_ir_uses(function);
+    int values_after = count_ir_values(function);
+
+    if (statistics != NULL)
+    {
+        statistics->ir_values_before = values_before;
+        statistics->ir_values_after = values_after;
+        statistics->ir_copies_propagated = copies_propagated;
+        statistics->ir_phis_removed = phis_removed;
+        statistics->ir_common_subexpressions = common_subexpressions;
+        statistics->ir_dead_values = dead_values;
+    }
+
+    return values_before - values_after;
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#ifndef OPTIMIZE_IR
+#define OPTIMIZE_IR
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../core/extensions/memory_extensions.h"
+#include "../optimizer/optimization_statistics.h"
+#include "ir.h"
+
+/// @brief Computes the immediate dominator of every block in the `function` that is reachable from its entry block.
+/// @param function The IR function to compute dominators for.
+void compute_ir_dominators(ir_function* function);
+
+/// @brief Runs copy propagation, trivial phi removal, common subexpression elimination and dead code elimination over the `function`.
+/// @param function The IR function to optimize.
+/// @param statistics The optimization statistics to fill while optimizing, can be `NULL`.
+/// @return The amount of values that were removed.
+int optimize_ir(ir_function* function, optimization_statistics* statistics);
+
+#endif
\ No newline at end of file
@@ -112,80 +112,16 @@ static char* get_string_literal(char* source, int* position)
     return string;
 }
 
-static token* get_next_token(char* source, int* position, int* line, int* column)
+/// @brief Reads the token that starts at the `position`, which moves past it.
+static token* read_token(char* source, int* position, int line, int column)
 {
-    /* check for end of file at the very beginning */
-    if (source[*position] == '\0')
-    {
-        return create_token(TOKEN_END_OF_FILE, NULL, *line, *column);
-    }
-
-    /* loop to handle skipping comments and whitespace, to avoid recursion */
-    while (true)
-    {
-        /* skip whitespace */
-        while (isspace(source[*position]))
-        {
-            if (source[*position] == '\n')
-            {
-                (*line)++;
-                (*column) = 1;
-                (*position)++;
-                continue;
-            }
-            (*column)++;
-            (*position)++;
-        }
-
-        /* check for multi-line comments */
-        if (source[*position] == '/' && source[*position + 1] == '*')
-        {
-            /* multi-line comment found, skip beginning comment indicator */
-            (*position) += 2;
-            while (source[*position] != '\0' && !(source[*position] == '*' && source[*position + 1] == '/'))
-            {
-                if (source[*position] == '\n')
-                {
-                    (*line)++;
-                    (*column) = 1;
-                    (*position)++;
-                    continue;
-                }
-                (*column)++;
-                (*position)++;
-            }
-
-            /* skip ending comment indicator */
-            if (source[*position] == '*' && source[*position + 1] == '/')
-            {
-                (*position) += 2;
-            }
-            else
-            {
-                /* guard for unterminated comment */
-                return create_token(TOKEN_ERROR, "Unterminated comment", *line, *column);
-            }
-
-            /* skip the rest of the tokenizing code and go to the beginning of the while loop */
-            continue;
-        }
-
-        /* no comment or whitespace, exit the while loop */
-        break;
-    }
-
-    /* check for end of file again, in case it was reached during comment or whitespace */
-    if (source[*position] == '\0') {
-        return create_token(TOKEN_END_OF_FILE, NULL, *line, *column);
-    }
-
     /* check for keywords and identifiers */
     if (isalpha(source[*position]))
     {
         char* identifier = get_identifier(source, position);
         if (identifier == NULL)
         {
-            return create_token(TOKEN_ERROR, NULL, *line, *column);
+            return create_token(TOKEN_ERROR, NULL, line, column);
         }
 
         if (is_keyword(identifier))
@@ -206,7 +142,7 @@ static token* get_next_token(char* source, int* position, int* line, int* column
             else if (strcmp(identifier, "on") == 0) keyword_type = TOKEN_BIT_LITERAL_ON;
             else if (strcmp(identifier, "off") == 0) keyword_type = TOKEN_BIT_LITERAL_OFF;
 
-            token* token = create_token(keyword_type, identifier, *line, *column);
+            token* token = create_token(keyword_type, identifier, line, column);
 
             safe_free(identifier);
 
@@ -214,7 +150,7 @@ static token* get_next_token(char* source, int* position, int* line, int* column
         }
 
         /* if it wasn't a keyword, it has to be an identifier */
-        token* token = create_token(TOKEN_IDENTIFIER, identifier, *line, *column);
+        token* token = create_token(TOKEN_IDENTIFIER, identifier, line, column);
 
         safe_free(identifier);
 
@@ -244,7 +180,7 @@ static token* get_next_token(char* source, int* position, int* line, int* column
             if (has_decimal)
             {
                 /* multiple decimal points, error */
-                return create_token(TOKEN_ERROR, "Invalid number format", *line, *column);
+                return create_token(TOKEN_ERROR, "Invalid number format", line, column);
             }
 
             /* mark as decimal if decimal found */
@@ -259,12 +195,12 @@ static token* get_next_token(char* source, int* position, int* line, int* column
             char* number = (char*)safe_malloc((length + 1) * sizeof(char));
             memcpy(number, &source[start_pos], length);
             number[length] = '\0';
-            return create_token(TOKEN_NUMBER_LITERAL, number, *line, *column);
+            return create_token(TOKEN_NUMBER_LITERAL, number, line, column);
         }
 
         /* it's just a period, correct position and send back punctuation */
         (*position) = start_pos + 1;
-        return create_token(TOKEN_PUNCTUATION_PERIOD, ".", *line, *column);
+        return create_token(TOKEN_PUNCTUATION_PERIOD, ".", line, column);
     }
 
     /* check for string literals */
@@ -273,10 +209,10 @@ static token* get_next_token(char* source, int* position, int* line, int* column
         char* string = get_string_literal(source, position);
         if (string == NULL)
         {
-            return create_token(TOKEN_ERROR, NULL, *line, *column);
+            return create_token(TOKEN_ERROR, NULL, line, column);
         }
 
-        token* token = create_token(TOKEN_STRING_LITERAL, string, *line, *column);
+        token* token = create_token(TOKEN_STRING_LITERAL, string, line, column);
 
         safe_free(string);
 
@@ -292,7 +228,7 @@ static token* get_next_token(char* source, int* position, int* line, int* column
          * and any variables inside of it. for now, just return a token for the start.
          */
         (*position)++;
-        return create_token(TOKEN_STRING_TEMPLATE_START, "`", *line, *column);
+        return create_token(TOKEN_STRING_TEMPLATE_START, "`", line, column);
     }
 
     /* check for operators and punctuation */
@@ -300,41 +236,118 @@ static token* get_next_token(char* source, int* position, int* line, int* column
     {
         case '=':
             (*position)++;
-            return create_token(TOKEN_OPERATOR_ASSIGN, "=", *line, *column);
+            return create_token(TOKEN_OPERATOR_ASSIGN, "=", line, column);
         case '+':
             (*position)++;
-            return create_token(TOKEN_OPERATOR_PLUS, "+", *line, *column);
+            return create_token(TOKEN_OPERATOR_PLUS, "+", line, column);
         case '-':
             (*position)++;
-            return create_token(TOKEN_OPERATOR_MINUS, "-", *line, *column);
+            return create_token(TOKEN_OPERATOR_MINUS, "-", line, column);
         case '*':
             (*position)++;
-            return create_token(TOKEN_OPERATOR_MULTIPLY, "*", *line, *column);
+            return create_token(TOKEN_OPERATOR_MULTIPLY, "*", line, column);
         case '/':
             (*position)++;
-            return create_token(TOKEN_OPERATOR_DIVIDE, "/", *line, *column);
+            return create_token(TOKEN_OPERATOR_DIVIDE, "/", line, column);
         case '.':
             (*position)++;
-            return create_token(TOKEN_PUNCTUATION_PERIOD, ".", *line, *column);
+            return create_token(TOKEN_PUNCTUATION_PERIOD, ".", line, column);
         case ',':
             (*position)++;
-            return create_token(TOKEN_PUNCTUATION_COMMA, ",", *line, *column);
+            return create_token(TOKEN_PUNCTUATION_COMMA, ",", line, column);
         case '(':
             (*position)++;
-            return create_token(TOKEN_PUNCTUATION_OPEN_PAREN, "(", *line, *column);
+            return create_token(TOKEN_PUNCTUATION_OPEN_PAREN, "(", line, column);
         case ')':
             (*position)++;
-            return create_token(TOKEN_PUNCTUATION_CLOSE_PAREN, ")", *line, *column);
+            return create_token(TOKEN_PUNCTUATION_CLOSE_PAREN, ")", line, column);
         case '[':
             (*position)++;
-            return create_token(TOKEN_PUNCTUATION_OPEN_BRACKET, "[", *line, *column);
+            return create_token(TOKEN_PUNCTUATION_OPEN_BRACKET, "[", line, column);
         case ']':
             (*position)++;
-            return create_token(TOKEN_PUNCTUATION_CLOSE_BRACKET, "]", *line, *column);
+            return create_token(TOKEN_PUNCTUATION_CLOSE_BRACKET, "]", line, column);
         default:
             (*position)++;
-            return create_token(TOKEN_ERROR, NULL, *line, *column);
+            return create_token(TOKEN_ERROR, NULL, line, column);
+    }
+}
+
+static token* get_next_token(char* source, int* position, int* line, int* column)
+{
+    /* check for end of file at the very beginning */
+    if (source[*position] == '\0')
+    {
+        return create_token(TOKEN_END_OF_FILE, NULL, *line, *column);
+    }
+
+    /* loop to handle skipping comments and whitespace, to avoid recursion */
+    while (true)
+    {
+        /* skip whitespace */
+        while (isspace(source[*position]))
+        {
+            if (source[*position] == '\n')
+            {
+                (*line)++;
+                (*column) = 1;
+                (*position)++;
+                continue;
+            }
+            (*column)++;
+            (*position)++;
+        }
+
+        /* check for multi-line comments */
+        if (source[*position] == '/' && source[*position + 1] == '*')
+        {
+            /* multi-line comment found, skip beginning comment indicator */
+            (*position) += 2;
+            (*column) += 2;
+            while (source[*position] != '\0' && !(source[*position] == '*' && source[*position + 1] == '/'))
+            {
+                if (source[*position] == '\n')
+                {
+                    (*line)++;
+                    (*column) = 1;
+                    (*position)++;
+                    continue;
+                }
+                (*column)++;
+                (*position)++;
+            }
+
+            /* skip ending comment indicator */
+            if (source[*position] == '*' && source[*position + 1] == '/')
+            {
+                (*position) += 2;
+                (*column) += 2;
+            }
+            else
+            {
+                /* guard for unterminated comment */
+                return create_token(TOKEN_ERROR, "Unterminated comment", *line, *column);
+            }
+
+            /* skip the rest of the tokenizing code and go to the beginning of the while loop */
+            continue;
+        }
+
+        /* no comment or whitespace, exit the while loop */
+        break;
+    }
+
+    /* check for end of file again, in case it was reached during comment or whitespace */
+    if (source[*position] == '\0') {
+        return create_token(TOKEN_END_OF_FILE, NULL, *line, *column);
     }
+
+    /* the column only moves past the token once it is read, so the token starts where the skipped characters end */
+    int token_start = *position;
+    token* next_token = read_token(source, position, *line, *column);
+    *column += *position - token_start;
+
+    return next_token;
 }
 
 token** get_tokens(char* source, size_t* token_count)
@@ -0,0 +1,428 @@
+#include "link_bytecode.h"
+
+/// @brief The code, constants, strings and debug info of a compiled .lbc file, decompressed where they had to be.
+typedef struct
+{
+    const unsigned char* records;
+    size_t record_count;
+    const unsigned char* views;
+    size_t view_count;
+    const char* text;
+    size_t text_size;
+    /// @brief The line table, or `NULL` if the file has no debug info.
+    const unsigned char* debug_info;
+    size_t debug_info_size;
+    uint32_t row_count;
+    int32_t variable_count;
+    unsigned char* allocations[4];
+} UNIT_SECTIONS;
+
+static void release_unit_sections(UNIT_SECTIONS* sections)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        if (sections->allocations[i] != NULL)
+        {
+            safe_free(sections->allocations[i]);
+        }
+    }
+}
+
+/// @brief Verifies and loads the sections of a compiled .lbc file that the linker reads.
+static bool load_unit_sections(const unsigned char* bytecode, size_t size, UNIT_SECTIONS* sections)
+{
+    memset(sections, 0, sizeof(UNIT_SECTIONS));
+    bytecode_container container;
+    if (read_bytecode_container(bytecode, size, &container) != BYTECODE_FILE_VALID)
+    {
+        return false;
+    }
+    const bytecode_section* code = find_bytecode_section(&container, BYTECODE_SECTION_CODE);
+    const bytecode_section* constants = find_bytecode_section(&container, BYTECODE_SECTION_CONSTANTS);
+    const bytecode_section* strings = find_bytecode_section(&container, BYTECODE_SECTION_STRINGS);
+    if (code == NULL || constants == NULL || strings == NULL)
+    {
+        return false;
+    }
+
+    size_t code_size, constants_size;
+    sections->records = load_bytecode_section(&container, code, SIZE_MAX, &sections->allocations[0], &code_size);
+    sections->views = load_bytecode_section(&container, constants, SIZE_MAX, &sections->allocations[1], &constants_size);
+    sections->text = (const char*)load_bytecode_section(&container, strings, SIZE_MAX, &sections->allocations[2], &sections->text_size);
+    sections->record_count = code->count;
+    sections->view_count = constants->count;
+    sections->variable_count = container.variable_count;
+    if (sections->records == NULL || sections->views == NULL || sections->text == NULL
+        || code_size != (size_t)code->count * BYTECODE_INSTRUCTION_SIZE || constants_size != (size_t)constants->count * BYTECODE_STRING_SIZE)
+    {
+        release_unit_sections(sections);
+        return false;
+    }
+
+    const bytecode_section* debug = find_bytecode_section(&container, BYTECODE_SECTION_DEBUG);
+    if (debug != NULL)
+    {
+        sections->debug_info = load_bytecode_section(&container, debug, SIZE_MAX, &sections->allocations[3], &sections->debug_info_size);
+        sections->row_count = debug->count;
+        if (sections->debug_info == NULL)
+        {
+            release_unit_sections(sections);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// @brief Decodes the line table of a compiled .lbc file into the source location of every instruction of a unit.
+static bool read_unit_locations(const UNIT_SECTIONS* sections, bytecode_unit* unit)
+{
+    line_table table;
+    if (decode_line_table(sections->debug_info, sections->debug_info_size, sections->row_count, SIZE_MAX, &table) == false)
+    {
+        return false;
+    }
+
+    unit->locations = (source_location*)safe_malloc((unit->instruction_count > 0 ? unit->instruction_count : 1) * sizeof(source_location));
+    for (int i = 0; i < unit->instruction_count; i++)
+    {
+        if (find_source_location(&table, i, &unit->locations[i]) == false)
+        {
+            unit->locations[i] = (source_location){0, 0, 0};
+        }
+    }
+
+    /* the files point into the line table, so they are copied to outlive it */
+    unit->files = (char**)safe_malloc((table.file_count > 0 ? table.file_count : 1) * sizeof(char*));
+    for (int i = 0; i < table.file_count; i++)
+    {
+        size_t length = strlen(table.files[i]);
+        unit->files[i] = (char*)safe_malloc(length + 1);
+        memcpy(unit->files[i], table.files[i], length + 1);
+        unit->file_count++;
+    }
+    free_line_table(&table);
+
+    return true;
+}
+
+/// @brief Reads a string view, checking that its text is inside the strings.
+static bool read_unit_string(const UNIT_SECTIONS* sections, size_t index, bytecode_string* view)
+{
+    if (index >= sections->view_count)
+    {
+        return false;
+    }
+    decode_bytecode_string(sections->views + index * BYTECODE_STRING_SIZE, view);
+    uint64_t end = (uint64_t)view->offset + view->length;
+
+    return end < sections->text_size && sections->text[end] == '\0';
+}
+
+bool read_bytecode_unit(const unsigned char* bytecode, size_t size, const char* module_name, bytecode_unit* unit)
+{
+    unit->module_name = module_name;
+    unit->instructions = NULL;
+    unit->instruction_count = 0;
+    unit->objects = NULL;
+    unit->object_count = 0;
+    unit->variable_count = 0;
+    unit->locations = NULL;
+    unit->files = NULL;
+    unit->file_count = 0;
+
+    UNIT_SECTIONS sections;
+    if (load_unit_sections(bytecode, size, &sections) == false)
+    {
+        return false;
+    }
+
+    /* the objects are copied, so they outlive the file and can be handed to the serializer */
+    bool is_read = true;
+    unit->objects = (char**)safe_malloc((sections.view_count > 0 ? sections.view_count : 1) * sizeof(char*));
+    for (size_t i = 0; i < sections.view_count && is_read == true; i++)
+    {
+        bytecode_string view;
+        is_read = read_unit_string(&sections, i, &view);
+        if (is_read == true)
+        {
+            unit->objects[i] = (char*)safe_malloc(view.length + 1);
+            memcpy(unit->objects[i], sections.text + view.offset, view.length + 1);
+            unit->object_count++;
+        }
+    }
+
+    if (is_read == true)
+    {
+        unit->instruction_count = (int)sections.record_count;
+        unit->instructions = (instruction*)safe_malloc((unit->instruction_count > 0 ? unit->instruction_count : 1) * sizeof(instruction));
+        for (int i = 0; i < unit->instruction_count; i++)
+        {
+            decode_bytecode_instruction(sections.records + (size_t)i * BYTECODE_INSTRUCTION_SIZE, &unit->instructions[i]);
+        }
+        unit->variable_count = sections.variable_count;
+        if (sections.debug_info != NULL)
+        {
+            is_read = read_unit_locations(&sections, unit);
+        }
+    }
+
+    if (is_read == false)
+    {
+        free_bytecode_unit(unit);
+    }
+    release_unit_sections(&sections);
+
+    return is_read;
+}
+
+/// @brief Determines if an instruction refers to an object by its index.
+static bool is_object_reference(const instruction* instruction)
+{
+    return instruction->op_code == OP_GRAB
+        || (instruction->op_code == OP_LOAD_CONST && (instruction->op_type == OP_TYPE_TEXT || instruction->op_type == OP_TYPE_INDEX));
+}
+
+char** read_bytecode_grabs(const unsigned char* bytecode, size_t size, int* count)
+{
+    *count = 0;
+    UNIT_SECTIONS sections;
+    if (load_unit_sections(bytecode, size, &sections) == false)
+    {
+        return NULL;
+    }
+
+    bool is_read = true;
+    char** grabs = (char**)safe_malloc((sections.record_count > 0 ? sections.record_count : 1) * sizeof(char*));
+    for (size_t i = 0; i < sections.record_count && is_read == true; i++)
+    {
+        instruction grab;
+        decode_bytecode_instruction(sections.records + i * BYTECODE_INSTRUCTION_SIZE, &grab);
+        if (grab.op_code != OP_GRAB)
+        {
+            continue;
+        }
+
+        bytecode_string view;
+        is_read = grab.operand.i >= 0 && read_unit_string(&sections, (size_t)grab.operand.i, &view);
+        if (is_read == true)
+        {
+            grabs[*count] = (char*)safe_malloc(view.length + 1);
+            memcpy(grabs[(*count)++], sections.text + view.offset, view.length + 1);
+        }
+    }
+    release_unit_sections(&sections);
+
+    if (is_read == false)
+    {
+        for (int i = 0; i < *count; i++)
+        {
+            safe_free(grabs[i]);
+        }
+        safe_free(grabs);
+        *count = 0;
+        return NULL;
+    }
+
+    return grabs;
+}
+
+void free_bytecode_unit(bytecode_unit* unit)
+{
+    if (unit->instructions != NULL)
+    {
+        safe_free(unit->instructions);
+    }
+    for (int i = 0; i < unit->object_count; i++)
+    {
+        safe_free(unit->objects[i]);
+    }
+    if (unit->objects != NULL)
+    {
+        safe_free(unit->objects);
+    }
+    if (unit->locations != NULL)
+    {
+        safe_free(unit->locations);
+    }
+    for (int i = 0; i < unit->file_count; i++)
+    {
+        safe_free(unit->files[i]);
+    }
+    if (unit->files != NULL)
+    {
+        safe_free(unit->files);
+    }
+    unit->instructions = NULL;
+    unit->instruction_count = 0;
+    unit->objects = NULL;
+    unit->object_count = 0;
+    unit->locations = NULL;
+    unit->files = NULL;
+    unit->file_count = 0;
+}
+
+/// @brief The linked program while units are being placed into it.
+typedef struct
+{
+    const bytecode_unit* units;
+    int unit_count;
+    /// @brief Where the objects, variables and files of every unit start, they keep the order of the units.
+    int* object_bases;
+    int* variable_bases;
+    int* file_bases;
+    /// @brief `true` for every unit that is placed or being placed.
+    bool* is_placed;
+    instruction* instructions;
+    /// @brief The source location of every instruction, or `NULL` if no unit has debug info.
+    source_location* locations;
+    int instruction_count;
+} LINKED_PROGRAM;
+
+/// @brief Finds a unit being linked by its module name.
+/// @return The index of the unit, or `-1` if the runtime provides the module instead.
+static int find_linked_unit(const bytecode_unit* units, int unit_count, const char* module_name)
+{
+    for (int i = 0; i < unit_count; i++)
+    {
+        if (strcmp(units[i].module_name, module_name) == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/// @brief Places the instructions of a unit at the end of the program, with the instructions of every linked chunk it
+/// grabs first placed where it grabs it, the way the runtime runs a module of an archive when it is grabbed.
+static void place_unit(LINKED_PROGRAM* program, int unit_index)
+{
+    const bytecode_unit* unit = &program->units[unit_index];
+    bool is_entry = unit_index == program->unit_count - 1;
+    program->is_placed[unit_index] = true;
+
+    /* where every instruction of the unit is placed, and past its last one, so its jumps can follow them */
+    int* positions = (int*)safe_malloc((unit->instruction_count + 1) * sizeof(int));
+    int* jumps = (int*)safe_malloc((unit->instruction_count > 0 ? unit->instruction_count : 1) * sizeof(int));
+    int jump_count = 0;
+    for (int j = 0; j < unit->instruction_count; j++)
+    {
+        positions[j] = program->instruction_count;
+        instruction linked = unit->instructions[j];
+        int grabbed_unit = linked.op_code == OP_GRAB && linked.operand.i >= 0 && linked.operand.i < unit->object_count
+            ? find_linked_unit(program->units, program->unit_count, unit->objects[linked.operand.i]) : -1;
+        if (grabbed_unit >= 0)
+        {
+            /* a chunk that already ran, or is still running because it grabbed this one, doesn't run again */
+            if (program->is_placed[grabbed_unit] == false)
+            {
+                place_unit(program, grabbed_unit);
+            }
+            continue;
+        }
+
+        /* a chunk that halts or returns continues after the grab that ran it instead */
+        if (is_entry == false && (linked.op_code == OP_HALT || linked.op_code == OP_RETURN))
+        {
+            linked = (instruction){OP_JMP, {.jump = {0}}};
+            jumps[jump_count++] = j;
+        }
+        else if (is_jump_op_code(linked.op_code) == true)
+        {
+            jumps[jump_count++] = j;
+        }
+        else if (is_object_reference(&linked) == true)
+        {
+            linked.operand.i += program->object_bases[unit_index];
+        }
+        else if (linked.op_code == OP_LOAD_VAR || linked.op_code == OP_STORE_VAR)
+        {
+            linked.operand.variable.variable_index += program->variable_bases[unit_index];
+        }
+
+        if (program->locations != NULL)
+        {
+            /* a unit without debug info leaves its instructions at an unknown place */
+            source_location location = unit->locations != NULL ? unit->locations[j] : (source_location){0, 0, 0};
+            location.file += program->file_bases[unit_index];
+            program->locations[program->instruction_count] = location;
+        }
+        program->instructions[program->instruction_count++] = linked;
+    }
+    positions[unit->instruction_count] = program->instruction_count;
+
+    /* a jump outside of its unit is left as it is, for the runtime to reject */
+    for (int k = 0; k < jump_count; k++)
+    {
+        int j = jumps[k];
+        int target = is_jump_op_code(unit->instructions[j].op_code) == true ? get_jump_target(unit->instructions, j) : unit->instruction_count;
+        if (target >= 0 && target <= unit->instruction_count)
+        {
+            program->instructions[positions[j]].operand.jump.jump_offset = positions[target] - (positions[j] + 1);
+        }
+    }
+    safe_free(positions);
+    safe_free(jumps);
+}
+
+unsigned char* link_bytecode_units(const bytecode_unit* units, int unit_count, const compiler_options* options, size_t* size)
+{
+    int instruction_count = 0;
+    int object_count = 0;
+    int variable_count = 0;
+    int file_count = 0;
+    bool has_locations = false;
+    LINKED_PROGRAM program = { units, unit_count, NULL, NULL, NULL, NULL, NULL, NULL, 0 };
+    program.object_bases = (int*)safe_malloc(unit_count * sizeof(int));
+    program.variable_bases = (int*)safe_malloc(unit_count * sizeof(int));
+    program.file_bases = (int*)safe_malloc(unit_count * sizeof(int));
+    program.is_placed = (bool*)safe_malloc(unit_count * sizeof(bool));
+    for (int i = 0; i < unit_count; i++)
+    {
+        program.object_bases[i] = object_count;
+        program.variable_bases[i] = variable_count;
+        program.file_bases[i] = file_count;
+        program.is_placed[i] = false;
+        instruction_count += units[i].instruction_count;
+        object_count += units[i].object_count;
+        variable_count += units[i].variable_count;
+        file_count += units[i].file_count;
+        has_locations = has_locations == true || units[i].locations != NULL;
+    }
+
+    char** objects = (char**)safe_malloc((object_count > 0 ? object_count : 1) * sizeof(char*));
+    const char** files = (const char**)safe_malloc((file_count > 0 ? file_count : 1) * sizeof(char*));
+    for (int i = 0; i < unit_count; i++)
+    {
+        for (int j = 0; j < units[i].object_count; j++)
+        {
+            objects[program.object_bases[i] + j] = units[i].objects[j];
+        }
+        for (int j = 0; j < units[i].file_count; j++)
+        {
+            files[program.file_bases[i] + j] = units[i].files[j];
+        }
+    }
+
+    /* the grabs of linked chunks are left out, so the program is at most as long as its units together */
+    program.instructions = (instruction*)safe_malloc((instruction_count > 0 ? instruction_count : 1) * sizeof(instruction));
+    program.locations = has_locations == true ? (source_location*)safe_malloc((instruction_count > 0 ? instruction_count : 1) * sizeof(source_location)) : NULL;
+    place_unit(&program, unit_count - 1);
+
+    /* the objects and files still belong to the units */
+    unsigned char* bytecode = serialize_bytecode(program.instructions, program.instruction_count, objects, object_count, variable_count, program.locations, files, file_count, options, size);
+    safe_free(program.instructions);
+    if (program.locations != NULL)
+    {
+        safe_free(program.locations);
+    }
+    safe_free(program.object_bases);
+    safe_free(program.variable_bases);
+    safe_free(program.file_bases);
+    safe_free(program.is_placed);
+    safe_free(objects);
+    safe_free(files);
+
+    return bytecode;
+}
\ No newline at end of file
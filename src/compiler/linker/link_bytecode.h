@@ -0,0 +1,64 @@
+#ifndef LINK_BYTECODE
+#define LINK_BYTECODE
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "../../core/extensions/memory_extensions.h"
+#include "../../core/logger/logger.h"
+#include "../../core/types/bytecode.h"
+#include "../../core/types/bytecode_file.h"
+#include "../../core/types/line_table.h"
+#include "../bytecode_generator/bytecode_generator.h"
+#include "../types/compiler_options.h"
+
+/// @struct bytecode_unit
+/// @brief The decoded bytecode of a single compiled chunk, ready to be linked with others.
+typedef struct bytecode_unit bytecode_unit;
+
+struct bytecode_unit
+{
+    /// @brief The name other chunks grab this chunk by.
+    const char* module_name;
+    instruction* instructions;
+    int instruction_count;
+    char** objects;
+    int object_count;
+    int variable_count;
+    /// @brief Where in the source every instruction was compiled from, or `NULL` if the file has no debug info.
+    source_location* locations;
+    /// @brief The path of every source file the `locations` refer to.
+    char** files;
+    int file_count;
+};
+
+/// @brief Decodes a compiled .lbc file into a bytecode unit.
+/// @param bytecode The compiled .lbc file.
+/// @param size The size of the file.
+/// @param module_name The name of the chunk the file was compiled from.
+/// @param unit The bytecode unit to fill.
+/// @return `true` if the file was decoded, `false` if it is corrupt.
+bool read_bytecode_unit(const unsigned char* bytecode, size_t size, const char* module_name, bytecode_unit* unit);
+
+/// @brief Reads the names of the modules a compiled .lbc file grabs, in the order it grabs them, without decoding the rest of it.
+/// @param bytecode The compiled .lbc file.
+/// @param size The size of the file.
+/// @param count The amount of module names.
+/// @return The module names, which the caller frees along with the array, or `NULL` if the file is corrupt.
+char** read_bytecode_grabs(const unsigned char* bytecode, size_t size, int* count);
+
+/// @brief Deallocates the instructions, objects and source locations of a bytecode unit, but not the unit itself.
+/// @param unit The bytecode unit to free the members of.
+void free_bytecode_unit(bytecode_unit* unit);
+
+/// @brief Links bytecode units into a single .lbc file, where every chunk runs once where it is first grabbed, like a
+/// module of an archive. The instructions of a chunk take the place of the first grab of it, with their variables and
+/// objects moved past those of the units before them, later grabs of it are left out, and a chunk that halts or returns
+/// continues after the grab instead. The source locations of every unit that has them are kept.
+/// @param units The units to link, the last one is the entry chunk.
+/// @param unit_count The amount of units.
+/// @param options The compiler options, which are recorded in the metadata of the file.
+/// @param size The size of the linked file.
+/// @return The linked .lbc file, which the caller frees.
+unsigned char* link_bytecode_units(const bytecode_unit* units, int unit_count, const compiler_options* options, size_t* size);
+
+#endif
\ No newline at end of file
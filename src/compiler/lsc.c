@@ -0,0 +1,100 @@
+/* open, write, close and getpid are POSIX, which strict C17 hides unless asked for */
+#define _POSIX_C_SOURCE 200809L
+#include "lsc.h"
+
+unsigned char* lsc_compile_to_buffer(const char* source, const compiler_options* options, optimization_statistics* statistics, size_t* size)
+{
+    *size = 0;
+
+    size_t token_count = 0;
+    /* the lexer only reads the source */
+    begin_compiler_pass(COMPILER_PASS_LEX);
+    token** tokens = get_tokens((char*)source, &token_count);
+    end_compiler_pass(COMPILER_PASS_LEX);
+    if (tokens == NULL)
+    {
+        log_error("Compiler error: Failed to get tokens from L# source file.");
+        return NULL;
+    }
+
+    begin_compiler_pass(COMPILER_PASS_PARSE);
+    abstract_syntax_node* abstract_syntax_tree = get_abstract_syntax_tree(tokens, token_count);
+    free_tokens(tokens);
+    end_compiler_pass(COMPILER_PASS_PARSE);
+    if (abstract_syntax_tree == NULL)
+    {
+        log_error("Compiler error: Failed to get abstract syntax tree from tokens.");
+        return NULL;
+    }
+
+    unsigned char* bytecode = compile_ast_to_bytecode(abstract_syntax_tree, options, statistics, size);
+    free_ast(abstract_syntax_tree);
+    if (bytecode == NULL)
+    {
+        log_error("Compiler error: Failed to compile abstract syntax tree into bytecode.");
+    }
+
+    return bytecode;
+}
+
+bool lsc_write_bytecode(const unsigned char* bytecode, size_t size, int descriptor)
+{
+    /* the whole file goes out in one write, only a pipe that takes less at a time needs more */
+    size_t written = 0;
+    while (written < size)
+    {
+        ssize_t result = write(descriptor, bytecode + written, size - written);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            return false;
+        }
+        written += (size_t)result;
+    }
+
+    return true;
+}
+
+bool lsc_write_bytecode_to_path(const unsigned char* bytecode, size_t size, const char* path)
+{
+    if (strcmp(path, "-") == 0)
+    {
+        return lsc_write_bytecode(bytecode, size, STDOUT_FILENO);
+    }
+
+    int descriptor = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (descriptor < 0)
+    {
+        log_error("Compiler error: Error opening \"%s\" for writing.", path);
+        return false;
+    }
+
+    bool is_written = lsc_write_bytecode(bytecode, size, descriptor);
+    is_written = close(descriptor) == 0 && is_written == true;
+    if (is_written == false)
+    {
+        log_error("Compiler error: Error writing bytecode to \"%s\".", path);
+    }
+
+    return is_written;
+}
+
+bool lsc_replace_bytecode_file(const unsigned char* bytecode, size_t size, const char* path)
+{
+    /* every compiler writes its own temporary file, so concurrent compilations never mix and nobody reads half a file */
+    size_t capacity = strlen(path) + 32;
+    char* temporary_path = (char*)safe_malloc(capacity);
+    snprintf(temporary_path, capacity, "%s.%ld.tmp", path, (long)getpid());
+
+    bool is_replaced = lsc_write_bytecode_to_path(bytecode, size, temporary_path) == true && rename(temporary_path, path) == 0;
+    if (is_replaced == false)
+    {
+        remove(temporary_path);
+    }
+    safe_free(temporary_path);
+
+    return is_replaced;
+}
\ No newline at end of file
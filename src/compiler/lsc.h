@@ -0,0 +1,48 @@
+#ifndef LSC
+#define LSC
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "../core/extensions/memory_extensions.h"
+#include "../core/logger/logger.h"
+#include "bytecode_generator/bytecode_generator.h"
+#include "lexer/get_tokens.h"
+#include "optimizer/optimization_statistics.h"
+#include "parser/get_abstract_syntax_tree.h"
+#include "timing/pass_timings.h"
+#include "types/compiler_options.h"
+
+/// @brief Compiles L# source code into an .lbc file held in one contiguous buffer, without touching the filesystem.
+/// @param source The null-terminated L# source code.
+/// @param options The compiler options.
+/// @param statistics The optimization statistics to fill while optimizing, can be `NULL`.
+/// @param size The size of the compiled file.
+/// @return The compiled .lbc file, which the caller frees, or `NULL` if compiling fails.
+unsigned char* lsc_compile_to_buffer(const char* source, const compiler_options* options, optimization_statistics* statistics, size_t* size);
+
+/// @brief Writes a compiled .lbc file to an open file descriptor with a single `write`.
+/// @param bytecode The compiled .lbc file.
+/// @param size The size of the file.
+/// @param descriptor The file descriptor to write to.
+/// @return `true` if the whole file was written, `false` otherwise.
+bool lsc_write_bytecode(const unsigned char* bytecode, size_t size, int descriptor);
+
+/// @brief Writes a compiled .lbc file to a path with a single `write`.
+/// @param bytecode The compiled .lbc file.
+/// @param size The size of the file.
+/// @param path The path to write the file to, or `-` for stdout.
+/// @return `true` if the whole file was written, `false` otherwise.
+bool lsc_write_bytecode_to_path(const unsigned char* bytecode, size_t size, const char* path);
+
+/// @brief Writes a compiled .lbc file to a temporary file next to `path` and renames it into place, so the file at `path` is always whole.
+/// @param bytecode The compiled .lbc file.
+/// @param size The size of the file.
+/// @param path The path to replace.
+/// @return `true` if the file at `path` was replaced, `false` otherwise.
+bool lsc_replace_bytecode_file(const unsigned char* bytecode, size_t size, const char* path);
+
+#endif
\ No newline at end of file
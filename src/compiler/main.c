@@ -1,45 +1,86 @@
+/* dup and dup2 are POSIX, which strict C17 hides unless asked for */
+#define _POSIX_C_SOURCE 200809L
 #include "main.h"
 
 int main(int argc, const char* argv[])
 {
-    if (argv[1] == NULL)
+    compiler_options options;
+    if (parse_compiler_options(argc, argv, &options) == false)
+    {
+        return 1;
+    }
+
+    if (options.input_path == NULL)
     {
         log_error("Compiler error: An L# entry file must be provided as an argument to the L# compiler.");
-        return 0;
+        return 1;
     }
     
-    if (strlen(argv[1]) <= 0)
+    if (strlen(options.input_path) <= 0)
     {
         log_error("Compiler error: A valid L# entry file must be provided as an argument to the L# compiler.");
-        return 0;
+        return 1;
     }
 
-    char* file_content = read_file(argv[1]);
-    assert(file_content != NULL && "Unable to read L# file.");
+    if (options.time_passes != PASS_TIMING_NONE)
+    {
+        start_pass_timings();
+    }
 
-    size_t token_count = 0;
-    token** tokens = get_tokens(file_content, &token_count);
-    if (tokens == NULL)
+    /* with the bytecode going to stdout, everything else the compiler prints goes to stderr instead */
+    bool is_output_stdout = strcmp(options.output_path, "-") == 0;
+    int bytecode_descriptor = STDOUT_FILENO;
+    if (is_output_stdout == true)
     {
-        log_error("Compiler error: Failed to get tokens from L# source file.");
-        return 0;
+        fflush(stdout);
+        bytecode_descriptor = dup(STDOUT_FILENO);
+        dup2(STDERR_FILENO, STDOUT_FILENO);
     }
 
-    abstract_syntax_node* abstract_syntax_tree = get_abstract_syntax_tree(tokens, token_count);
-    if (abstract_syntax_tree == NULL)
+    size_t bytecode_size;
+    optimization_statistics statistics;
+    chunk_build_statistics build_statistics;
+    create_optimization_statistics(&statistics);
+    create_chunk_build_statistics(&build_statistics);
+    unsigned char* bytecode = build_chunks(&options, &statistics, &build_statistics, &bytecode_size);
+    if (bytecode == NULL)
     {
-        log_error("Compiler error: Failed to get abstract syntax tree from tokens.");
-        return 0;
+        return 1;
     }
-    free_tokens(tokens);
 
-    int instruction_count;
-    instruction* instructions = compile_ast_to_bytecode(abstract_syntax_tree, &instruction_count, "bin/program.lbc");
+    begin_compiler_pass(COMPILER_PASS_WRITE);
+    bool is_written = is_output_stdout == true
+        ? lsc_write_bytecode(bytecode, bytecode_size, bytecode_descriptor)
+        : lsc_write_bytecode_to_path(bytecode, bytecode_size, options.output_path);
+    safe_free(bytecode);
+    end_compiler_pass(COMPILER_PASS_WRITE);
+    if (is_written == false)
+    {
+        log_error("Compiler error: Failed to write the bytecode.");
+        return 1;
+    }
 
     log_info("L# compilation complete.");
+    if (options.build_directory != NULL)
+    {
+        log_info("Compiled %d of %d chunk(s), reused the rest from \"%s\".", build_statistics.compiled_count, build_statistics.chunk_count, options.build_directory);
+    }
+    if (options.print_optimization_statistics == true)
+    {
+        print_optimization_statistics(&statistics);
+    }
+    if (options.print_cache_statistics == true)
+    {
+        if (options.dump_ir == false && options.print_optimization_statistics == false)
+        {
+            print_compile_cache_statistics(options.cache_directory, build_statistics.cache_hits, build_statistics.cache_misses);
+        }
+        else
+        {
+            log_info("Compile cache: not used, --dump-ir and --opt-stats always compile.");
+        }
+    }
+    print_pass_timings(options.time_passes);
 
-    free_ast(abstract_syntax_tree);
-    safe_free_collection((void**)instructions);
-
-    return 1;
+    return 0;
 }
\ No newline at end of file
@@ -1,12 +1,17 @@
 #ifndef LSHARPC
 #define LSHARPC
 #include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 #include "../core/logger/logger.h"
-#include "file/read_file.h"
-#include "lexer/get_tokens.h"
-#include "parser/get_abstract_syntax_tree.h"
-#include "bytecode_generator/bytecode_generator.h"
+#include "cache/compile_cache.h"
+#include "chunks/build_chunks.h"
+#include "optimizer/optimization_statistics.h"
+#include "timing/pass_timings.h"
+#include "types/compiler_options.h"
+#include "lsc.h"
 
 /// @brief The main entry point of the L# compiler.
 /// @param argc The number of command-line arguments given to the compiler.
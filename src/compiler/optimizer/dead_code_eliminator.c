@@ -0,0 +1,514 @@
+#include "dead_code_eliminator.h"
+
+/// @brief The most times dead stores are removed before giving up on reaching a fixed point.
+#define MAXIMUM_DEAD_CODE_PASSES 16
+
+/// @struct abstract_stack_value
+/// @brief What is known at compile time about a value on the stack.
+typedef struct abstract_stack_value abstract_stack_value;
+
+struct abstract_stack_value
+{
+    bool is_number;
+    bool is_nonzero_number;
+};
+
+/// @brief Determines if control never falls through from the `instruction` to the one after it.
+static bool is_terminal_instruction(instruction instruction)
+{
+    /* a return outside of a function ends the program, just like a halt */
+    return instruction.op_code == OP_HALT || instruction.op_code == OP_RETURN || instruction.op_code == OP_JMP;
+}
+
+/// @brief Gets the instructions control can continue at after the instruction at `index`.
+/// @return The amount of successors written to `successors`.
+static int get_successors(bytecode_generator* generator, int index, int* successors)
+{
+    instruction current = generator->instructions[index];
+    int successor_count = 0;
+    if (is_terminal_instruction(current) == false && index + 1 < generator->instruction_count)
+    {
+        successors[successor_count++] = index + 1;
+    }
+    if (is_jump_op_code(current.op_code) == true)
+    {
+        int target = get_jump_target(generator->instructions, index);
+        if (target >= 0 && target < generator->instruction_count)
+        {
+            successors[successor_count++] = target;
+        }
+    }
+
+    return successor_count;
+}
+
+int remove_unreachable_instructions(bytecode_generator* generator)
+{
+    int instruction_count = generator->instruction_count;
+    if (instruction_count == 0)
+    {
+        return 0;
+    }
+
+    bool* removed = (bool*)safe_malloc((instruction_count + 1) * sizeof(bool));
+    int* worklist = (int*)safe_malloc(instruction_count * sizeof(int));
+    int worklist_count = 0;
+    for (int i = 0; i < instruction_count; i++)
+    {
+        removed[i] = true;
+    }
+
+    /* everything that can be reached from the first instruction stays */
+    removed[0] = false;
+    worklist[worklist_count++] = 0;
+    while (worklist_count > 0)
+    {
+        int index = worklist[--worklist_count];
+        int successors[2];
+        int successor_count = get_successors(generator, index, successors);
+        for (int i = 0; i < successor_count; i++)
+        {
+            if (removed[successors[i]] == true)
+            {
+                removed[successors[i]] = false;
+                worklist[worklist_count++] = successors[i];
+            }
+        }
+    }
+
+    int removed_count = remove_instructions(generator, removed);
+
+    safe_free(removed);
+    safe_free(worklist);
+    return removed_count;
+}
+
+/// @brief Updates the `live` variables from after the `instruction` to before it.
+static void update_live_variables(instruction instruction, int variable_count, uint64_t* live)
+{
+    int variable = instruction.operand.variable.variable_index;
+    if (variable < 0 || variable >= variable_count)
+    {
+        return;
+    }
+
+    if (instruction.op_code == OP_STORE_VAR)
+    {
+        live[variable / 64] &= ~(1ULL << (variable % 64));
+    }
+    else if (instruction.op_code == OP_LOAD_VAR)
+    {
+        live[variable / 64] |= 1ULL << (variable % 64);
+    }
+}
+
+/// @brief Splits the instructions into basic blocks, which start at the first instruction, at every jump target, and after every jump or terminal instruction.
+/// @param block_starts Filled with the first instruction of every block, followed by the instruction count.
+/// @param block_of Filled with the block of every instruction.
+/// @return The amount of blocks.
+static int find_basic_blocks(bytecode_generator* generator, int* block_starts, int* block_of)
+{
+    int instruction_count = generator->instruction_count;
+    bool* is_leader = (bool*)safe_malloc((instruction_count + 1) * sizeof(bool));
+    for (int i = 0; i <= instruction_count; i++)
+    {
+        is_leader[i] = i == 0;
+    }
+    for (int i = 0; i < instruction_count; i++)
+    {
+        instruction current = generator->instructions[i];
+        if (is_jump_op_code(current.op_code) == true)
+        {
+            int target = get_jump_target(generator->instructions, i);
+            if (target >= 0 && target < instruction_count)
+            {
+                is_leader[target] = true;
+            }
+        }
+        if (is_jump_op_code(current.op_code) == true || is_terminal_instruction(current) == true)
+        {
+            is_leader[i + 1] = true;
+        }
+    }
+
+    int block_count = 0;
+    for (int i = 0; i < instruction_count; i++)
+    {
+        if (is_leader[i] == true)
+        {
+            block_starts[block_count++] = i;
+        }
+        block_of[i] = block_count - 1;
+    }
+    block_starts[block_count] = instruction_count;
+
+    safe_free(is_leader);
+    return block_count;
+}
+
+/// @brief Fills `live` with the variables that are live after the last instruction of a block, from what is live at the start of the blocks after it.
+static void get_block_live_out(bytecode_generator* generator, const int* block_starts, const int* block_of, const uint64_t* live_in, int word_count, int block, uint64_t* live)
+{
+    memset(live, 0, word_count * sizeof(uint64_t));
+
+    /* control only leaves a block through its last instruction, and always enters one at its start */
+    int successors[2];
+    int successor_count = get_successors(generator, block_starts[block + 1] - 1, successors);
+    for (int s = 0; s < successor_count; s++)
+    {
+        const uint64_t* successor_in = &live_in[(size_t)block_of[successors[s]] * word_count];
+        for (int w = 0; w < word_count; w++)
+        {
+            live[w] |= successor_in[w];
+        }
+    }
+}
+
+/// @brief Computes which variables are live at the start of each basic block, as one bitset of `word_count` words per block.
+/// Straight-line code is a single block, which takes a single backward sweep.
+static uint64_t* get_block_live_in_sets(bytecode_generator* generator, const int* block_starts, const int* block_of, int block_count, int word_count)
+{
+    uint64_t* live_in = (uint64_t*)safe_malloc((size_t)block_count * word_count * sizeof(uint64_t));
+    uint64_t* live = (uint64_t*)safe_malloc(word_count * sizeof(uint64_t));
+    memset(live_in, 0, (size_t)block_count * word_count * sizeof(uint64_t));
+
+    /* walking backwards converges quickly, loops need another pass for each nesting level */
+    bool changed = true;
+    while (changed == true)
+    {
+        changed = false;
+        for (int block = block_count - 1; block >= 0; block--)
+        {
+            get_block_live_out(generator, block_starts, block_of, live_in, word_count, block, live);
+            for (int i = block_starts[block + 1] - 1; i >= block_starts[block]; i--)
+            {
+                update_live_variables(generator->instructions[i], generator->variable_count, live);
+            }
+
+            uint64_t* in = &live_in[(size_t)block * word_count];
+            if (memcmp(in, live, word_count * sizeof(uint64_t)) != 0)
+            {
+                memcpy(in, live, word_count * sizeof(uint64_t));
+                changed = true;
+            }
+        }
+    }
+
+    safe_free(live);
+    return live_in;
+}
+
+/// @brief Gets how many values the `instruction` pops and pushes, if it is free of side effects.
+/// @return `true` if the instruction can be removed when its result is unused, `false` otherwise.
+static bool get_pure_stack_effect(instruction instruction, int* pops, int* pushes)
+{
+    switch (instruction.op_code)
+    {
+        case OP_LOAD_CONST:
+        case OP_LOAD_VAR:
+            *pops = 0;
+            *pushes = 1;
+            return true;
+        case OP_DUP:
+            *pops = 1;
+            *pushes = 2;
+            return true;
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+        case OP_DIV:
+            /* only pure for some operands, which is checked by simulating the expression */
+            *pops = 2;
+            *pushes = 1;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// @brief Checks that the instructions in [start, end) can't fail at runtime, by tracking which stack values are known numbers.
+static bool is_expression_pure(bytecode_generator* generator, int start, int end)
+{
+    abstract_stack_value* stack = (abstract_stack_value*)safe_malloc((end - start + 1) * sizeof(abstract_stack_value));
+    int depth = 0;
+    bool is_pure = true;
+
+    for (int i = start; i < end && is_pure == true; i++)
+    {
+        instruction current = generator->instructions[i];
+        switch (current.op_code)
+        {
+            case OP_LOAD_CONST:
+            {
+                bool is_number = current.op_type == OP_TYPE_NUMBER;
+                stack[depth++] = (abstract_stack_value){ is_number, is_number && current.operand.d != 0.0 };
+                break;
+            }
+            case OP_LOAD_VAR:
+            {
+                stack[depth++] = (abstract_stack_value){ false, false };
+                break;
+            }
+            case OP_DUP:
+            {
+                if (depth < 1)
+                {
+                    is_pure = false;
+                    break;
+                }
+                stack[depth] = stack[depth - 1];
+                depth++;
+                break;
+            }
+            default:
+            {
+                /* arithmetic only can't fail on two numbers, and a divisor that isn't zero */
+                if (depth < 2 || stack[depth - 2].is_number == false || stack[depth - 1].is_number == false
+                    || (current.op_code == OP_DIV && stack[depth - 1].is_nonzero_number == false))
+                {
+                    is_pure = false;
+                    break;
+                }
+                depth--;
+                stack[depth - 1] = (abstract_stack_value){ true, false };
+                break;
+            }
+        }
+    }
+
+    safe_free(stack);
+    return is_pure;
+}
+
+/// @brief Flags the side-effect-free expression that the `OP_POP` at `pop_index` discards, along with the pop itself.
+/// @return `true` if the expression was flagged for removal, `false` otherwise.
+static bool remove_discarded_expression(bytecode_generator* generator, int pop_index, const bool* is_jump_target, bool* removed)
+{
+    /* walk back until the instructions before the pop have pushed exactly the one value it discards */
+    int needed = 1;
+    int start = -1;
+    for (int i = pop_index - 1; i >= 0; i--)
+    {
+        int pops;
+        int pushes;
+        if (is_jump_target[i + 1] == true || removed[i] == true || get_pure_stack_effect(generator->instructions[i], &pops, &pushes) == false)
+        {
+            return false;
+        }
+
+        needed += pops - pushes;
+        if (needed <= 0)
+        {
+            start = needed == 0 ? i : -1;
+            break;
+        }
+    }
+
+    if (start == -1 || is_expression_pure(generator, start, pop_index) == false)
+    {
+        return false;
+    }
+
+    for (int i = start; i <= pop_index; i++)
+    {
+        removed[i] = true;
+    }
+    return true;
+}
+
+static void mark_jump_targets(bytecode_generator* generator, bool* is_jump_target)
+{
+    for (int i = 0; i <= generator->instruction_count; i++)
+    {
+        is_jump_target[i] = false;
+    }
+
+    for (int i = 0; i < generator->instruction_count; i++)
+    {
+        if (is_jump_op_code(generator->instructions[i].op_code) == true)
+        {
+            int target = get_jump_target(generator->instructions, i);
+            if (target >= 0 && target <= generator->instruction_count)
+            {
+                is_jump_target[target] = true;
+            }
+        }
+    }
+}
+
+/// @brief Removes the side-effect-free expressions whose values are only popped again.
+/// @return The amount of instructions that were removed.
+static int remove_discarded_expressions(bytecode_generator* generator)
+{
+    int instruction_count = generator->instruction_count;
+    bool* removed = (bool*)safe_malloc((instruction_count + 1) * sizeof(bool));
+    bool* is_jump_target = (bool*)safe_malloc((instruction_count + 1) * sizeof(bool));
+    mark_jump_targets(generator, is_jump_target);
+    for (int i = 0; i < instruction_count; i++)
+    {
+        removed[i] = false;
+    }
+    for (int i = 0; i < instruction_count; i++)
+    {
+        if (generator->instructions[i].op_code == OP_POP)
+        {
+            remove_discarded_expression(generator, i, is_jump_target, removed);
+        }
+    }
+    int removed_count = remove_instructions(generator, removed);
+
+    safe_free(removed);
+    safe_free(is_jump_target);
+    return removed_count;
+}
+
+int remove_dead_stores(bytecode_generator* generator)
+{
+    int instruction_count = generator->instruction_count;
+    int dead_store_count = 0;
+    if (instruction_count > 0 && generator->variable_count > 0)
+    {
+        int word_count = (generator->variable_count + 63) / 64;
+        int* block_starts = (int*)safe_malloc((instruction_count + 1) * sizeof(int));
+        int* block_of = (int*)safe_malloc(instruction_count * sizeof(int));
+        int block_count = find_basic_blocks(generator, block_starts, block_of);
+        uint64_t* live_in = get_block_live_in_sets(generator, block_starts, block_of, block_count, word_count);
+
+        /* a store whose variable isn't live afterwards only has to take its value off the stack */
+        uint64_t* live = (uint64_t*)safe_malloc(word_count * sizeof(uint64_t));
+        for (int block = 0; block < block_count; block++)
+        {
+            get_block_live_out(generator, block_starts, block_of, live_in, word_count, block, live);
+            for (int i = block_starts[block + 1] - 1; i >= block_starts[block]; i--)
+            {
+                instruction* current = &generator->instructions[i];
+                int variable = current->operand.variable.variable_index;
+                bool is_dead_store = current->op_code == OP_STORE_VAR && variable >= 0 && variable < generator->variable_count
+                    && (live[variable / 64] & (1ULL << (variable % 64))) == 0;
+                update_live_variables(*current, generator->variable_count, live);
+                if (is_dead_store == true)
+                {
+                    *current = (instruction){OP_POP, {0}, OP_TYPE_NULL};
+                    dead_store_count++;
+                }
+            }
+        }
+        safe_free(live);
+        safe_free(live_in);
+        safe_free(block_starts);
+        safe_free(block_of);
+    }
+
+    /* then drop whatever computed the discarded values, as long as computing them can't fail */
+    remove_discarded_expressions(generator);
+    return dead_store_count;
+}
+
+int eliminate_dead_code(bytecode_generator* generator, optimization_statistics* statistics)
+{
+    int instruction_count_before = generator->instruction_count;
+
+    int unreachable_count = remove_unreachable_instructions(generator);
+    int dead_store_count = 0;
+    for (int pass = 0; pass < MAXIMUM_DEAD_CODE_PASSES; pass++)
+    {
+        /* removing a dead store can remove the last load of another variable */
+        int removed_count = remove_dead_stores(generator);
+        if (removed_count == 0)
+        {
+            break;
+        }
+        dead_store_count += removed_count;
+    }
+
+    if (statistics != NULL)
+    {
+        statistics->unreachable_instructions_removed += unreachable_count;
+        statistics->dead_stores_removed += dead_store_count;
+    }
+
+    return instruction_count_before - generator->instruction_count;
+}
+
+/// @brief Gets the object index the `instruction` refers to.
+/// @return A pointer to the object index in the instruction's operand, or `NULL` if it doesn't refer to an object.
+static int* get_object_reference(instruction* instruction)
+{
+    bool is_text_constant = instruction->op_code == OP_LOAD_CONST && (instruction->op_type == OP_TYPE_TEXT || instruction->op_type == OP_TYPE_INDEX);
+    if (is_text_constant == true || instruction->op_code == OP_GRAB)
+    {
+        return &instruction->operand.i;
+    }
+
+    return NULL;
+}
+
+int remove_unused_objects(bytecode_generator* generator, optimization_statistics* statistics)
+{
+    int object_count = generator->object_count;
+    if (object_count == 0)
+    {
+        return 0;
+    }
+
+    bool* is_used = (bool*)safe_malloc(object_count * sizeof(bool));
+    int* new_indices = (int*)safe_malloc(object_count * sizeof(int));
+    for (int i = 0; i < object_count; i++)
+    {
+        is_used[i] = false;
+        new_indices[i] = -1;
+    }
+    for (int i = 0; i < generator->instruction_count; i++)
+    {
+        int* reference = get_object_reference(&generator->instructions[i]);
+        if (reference != NULL && *reference >= 0 && *reference < object_count)
+        {
+            is_used[*reference] = true;
+        }
+    }
+
+    /* keep the first of every used text, and point its duplicates at it */
+    symbol_table* kept_objects = create_symbol_table(100);
+    int new_count = 0;
+    for (int i = 0; i < object_count; i++)
+    {
+        if (is_used[i] == true)
+        {
+            symbol* kept_object = lookup_symbol(kept_objects, generator->objects[i]);
+            if (kept_object != NULL)
+            {
+                new_indices[i] = kept_object->index;
+                safe_free(generator->objects[i]);
+                continue;
+            }
+
+            new_indices[i] = new_count;
+            insert_symbol(kept_objects, generator->objects[i], SYMBOL_TEXT, new_count);
+            generator->objects[new_count++] = generator->objects[i];
+        }
+        else
+        {
+            safe_free(generator->objects[i]);
+        }
+    }
+    free_symbol_table(kept_objects);
+
+    for (int i = 0; i < generator->instruction_count; i++)
+    {
+        int* reference = get_object_reference(&generator->instructions[i]);
+        if (reference != NULL && *reference >= 0 && *reference < object_count)
+        {
+            *reference = new_indices[*reference];
+        }
+    }
+    generator->object_count = new_count;
+
+    if (statistics != NULL)
+    {
+        statistics->objects_removed += object_count - new_count;
+    }
+
+    safe_free(is_used);
+    safe_free(new_indices);
+    return object_count - new_count;
+}
\ No newline at end of file
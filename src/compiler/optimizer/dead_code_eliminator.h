@@ -0,0 +1,35 @@
+#ifndef DEAD_CODE_ELIMINATOR
+#define DEAD_CODE_ELIMINATOR
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../core/extensions/memory_extensions.h"
+#include "../../core/types/bytecode.h"
+#include "../../core/types/symbol_table.h"
+#include "../bytecode_generator/bytecode_generator.h"
+#include "optimization_statistics.h"
+
+/// @brief Removes every instruction of the `generator` that control can never reach from the first instruction.
+/// @param generator The `bytecode_generator` that holds the emitted instructions.
+/// @return The amount of instructions that were removed.
+int remove_unreachable_instructions(bytecode_generator* generator);
+
+/// @brief Removes stores to variables that are never loaded again, along with the side-effect-free expressions that computed the stored value.
+/// @param generator The `bytecode_generator` that holds the emitted instructions.
+/// @return The amount of stores that were removed.
+int remove_dead_stores(bytecode_generator* generator);
+
+/// @brief Removes unreachable instructions and dead stores until neither finds anything more to remove.
+/// @param generator The `bytecode_generator` that holds the emitted instructions.
+/// @param statistics The optimization statistics to record the removals in, can be `NULL`.
+/// @return The amount of instructions that were removed.
+int eliminate_dead_code(bytecode_generator* generator, optimization_statistics* statistics);
+
+/// @brief Removes the objects of the `generator` that no instruction refers to, merges objects with the same text, and renumbers the references that remain.
+/// @param generator The `bytecode_generator` that holds the emitted instructions and objects.
+/// @param statistics The optimization statistics to record the removals in, can be `NULL`.
+/// @return The amount of objects that were removed.
+int remove_unused_objects(bytecode_generator* generator, optimization_statistics* statistics);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include "optimization_statistics.h"
+
+void create_optimization_statistics(optimization_statistics* statistics)
+{
+    statistics->instructions_before = 0;
+    statistics->instructions_after = 0;
+    statistics->peephole_passes = 0;
+    statistics->variables_before = 0;
+    statistics->variable_slots_after = 0;
+    statistics->unreachable_instructions_removed = 0;
+    statistics->dead_stores_removed = 0;
+    statistics->objects_removed = 0;
+    statistics->log_calls_elided = 0;
+    statistics->ir_values_before = 0;
+    statistics->ir_values_after = 0;
+    statistics->ir_copies_propagated = 0;
+    statistics->ir_phis_removed = 0;
+    statistics->ir_common_subexpressions = 0;
+    statistics->ir_dead_values = 0;
+    for (int i = 0; i < PEEPHOLE_RULE_COUNT; i++)
+    {
+        statistics->peephole_rule_hits[i] = 0;
+    }
+}
+
+void add_optimization_statistics(optimization_statistics* total, const optimization_statistics* chunk)
+{
+    total->instructions_before += chunk->instructions_before;
+    total->instructions_after += chunk->instructions_after;
+    total->peephole_passes += chunk->peephole_passes;
+    total->variables_before += chunk->variables_before;
+    total->variable_slots_after += chunk->variable_slots_after;
+    total->unreachable_instructions_removed += chunk->unreachable_instructions_removed;
+    total->dead_stores_removed += chunk->dead_stores_removed;
+    total->objects_removed += chunk->objects_removed;
+    total->log_calls_elided += chunk->log_calls_elided;
+    total->ir_values_before += chunk->ir_values_before;
+    total->ir_values_after += chunk->ir_values_after;
+    total->ir_copies_propagated += chunk->ir_copies_propagated;
+    total->ir_phis_removed += chunk->ir_phis_removed;
+    total->ir_common_subexpressions += chunk->ir_common_subexpressions;
+    total->ir_dead_values += chunk->ir_dead_values;
+    for (int i = 0; i < PEEPHOLE_RULE_COUNT; i++)
+    {
+        total->peephole_rule_hits[i] += chunk->peephole_rule_hits[i];
+    }
+}
+
+const char* get_peephole_rule_name(peephole_rule_id rule_id)
+{
+    switch (rule_id)
+    {
+        case PEEPHOLE_STORE_LOAD_TO_DUP: return "store/load to dup";
+        case PEEPHOLE_LOAD_STORE_SAME_VARIABLE: return "load/store same variable";
+        case PEEPHOLE_LOAD_CONST_POP: return "load const/pop";
+        case PEEPHOLE_LOAD_VAR_POP: return "load var/pop";
+        case PEEPHOLE_DUP_POP: return "dup/pop";
+        case PEEPHOLE_JUMP_TO_NEXT: return "jump to next";
+        case PEEPHOLE_CONDITIONAL_JUMP_TO_NEXT: return "conditional jump to next";
+        case PEEPHOLE_JUMP_THREADING: return "jump threading";
+        default: return "unknown rule";
+    }
+}
+
+void print_optimization_statistics(const optimization_statistics* statistics)
+{
+    int removed = statistics->instructions_before - statistics->instructions_after;
+    double percent_removed = statistics->instructions_before > 0
+        ? 100.0 * removed / statistics->instructions_before
+        : 0.0;
+
+    /* build one message so the report stays together in the log */
+    char report[2048];
+    int length = snprintf(report, sizeof(report), "Optimization statistics: %d of %d instructions removed (%.1f%%) in %d peephole pass(es).",
+        removed, statistics->instructions_before, percent_removed, statistics->peephole_passes);
+
+    length += snprintf(report + length, sizeof(report) - length, "\n   %d variable(s) packed into %d slot(s).",
+        statistics->variables_before, statistics->variable_slots_after);
+
+    length += snprintf(report + length, sizeof(report) - length, "\n   %d unreachable instruction(s), %d dead store(s) and %d unused object(s) removed.",
+        statistics->unreachable_instructions_removed, statistics->dead_stores_removed, statistics->objects_removed);
+
+    if (statistics->log_calls_elided > 0)
+    {
+        length += snprintf(report + length, sizeof(report) - length, "\n   %d logging call(s) below the minimum log level left out.", statistics->log_calls_elided);
+    }
+
+    /* the IR is only built at -O2 */
+    if (statistics->ir_values_before > 0)
+    {
+        length += snprintf(report + length, sizeof(report) - length, "\n   %d of %d IR value(s) left: %d copies propagated, %d phis removed, %d common subexpressions, %d dead values.",
+            statistics->ir_values_after, statistics->ir_values_before, statistics->ir_copies_propagated,
+            statistics->ir_phis_removed, statistics->ir_common_subexpressions, statistics->ir_dead_values);
+    }
+
+    for (int i = 0; i < PEEPHOLE_RULE_COUNT && length < (int)sizeof(report); i++)
+    {
+        if (statistics->peephole_rule_hits[i] == 0)
+        {
+            continue;
+        }
+        length += snprintf(report + length, sizeof(report) - length, "\n   %-26s %d", get_peephole_rule_name((peephole_rule_id)i), statistics->peephole_rule_hits[i]);
+    }
+
+    log_info("%s", report);
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#ifndef OPTIMIZATION_STATISTICS
+#define OPTIMIZATION_STATISTICS
+#include <stdio.h>
+#include "../../core/logger/logger.h"
+
+/// @enum peephole_rule_id
+/// @brief Identifies each rewrite rule in the peephole optimizer's rule table.
+typedef enum peephole_rule_id
+{
+    PEEPHOLE_STORE_LOAD_TO_DUP,
+    PEEPHOLE_LOAD_STORE_SAME_VARIABLE,
+    PEEPHOLE_LOAD_CONST_POP,
+    PEEPHOLE_LOAD_VAR_POP,
+    PEEPHOLE_DUP_POP,
+    PEEPHOLE_JUMP_TO_NEXT,
+    PEEPHOLE_CONDITIONAL_JUMP_TO_NEXT,
+    PEEPHOLE_JUMP_THREADING,
+    PEEPHOLE_RULE_COUNT
+} peephole_rule_id;
+
+/// @struct optimization_statistics
+/// @brief Counts of what the bytecode optimizer changed while compiling an L# program.
+typedef struct optimization_statistics optimization_statistics;
+
+struct optimization_statistics
+{
+    /// @brief The amount of instructions before any optimization.
+    int instructions_before;
+    /// @brief The amount of instructions after all optimizations.
+    int instructions_after;
+    /// @brief The amount of times the peephole optimizer walked the instructions.
+    int peephole_passes;
+    /// @brief The amount of times each peephole rule was applied, indexed by `peephole_rule_id`.
+    int peephole_rule_hits[PEEPHOLE_RULE_COUNT];
+    /// @brief The amount of distinct variables the program loads or stores.
+    int variables_before;
+    /// @brief The amount of variable slots left after slots of dead variables are reused.
+    int variable_slots_after;
+    /// @brief The amount of instructions removed because control never reaches them.
+    int unreachable_instructions_removed;
+    /// @brief The amount of stores removed because their variable is never loaded afterwards.
+    int dead_stores_removed;
+    /// @brief The amount of objects removed because no instruction refers to them, or another object has the same text.
+    int objects_removed;
+    /// @brief The amount of builtin logging calls left out because they were below the minimum log level.
+    int log_calls_elided;
+    /// @brief The amount of IR values built from the abstract syntax tree.
+    int ir_values_before;
+    /// @brief The amount of IR values left after the IR optimizations.
+    int ir_values_after;
+    /// @brief The amount of copies whose uses were forwarded to the copied value.
+    int ir_copies_propagated;
+    /// @brief The amount of phis removed because they merged a single value.
+    int ir_phis_removed;
+    /// @brief The amount of values replaced by an equal value that dominates them.
+    int ir_common_subexpressions;
+    /// @brief The amount of values removed because nothing used them.
+    int ir_dead_values;
+};
+
+/// @brief Fills `statistics` with zeroed counts.
+/// @param statistics The optimization statistics to reset.
+void create_optimization_statistics(optimization_statistics* statistics);
+
+/// @brief Adds the counts of compiling one chunk to the counts of compiling a whole program.
+/// @param total The optimization statistics of the whole program.
+/// @param chunk The optimization statistics of a single chunk.
+void add_optimization_statistics(optimization_statistics* total, const optimization_statistics* chunk);
+
+/// @brief Gets a human-readable name of the peephole rule with the `rule_id`.
+/// @param rule_id The peephole rule to get the name of.
+/// @return The name of the rule.
+const char* get_peephole_rule_name(peephole_rule_id rule_id);
+
+/// @brief Logs the `statistics` as an informational message.
+/// @param statistics The optimization statistics to report.
+void print_optimization_statistics(const optimization_statistics* statistics);
+
+#endif
\ No newline at end of file
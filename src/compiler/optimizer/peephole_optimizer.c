@@ -0,0 +1,256 @@
+#include "peephole_optimizer.h"
+
+/// @brief The most times the optimizer will walk the instructions before giving up on reaching a fixed point.
+#define MAXIMUM_PEEPHOLE_PASSES 16
+
+/// @brief A function that tries to rewrite the window of instructions starting at `index`.
+/// @return `true` if the rule matched and rewrote the window, `false` otherwise.
+typedef bool (*peephole_rule_function)(bytecode_generator* generator, int index, bool* removed);
+
+/// @struct peephole_rule
+/// @brief A single entry in the peephole rule table.
+typedef struct peephole_rule peephole_rule;
+
+struct peephole_rule
+{
+    peephole_rule_id id;
+    /// @brief The amount of consecutive instructions the rule looks at.
+    int window_size;
+    peephole_rule_function apply;
+};
+
+static bool is_same_variable(instruction first, instruction second)
+{
+    return first.operand.variable.variable_index == second.operand.variable.variable_index;
+}
+
+/* STORE_VAR x; LOAD_VAR x -> DUP; STORE_VAR x */
+static bool rewrite_store_load_to_dup(bytecode_generator* generator, int index, bool* removed)
+{
+    instruction* window = &generator->instructions[index];
+    if (window[0].op_code != OP_STORE_VAR || window[1].op_code != OP_LOAD_VAR || is_same_variable(window[0], window[1]) == false)
+    {
+        return false;
+    }
+
+    window[1] = window[0];
+    window[0] = (instruction){OP_DUP, {0}, OP_TYPE_NULL};
+    return true;
+}
+
+/* LOAD_VAR x; STORE_VAR x -> (nothing) */
+static bool remove_load_store_same_variable(bytecode_generator* generator, int index, bool* removed)
+{
+    instruction* window = &generator->instructions[index];
+    if (window[0].op_code != OP_LOAD_VAR || window[1].op_code != OP_STORE_VAR || is_same_variable(window[0], window[1]) == false)
+    {
+        return false;
+    }
+
+    removed[index] = true;
+    removed[index + 1] = true;
+    return true;
+}
+
+/* <push> ; POP -> (nothing), for any push without side effects */
+static bool remove_push_pop(bytecode_generator* generator, int index, bool* removed, op_code push_op_code)
+{
+    instruction* window = &generator->instructions[index];
+    if (window[0].op_code != push_op_code || window[1].op_code != OP_POP)
+    {
+        return false;
+    }
+
+    removed[index] = true;
+    removed[index + 1] = true;
+    return true;
+}
+
+static bool remove_load_const_pop(bytecode_generator* generator, int index, bool* removed)
+{
+    return remove_push_pop(generator, index, removed, OP_LOAD_CONST);
+}
+
+static bool remove_load_var_pop(bytecode_generator* generator, int index, bool* removed)
+{
+    return remove_push_pop(generator, index, removed, OP_LOAD_VAR);
+}
+
+static bool remove_dup_pop(bytecode_generator* generator, int index, bool* removed)
+{
+    return remove_push_pop(generator, index, removed, OP_DUP);
+}
+
+/* JMP +0 -> (nothing) */
+static bool remove_jump_to_next(bytecode_generator* generator, int index, bool* removed)
+{
+    instruction* window = &generator->instructions[index];
+    if (window[0].op_code != OP_JMP || window[0].operand.jump.jump_offset != 0)
+    {
+        return false;
+    }
+
+    removed[index] = true;
+    return true;
+}
+
+/* JMP_IF_FALSE +0 -> POP, the condition still has to leave the stack */
+static bool rewrite_conditional_jump_to_next(bytecode_generator* generator, int index, bool* removed)
+{
+    instruction* window = &generator->instructions[index];
+    if (window[0].op_code != OP_JMP_IF_FALSE || window[0].operand.jump.jump_offset != 0)
+    {
+        return false;
+    }
+
+    window[0] = (instruction){OP_POP, {0}, OP_TYPE_NULL};
+    return true;
+}
+
+/* JMP a; ... a: JMP b -> JMP b */
+static bool thread_jump(bytecode_generator* generator, int index, bool* removed)
+{
+    instruction* instructions = generator->instructions;
+    if (is_jump_op_code(instructions[index].op_code) == false)
+    {
+        return false;
+    }
+
+    int original_target = get_jump_target(instructions, index);
+    int target = original_target;
+
+    /* follow the chain of unconditional jumps, bounded so a jump cycle can't hang the compiler */
+    for (int hops = 0; hops < generator->instruction_count; hops++)
+    {
+        if (target < 0 || target >= generator->instruction_count || instructions[target].op_code != OP_JMP || target == index)
+        {
+            break;
+        }
+        target = get_jump_target(instructions, target);
+    }
+
+    if (target == original_target || target < 0 || target > generator->instruction_count)
+    {
+        return false;
+    }
+
+    instructions[index].operand.jump.jump_offset = target - (index + 1);
+    return true;
+}
+
+static const peephole_rule peephole_rules[] =
+{
+    { PEEPHOLE_STORE_LOAD_TO_DUP, 2, rewrite_store_load_to_dup },
+    { PEEPHOLE_LOAD_STORE_SAME_VARIABLE, 2, remove_load_store_same_variable },
+    { PEEPHOLE_LOAD_CONST_POP, 2, remove_load_const_pop },
+    { PEEPHOLE_LOAD_VAR_POP, 2, remove_load_var_pop },
+    { PEEPHOLE_DUP_POP, 2, remove_dup_pop },
+    { PEEPHOLE_JUMP_TO_NEXT, 1, remove_jump_to_next },
+    { PEEPHOLE_CONDITIONAL_JUMP_TO_NEXT, 1, rewrite_conditional_jump_to_next },
+    { PEEPHOLE_JUMP_THREADING, 1, thread_jump },
+};
+
+static void mark_jump_targets(bytecode_generator* generator, bool* is_jump_target)
+{
+    for (int i = 0; i <= generator->instruction_count; i++)
+    {
+        is_jump_target[i] = false;
+    }
+
+    for (int i = 0; i < generator->instruction_count; i++)
+    {
+        if (is_jump_op_code(generator->instructions[i].op_code) == false)
+        {
+            continue;
+        }
+
+        int target = get_jump_target(generator->instructions, i);
+        if (target >= 0 && target <= generator->instruction_count)
+        {
+            is_jump_target[target] = true;
+        }
+    }
+}
+
+/// @brief Checks that control can only enter the window at its first instruction, so rewriting it can't change what a jump lands on.
+static bool is_window_straight_line(const bool* is_jump_target, int index, int window_size)
+{
+    for (int i = 1; i < window_size; i++)
+    {
+        if (is_jump_target[index + i] == true)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool run_peephole_pass(bytecode_generator* generator, bool* removed, bool* is_jump_target, optimization_statistics* statistics)
+{
+    bool changed = false;
+    int rule_count = sizeof(peephole_rules) / sizeof(peephole_rules[0]);
+
+    mark_jump_targets(generator, is_jump_target);
+    for (int i = 0; i < generator->instruction_count; i++)
+    {
+        removed[i] = false;
+    }
+
+    for (int i = 0; i < generator->instruction_count; i++)
+    {
+        for (int rule_index = 0; rule_index < rule_count; rule_index++)
+        {
+            const peephole_rule* rule = &peephole_rules[rule_index];
+            if (i + rule->window_size > generator->instruction_count || is_window_straight_line(is_jump_target, i, rule->window_size) == false)
+            {
+                continue;
+            }
+
+            if (rule->apply(generator, i, removed) == false)
+            {
+                continue;
+            }
+
+            changed = true;
+            if (statistics != NULL)
+            {
+                statistics->peephole_rule_hits[rule->id]++;
+            }
+
+            /* don't let windows overlap within a pass, the next pass sees the rewritten code */
+            i += rule->window_size - 1;
+            break;
+        }
+    }
+
+    remove_instructions(generator, removed);
+    return changed;
+}
+
+int optimize_peephole(bytecode_generator* generator, optimization_statistics* statistics)
+{
+    int instruction_count_before = generator->instruction_count;
+
+    /* one extra flag for a jump that targets one past the last instruction */
+    bool* removed = (bool*)safe_malloc((instruction_count_before + 1) * sizeof(bool));
+    bool* is_jump_target = (bool*)safe_malloc((instruction_count_before + 1) * sizeof(bool));
+
+    for (int pass = 0; pass < MAXIMUM_PEEPHOLE_PASSES; pass++)
+    {
+        if (statistics != NULL)
+        {
+            statistics->peephole_passes++;
+        }
+
+        if (run_peephole_pass(generator, removed, is_jump_target, statistics) == false)
+        {
+            break;
+        }
+    }
+
+    safe_free(removed);
+    safe_free(is_jump_target);
+
+    return instruction_count_before - generator->instruction_count;
+}
\ No newline at end of file
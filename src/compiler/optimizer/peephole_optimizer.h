@@ -0,0 +1,16 @@
+#ifndef PEEPHOLE_OPTIMIZER
+#define PEEPHOLE_OPTIMIZER
+#include <stdbool.h>
+#include <stdlib.h>
+#include "../../core/extensions/memory_extensions.h"
+#include "../../core/types/bytecode.h"
+#include "../bytecode_generator/bytecode_generator.h"
+#include "optimization_statistics.h"
+
+/// @brief Rewrites short sequences of the `generator` instructions into cheaper equivalents until no rule in the rule table applies.
+/// @param generator The `bytecode_generator` that holds the emitted instructions.
+/// @param statistics The optimization statistics to record each applied rule in, can be `NULL`.
+/// @return The amount of instructions that were removed.
+int optimize_peephole(bytecode_generator* generator, optimization_statistics* statistics);
+
+#endif
\ No newline at end of file
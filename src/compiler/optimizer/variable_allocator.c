@@ -0,0 +1,245 @@
+#include "variable_allocator.h"
+
+static bool is_variable_instruction(instruction instruction)
+{
+    return instruction.op_code == OP_LOAD_VAR || instruction.op_code == OP_STORE_VAR;
+}
+
+static int compare_live_intervals(const void* left, const void* right)
+{
+    const live_interval* left_interval = (const live_interval*)left;
+    const live_interval* right_interval = (const live_interval*)right;
+    if (left_interval->start != right_interval->start)
+    {
+        return left_interval->start < right_interval->start ? -1 : 1;
+    }
+
+    return left_interval->variable_index - right_interval->variable_index;
+}
+
+/// @brief Gets one more than the highest variable index used by any instruction.
+static int get_variable_index_limit(bytecode_generator* generator)
+{
+    int limit = generator->variable_count;
+    for (int i = 0; i < generator->instruction_count; i++)
+    {
+        instruction current = generator->instructions[i];
+        if (is_variable_instruction(current) && current.operand.variable.variable_index >= limit)
+        {
+            limit = current.operand.variable.variable_index + 1;
+        }
+    }
+
+    return limit;
+}
+
+/// @brief Stretches every interval that overlaps a loop to cover the whole loop, since a value can flow around the backward jump.
+static void extend_intervals_over_loops(bytecode_generator* generator, int* starts, int* ends, int variable_limit)
+{
+    bool changed = true;
+    while (changed == true)
+    {
+        changed = false;
+        for (int i = 0; i < generator->instruction_count; i++)
+        {
+            if (is_jump_op_code(generator->instructions[i].op_code) == false)
+            {
+                continue;
+            }
+
+            int target = get_jump_target(generator->instructions, i);
+            if (target > i)
+            {
+                continue;
+            }
+
+            /* the loop covers [target, i] */
+            for (int variable = 0; variable < variable_limit; variable++)
+            {
+                if (starts[variable] == -1 || ends[variable] < target || starts[variable] > i)
+                {
+                    continue;
+                }
+
+                if (starts[variable] > target)
+                {
+                    starts[variable] = target;
+                    changed = true;
+                }
+                if (ends[variable] < i)
+                {
+                    ends[variable] = i;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+live_interval* get_live_intervals(bytecode_generator* generator, int* interval_count)
+{
+    *interval_count = 0;
+
+    int variable_limit = get_variable_index_limit(generator);
+    if (variable_limit == 0)
+    {
+        return NULL;
+    }
+
+    int* starts = (int*)safe_malloc(variable_limit * sizeof(int));
+    int* ends = (int*)safe_malloc(variable_limit * sizeof(int));
+    for (int variable = 0; variable < variable_limit; variable++)
+    {
+        starts[variable] = -1;
+        ends[variable] = -1;
+    }
+
+    /* in straight-line code a variable lives from its first to its last load or store */
+    for (int i = 0; i < generator->instruction_count; i++)
+    {
+        instruction current = generator->instructions[i];
+        if (is_variable_instruction(current) == false)
+        {
+            continue;
+        }
+
+        int variable = current.operand.variable.variable_index;
+        if (starts[variable] == -1)
+        {
+            /* a variable loaded before it is stored reads its initial null, so it can't take over a slot another variable wrote */
+            starts[variable] = current.op_code == OP_LOAD_VAR ? 0 : i;
+            (*interval_count)++;
+        }
+        ends[variable] = i;
+    }
+
+    extend_intervals_over_loops(generator, starts, ends, variable_limit);
+
+    live_interval* intervals = NULL;
+    if (*interval_count > 0)
+    {
+        intervals = (live_interval*)safe_malloc(*interval_count * sizeof(live_interval));
+        int next_interval = 0;
+        for (int variable = 0; variable < variable_limit; variable++)
+        {
+            if (starts[variable] != -1)
+            {
+                intervals[next_interval++] = (live_interval){ variable, starts[variable], ends[variable] };
+            }
+        }
+        qsort(intervals, *interval_count, sizeof(live_interval), compare_live_intervals);
+    }
+
+    safe_free(starts);
+    safe_free(ends);
+
+    return intervals;
+}
+
+/* the active intervals are kept in a min-heap ordered by their end, so the next one to expire is always on top */
+
+static void push_active_interval(live_interval** heap, int* heap_count, live_interval* interval)
+{
+    int child = (*heap_count)++;
+    heap[child] = interval;
+    while (child > 0)
+    {
+        int parent = (child - 1) / 2;
+        if (heap[parent]->end <= heap[child]->end)
+        {
+            break;
+        }
+        live_interval* swap = heap[parent];
+        heap[parent] = heap[child];
+        heap[child] = swap;
+        child = parent;
+    }
+}
+
+static live_interval* pop_active_interval(live_interval** heap, int* heap_count)
+{
+    live_interval* top = heap[0];
+    heap[0] = heap[--(*heap_count)];
+
+    int parent = 0;
+    while (true)
+    {
+        int smallest = parent;
+        int left = parent * 2 + 1;
+        int right = left + 1;
+        if (left < *heap_count && heap[left]->end < heap[smallest]->end)
+        {
+            smallest = left;
+        }
+        if (right < *heap_count && heap[right]->end < heap[smallest]->end)
+        {
+            smallest = right;
+        }
+        if (smallest == parent)
+        {
+            break;
+        }
+        live_interval* swap = heap[parent];
+        heap[parent] = heap[smallest];
+        heap[smallest] = swap;
+        parent = smallest;
+    }
+
+    return top;
+}
+
+int allocate_variable_slots(bytecode_generator* generator, optimization_statistics* statistics)
+{
+    int interval_count = 0;
+    live_interval* intervals = get_live_intervals(generator, &interval_count);
+    int variable_limit = get_variable_index_limit(generator);
+
+    int* slots = (int*)safe_malloc((variable_limit + 1) * sizeof(int));
+    live_interval** active = (live_interval**)safe_malloc((interval_count + 1) * sizeof(live_interval*));
+    int* free_slots = (int*)safe_malloc((interval_count + 1) * sizeof(int));
+    int active_count = 0;
+    int free_slot_count = 0;
+    int slot_count = 0;
+
+    for (int i = 0; i < interval_count; i++)
+    {
+        live_interval* interval = &intervals[i];
+
+        /* give back the slots of every variable whose value is no longer needed */
+        while (active_count > 0 && active[0]->end < interval->start)
+        {
+            live_interval* expired = pop_active_interval(active, &active_count);
+            free_slots[free_slot_count++] = slots[expired->variable_index];
+        }
+
+        /* reuse the most recently freed slot, it is the most likely to still be in cache */
+        slots[interval->variable_index] = free_slot_count > 0 ? free_slots[--free_slot_count] : slot_count++;
+        push_active_interval(active, &active_count, interval);
+    }
+
+    for (int i = 0; i < generator->instruction_count; i++)
+    {
+        instruction* current = &generator->instructions[i];
+        if (is_variable_instruction(*current))
+        {
+            current->operand.variable.variable_index = slots[current->operand.variable.variable_index];
+        }
+    }
+
+    if (statistics != NULL)
+    {
+        statistics->variables_before = interval_count;
+        statistics->variable_slots_after = slot_count;
+    }
+    generator->variable_count = slot_count;
+
+    if (intervals != NULL)
+    {
+        safe_free(intervals);
+    }
+    safe_free(slots);
+    safe_free(active);
+    safe_free(free_slots);
+
+    return slot_count;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef VARIABLE_ALLOCATOR
+#define VARIABLE_ALLOCATOR
+#include <stdbool.h>
+#include <stdlib.h>
+#include "../../core/extensions/memory_extensions.h"
+#include "../../core/types/bytecode.h"
+#include "../bytecode_generator/bytecode_generator.h"
+#include "optimization_statistics.h"
+
+/// @struct live_interval
+/// @brief The range of instructions a variable has to keep its value for.
+typedef struct live_interval live_interval;
+
+struct live_interval
+{
+    /// @brief The variable index given by the bytecode generator.
+    int variable_index;
+    /// @brief The index of the first instruction that uses the variable.
+    int start;
+    /// @brief The index of the last instruction the variable's value is needed at.
+    int end;
+};
+
+/// @brief Computes the live interval of every variable the `generator` instructions load or store.
+/// @param generator The `bytecode_generator` that holds the emitted instructions.
+/// @param interval_count The amount of intervals that were computed.
+/// @return A collection of live intervals sorted by their start, or `NULL` if no variables are used.
+live_interval* get_live_intervals(bytecode_generator* generator, int* interval_count);
+
+/// @brief Assigns every variable of the `generator` to a slot with a linear scan over their live intervals, reusing slots of variables that are no longer live.
+/// @param generator The `bytecode_generator` that holds the emitted instructions, its `variable_count` becomes the amount of slots.
+/// @param statistics The optimization statistics to record the slot counts in, can be `NULL`.
+/// @return The amount of variable slots the program needs.
+int allocate_variable_slots(bytecode_generator* generator, optimization_statistics* statistics);
+
+#endif
\ No newline at end of file
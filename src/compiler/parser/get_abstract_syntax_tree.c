@@ -134,10 +134,14 @@ static abstract_syntax_node* parse_factor_expression()
     }
     else if (peek_token()->type == TOKEN_BIT_LITERAL_ON)
     {
+        /* consume "on" */
+        consume_token();
         return create_ast_node_bit_literal(true);
     }
     else if (peek_token()->type == TOKEN_BIT_LITERAL_OFF)
     {
+        /* consume "off" */
+        consume_token();
         return create_ast_node_bit_literal(false);
     }
 
@@ -152,6 +156,9 @@ static abstract_syntax_node* parse_factor_expression()
 
 static abstract_syntax_node* parse_function_expression()
 {
+    /* a call is located at its name, so a failing call nested in an expression points at itself */
+    token* name_token = peek_token();
+
     /* look for fluent (i.e. foo.bar()) function calls */
     if (peek_token()->type == TOKEN_IDENTIFIER && peek_token_ahead(1) != NULL && peek_token_ahead(1)->type == TOKEN_PUNCTUATION_PERIOD)
     {
@@ -210,6 +217,7 @@ static abstract_syntax_node* parse_function_expression()
             {
                 consume_token();
                 abstract_syntax_node* function_call_node = create_ast_node_function_call(full_function_name, arguments, argument_count, argument_capacity);
+                set_ast_node_location(function_call_node, name_token->line, name_token->column);
                 safe_free(full_function_name);
                 return function_call_node;
             }
@@ -263,6 +271,7 @@ static abstract_syntax_node* parse_function_expression()
             /* Consume "(" */
             consume_token();
             abstract_syntax_node* function_call_node = create_ast_node_function_call(function_name, arguments, argument_count, argument_capacity);
+            set_ast_node_location(function_call_node, name_token->line, name_token->column);
             safe_free(function_name);
             return function_call_node;
         }
@@ -330,9 +339,11 @@ static abstract_syntax_node* parse_multiplicative_expression()
 
     while (peek_token() != NULL && (peek_token()->type == TOKEN_OPERATOR_MULTIPLY || peek_token()->type == TOKEN_OPERATOR_DIVIDE))
     {
-        char* op_symbol = strdup(consume_token()->value);
+        token* operator_token = consume_token();
+        char* op_symbol = duplicate_string(operator_token->value);
         abstract_syntax_node* right = parse_factor_expression();
         left = create_ast_node_binary_operation(left, right, op_symbol);
+        set_ast_node_location(left, operator_token->line, operator_token->column);
         safe_free(op_symbol);
     }
     return left;
@@ -345,9 +356,11 @@ static abstract_syntax_node* parse_additive_expression()
 
     while (peek_token() != NULL && (peek_token()->type == TOKEN_OPERATOR_PLUS || peek_token()->type == TOKEN_OPERATOR_MINUS))
     {
-        char* op_symbol = strdup(consume_token()->value);
+        token* operator_token = consume_token();
+        char* op_symbol = duplicate_string(operator_token->value);
         abstract_syntax_node* right = parse_multiplicative_expression();
         left = create_ast_node_binary_operation(left, right, op_symbol);
+        set_ast_node_location(left, operator_token->line, operator_token->column);
         safe_free(op_symbol);
     }
     return left;
@@ -615,9 +628,12 @@ static abstract_syntax_node* parse_program()
 
     while (peek_token() != NULL && peek_token()->type != TOKEN_END_OF_FILE)
     {
+        /* every statement is located at its first token, which the instructions compiled for it are reported at */
+        token* first_token = peek_token();
         abstract_syntax_node* statement_node = parse_statement();
         if (statement_node != NULL)
         {
+            set_ast_node_location(statement_node, first_token->line, first_token->column);
             program_node->data.program_node.statements[program_node->data.program_node.statement_count] = statement_node;
             program_node->data.program_node.statement_count++;
             if (program_node->data.program_node.statement_count >= program_node->data.program_node.statement_capacity)
@@ -730,9 +746,9 @@ void free_ast(abstract_syntax_node* node)
             safe_free(node->data.error_node.message);
             break;
         case AST_NODE_DECLARATION:
-            safe_free(node->data.assignment.variable_name);
-            safe_free(node->data.type_node.type_name);
-            free_ast(node->data.assignment.expression);
+            safe_free(node->data.declaration_node.type_name);
+            safe_free(node->data.declaration_node.variable_name);
+            free_ast(node->data.declaration_node.expression);
             break;
         default:
             /* TODO: Handle other node types or do nothing if there's no data to free */
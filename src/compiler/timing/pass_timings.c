@@ -0,0 +1,125 @@
+#include "pass_timings.h"
+
+static bool is_timing = false;
+static pass_timing timings[COMPILER_PASS_COUNT];
+static uint64_t pass_starts[COMPILER_PASS_COUNT];
+static allocation_statistics pass_start_allocations[COMPILER_PASS_COUNT];
+static uint64_t total_start;
+
+void start_pass_timings()
+{
+    for (int i = 0; i < COMPILER_PASS_COUNT; i++)
+    {
+        timings[i] = (pass_timing){ 0, 0, 0, 0, 0 };
+    }
+    count_allocations();
+    is_timing = true;
+    total_start = get_monotonic_time();
+}
+
+void begin_compiler_pass(compiler_pass pass)
+{
+    if (is_timing == false)
+    {
+        return;
+    }
+
+    get_allocation_statistics(&pass_start_allocations[pass]);
+    pass_starts[pass] = get_monotonic_time();
+}
+
+void end_compiler_pass(compiler_pass pass)
+{
+    if (is_timing == false)
+    {
+        return;
+    }
+
+    uint64_t elapsed = get_elapsed_time(pass_starts[pass]);
+    allocation_statistics allocations;
+    get_allocation_statistics(&allocations);
+    size_t peak_resident_size = get_peak_resident_size();
+
+    pass_timing* timing = &timings[pass];
+    timing->run_count++;
+    timing->nanoseconds += elapsed;
+    timing->allocation_count += allocations.count - pass_start_allocations[pass].count;
+    timing->allocated_bytes += allocations.bytes - pass_start_allocations[pass].bytes;
+    timing->peak_resident_size = peak_resident_size > timing->peak_resident_size ? peak_resident_size : timing->peak_resident_size;
+}
+
+const char* get_compiler_pass_name(compiler_pass pass)
+{
+    switch (pass)
+    {
+        case COMPILER_PASS_READ: return "read";
+        case COMPILER_PASS_CACHE: return "cache";
+        case COMPILER_PASS_LEX: return "lex";
+        case COMPILER_PASS_PARSE: return "parse";
+        case COMPILER_PASS_GENERATE: return "generate";
+        case COMPILER_PASS_OPTIMIZE: return "optimize";
+        case COMPILER_PASS_SERIALIZE: return "serialize";
+        case COMPILER_PASS_LINK: return "link";
+        case COMPILER_PASS_WRITE: return "write";
+        default: return "unknown pass";
+    }
+}
+
+static void print_pass_timings_json(uint64_t total, const allocation_statistics* allocations, size_t peak_resident_size)
+{
+    /* one line of its own, so it can be picked out of the rest of the output */
+    printf("{\"passes\":[");
+    for (int i = 0; i < COMPILER_PASS_COUNT; i++)
+    {
+        const pass_timing* timing = &timings[i];
+        printf("%s{\"pass\":\"%s\",\"runs\":%d,\"time_ms\":%.3f,\"allocations\":%" PRIu64 ",\"allocated_bytes\":%" PRIu64 ",\"peak_resident_bytes\":%zu}",
+            i > 0 ? "," : "", get_compiler_pass_name((compiler_pass)i), timing->run_count, timing->nanoseconds / 1e6,
+            timing->allocation_count, timing->allocated_bytes, timing->peak_resident_size);
+    }
+    printf("],\"total_ms\":%.3f,\"allocations\":%" PRIu64 ",\"allocated_bytes\":%" PRIu64 ",\"peak_resident_bytes\":%zu}\n",
+        total / 1e6, allocations->count, allocations->bytes, peak_resident_size);
+    fflush(stdout);
+}
+
+void print_pass_timings(pass_timing_format format)
+{
+    if (is_timing == false || format == PASS_TIMING_NONE)
+    {
+        return;
+    }
+
+    uint64_t total = get_elapsed_time(total_start);
+    allocation_statistics allocations;
+    get_allocation_statistics(&allocations);
+    size_t peak_resident_size = get_peak_resident_size();
+    if (format == PASS_TIMING_JSON)
+    {
+        print_pass_timings_json(total, &allocations, peak_resident_size);
+        return;
+    }
+
+    /* build one message so the table stays together in the log */
+    char report[2048];
+    int length = snprintf(report, sizeof(report), "Pass timings:\n   %-10s %5s %11s %7s %12s %15s %14s",
+        "pass", "runs", "time (ms)", "share", "allocations", "allocated (KB)", "peak RSS (MB)");
+    uint64_t passes_total = 0;
+    for (int i = 0; i < COMPILER_PASS_COUNT; i++)
+    {
+        const pass_timing* timing = &timings[i];
+        passes_total += timing->nanoseconds;
+        if (timing->run_count == 0)
+        {
+            continue;
+        }
+        length += snprintf(report + length, sizeof(report) - length, "\n   %-10s %5d %11.3f %6.1f%% %12" PRIu64 " %15.1f %14.1f",
+            get_compiler_pass_name((compiler_pass)i), timing->run_count, timing->nanoseconds / 1e6, total > 0 ? 100.0 * timing->nanoseconds / total : 0.0,
+            timing->allocation_count, timing->allocated_bytes / 1e3, timing->peak_resident_size / 1e6);
+    }
+
+    /* the time between passes, such as finding chunks and keeping the build directory, isn't any pass's */
+    uint64_t other = total > passes_total ? total - passes_total : 0;
+    length += snprintf(report + length, sizeof(report) - length, "\n   %-10s %5s %11.3f %6.1f%%", "other", "", other / 1e6, total > 0 ? 100.0 * other / total : 0.0);
+    snprintf(report + length, sizeof(report) - length, "\n   %-10s %5s %11.3f %6.1f%% %12" PRIu64 " %15.1f %14.1f", "total", "", total / 1e6, 100.0,
+        allocations.count, allocations.bytes / 1e3, peak_resident_size / 1e6);
+    log_info("%s", report);
+}
\ No newline at end of file
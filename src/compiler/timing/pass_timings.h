@@ -0,0 +1,70 @@
+#ifndef PASS_TIMINGS
+#define PASS_TIMINGS
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "../../core/extensions/memory_extensions.h"
+#include "../../core/extensions/time_extensions.h"
+#include "../../core/logger/logger.h"
+#include "../types/compiler_options.h"
+
+/**
+ * Pass timings record how long every pass of the compiler took on a monotonic clock, how many allocations it made and
+ * how many bytes they asked for, and the peak resident memory of the compiler once it was done. A pass that runs once
+ * for every chunk adds every run up. Nothing is recorded until `start_pass_timings` is called, so a compilation that
+ * doesn't report them only pays for checking a flag at the start and end of every pass.
+ */
+
+/// @enum compiler_pass
+/// @brief The passes of the compiler, in the order they run for a chunk.
+typedef enum compiler_pass
+{
+    COMPILER_PASS_READ,
+    COMPILER_PASS_CACHE,
+    COMPILER_PASS_LEX,
+    COMPILER_PASS_PARSE,
+    COMPILER_PASS_GENERATE,
+    COMPILER_PASS_OPTIMIZE,
+    COMPILER_PASS_SERIALIZE,
+    COMPILER_PASS_LINK,
+    COMPILER_PASS_WRITE,
+    COMPILER_PASS_COUNT
+} compiler_pass;
+
+/// @struct pass_timing
+/// @brief What every run of a compiler pass took, added up.
+typedef struct pass_timing pass_timing;
+
+struct pass_timing
+{
+    /// @brief The amount of times the pass ran.
+    int run_count;
+    uint64_t nanoseconds;
+    uint64_t allocation_count;
+    uint64_t allocated_bytes;
+    /// @brief The peak resident memory of the compiler at the end of the pass, in bytes.
+    size_t peak_resident_size;
+};
+
+/// @brief Starts recording pass timings, and the total time from now on.
+void start_pass_timings();
+
+/// @brief Records the start of a run of a compiler pass, if pass timings are recorded.
+/// @param pass The pass that starts.
+void begin_compiler_pass(compiler_pass pass);
+
+/// @brief Records the end of a run of a compiler pass, if pass timings are recorded.
+/// @param pass The pass that ends.
+void end_compiler_pass(compiler_pass pass);
+
+/// @brief Gets the name of a compiler pass.
+/// @param pass The compiler pass.
+/// @return The name of the pass.
+const char* get_compiler_pass_name(compiler_pass pass);
+
+/// @brief Reports the pass timings recorded since `start_pass_timings`, as a table in the log or as a line of JSON on stdout.
+/// @param format How to report the pass timings.
+void print_pass_timings(pass_timing_format format);
+
+#endif
\ No newline at end of file
@@ -10,6 +10,8 @@ static abstract_syntax_node* create_new_node(abstract_syntax_node_type type)
     }
 
     node->type = type;
+    node->line = 0;
+    node->column = 0;
     node->left = NULL;
     node->right = NULL;
     node->children = NULL;
@@ -17,6 +19,17 @@ static abstract_syntax_node* create_new_node(abstract_syntax_node_type type)
     return node;
 }
 
+void set_ast_node_location(abstract_syntax_node* node, int line, int column)
+{
+    if (node == NULL || node->line > 0)
+    {
+        return;
+    }
+
+    node->line = line;
+    node->column = column;
+}
+
 void print_ast_node(abstract_syntax_node* node, int indent)
 {
     /* guard against NULL nodes */
@@ -38,6 +38,10 @@ typedef struct abstract_syntax_node abstract_syntax_node;
 struct abstract_syntax_node
 {
     abstract_syntax_node_type type;
+    /// @brief The line of the token the node was parsed at, `0` if the node doesn't record one.
+    int line;
+    /// @brief The column of the token the node was parsed at.
+    int column;
     struct abstract_syntax_node* left;
     struct abstract_syntax_node* right;
     struct abstract_syntax_node** children;
@@ -163,6 +167,12 @@ void print_ast_node(abstract_syntax_node* node, int indent);
 /// @return The name of the `type`, or `UNKNOWN` by default.
 const char* get_ast_node_type_name(abstract_syntax_node_type type);
 
+/// @brief Records where in the source a `node` was parsed, unless it already records a place of its own.
+/// @param node The node to record the place of, can be `NULL`.
+/// @param line The line the node was parsed at.
+/// @param column The column the node was parsed at.
+void set_ast_node_location(abstract_syntax_node* node, int line, int column);
+
 /// @brief Creates an `AST_NODE_BINARY_OP` abstract syntax node.
 /// @param left The left side of the binary operation.
 /// @param right The right side of the binary operation.
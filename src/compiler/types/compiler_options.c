@@ -0,0 +1,144 @@
+#include "compiler_options.h"
+
+void create_compiler_options(compiler_options* options)
+{
+    options->input_path = NULL;
+    options->output_path = "bin/program.lbc";
+    options->print_optimization_statistics = false;
+    options->optimization_level = 1;
+    options->dump_ir = false;
+    options->minimum_log_level = LOG_LEVEL_DEBUG;
+    options->compress_sections = false;
+    options->cache_directory = NULL;
+    options->build_directory = NULL;
+    options->write_archive = false;
+    options->print_cache_statistics = false;
+    options->time_passes = PASS_TIMING_NONE;
+}
+
+bool parse_compiler_options(int argc, const char* argv[], compiler_options* options)
+{
+    create_compiler_options(options);
+    bool is_output_path_given = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* argument = argv[i];
+
+        if (strcmp(argument, "--opt-stats") == 0)
+        {
+            options->print_optimization_statistics = true;
+            continue;
+        }
+
+        if (strcmp(argument, "-O0") == 0 || strcmp(argument, "-O1") == 0 || strcmp(argument, "-O2") == 0)
+        {
+            options->optimization_level = argument[2] - '0';
+            continue;
+        }
+
+        if (strcmp(argument, "-o") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                log_error("Compiler error: -o must be followed by an output path, or - for stdout.");
+                return false;
+            }
+            options->output_path = argv[++i];
+            is_output_path_given = true;
+            continue;
+        }
+
+        if (strcmp(argument, "--compress") == 0)
+        {
+            options->compress_sections = true;
+            continue;
+        }
+
+        if (strcmp(argument, "--archive") == 0)
+        {
+            options->write_archive = true;
+            continue;
+        }
+
+        if (strncmp(argument, "--cache-dir=", strlen("--cache-dir=")) == 0)
+        {
+            options->cache_directory = argument + strlen("--cache-dir=");
+            if (strlen(options->cache_directory) == 0)
+            {
+                log_error("Compiler error: --cache-dir= must be followed by a directory.");
+                return false;
+            }
+            continue;
+        }
+
+        if (strncmp(argument, "--build-dir=", strlen("--build-dir=")) == 0)
+        {
+            options->build_directory = argument + strlen("--build-dir=");
+            if (strlen(options->build_directory) == 0)
+            {
+                log_error("Compiler error: --build-dir= must be followed by a directory.");
+                return false;
+            }
+            continue;
+        }
+
+        if (strcmp(argument, "--cache-stats") == 0)
+        {
+            options->print_cache_statistics = true;
+            continue;
+        }
+
+        if (strcmp(argument, "--time-passes") == 0 || strcmp(argument, "--time-passes=table") == 0)
+        {
+            options->time_passes = PASS_TIMING_TABLE;
+            continue;
+        }
+
+        if (strcmp(argument, "--time-passes=json") == 0)
+        {
+            options->time_passes = PASS_TIMING_JSON;
+            continue;
+        }
+
+        if (strcmp(argument, "--dump-ir") == 0)
+        {
+            options->dump_ir = true;
+            continue;
+        }
+
+        if (strncmp(argument, "--log-level=", strlen("--log-level=")) == 0)
+        {
+            const char* level_name = argument + strlen("--log-level=");
+            if (parse_log_level(level_name, &options->minimum_log_level) == false)
+            {
+                log_error("Compiler error: Unknown log level \"%s\", expected debug, info, warning or error.", level_name);
+                return false;
+            }
+            continue;
+        }
+
+        /* anything that isn't an option is the entry file */
+        if (argument[0] != '-' && options->input_path == NULL)
+        {
+            options->input_path = argument;
+            continue;
+        }
+
+        log_error("Compiler error: Unknown argument \"%s\".", argument);
+        return false;
+    }
+
+    if (options->write_archive == true && is_output_path_given == false)
+    {
+        options->output_path = "bin/program.lba";
+    }
+
+    if (options->print_cache_statistics == true && options->cache_directory == NULL)
+    {
+        log_error("Compiler error: --cache-stats needs a compile cache, given with --cache-dir=<directory>.");
+        return false;
+    }
+
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef COMPILER_OPTIONS
+#define COMPILER_OPTIONS
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../core/logger/logger.h"
+
+/// @brief The version of the L# compiler, which is part of every compile cache key so a new compiler never reuses old bytecode.
+#define LSC_VERSION "0.1.0"
+
+/// @enum pass_timing_format
+/// @brief How the time, allocations and memory of every compiler pass are reported.
+typedef enum pass_timing_format
+{
+    PASS_TIMING_NONE,
+    PASS_TIMING_TABLE,
+    PASS_TIMING_JSON
+} pass_timing_format;
+
+/// @struct compiler_options
+/// @brief The command-line options that change how the L# compiler behaves.
+typedef struct compiler_options compiler_options;
+
+struct compiler_options
+{
+    /// @brief The path to the L# entry file.
+    const char* input_path;
+    /// @brief The path to the bytecode file that will be written, `-` to write it to stdout.
+    const char* output_path;
+    /// @brief `true` if optimization statistics should be reported after compiling.
+    bool print_optimization_statistics;
+    /// @brief How much the bytecode is optimized, `0` for none, `1` for the bytecode passes, `2` to also optimize an SSA intermediate representation.
+    int optimization_level;
+    /// @brief `true` if the intermediate representation should be printed after it is optimized.
+    bool dump_ir;
+    /// @brief Calls to builtin logging functions below this level are left out of the bytecode.
+    log_level minimum_log_level;
+    /// @brief `true` if the code, constants and strings sections should be compressed when that makes them smaller.
+    bool compress_sections;
+    /// @brief The directory of previously compiled bytecode files to reuse, `NULL` to always compile.
+    const char* cache_directory;
+    /// @brief The directory that keeps the unit of every chunk and the manifest of how they were built, `NULL` to compile every chunk.
+    const char* build_directory;
+    /// @brief `true` if every chunk should be bundled into an .lba archive that the runtime grabs them from, instead of being linked into one .lbc file.
+    bool write_archive;
+    /// @brief `true` if whether the compile cache was hit, and how well it has served so far, should be reported.
+    bool print_cache_statistics;
+    /// @brief How the time every compiler pass took should be reported, if at all.
+    pass_timing_format time_passes;
+};
+
+/// @brief Fills `options` with the default compiler options.
+/// @param options The compiler options to fill.
+void create_compiler_options(compiler_options* options);
+
+/// @brief Parses the command-line arguments of the L# compiler into `options`.
+/// @param argc The number of command-line arguments.
+/// @param argv An array of command-line arguments.
+/// @param options The compiler options to fill.
+/// @return `true` if all arguments were understood, `false` otherwise.
+bool parse_compiler_options(int argc, const char* argv[], compiler_options* options);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "byte_extensions.h"
+
+void write_u16(unsigned char* bytes, uint16_t number)
+{
+    bytes[0] = (unsigned char)number;
+    bytes[1] = (unsigned char)(number >> 8);
+}
+
+void write_u32(unsigned char* bytes, uint32_t number)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        bytes[i] = (unsigned char)(number >> (8 * i));
+    }
+}
+
+void write_u64(unsigned char* bytes, uint64_t number)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        bytes[i] = (unsigned char)(number >> (8 * i));
+    }
+}
+
+uint16_t read_u16(const unsigned char* bytes)
+{
+    return (uint16_t)(bytes[0] | bytes[1] << 8);
+}
+
+uint32_t read_u32(const unsigned char* bytes)
+{
+    return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+uint64_t read_u64(const unsigned char* bytes)
+{
+    return (uint64_t)read_u32(bytes) | (uint64_t)read_u32(bytes + 4) << 32;
+}
\ No newline at end of file
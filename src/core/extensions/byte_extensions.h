@@ -0,0 +1,40 @@
+#ifndef BYTE_EXTENSIONS
+#define BYTE_EXTENSIONS
+#include <stdint.h>
+
+/**
+ * Every number in an L# file, be it bytecode, an archive or a snapshot, is stored little-endian regardless of the
+ * host, so the files one machine writes can be read on any other.
+ */
+
+/// @brief Writes a 16-bit number as 2 little-endian bytes.
+/// @param bytes Where to write the number.
+/// @param number The number to write.
+void write_u16(unsigned char* bytes, uint16_t number);
+
+/// @brief Writes a 32-bit number as 4 little-endian bytes.
+/// @param bytes Where to write the number.
+/// @param number The number to write.
+void write_u32(unsigned char* bytes, uint32_t number);
+
+/// @brief Writes a 64-bit number as 8 little-endian bytes.
+/// @param bytes Where to write the number.
+/// @param number The number to write.
+void write_u64(unsigned char* bytes, uint64_t number);
+
+/// @brief Reads a 16-bit number from 2 little-endian bytes.
+/// @param bytes The bytes to read.
+/// @return The number.
+uint16_t read_u16(const unsigned char* bytes);
+
+/// @brief Reads a 32-bit number from 4 little-endian bytes.
+/// @param bytes The bytes to read.
+/// @return The number.
+uint32_t read_u32(const unsigned char* bytes);
+
+/// @brief Reads a 64-bit number from 8 little-endian bytes.
+/// @param bytes The bytes to read.
+/// @return The number.
+uint64_t read_u64(const unsigned char* bytes);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,215 @@
+#include "compression_extensions.h"
+
+#define LZ_HASH_BITS 14
+#define LZ_MAXIMUM_OFFSET 65535
+
+/// @brief Matches are never searched for this close to the end, so reading 4 bytes ahead always stays in bounds.
+#define LZ_END_MARGIN 12
+
+/// @brief The last bytes of the input are always literals.
+#define LZ_LAST_LITERALS 5
+
+static uint32_t read_sequence(const unsigned char* bytes)
+{
+    uint32_t sequence;
+    memcpy(&sequence, bytes, sizeof(sequence));
+    return sequence;
+}
+
+static uint32_t hash_sequence(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/// @brief Writes the bytes that extend a nibble of 15.
+static unsigned char* write_length(unsigned char* output, size_t length)
+{
+    while (length >= 255)
+    {
+        *output++ = 255;
+        length -= 255;
+    }
+    *output++ = (unsigned char)length;
+
+    return output;
+}
+
+/// @brief Writes one sequence, a `match_length` of `0` writes the literals-only last sequence.
+/// @return The end of the written sequence, or `NULL` if it doesn't fit before `output_end`.
+static unsigned char* write_sequence(unsigned char* output, unsigned char* output_end, const unsigned char* literals, size_t literal_length, size_t offset, size_t match_length)
+{
+    /* the worst case: token, literal length bytes, literals, offset and match length bytes */
+    size_t needed = 1 + literal_length / 255 + 1 + literal_length + 2 + match_length / 255 + 1;
+    if (needed > (size_t)(output_end - output))
+    {
+        return NULL;
+    }
+
+    unsigned char* token = output++;
+    *token = (unsigned char)((literal_length >= 15 ? 15 : literal_length) << 4);
+    if (literal_length >= 15)
+    {
+        output = write_length(output, literal_length - 15);
+    }
+    memcpy(output, literals, literal_length);
+    output += literal_length;
+
+    if (match_length == 0)
+    {
+        return output;
+    }
+
+    *output++ = (unsigned char)offset;
+    *output++ = (unsigned char)(offset >> 8);
+    size_t extra_length = match_length - LZ_MINIMUM_MATCH;
+    *token |= (unsigned char)(extra_length >= 15 ? 15 : extra_length);
+    if (extra_length >= 15)
+    {
+        output = write_length(output, extra_length - 15);
+    }
+
+    return output;
+}
+
+/// @brief Reads the bytes that extend a nibble of 15.
+/// @return `false` if the input ends before the length does.
+static bool read_length(const unsigned char** input, const unsigned char* input_end, size_t* length)
+{
+    unsigned char byte;
+    do
+    {
+        if (*input >= input_end)
+        {
+            return false;
+        }
+        byte = *(*input)++;
+        *length += byte;
+    } while (byte == 255);
+
+    return true;
+}
+
+size_t get_maximum_compressed_size(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+size_t compress_lz(const void* source, size_t size, void* destination, size_t capacity)
+{
+    const unsigned char* input = (const unsigned char*)source;
+    unsigned char* output = (unsigned char*)destination;
+    unsigned char* output_end = output + capacity;
+
+    /* positions are stored plus one, so a zeroed table means no position yet */
+    uint32_t* table = (uint32_t*)safe_malloc(sizeof(uint32_t) << LZ_HASH_BITS);
+    memset(table, 0, sizeof(uint32_t) << LZ_HASH_BITS);
+
+    size_t anchor = 0;
+    size_t position = 0;
+    size_t search_limit = size > LZ_END_MARGIN ? size - LZ_END_MARGIN : 0;
+    while (position < search_limit && output != NULL)
+    {
+        uint32_t sequence = read_sequence(input + position);
+        uint32_t hash = hash_sequence(sequence);
+        size_t candidate = table[hash];
+        table[hash] = (uint32_t)(position + 1);
+
+        if (candidate == 0 || position - (candidate - 1) > LZ_MAXIMUM_OFFSET || read_sequence(input + candidate - 1) != sequence)
+        {
+            /* skip ahead faster the longer nothing has matched, so data that doesn't compress stays cheap */
+            position += 1 + ((position - anchor) >> 6);
+            continue;
+        }
+        candidate--;
+
+        size_t match_length = LZ_MINIMUM_MATCH;
+        size_t match_limit = size - LZ_LAST_LITERALS - position;
+        while (match_length < match_limit && input[candidate + match_length] == input[position + match_length])
+        {
+            match_length++;
+        }
+
+        output = write_sequence(output, output_end, input + anchor, position - anchor, position - candidate, match_length);
+        position += match_length;
+        anchor = position;
+    }
+
+    if (output != NULL)
+    {
+        output = write_sequence(output, output_end, input + anchor, size - anchor, 0, 0);
+    }
+    safe_free(table);
+
+    return output != NULL ? (size_t)(output - (unsigned char*)destination) : 0;
+}
+
+bool decompress_lz(const void* source, size_t size, void* destination, size_t decompressed_size)
+{
+    const unsigned char* input = (const unsigned char*)source;
+    const unsigned char* input_end = input + size;
+    unsigned char* output_start = (unsigned char*)destination;
+    unsigned char* output = output_start;
+    unsigned char* output_end = output + decompressed_size;
+
+    while (input < input_end)
+    {
+        unsigned char token = *input++;
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && read_length(&input, input_end, &literal_length) == false)
+        {
+            return false;
+        }
+        if (literal_length > (size_t)(input_end - input) || literal_length > (size_t)(output_end - output))
+        {
+            return false;
+        }
+        memcpy(output, input, literal_length);
+        input += literal_length;
+        output += literal_length;
+
+        /* only the last sequence ends right after its literals */
+        if (input == input_end)
+        {
+            break;
+        }
+
+        if (input_end - input < 2)
+        {
+            return false;
+        }
+        size_t offset = (size_t)input[0] | (size_t)input[1] << 8;
+        input += 2;
+        if (offset == 0 || offset > (size_t)(output - output_start))
+        {
+            return false;
+        }
+
+        size_t match_length = (token & 15) + LZ_MINIMUM_MATCH;
+        if ((token & 15) == 15 && read_length(&input, input_end, &match_length) == false)
+        {
+            return false;
+        }
+        if (match_length > (size_t)(output_end - output))
+        {
+            return false;
+        }
+
+        const unsigned char* match = output - offset;
+        if (offset >= match_length)
+        {
+            memcpy(output, match, match_length);
+            output += match_length;
+        }
+        else
+        {
+            /* an overlapping match repeats the bytes it is still writing */
+            for (size_t i = 0; i < match_length; i++)
+            {
+                *output++ = match[i];
+            }
+        }
+    }
+
+    return output == output_end;
+}
\ No newline at end of file
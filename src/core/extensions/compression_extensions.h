@@ -0,0 +1,41 @@
+#ifndef COMPRESSION_EXTENSIONS
+#define COMPRESSION_EXTENSIONS
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "memory_extensions.h"
+
+/**
+ * A small LZ77 codec in the spirit of LZ4: a compressed block is a series of sequences, each a token byte whose
+ * high nibble is the amount of literals and whose low nibble is the match length minus LZ_MINIMUM_MATCH, the
+ * literals themselves, and then a 16-bit little-endian offset back into the output. A nibble of 15 is followed by
+ * length bytes that are added to it, up to and including the first one that isn't 255. The last sequence has
+ * literals only. Decoding is a loop of copies with no entropy coding, so it runs far faster than a disk reads.
+ */
+
+/// @brief The shortest match worth encoding.
+#define LZ_MINIMUM_MATCH 4
+
+/// @brief Gets the most bytes compressing `size` bytes can produce, for data that doesn't compress at all.
+/// @param size The amount of bytes to compress.
+/// @return The capacity a destination needs to always hold the compressed bytes.
+size_t get_maximum_compressed_size(size_t size);
+
+/// @brief Compresses `size` bytes.
+/// @param source The bytes to compress.
+/// @param size The amount of bytes to compress.
+/// @param destination The buffer to write the compressed bytes to.
+/// @param capacity The size of the `destination`.
+/// @return The amount of compressed bytes, or `0` if they don't fit in the `destination`.
+size_t compress_lz(const void* source, size_t size, void* destination, size_t capacity);
+
+/// @brief Decompresses bytes compressed by `compress_lz`, never reading or writing outside of either buffer.
+/// @param source The compressed bytes.
+/// @param size The amount of compressed bytes.
+/// @param destination The buffer to write the decompressed bytes to.
+/// @param decompressed_size The amount of bytes the data decompresses to.
+/// @return `true` if the data decompressed to exactly `decompressed_size` bytes, `false` if it is corrupt.
+bool decompress_lz(const void* source, size_t size, void* destination, size_t decompressed_size);
+
+#endif
\ No newline at end of file
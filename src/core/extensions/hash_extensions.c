@@ -0,0 +1,125 @@
+#include "hash_extensions.h"
+
+/// @brief The reversed Castagnoli polynomial.
+#define CRC32C_POLYNOMIAL 0x82F63B78u
+
+/* eight tables let the software checksum take 8 bytes per step, the first one is the classic byte-at-a-time table */
+static uint32_t crc32c_tables[8][256];
+static bool are_tables_ready = false;
+
+static void create_crc32c_tables()
+{
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (CRC32C_POLYNOMIAL & (0u - (crc & 1)));
+        }
+        crc32c_tables[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        for (int table = 1; table < 8; table++)
+        {
+            uint32_t previous = crc32c_tables[table - 1][i];
+            crc32c_tables[table][i] = (previous >> 8) ^ crc32c_tables[0][previous & 0xFF];
+        }
+    }
+    are_tables_ready = true;
+}
+
+static uint32_t update_crc32c_software(uint32_t crc, const unsigned char* bytes, size_t size)
+{
+    if (are_tables_ready == false)
+    {
+        create_crc32c_tables();
+    }
+
+    /* slicing-by-8, the 8 bytes are read one at a time so it works on any byte order and alignment */
+    while (size >= 8)
+    {
+        uint32_t low = crc ^ ((uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24);
+        crc = crc32c_tables[7][low & 0xFF] ^ crc32c_tables[6][(low >> 8) & 0xFF]
+            ^ crc32c_tables[5][(low >> 16) & 0xFF] ^ crc32c_tables[4][low >> 24]
+            ^ crc32c_tables[3][bytes[4]] ^ crc32c_tables[2][bytes[5]]
+            ^ crc32c_tables[1][bytes[6]] ^ crc32c_tables[0][bytes[7]];
+        bytes += 8;
+        size -= 8;
+    }
+    while (size > 0)
+    {
+        crc = (crc >> 8) ^ crc32c_tables[0][(crc ^ *bytes) & 0xFF];
+        bytes++;
+        size--;
+    }
+
+    return crc;
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+/// @brief Uses the SSE4.2 `crc32` instruction, which computes exactly the Castagnoli polynomial.
+__attribute__((target("sse4.2")))
+static uint32_t update_crc32c_hardware(uint32_t crc, const unsigned char* bytes, size_t size)
+{
+    uint64_t crc64 = crc;
+    while (size >= 8)
+    {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        bytes += 8;
+        size -= 8;
+    }
+    crc = (uint32_t)crc64;
+    while (size > 0)
+    {
+        crc = _mm_crc32_u8(crc, *bytes);
+        bytes++;
+        size--;
+    }
+
+    return crc;
+}
+
+static bool has_hardware_crc32c()
+{
+    static int is_supported = -1;
+    if (is_supported < 0)
+    {
+        is_supported = __builtin_cpu_supports("sse4.2") ? 1 : 0;
+    }
+
+    return is_supported == 1;
+}
+#endif
+
+uint32_t update_crc32c(uint32_t checksum, const void* data, size_t size)
+{
+    /* the running value is kept inverted, so a checksum can be continued from where it stopped */
+    uint32_t crc = ~checksum;
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    if (has_hardware_crc32c() == true)
+    {
+        return ~update_crc32c_hardware(crc, (const unsigned char*)data, size);
+    }
+#endif
+
+    return ~update_crc32c_software(crc, (const unsigned char*)data, size);
+}
+
+uint32_t get_crc32c(const void* data, size_t size)
+{
+    return update_crc32c(0, data, size);
+}
+
+uint64_t update_fnv1a64(uint64_t hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+    }
+
+    return hash;
+}
\ No newline at end of file
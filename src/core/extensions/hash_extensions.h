@@ -0,0 +1,34 @@
+#ifndef HASH_EXTENSIONS
+#define HASH_EXTENSIONS
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#endif
+
+/// @brief Computes the CRC32C (Castagnoli) checksum of `size` bytes.
+/// @param data The bytes to checksum.
+/// @param size The amount of bytes.
+/// @return The checksum of the bytes.
+uint32_t get_crc32c(const void* data, size_t size);
+
+/// @brief Continues a CRC32C checksum over more bytes, so data can be checksummed in pieces.
+/// @param checksum The checksum of the bytes before `data`, `0` to start a new checksum.
+/// @param data The bytes to checksum.
+/// @param size The amount of bytes.
+/// @return The checksum of every byte so far.
+uint32_t update_crc32c(uint32_t checksum, const void* data, size_t size);
+
+/// @brief The 64-bit FNV-1a hash of no bytes at all, where every hash starts.
+#define FNV1A64_OFFSET_BASIS 0xCBF29CE484222325ull
+
+/// @brief Continues a 64-bit FNV-1a hash over more bytes, so data can be hashed in pieces.
+/// @param hash The hash of the bytes before `data`, `FNV1A64_OFFSET_BASIS` to start a new hash.
+/// @param data The bytes to hash.
+/// @param size The amount of bytes.
+/// @return The hash of every byte so far.
+uint64_t update_fnv1a64(uint64_t hash, const void* data, size_t size);
+
+#endif
\ No newline at end of file
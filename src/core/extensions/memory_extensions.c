@@ -1,8 +1,25 @@
+/* getrusage is POSIX, which strict C17 hides unless asked for */
+#define _POSIX_C_SOURCE 200809L
 #include "memory_extensions.h"
 
+/* allocations are only counted once something asks for it, every other allocation only checks the flag */
+static bool is_counting_allocations = false;
+static allocation_statistics allocations = { 0, 0 };
+
+void* try_malloc(size_t size)
+{
+    if (is_counting_allocations == true)
+    {
+        allocations.count++;
+        allocations.bytes += size;
+    }
+
+    return malloc(size);
+}
+
 void* safe_malloc(size_t size)
 {
-    void* ptr = malloc(size);
+    void* ptr = try_malloc(size);
     if (ptr == NULL)
     {
         log_error("Core error: Memory allocation failed (size: %zu bytes).", size);
@@ -12,6 +29,32 @@ void* safe_malloc(size_t size)
     return ptr;
 }
 
+void count_allocations()
+{
+    is_counting_allocations = true;
+}
+
+void get_allocation_statistics(allocation_statistics* statistics)
+{
+    *statistics = allocations;
+}
+
+size_t get_peak_resident_size()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+
+    /* Linux reports kilobytes, macOS reports bytes */
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss;
+#else
+    return (size_t)usage.ru_maxrss * 1024;
+#endif
+}
+
 void safe_free(void* ptr)
 {
     if (ptr == NULL)
@@ -1,14 +1,45 @@
 #ifndef MEMORY_EXTENSIONS
 #define MEMORY_EXTENSIONS
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/resource.h>
 #include "../logger/logger.h"
 
+/// @struct allocation_statistics
+/// @brief The allocations `safe_malloc` made while they were counted.
+typedef struct allocation_statistics allocation_statistics;
+
+struct allocation_statistics
+{
+    /// @brief The amount of allocations.
+    uint64_t count;
+    /// @brief The amount of bytes that were asked for, altogether.
+    uint64_t bytes;
+};
+
 /// @brief Safely allocates memory of `size` bytes, or exits the program.
 /// @param size The amount of bytes to allocate in memory.
 /// @return A pointer which can be casted to a pointer of the expected type.
 void* safe_malloc(size_t size);
 
+/// @brief Allocates memory of `size` bytes like `safe_malloc`, but leaves running out of memory to the caller instead of exiting.
+/// @param size The amount of bytes to allocate in memory.
+/// @return A pointer which can be casted to a pointer of the expected type, or `NULL` if there isn't enough memory.
+void* try_malloc(size_t size);
+
+/// @brief Starts counting the allocations `safe_malloc` makes, which aren't counted until something asks for them.
+void count_allocations();
+
+/// @brief Gets how many allocations `safe_malloc` made since `count_allocations` was called, and how big they were.
+/// @param statistics The allocation statistics to fill.
+void get_allocation_statistics(allocation_statistics* statistics);
+
+/// @brief Gets the most memory the process has had resident at once so far.
+/// @return The peak resident set size in bytes, or `0` if it can't be read.
+size_t get_peak_resident_size();
+
 /// @brief Safely frees the allocated memory of `ptr`.
 /// @param ptr The pointer to free memory for.
 void safe_free(void* ptr);
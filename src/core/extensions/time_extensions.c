@@ -0,0 +1,15 @@
+/* clock_gettime is POSIX, which strict C17 hides unless asked for */
+#define _POSIX_C_SOURCE 200809L
+#include "time_extensions.h"
+
+uint64_t get_monotonic_time()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+uint64_t get_elapsed_time(uint64_t start)
+{
+    return get_monotonic_time() - start;
+}
\ No newline at end of file
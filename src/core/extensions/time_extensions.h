@@ -0,0 +1,15 @@
+#ifndef TIME_EXTENSIONS
+#define TIME_EXTENSIONS
+#include <stdint.h>
+#include <time.h>
+
+/// @brief Gets the time of a clock that only ever moves forward, unlike the wall clock, for measuring how long something takes.
+/// @return The time in nanoseconds since an unspecified starting point.
+uint64_t get_monotonic_time();
+
+/// @brief Gets how long it has been since a time read from `get_monotonic_time`.
+/// @param start The earlier monotonic time, in nanoseconds.
+/// @return The time since `start` in nanoseconds.
+uint64_t get_elapsed_time(uint64_t start);
+
+#endif
\ No newline at end of file
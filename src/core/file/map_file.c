@@ -0,0 +1,104 @@
+/* mmap, fstat and the file descriptor functions are POSIX, which strict C17 hides unless asked for */
+#define _POSIX_C_SOURCE 200809L
+#include "map_file.h"
+
+/// @brief Reads the rest of a file descriptor into an allocation, for files that can't be mapped.
+static bool read_file_descriptor(int descriptor, size_t size_hint, mapped_file* file)
+{
+    size_t capacity = size_hint > 0 ? size_hint : 4096;
+    size_t size = 0;
+    char* data = (char*)safe_malloc(capacity);
+    for (;;)
+    {
+        if (size == capacity)
+        {
+            capacity *= 2;
+            char* larger = (char*)safe_malloc(capacity);
+            memcpy(larger, data, size);
+            safe_free(data);
+            data = larger;
+        }
+
+        ssize_t bytes_read = read(descriptor, data + size, capacity - size);
+        if (bytes_read == 0)
+        {
+            break;
+        }
+        if (bytes_read < 0)
+        {
+            safe_free(data);
+            return false;
+        }
+        size += (size_t)bytes_read;
+    }
+
+    file->data = data;
+    file->size = size;
+    file->is_mapped = false;
+    return true;
+}
+
+bool map_file(const char* path, mapped_file* file)
+{
+    file->data = NULL;
+    file->size = 0;
+    file->is_mapped = false;
+
+    /* stdin can't be mapped, whatever is piped in is read into an allocation */
+    if (strcmp(path, "-") == 0)
+    {
+        return read_file_descriptor(STDIN_FILENO, 0, file);
+    }
+
+    int descriptor = open(path, O_RDONLY);
+    if (descriptor < 0)
+    {
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(descriptor, &status) != 0)
+    {
+        close(descriptor);
+        return false;
+    }
+
+    /* only regular files can be mapped, and an empty mapping isn't allowed */
+    if (S_ISREG(status.st_mode) && status.st_size > 0)
+    {
+        void* mapping = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapping != MAP_FAILED)
+        {
+            close(descriptor);
+            file->data = (const char*)mapping;
+            file->size = (size_t)status.st_size;
+            file->is_mapped = true;
+            return true;
+        }
+    }
+
+    bool is_read = read_file_descriptor(descriptor, S_ISREG(status.st_mode) ? (size_t)status.st_size : 0, file);
+    close(descriptor);
+    return is_read;
+}
+
+void unmap_file(mapped_file* file)
+{
+    if (file->data == NULL)
+    {
+        return;
+    }
+
+    if (file->is_mapped == true)
+    {
+        munmap((void*)file->data, file->size);
+    }
+    else
+    {
+        safe_free((void*)file->data);
+    }
+
+    file->data = NULL;
+    file->size = 0;
+    file->is_mapped = false;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef MAP_FILE
+#define MAP_FILE
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../extensions/memory_extensions.h"
+#include "../logger/logger.h"
+
+/// @struct mapped_file
+/// @brief The read-only contents of a file, mapped into memory when the file allows it.
+typedef struct mapped_file mapped_file;
+
+struct mapped_file
+{
+    const char* data;
+    size_t size;
+    /// @brief `true` if `data` is a memory mapping, `false` if it was read into an allocation.
+    bool is_mapped;
+};
+
+/// @brief Maps the file at `path` into memory, or reads it into an allocation if it can't be mapped.
+/// @param path The path of the file, or `-` for stdin.
+/// @param file The mapped file to fill.
+/// @return `true` if the contents of the file are available, `false` otherwise.
+bool map_file(const char* path, mapped_file* file);
+
+/// @brief Unmaps or frees the contents of a `file`.
+/// @param file The mapped file to release.
+void unmap_file(mapped_file* file);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,415 @@
+/* nanosleep is POSIX, which strict C17 hides unless asked for */
+#define _POSIX_C_SOURCE 200809L
+#include "async_logger.h"
+
+/**
+ * The queue is the bounded multi-producer queue described by Dmitry Vyukov: every cell carries
+ * a sequence number that tells producers and consumers whose turn it is, so claiming a cell is
+ * a single compare-and-swap and no lock is ever taken on the logging thread.
+ */
+
+#define RESET_ESCAPE_CODE "\x1B[0m"
+
+/// @brief The most bytes the writer thread collects before it writes them out at once.
+#define ASYNC_LOG_BATCH_SIZE 65536
+
+/// @brief The longest the writer thread sleeps while the queue is empty, in microseconds.
+#define MAXIMUM_IDLE_SLEEP_MICROSECONDS 1000
+
+/// @struct async_log_cell
+/// @brief A slot in the log queue that holds one formatted log record.
+typedef struct async_log_cell async_log_cell;
+
+struct async_log_cell
+{
+    atomic_size_t sequence;
+    size_t length;
+    char text[ASYNC_LOG_RECORD_CAPACITY];
+};
+
+static async_log_cell* cells = NULL;
+static size_t cell_mask = 0;
+static atomic_size_t enqueue_position = 0;
+static atomic_size_t dequeue_position = 0;
+/// @brief Every record before this position has been written out.
+static atomic_size_t written_position = 0;
+static atomic_size_t dropped_count = 0;
+static atomic_bool is_running = false;
+static atomic_bool should_stop = false;
+static bool is_exit_handler_registered = false;
+static log_overflow_policy overflow_policy = LOG_OVERFLOW_BLOCK;
+static pthread_t writer_thread;
+
+static const int crash_signals[] =
+{
+    SIGABRT,
+    SIGFPE,
+    SIGILL,
+    SIGINT,
+    SIGSEGV,
+    SIGTERM,
+#ifdef SIGBUS
+    SIGBUS,
+#endif
+};
+
+static void write_all(const char* buffer, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t written = write(STDOUT_FILENO, buffer, length);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return;
+        }
+        buffer += written;
+        length -= (size_t)written;
+    }
+}
+
+static void sleep_microseconds(long microseconds)
+{
+    struct timespec duration = { 0, microseconds * 1000 };
+    nanosleep(&duration, NULL);
+}
+
+/// @brief Claims the next free cell for a producer.
+/// @return The claimed cell, or `NULL` if the queue is full.
+static async_log_cell* claim_cell(size_t* position)
+{
+    size_t current = atomic_load_explicit(&enqueue_position, memory_order_relaxed);
+    for (;;)
+    {
+        async_log_cell* cell = &cells[current & cell_mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)current;
+        if (difference == 0)
+        {
+            /* a failed exchange reloads `current`, so just try again */
+            if (atomic_compare_exchange_weak_explicit(&enqueue_position, &current, current + 1, memory_order_relaxed, memory_order_relaxed))
+            {
+                *position = current;
+                return cell;
+            }
+        }
+        else if (difference < 0)
+        {
+            return NULL;
+        }
+        else
+        {
+            current = atomic_load_explicit(&enqueue_position, memory_order_relaxed);
+        }
+    }
+}
+
+static void publish_cell(async_log_cell* cell, size_t position)
+{
+    atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+}
+
+/// @brief Takes the oldest published cell for a consumer.
+/// @return The taken cell, or `NULL` if no record is ready.
+static async_log_cell* take_cell(size_t* position)
+{
+    size_t current = atomic_load_explicit(&dequeue_position, memory_order_relaxed);
+    for (;;)
+    {
+        async_log_cell* cell = &cells[current & cell_mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)(current + 1);
+        if (difference == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&dequeue_position, &current, current + 1, memory_order_relaxed, memory_order_relaxed))
+            {
+                *position = current;
+                return cell;
+            }
+        }
+        else if (difference < 0)
+        {
+            return NULL;
+        }
+        else
+        {
+            current = atomic_load_explicit(&dequeue_position, memory_order_relaxed);
+        }
+    }
+}
+
+static void release_cell(async_log_cell* cell, size_t position)
+{
+    /* the cell becomes free for the producer one lap around the queue later */
+    atomic_store_explicit(&cell->sequence, position + cell_mask + 1, memory_order_release);
+}
+
+/// @brief Copies as many ready records as fit into the `batch`, their cells stay taken until the batch is written.
+/// @return The length of the batch.
+static size_t fill_batch(char* batch, size_t* next_position)
+{
+    size_t batch_length = 0;
+    size_t position;
+    async_log_cell* cell;
+    while (batch_length + ASYNC_LOG_RECORD_CAPACITY <= ASYNC_LOG_BATCH_SIZE && (cell = take_cell(&position)) != NULL)
+    {
+        memcpy(batch + batch_length, cell->text, cell->length);
+        batch_length += cell->length;
+        *next_position = position + 1;
+    }
+
+    return batch_length;
+}
+
+/// @brief Frees the cells of every record from `position` up to `next_position` for the producers.
+static void release_cells(size_t position, size_t next_position)
+{
+    for (; position < next_position; position++)
+    {
+        release_cell(&cells[position & cell_mask], position);
+    }
+}
+
+static void* run_log_writer(void* argument)
+{
+    char* batch = (char*)malloc(ASYNC_LOG_BATCH_SIZE);
+    long idle_sleep = 1;
+
+    for (;;)
+    {
+        size_t position = atomic_load_explicit(&written_position, memory_order_acquire);
+        size_t next_position = position;
+        size_t batch_length = fill_batch(batch, &next_position);
+        if (next_position != position)
+        {
+            /* the cells are only released once their records are out, so a crash in between can still write them from the cells */
+            write_all(batch, batch_length);
+            atomic_store_explicit(&written_position, next_position, memory_order_release);
+            release_cells(position, next_position);
+            idle_sleep = 1;
+            continue;
+        }
+
+        if (atomic_load_explicit(&should_stop, memory_order_acquire) == true)
+        {
+            break;
+        }
+
+        /* back off while there is nothing to write, a burst of messages wakes the loop quickly again */
+        sleep_microseconds(idle_sleep);
+        if (idle_sleep < MAXIMUM_IDLE_SLEEP_MICROSECONDS)
+        {
+            idle_sleep *= 2;
+        }
+    }
+
+    free(batch);
+    return NULL;
+}
+
+/// @brief Writes whatever is queued from inside a signal handler, then lets the signal do what it normally does.
+static void handle_crash_signal(int signal_number)
+{
+    /**
+     * The writer thread keeps running while the handler does, so rather than taking cells from it the handler walks
+     * every cell that isn't written yet: a published cell holds a record whether or not the writer took it into its
+     * batch, and a released one was already written. A crash in the middle of the writer's batch repeats some
+     * records rather than losing them.
+     */
+    size_t position = atomic_load_explicit(&written_position, memory_order_acquire);
+    size_t end_position = atomic_load_explicit(&enqueue_position, memory_order_acquire);
+    for (; position < end_position; position++)
+    {
+        async_log_cell* cell = &cells[position & cell_mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        if (sequence == position + 1)
+        {
+            write_all(cell->text, cell->length);
+        }
+        else if (sequence < position + 1)
+        {
+            /* claimed but never published, it and everything after it was still being logged */
+            break;
+        }
+    }
+
+    signal(signal_number, SIG_DFL);
+    raise(signal_number);
+}
+
+static void handle_exit()
+{
+    stop_async_logger();
+}
+
+bool start_async_logger(int capacity, log_overflow_policy policy)
+{
+    if (atomic_load(&is_running) == true)
+    {
+        return true;
+    }
+
+    size_t cell_count = 2;
+    while (cell_count < (size_t)capacity)
+    {
+        cell_count *= 2;
+    }
+
+    /* purposefully using `malloc` here instead of `safe_malloc` so there is no circular dependency with memory_extensions.h */
+    cells = (async_log_cell*)malloc(cell_count * sizeof(async_log_cell));
+    if (cells == NULL)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < cell_count; i++)
+    {
+        atomic_init(&cells[i].sequence, i);
+        cells[i].length = 0;
+    }
+    cell_mask = cell_count - 1;
+    atomic_store(&enqueue_position, 0);
+    atomic_store(&dequeue_position, 0);
+    atomic_store(&written_position, 0);
+    atomic_store(&dropped_count, 0);
+    atomic_store(&should_stop, false);
+    overflow_policy = policy;
+
+    /* anything printed before now has to come out before the queued messages */
+    fflush(stdout);
+    if (pthread_create(&writer_thread, NULL, run_log_writer, NULL) != 0)
+    {
+        free(cells);
+        cells = NULL;
+        return false;
+    }
+
+    for (size_t i = 0; i < sizeof(crash_signals) / sizeof(crash_signals[0]); i++)
+    {
+        signal(crash_signals[i], handle_crash_signal);
+    }
+    if (is_exit_handler_registered == false)
+    {
+        atexit(handle_exit);
+        is_exit_handler_registered = true;
+    }
+
+    atomic_store_explicit(&is_running, true, memory_order_release);
+    return true;
+}
+
+void stop_async_logger()
+{
+    if (atomic_load_explicit(&is_running, memory_order_acquire) == false)
+    {
+        return;
+    }
+
+    /* new messages go back to the synchronous path while the writer drains the queue */
+    atomic_store_explicit(&is_running, false, memory_order_release);
+    atomic_store_explicit(&should_stop, true, memory_order_release);
+    pthread_join(writer_thread, NULL);
+
+    size_t dropped = get_dropped_async_log_count();
+    if (dropped > 0)
+    {
+        /* stderr, so the report never ends up inside structured log output */
+        fprintf(stderr, "\x1B[33m[warning]" RESET_ESCAPE_CODE ":\n   %zu log message(s) were dropped because the log queue was full.\n", dropped);
+    }
+
+    for (size_t i = 0; i < sizeof(crash_signals) / sizeof(crash_signals[0]); i++)
+    {
+        signal(crash_signals[i], SIG_DFL);
+    }
+
+    free(cells);
+    cells = NULL;
+}
+
+void flush_async_logger()
+{
+    if (atomic_load_explicit(&is_running, memory_order_acquire) == false)
+    {
+        return;
+    }
+
+    size_t target = atomic_load_explicit(&enqueue_position, memory_order_acquire);
+    while (atomic_load_explicit(&written_position, memory_order_acquire) < target)
+    {
+        sleep_microseconds(10);
+    }
+}
+
+bool is_async_logger_running()
+{
+    return atomic_load_explicit(&is_running, memory_order_acquire);
+}
+
+size_t get_dropped_async_log_count()
+{
+    return atomic_load_explicit(&dropped_count, memory_order_relaxed);
+}
+
+/// @brief Claims a cell for a new record, waiting for room or dropping the record as the overflow policy says.
+/// @return The claimed cell, or `NULL` if the record was dropped.
+static async_log_cell* claim_record_cell(size_t* position)
+{
+    async_log_cell* cell = claim_cell(position);
+    while (cell == NULL)
+    {
+        if (overflow_policy == LOG_OVERFLOW_DROP)
+        {
+            atomic_fetch_add_explicit(&dropped_count, 1, memory_order_relaxed);
+            return NULL;
+        }
+        sleep_microseconds(10);
+        cell = claim_cell(position);
+    }
+
+    return cell;
+}
+
+/// @brief Publishes a claimed cell, and keeps the order when its record didn't fit by letting everything before it come out first.
+/// @return `true` if the record fit in the cell, `false` if the caller has to write it synchronously.
+static bool publish_record(async_log_cell* cell, size_t position, bool does_fit)
+{
+    if (does_fit == false)
+    {
+        /* a record that doesn't fit leaves an empty record behind */
+        cell->length = 0;
+    }
+    publish_cell(cell, position);
+
+    if (does_fit == false)
+    {
+        flush_async_logger();
+    }
+    return does_fit;
+}
+
+bool write_async_log_record(const log_sink* sink, const log_record* record)
+{
+    if (atomic_load_explicit(&is_running, memory_order_acquire) == false)
+    {
+        return false;
+    }
+
+    size_t position;
+    async_log_cell* cell = claim_record_cell(&position);
+    if (cell == NULL)
+    {
+        return true;
+    }
+
+    /* encode straight into the cell */
+    size_t length = sink->encode_record(record, cell->text, ASYNC_LOG_RECORD_CAPACITY);
+    bool does_fit = length <= ASYNC_LOG_RECORD_CAPACITY;
+    if (does_fit == true)
+    {
+        cell->length = length;
+    }
+
+    return publish_record(cell, position, does_fit);
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef ASYNC_LOGGER
+#define ASYNC_LOGGER
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "log_sink.h"
+
+/// @brief The most bytes a single queued log record can hold, longer messages are written synchronously.
+#define ASYNC_LOG_RECORD_CAPACITY 496
+
+/// @brief The amount of records the queue holds when no capacity is given.
+#define DEFAULT_ASYNC_LOG_CAPACITY 4096
+
+/// @enum log_overflow_policy
+/// @brief What a caller does when the asynchronous log queue is full.
+typedef enum log_overflow_policy
+{
+    /// @brief Wait for the writer thread to make room, no message is lost.
+    LOG_OVERFLOW_BLOCK,
+    /// @brief Drop the message and count it, the caller never waits.
+    LOG_OVERFLOW_DROP
+} log_overflow_policy;
+
+/// @brief Starts the background thread that writes queued log messages, and routes every log message through the queue.
+/// @param capacity The amount of records the queue holds, rounded up to a power of two.
+/// @param policy What to do when the queue is full.
+/// @return `true` if the asynchronous logger is running, `false` otherwise.
+bool start_async_logger(int capacity, log_overflow_policy policy);
+
+/// @brief Writes every queued message, stops the background thread, and goes back to logging synchronously.
+void stop_async_logger();
+
+/// @brief Waits until every message queued so far has been written.
+void flush_async_logger();
+
+/// @brief Determines if log messages are currently queued for the background thread.
+/// @return `true` if the asynchronous logger is running, `false` otherwise.
+bool is_async_logger_running();
+
+/// @brief Encodes a log record straight into the queue.
+/// @param sink The log sink that encodes the `record`.
+/// @param record The log record to queue.
+/// @return `true` if the record was queued or dropped, `false` if the caller has to write it synchronously.
+bool write_async_log_record(const log_sink* sink, const log_record* record);
+
+/// @brief Gets the amount of messages dropped because the queue was full.
+/// @return The amount of dropped messages.
+size_t get_dropped_async_log_count();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,273 @@
+#include "log_sink.h"
+
+#define CYAN_ESCAPE_CODE    "\x1B[36m"
+#define GREEN_ESCAPE_CODE   "\x1B[32m"
+#define RED_ESCAPE_CODE     "\x1B[31m"
+#define RESET_ESCAPE_CODE   "\x1B[0m"
+#define YELLOW_ESCAPE_CODE  "\x1B[33m"
+
+/// @brief Builds the line that goes in front of every console message of a severity.
+#define CONSOLE_HEADER(color_code, name) color_code "[" name "]" RESET_ESCAPE_CODE ":\n   "
+
+/// @brief The size of the fixed part of a binary log record.
+#define BINARY_RECORD_HEADER_SIZE 27
+
+typedef struct
+{
+    const char* text;
+    size_t length;
+} LOG_HEADER;
+
+/* indexed by log_level */
+static const LOG_HEADER console_headers[] =
+{
+    { CONSOLE_HEADER(GREEN_ESCAPE_CODE, "debug"), sizeof(CONSOLE_HEADER(GREEN_ESCAPE_CODE, "debug")) - 1 },
+    { CONSOLE_HEADER(CYAN_ESCAPE_CODE, "information"), sizeof(CONSOLE_HEADER(CYAN_ESCAPE_CODE, "information")) - 1 },
+    { CONSOLE_HEADER(YELLOW_ESCAPE_CODE, "warning"), sizeof(CONSOLE_HEADER(YELLOW_ESCAPE_CODE, "warning")) - 1 },
+    { CONSOLE_HEADER(RED_ESCAPE_CODE, "error"), sizeof(CONSOLE_HEADER(RED_ESCAPE_CODE, "error")) - 1 },
+};
+
+/// @brief Appends bytes to a buffer, counting the bytes that don't fit so the caller learns how large the buffer has to be.
+typedef struct
+{
+    char* buffer;
+    size_t capacity;
+    size_t length;
+} RECORD_WRITER;
+
+static void append_bytes(RECORD_WRITER* writer, const void* bytes, size_t count)
+{
+    /* once something doesn't fit, nothing after it does either */
+    if (writer->length + count <= writer->capacity)
+    {
+        memcpy(writer->buffer + writer->length, bytes, count);
+    }
+    writer->length += count;
+}
+
+static void append_text(RECORD_WRITER* writer, const char* text)
+{
+    append_bytes(writer, text, strlen(text));
+}
+
+static void append_character(RECORD_WRITER* writer, char character)
+{
+    append_bytes(writer, &character, 1);
+}
+
+static void append_integer(RECORD_WRITER* writer, long long number)
+{
+    char text[24];
+    int length = snprintf(text, sizeof(text), "%lld", number);
+    append_bytes(writer, text, (size_t)length);
+}
+
+/// @brief Appends the `timestamp` as an ISO 8601 date and time in UTC, without `gmtime` so encoding stays thread-safe.
+static void append_timestamp(RECORD_WRITER* writer, int64_t timestamp)
+{
+    int64_t seconds = timestamp / 1000000000;
+    long microseconds = (long)(timestamp % 1000000000) / 1000;
+    int64_t days = seconds / 86400;
+    int64_t second_of_day = seconds % 86400;
+
+    /* the civil date of a day count, as derived by Howard Hinnant, with eras of 400 years starting on March 1st */
+    days += 719468;
+    int64_t era = days / 146097;
+    int64_t day_of_era = days - era * 146097;
+    int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    int64_t month_index = (5 * day_of_year + 2) / 153;
+    int day = (int)(day_of_year - (153 * month_index + 2) / 5 + 1);
+    int month = (int)(month_index < 10 ? month_index + 3 : month_index - 9);
+    long long year = (long long)(year_of_era + era * 400 + (month <= 2 ? 1 : 0));
+
+    char text[40];
+    int length = snprintf(text, sizeof(text), "%04lld-%02d-%02dT%02d:%02d:%02d.%06ldZ", year, month, day,
+        (int)(second_of_day / 3600), (int)(second_of_day / 60 % 60), (int)(second_of_day % 60), microseconds);
+    append_bytes(writer, text, (size_t)length);
+}
+
+/// @brief Appends `text` as the contents of a JSON string, escaping quotes, backslashes and control characters.
+static void append_json_string(RECORD_WRITER* writer, const char* text, size_t length)
+{
+    static const char hex_digits[] = "0123456789abcdef";
+
+    /* unescaped runs are copied at once */
+    size_t run_start = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        unsigned char character = (unsigned char)text[i];
+        if (character >= 0x20 && character != '"' && character != '\\')
+        {
+            continue;
+        }
+
+        append_bytes(writer, text + run_start, i - run_start);
+        run_start = i + 1;
+        switch (character)
+        {
+            case '"': append_text(writer, "\\\""); break;
+            case '\\': append_text(writer, "\\\\"); break;
+            case '\n': append_text(writer, "\\n"); break;
+            case '\r': append_text(writer, "\\r"); break;
+            case '\t': append_text(writer, "\\t"); break;
+            default:
+            {
+                char escape[] = { '\\', 'u', '0', '0', hex_digits[character >> 4], hex_digits[character & 0xF] };
+                append_bytes(writer, escape, sizeof(escape));
+                break;
+            }
+        }
+    }
+    append_bytes(writer, text + run_start, length - run_start);
+}
+
+static size_t encode_console_record(const log_record* record, char* buffer, size_t capacity)
+{
+    RECORD_WRITER writer = { buffer, capacity, 0 };
+    append_bytes(&writer, console_headers[record->level].text, console_headers[record->level].length);
+    append_bytes(&writer, record->message, record->length);
+    append_character(&writer, '\n');
+
+    return writer.length;
+}
+
+static size_t encode_json_record(const log_record* record, char* buffer, size_t capacity)
+{
+    RECORD_WRITER writer = { buffer, capacity, 0 };
+    append_text(&writer, "{\"timestamp\":\"");
+    append_timestamp(&writer, record->timestamp);
+    append_text(&writer, "\",\"severity\":\"");
+    append_text(&writer, get_log_level_name(record->level));
+    append_character(&writer, '"');
+    if (record->file != NULL)
+    {
+        append_text(&writer, ",\"file\":\"");
+        append_json_string(&writer, record->file, strlen(record->file));
+        append_character(&writer, '"');
+    }
+    if (record->line > 0)
+    {
+        append_text(&writer, ",\"line\":");
+        append_integer(&writer, record->line);
+    }
+    if (record->program_counter >= 0)
+    {
+        append_text(&writer, ",\"pc\":");
+        append_integer(&writer, record->program_counter);
+    }
+    append_text(&writer, ",\"message\":\"");
+    append_json_string(&writer, record->message, record->length);
+    append_text(&writer, "\"}\n");
+
+    return writer.length;
+}
+
+/**
+ * A binary record is a fixed header in host byte order, followed by the file name and the message:
+ *   uint32 record length     the amount of bytes after this field
+ *   uint8  severity          a log_level
+ *   int64  timestamp         nanoseconds since the Unix epoch
+ *   int32  line              0 if it isn't known
+ *   int32  program counter   -1 if no L# program logged the message
+ *   uint16 file length       0 if the file isn't known
+ *   uint32 message length
+ */
+static size_t encode_binary_record(const log_record* record, char* buffer, size_t capacity)
+{
+    uint16_t file_length = record->file != NULL ? (uint16_t)strlen(record->file) : 0;
+    uint32_t message_length = (uint32_t)record->length;
+    uint32_t record_length = BINARY_RECORD_HEADER_SIZE - sizeof(uint32_t) + file_length + message_length;
+    uint8_t severity = (uint8_t)record->level;
+    int32_t line = record->line;
+    int32_t program_counter = record->program_counter;
+
+    RECORD_WRITER writer = { buffer, capacity, 0 };
+    append_bytes(&writer, &record_length, sizeof(record_length));
+    append_bytes(&writer, &severity, sizeof(severity));
+    append_bytes(&writer, &record->timestamp, sizeof(record->timestamp));
+    append_bytes(&writer, &line, sizeof(line));
+    append_bytes(&writer, &program_counter, sizeof(program_counter));
+    append_bytes(&writer, &file_length, sizeof(file_length));
+    append_bytes(&writer, &message_length, sizeof(message_length));
+    append_bytes(&writer, record->file, file_length);
+    append_bytes(&writer, record->message, message_length);
+
+    return writer.length;
+}
+
+/* indexed by log_format */
+static const log_sink log_sinks[] =
+{
+    { "console", true, encode_console_record },
+    { "json", false, encode_json_record },
+    { "binary", false, encode_binary_record },
+};
+
+bool parse_log_level(const char* name, log_level* level)
+{
+    if (strcmp(name, "debug") == 0)
+    {
+        *level = LOG_LEVEL_DEBUG;
+    }
+    else if (strcmp(name, "info") == 0 || strcmp(name, "information") == 0)
+    {
+        *level = LOG_LEVEL_INFO;
+    }
+    else if (strcmp(name, "warning") == 0)
+    {
+        *level = LOG_LEVEL_WARNING;
+    }
+    else if (strcmp(name, "error") == 0)
+    {
+        *level = LOG_LEVEL_ERROR;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+const char* get_log_level_name(log_level level)
+{
+    switch (level)
+    {
+        case LOG_LEVEL_DEBUG: return "debug";
+        case LOG_LEVEL_INFO: return "info";
+        case LOG_LEVEL_WARNING: return "warning";
+        case LOG_LEVEL_ERROR: return "error";
+        default: return "unknown";
+    }
+}
+
+bool parse_log_format(const char* name, log_format* format)
+{
+    for (size_t i = 0; i < sizeof(log_sinks) / sizeof(log_sinks[0]); i++)
+    {
+        if (strcmp(name, log_sinks[i].name) == 0)
+        {
+            *format = (log_format)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const log_sink* get_log_sink(log_format format)
+{
+    return &log_sinks[format];
+}
+
+int64_t get_log_timestamp()
+{
+    struct timespec now;
+    if (timespec_get(&now, TIME_UTC) == 0)
+    {
+        return 0;
+    }
+
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
\ No newline at end of file
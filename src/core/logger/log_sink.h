@@ -0,0 +1,93 @@
+#ifndef LOG_SINK
+#define LOG_SINK
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/// @enum log_level
+/// @brief The severities of log messages, ordered from least to most severe.
+typedef enum log_level
+{
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARNING,
+    LOG_LEVEL_ERROR
+} log_level;
+
+/// @enum log_format
+/// @brief The formats a log sink can write log records in.
+typedef enum log_format
+{
+    /// @brief The colored severity name, followed by the indented message.
+    LOG_FORMAT_CONSOLE,
+    /// @brief One JSON object per line, with the timestamp, severity and source location of the message.
+    LOG_FORMAT_JSON,
+    /// @brief A compact binary record with a fixed header, followed by the file name and the message.
+    LOG_FORMAT_BINARY
+} log_format;
+
+/// @struct log_record
+/// @brief A single log message, along with where and when it was logged.
+typedef struct log_record log_record;
+
+struct log_record
+{
+    log_level level;
+    /// @brief The text of the message, which doesn't have to be null-terminated.
+    const char* message;
+    size_t length;
+    /// @brief When the message was logged, in nanoseconds since the Unix epoch.
+    int64_t timestamp;
+    /// @brief The file that logged the message, `NULL` if it isn't known.
+    const char* file;
+    /// @brief The line in the `file` that logged the message, `0` if it isn't known.
+    int line;
+    /// @brief The instruction of the L# program that logged the message, `-1` if no L# program logged it.
+    int program_counter;
+};
+
+/// @struct log_sink
+/// @brief Turns log records into the bytes that are written out for them.
+typedef struct log_sink log_sink;
+
+struct log_sink
+{
+    /// @brief The name of the sink, as given to `--log-format`.
+    const char* name;
+    /// @brief `true` if the sink writes for people reading a terminal, who expect each message as soon as it is logged.
+    bool is_interactive;
+    /// @brief Encodes a `record` into a `buffer`, which is only written completely if the encoded record fits in `capacity` bytes.
+    /// @return The amount of bytes the encoded record needs.
+    size_t (*encode_record)(const log_record* record, char* buffer, size_t capacity);
+};
+
+/// @brief Parses the name of a log level, such as `debug`, `info`, `warning` or `error`.
+/// @param name The name of the log level.
+/// @param level The log level to fill.
+/// @return `true` if the `name` is a log level, `false` otherwise.
+bool parse_log_level(const char* name, log_level* level);
+
+/// @brief Gets a human-readable name of the `level`.
+/// @param level The log level to get a name for.
+/// @return The name of the `level`.
+const char* get_log_level_name(log_level level);
+
+/// @brief Parses the name of a log format, such as `console`, `json` or `binary`.
+/// @param name The name of the log format.
+/// @param format The log format to fill.
+/// @return `true` if the `name` is a log format, `false` otherwise.
+bool parse_log_format(const char* name, log_format* format);
+
+/// @brief Gets the log sink that writes records in the `format`.
+/// @param format The format of the log sink.
+/// @return The log sink for the `format`.
+const log_sink* get_log_sink(log_format format);
+
+/// @brief Gets the current time as a log record timestamp.
+/// @return The amount of nanoseconds since the Unix epoch.
+int64_t get_log_timestamp();
+
+#endif
\ No newline at end of file
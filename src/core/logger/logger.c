@@ -1,103 +1,103 @@
+/* isatty and fileno are POSIX, which strict C17 hides unless asked for */
+#define _POSIX_C_SOURCE 200809L
 #include "logger.h"
 
-#define CYAN_ESCAPE_CODE    "\x1B[36m"
-#define GREEN_ESCAPE_CODE   "\x1B[32m"
-#define RED_ESCAPE_CODE     "\x1B[31m"
-#define RESET_ESCAPE_CODE   "\x1B[0m"
-#define YELLOW_ESCAPE_CODE  "\x1B[33m"
+/// @brief The size of the per-thread buffers messages are formatted and encoded into, longer messages fall back to the heap.
+#define LOG_BUFFER_SIZE 1024
 
-typedef enum
-{
-    LOG_SEVERITY_UNKNOWN,
-    LOG_SEVERITY_DEBUG,
-    LOG_SEVERITY_ERROR,
-    LOG_SEVERITY_INFORMATION,
-    LOG_SEVERITY_WARNING,
-} LOG_SEVERITY;
-
-typedef struct
-{
-    const char* name;
-    LOG_SEVERITY severity;
-    const char* color_code;
-} LOG_CONTEXT;
+/// @brief The size of the stdout buffer when log records aren't written for a terminal.
+#define LOG_OUTPUT_BUFFER_SIZE 65536
 
-static const LOG_CONTEXT log_contexts[] =
-{
-    { "debug", LOG_SEVERITY_DEBUG, GREEN_ESCAPE_CODE },
-    { "error", LOG_SEVERITY_ERROR, RED_ESCAPE_CODE },
-    { "information", LOG_SEVERITY_INFORMATION, CYAN_ESCAPE_CODE },
-    { "warning", LOG_SEVERITY_WARNING, YELLOW_ESCAPE_CODE },
-};
+static const log_sink* current_sink = NULL;
 
-static void log_message(LOG_CONTEXT context, size_t buffer_size,  const char* message, va_list args)
-{
-    assert(message != NULL && "[logger]: log_message provided a null message.");
-    assert(strlen(message) > 0 && "[logger]: log_message provided an empty message.");
-
-    /* purposefully using `malloc` here instead of `safe_malloc` so there is no circular dependency with memory_extensions.h */
-    char* formatted_message = (char*)malloc(buffer_size + 1);
-    assert(formatted_message != NULL && "[logger]: log_message unable to allocate buffer for message.");
+static _Thread_local char message_buffer[LOG_BUFFER_SIZE];
+static _Thread_local char record_buffer[LOG_BUFFER_SIZE];
 
-    vsnprintf(formatted_message, buffer_size + 1, message, args);
-    printf("%s[%s]" RESET_ESCAPE_CODE ":\n", context.color_code, context.name);
-    printf("   %s\n", formatted_message);
+void set_log_sink(const log_sink* sink)
+{
+    current_sink = sink;
 
-    free(formatted_message);
+    /* people reading a terminal still see each message as it's logged, everything else is written in large blocks */
+    if (sink->is_interactive == false || isatty(fileno(stdout)) == 0)
+    {
+        setvbuf(stdout, NULL, _IOFBF, LOG_OUTPUT_BUFFER_SIZE);
+    }
 }
 
-static size_t get_buffer_size(const char* message, va_list args)
+const log_sink* get_current_log_sink()
 {
-    va_list args_copy;
-    va_copy(args_copy, args);
-
-    size_t buffer_size = vsnprintf(NULL, 0, message, args_copy);
-    assert(buffer_size > 0 && "[logger]: get_buffer_size not able to determine buffer of message.");
-
-    va_end(args_copy);
-    return buffer_size;
+    return current_sink != NULL ? current_sink : get_log_sink(LOG_FORMAT_CONSOLE);
 }
 
-void log_debug(const char* message, ...)
+void write_log_record(const log_record* record)
 {
-    va_list args;
-    va_start(args, message);
-
-    size_t buffer_size = get_buffer_size(message, args);
-    log_message(log_contexts[0], buffer_size, message, args);
-
-    va_end(args);
+    assert(record->level >= LOG_LEVEL_DEBUG && record->level <= LOG_LEVEL_ERROR && "[logger]: write_log_record provided an unknown log level.");
+    const log_sink* sink = get_current_log_sink();
+
+    /* the asynchronous logger encodes straight into its queue when it is running */
+    if (write_async_log_record(sink, record) == true)
+    {
+        return;
+    }
+
+    char* encoded = record_buffer;
+    size_t length = sink->encode_record(record, record_buffer, LOG_BUFFER_SIZE);
+    if (length > LOG_BUFFER_SIZE)
+    {
+        /* purposefully using `malloc` here instead of `safe_malloc` so there is no circular dependency with memory_extensions.h */
+        encoded = (char*)malloc(length);
+        assert(encoded != NULL && "[logger]: write_log_record unable to allocate buffer for record.");
+        sink->encode_record(record, encoded, length);
+    }
+
+    fwrite(encoded, sizeof(char), length, stdout);
+    if (is_async_logger_running() == true)
+    {
+        /* the queued records after this one are written around stdio */
+        fflush(stdout);
+    }
+
+    if (encoded != record_buffer)
+    {
+        free(encoded);
+    }
 }
 
-void log_error(const char* message, ...)
+void log_write(log_level level, const char* message, size_t length)
 {
-    va_list args;
-    va_start(args, message);
-
-    size_t buffer_size = get_buffer_size(message, args);
-    log_message(log_contexts[1], buffer_size, message, args);
-
-    va_end(args);
+    log_record record = { level, message, length, get_log_timestamp(), NULL, 0, -1 };
+    write_log_record(&record);
 }
 
-void log_info(const char* message, ...)
+void log_message(log_level level, const char* file, int line, const char* message, ...)
 {
+    assert(message != NULL && "[logger]: log_message provided a null message.");
+    assert(strlen(message) > 0 && "[logger]: log_message provided an empty message.");
+
     va_list args;
     va_start(args, message);
+    va_list args_copy;
+    va_copy(args_copy, args);
 
-    size_t buffer_size = get_buffer_size(message, args);
-    log_message(log_contexts[2], buffer_size, message, args);
-
+    /* format once into this thread's buffer */
+    char* text = message_buffer;
+    int length = vsnprintf(message_buffer, LOG_BUFFER_SIZE, message, args);
+    assert(length >= 0 && "[logger]: log_message unable to format message.");
+    if (length >= LOG_BUFFER_SIZE)
+    {
+        /* only a message that didn't fit is formatted again, into a heap buffer that does */
+        text = (char*)malloc(length + 1);
+        assert(text != NULL && "[logger]: log_message unable to allocate buffer for message.");
+        vsnprintf(text, length + 1, message, args_copy);
+    }
+    va_end(args_copy);
     va_end(args);
-}
 
-void log_warning(const char* message, ...)
-{
-    va_list args;
-    va_start(args, message);
+    log_record record = { level, text, (size_t)length, get_log_timestamp(), file, line, -1 };
+    write_log_record(&record);
 
-    size_t buffer_size = get_buffer_size(message, args);
-    log_message(log_contexts[3], buffer_size, message, args);
-
-    va_end(args);
+    if (text != message_buffer)
+    {
+        free(text);
+    }
 }
\ No newline at end of file
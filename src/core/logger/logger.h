@@ -6,21 +6,50 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include "async_logger.h"
+#include "log_sink.h"
 
-/// @brief Logs a debug message to the console.
-/// @param message The message to log.
-void log_debug(const char* message, ...);
+/// @brief Logs a debug message, along with the file and line that logged it.
+/// @param message The message to log, followed by its format arguments.
+#define log_debug(...) log_message(LOG_LEVEL_DEBUG, __FILE__, __LINE__, __VA_ARGS__)
 
-/// @brief Logs an error message to the console.
-/// @param message The message to log.
-void log_error(const char* message, ...);
+/// @brief Logs an error message, along with the file and line that logged it.
+/// @param message The message to log, followed by its format arguments.
+#define log_error(...) log_message(LOG_LEVEL_ERROR, __FILE__, __LINE__, __VA_ARGS__)
 
-/// @brief Logs an informational message to the console.
-/// @param message The message to log.
-void log_info(const char* message, ...);
+/// @brief Logs an informational message, along with the file and line that logged it.
+/// @param message The message to log, followed by its format arguments.
+#define log_info(...) log_message(LOG_LEVEL_INFO, __FILE__, __LINE__, __VA_ARGS__)
 
-/// @brief Logs a warning message to the console.
-/// @param message The message to log.
-void log_warning(const char* message, ...);
+/// @brief Logs a warning message, along with the file and line that logged it.
+/// @param message The message to log, followed by its format arguments.
+#define log_warning(...) log_message(LOG_LEVEL_WARNING, __FILE__, __LINE__, __VA_ARGS__)
+
+/// @brief Writes every log message from now on through the `sink`, and gives stdout a large buffer unless the `sink` writes to a terminal.
+/// @param sink The log sink to write log records through.
+/// @remark Has to be called before anything is written to stdout.
+void set_log_sink(const log_sink* sink);
+
+/// @brief Gets the log sink that log messages are written through.
+/// @return The current log sink, the console sink if none was set.
+const log_sink* get_current_log_sink();
+
+/// @brief Writes a log record through the current log sink.
+/// @param record The log record to write.
+void write_log_record(const log_record* record);
+
+/// @brief Logs an already formatted message, without going through `printf`.
+/// @param level The severity of the message.
+/// @param message The text of the message, which doesn't have to be null-terminated.
+/// @param length The amount of characters in the `message`.
+void log_write(log_level level, const char* message, size_t length);
+
+/// @brief Formats and logs a message.
+/// @param level The severity of the message.
+/// @param file The file that logged the message.
+/// @param line The line in the `file` that logged the message.
+/// @param message The format of the message.
+void log_message(log_level level, const char* file, int line, const char* message, ...);
 
 #endif
\ No newline at end of file
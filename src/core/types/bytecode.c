@@ -8,6 +8,7 @@ const char* get_op_code_name(op_code opcode)
         case OP_LOAD_VAR: return "OP_LOAD_VAR";
         case OP_STORE_VAR: return "OP_STORE_VAR";
         case OP_POP: return "OP_POP";
+        case OP_DUP: return "OP_DUP";
         case OP_ADD: return "OP_ADD";
         case OP_SUB: return "OP_SUB";
         case OP_MUL: return "OP_MUL";
@@ -34,6 +35,29 @@ const char* get_op_code_name(op_code opcode)
     }
 }
 
+bool is_jump_op_code(op_code opcode)
+{
+    return opcode == OP_JMP || opcode == OP_JMP_IF_FALSE;
+}
+
+bool get_builtin_log_level(op_code opcode, log_level* level)
+{
+    switch (opcode)
+    {
+        case OP_BUILTIN_DEBUG: *level = LOG_LEVEL_DEBUG; return true;
+        case OP_BUILTIN_INFO: *level = LOG_LEVEL_INFO; return true;
+        case OP_BUILTIN_WARNING: *level = LOG_LEVEL_WARNING; return true;
+        case OP_BUILTIN_ERROR: *level = LOG_LEVEL_ERROR; return true;
+        default: return false;
+    }
+}
+
+int get_jump_target(const instruction* instructions, int index)
+{
+    /* the program counter has already moved past the jump when the offset is applied */
+    return index + 1 + instructions[index].operand.jump.jump_offset;
+}
+
 const char* get_op_type_name(op_type optype)
 {
     switch (optype)
@@ -1,6 +1,8 @@
 #ifndef BYTECODE
 #define BYTECODE
+#include <stdbool.h>
 #include <stdint.h>
+#include "../logger/logger.h"
 #include "symbol_table.h"
 
 /// @enum op_code
@@ -11,6 +13,7 @@ typedef enum op_code
     OP_LOAD_VAR,
     OP_STORE_VAR,
     OP_POP,
+    OP_DUP,
     OP_ADD,
     OP_SUB,
     OP_MUL,
@@ -35,6 +38,9 @@ typedef enum op_code
     OP_BUILTIN_INFO
 } op_code;
 
+/// @brief The amount of operation codes.
+#define OP_CODE_COUNT (OP_BUILTIN_INFO + 1)
+
 /// @enum value_type
 /// @brief Contains various L# value representations.
 typedef enum value_type
@@ -127,6 +133,23 @@ struct instruction
 /// @return The name of the `opcode`.
 const char* get_op_code_name(op_code opcode);
 
+/// @brief Determines if the `opcode` moves the program counter by a relative jump offset.
+/// @param opcode The `op_code` to check.
+/// @return `true` if the `opcode` is a jump, `false` otherwise.
+bool is_jump_op_code(op_code opcode);
+
+/// @brief Gets the log level of a builtin logging operation.
+/// @param opcode The `op_code` to check.
+/// @param level The log level to fill if the `opcode` is a builtin logging operation.
+/// @return `true` if the `opcode` is a builtin logging operation, `false` otherwise.
+bool get_builtin_log_level(op_code opcode, log_level* level);
+
+/// @brief Gets the index of the instruction a jump at `index` lands on.
+/// @param instructions The collection of instructions that contains the jump.
+/// @param index The index of the jump instruction.
+/// @return The index of the jump target, which can be one past the last instruction.
+int get_jump_target(const instruction* instructions, int index);
+
 /// @brief Gets a human-readable name of the `optype`.
 /// @param optype The `op_type` to get a human-readable name for.
 /// @return The name of the `optype`.
@@ -0,0 +1,204 @@
+#include "bytecode_archive.h"
+
+/// @brief Where the index checksum is, it is read as zero while the checksum is computed.
+#define ARCHIVE_CHECKSUM_OFFSET 8
+
+static uint64_t get_module_name_hash(const char* name, size_t length)
+{
+    return update_fnv1a64(FNV1A64_OFFSET_BASIS, name, length);
+}
+
+/// @brief Gets where the names start, right after the module table and bucket table.
+static uint64_t get_names_offset(uint32_t module_count, uint32_t bucket_count)
+{
+    return BYTECODE_ARCHIVE_HEADER_SIZE + (uint64_t)module_count * BYTECODE_ARCHIVE_MODULE_SIZE + (uint64_t)bucket_count * 4;
+}
+
+/// @brief Computes the index checksum, which covers everything before the module files with the checksum itself read as zero.
+static uint32_t get_index_checksum(const unsigned char* data, size_t index_size)
+{
+    static const unsigned char zero_checksum[4] = { 0 };
+    uint32_t checksum = update_crc32c(0, data, ARCHIVE_CHECKSUM_OFFSET);
+    checksum = update_crc32c(checksum, zero_checksum, sizeof(zero_checksum));
+
+    return update_crc32c(checksum, data + ARCHIVE_CHECKSUM_OFFSET + 4, index_size - ARCHIVE_CHECKSUM_OFFSET - 4);
+}
+
+bool is_bytecode_archive(const void* data, size_t size)
+{
+    return size >= 4 && memcmp(data, BYTECODE_ARCHIVE_MAGIC, 4) == 0;
+}
+
+unsigned char* pack_bytecode_archive(const bytecode_archive_module* modules, int module_count, int entry_module, size_t* size)
+{
+    /* at most half the buckets are used, so a lookup rarely looks past the bucket of its hash */
+    uint32_t bucket_count = 1;
+    while (bucket_count < (uint32_t)module_count * 2)
+    {
+        bucket_count *= 2;
+    }
+
+    uint32_t names_size = 0;
+    for (int i = 0; i < module_count; i++)
+    {
+        names_size += (uint32_t)strlen(modules[i].name) + 1;
+    }
+    uint32_t names_offset = (uint32_t)get_names_offset((uint32_t)module_count, bucket_count);
+    uint32_t index_size = names_offset + names_size;
+
+    /* lay the module files out one after the other, each aligned like the sections inside them */
+    uint32_t offset = index_size;
+    uint32_t* file_offsets = (uint32_t*)safe_malloc((module_count > 0 ? module_count : 1) * sizeof(uint32_t));
+    for (int i = 0; i < module_count; i++)
+    {
+        offset = (offset + BYTECODE_ALIGNMENT - 1) & ~(uint32_t)(BYTECODE_ALIGNMENT - 1);
+        file_offsets[i] = offset;
+        offset += (uint32_t)modules[i].size;
+    }
+
+    /* zeroed, so the buckets start empty and the padding between files is zero */
+    *size = offset;
+    unsigned char* data = (unsigned char*)safe_malloc(offset > 0 ? offset : 1);
+    memset(data, 0, offset);
+
+    memcpy(data, BYTECODE_ARCHIVE_MAGIC, 4);
+    write_u16(data + 4, BYTECODE_ARCHIVE_VERSION_MAJOR);
+    write_u16(data + 6, BYTECODE_ARCHIVE_VERSION_MINOR);
+    write_u32(data + 12, offset);
+    write_u32(data + 16, (uint32_t)module_count);
+    write_u32(data + 20, bucket_count);
+    write_u32(data + 24, (uint32_t)entry_module);
+    write_u32(data + 28, names_size);
+
+    unsigned char* buckets = data + BYTECODE_ARCHIVE_HEADER_SIZE + (size_t)module_count * BYTECODE_ARCHIVE_MODULE_SIZE;
+    uint32_t name_offset = 0;
+    for (int i = 0; i < module_count; i++)
+    {
+        size_t name_length = strlen(modules[i].name);
+        uint64_t hash = get_module_name_hash(modules[i].name, name_length);
+        unsigned char* entry = data + BYTECODE_ARCHIVE_HEADER_SIZE + (size_t)i * BYTECODE_ARCHIVE_MODULE_SIZE;
+        write_u64(entry, hash);
+        write_u32(entry + 8, name_offset);
+        write_u32(entry + 12, (uint32_t)name_length);
+        write_u32(entry + 16, file_offsets[i]);
+        write_u32(entry + 20, (uint32_t)modules[i].size);
+        memcpy(data + names_offset + name_offset, modules[i].name, name_length + 1);
+        name_offset += (uint32_t)name_length + 1;
+        if (modules[i].size > 0)
+        {
+            memcpy(data + file_offsets[i], modules[i].bytecode, modules[i].size);
+        }
+
+        uint32_t bucket = (uint32_t)hash & (bucket_count - 1);
+        while (read_u32(buckets + (size_t)bucket * 4) != 0)
+        {
+            bucket = (bucket + 1) & (bucket_count - 1);
+        }
+        write_u32(buckets + (size_t)bucket * 4, (uint32_t)i + 1);
+    }
+    write_u32(data + ARCHIVE_CHECKSUM_OFFSET, get_index_checksum(data, index_size));
+    safe_free(file_offsets);
+
+    return data;
+}
+
+bytecode_file_status read_bytecode_archive(const void* data, size_t size, bytecode_archive* archive)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    if (size < BYTECODE_ARCHIVE_HEADER_SIZE || is_bytecode_archive(bytes, size) == false)
+    {
+        return BYTECODE_FILE_NOT_BYTECODE;
+    }
+
+    archive->data = bytes;
+    archive->size = size;
+    archive->version_major = read_u16(bytes + 4);
+    archive->version_minor = read_u16(bytes + 6);
+    if (archive->version_major != BYTECODE_ARCHIVE_VERSION_MAJOR)
+    {
+        return BYTECODE_FILE_UNSUPPORTED_VERSION;
+    }
+
+    archive->module_count = read_u32(bytes + 16);
+    archive->bucket_count = read_u32(bytes + 20);
+    archive->entry_module = read_u32(bytes + 24);
+    uint32_t names_size = read_u32(bytes + 28);
+    uint64_t names_offset = get_names_offset(archive->module_count, archive->bucket_count);
+    if (read_u32(bytes + 12) != size || archive->entry_module >= archive->module_count
+        || archive->bucket_count < archive->module_count || (archive->bucket_count & (archive->bucket_count - 1)) != 0
+        || names_offset + names_size > size)
+    {
+        return BYTECODE_FILE_CORRUPT;
+    }
+
+    /* a damaged index is caught before any offset in it is trusted */
+    size_t index_size = (size_t)(names_offset + names_size);
+    if (read_u32(bytes + ARCHIVE_CHECKSUM_OFFSET) != get_index_checksum(bytes, index_size))
+    {
+        return BYTECODE_FILE_CORRUPT;
+    }
+
+    /* every name and file is checked once here, so a lookup can use them without checking again */
+    const char* names = (const char*)bytes + names_offset;
+    for (uint32_t i = 0; i < archive->module_count; i++)
+    {
+        const unsigned char* entry = bytes + BYTECODE_ARCHIVE_HEADER_SIZE + (size_t)i * BYTECODE_ARCHIVE_MODULE_SIZE;
+        uint64_t name_end = (uint64_t)read_u32(entry + 8) + read_u32(entry + 12);
+        uint32_t file_offset = read_u32(entry + 16);
+        if (name_end >= names_size || names[name_end] != '\0' || file_offset < index_size
+            || file_offset % BYTECODE_ALIGNMENT != 0 || (uint64_t)file_offset + read_u32(entry + 20) > size)
+        {
+            return BYTECODE_FILE_CORRUPT;
+        }
+    }
+
+    const unsigned char* buckets = bytes + BYTECODE_ARCHIVE_HEADER_SIZE + (size_t)archive->module_count * BYTECODE_ARCHIVE_MODULE_SIZE;
+    for (uint32_t i = 0; i < archive->bucket_count; i++)
+    {
+        if (read_u32(buckets + (size_t)i * 4) > archive->module_count)
+        {
+            return BYTECODE_FILE_CORRUPT;
+        }
+    }
+
+    return BYTECODE_FILE_VALID;
+}
+
+int find_bytecode_archive_module(const bytecode_archive* archive, const char* name)
+{
+    size_t name_length = strlen(name);
+    uint64_t hash = get_module_name_hash(name, name_length);
+    const unsigned char* modules = archive->data + BYTECODE_ARCHIVE_HEADER_SIZE;
+    const unsigned char* buckets = modules + (size_t)archive->module_count * BYTECODE_ARCHIVE_MODULE_SIZE;
+    const char* names = (const char*)archive->data + get_names_offset(archive->module_count, archive->bucket_count);
+
+    /* the walk stops at the first empty bucket, and never visits a bucket twice */
+    uint32_t bucket = (uint32_t)hash & (archive->bucket_count - 1);
+    for (uint32_t i = 0; i < archive->bucket_count; i++)
+    {
+        uint32_t slot = read_u32(buckets + (size_t)bucket * 4);
+        if (slot == 0)
+        {
+            return -1;
+        }
+
+        const unsigned char* entry = modules + (size_t)(slot - 1) * BYTECODE_ARCHIVE_MODULE_SIZE;
+        if (read_u64(entry) == hash && read_u32(entry + 12) == name_length
+            && memcmp(names + read_u32(entry + 8), name, name_length) == 0)
+        {
+            return (int)(slot - 1);
+        }
+        bucket = (bucket + 1) & (archive->bucket_count - 1);
+    }
+
+    return -1;
+}
+
+void get_bytecode_archive_module(const bytecode_archive* archive, uint32_t index, bytecode_archive_module* module)
+{
+    const unsigned char* entry = archive->data + BYTECODE_ARCHIVE_HEADER_SIZE + (size_t)index * BYTECODE_ARCHIVE_MODULE_SIZE;
+    const char* names = (const char*)archive->data + get_names_offset(archive->module_count, archive->bucket_count);
+    module->name = names + read_u32(entry + 8);
+    module->bytecode = archive->data + read_u32(entry + 16);
+    module->size = read_u32(entry + 20);
+}
\ No newline at end of file
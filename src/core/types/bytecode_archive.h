@@ -0,0 +1,101 @@
+#ifndef BYTECODE_ARCHIVE
+#define BYTECODE_ARCHIVE
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "../extensions/byte_extensions.h"
+#include "../extensions/hash_extensions.h"
+#include "../extensions/memory_extensions.h"
+#include "bytecode_file.h"
+
+/**
+ * An .lba file bundles the compiled .lbc file of every chunk of a program, behind an index the runtime resolves grabs
+ * through without searching for or compiling anything:
+ *   header           BYTECODE_ARCHIVE_HEADER_SIZE bytes: magic, version, index checksum, file size, module count,
+ *                    bucket count, entry module, names size
+ *   module table     module_count entries of BYTECODE_ARCHIVE_MODULE_SIZE bytes: name hash, name offset, name length,
+ *                    file offset, file size
+ *   bucket table     bucket_count 32-bit numbers, each one more than the index of a module, or zero for an empty bucket
+ *   names            the name of every module, each followed by a null terminator
+ *   files            the .lbc file of every module, each starting at a multiple of BYTECODE_ALIGNMENT
+ * Every number is little-endian. A module is found by the 64-bit FNV-1a hash of its name: the bucket count is a power of
+ * two, and a module sits in the first empty bucket from its hash onward. The index checksum is a CRC32C over the
+ * header, module table, bucket table and names with the checksum itself read as zero. The .lbc files are only
+ * checked by their own checksums once they are loaded, so opening an archive never touches them.
+ */
+
+/// @brief The first four bytes of every .lba file.
+#define BYTECODE_ARCHIVE_MAGIC "LSBA"
+
+/// @brief Archives with a different major version can't be read.
+#define BYTECODE_ARCHIVE_VERSION_MAJOR 1
+
+#define BYTECODE_ARCHIVE_VERSION_MINOR 0
+#define BYTECODE_ARCHIVE_HEADER_SIZE 32
+#define BYTECODE_ARCHIVE_MODULE_SIZE 24
+
+/// @struct bytecode_archive_module
+/// @brief A module of an .lba file, and the .lbc file it was compiled to.
+typedef struct bytecode_archive_module bytecode_archive_module;
+
+/// @struct bytecode_archive
+/// @brief The index of an .lba file.
+typedef struct bytecode_archive bytecode_archive;
+
+struct bytecode_archive_module
+{
+    /// @brief The name the module is grabbed by.
+    const char* name;
+    /// @brief The .lbc file of the module.
+    const unsigned char* bytecode;
+    size_t size;
+};
+
+struct bytecode_archive
+{
+    uint16_t version_major;
+    uint16_t version_minor;
+    uint32_t module_count;
+    uint32_t bucket_count;
+    /// @brief The index of the module that runs first.
+    uint32_t entry_module;
+    /// @brief The whole file, the module table, bucket table and names are read from it in place.
+    const unsigned char* data;
+    size_t size;
+};
+
+/// @brief Determines if a file starts like an .lba file, instead of an .lbc file.
+/// @param data The file.
+/// @param size The size of the file.
+/// @return `true` if the file starts with the archive magic number, `false` otherwise.
+bool is_bytecode_archive(const void* data, size_t size);
+
+/// @brief Packs the .lbc files of modules into a complete .lba file, with an index of their names.
+/// @param modules The modules, with unique names.
+/// @param module_count The amount of modules.
+/// @param entry_module The index of the module that runs first.
+/// @param size The size of the packed file.
+/// @return The packed file, which the caller frees.
+unsigned char* pack_bytecode_archive(const bytecode_archive_module* modules, int module_count, int entry_module, size_t* size);
+
+/// @brief Reads and checks the index of an .lba file, without touching the .lbc files of its modules.
+/// @param data The whole file.
+/// @param size The size of the file.
+/// @param archive The archive to fill.
+/// @return `BYTECODE_FILE_VALID` if the index is sound, the reason it isn't otherwise.
+bytecode_file_status read_bytecode_archive(const void* data, size_t size, bytecode_archive* archive);
+
+/// @brief Finds a module by its name, looking at a single bucket unless another name shares it.
+/// @param archive The archive to search.
+/// @param name The name of the module.
+/// @return The index of the module, or `-1` if the archive doesn't have it.
+int find_bytecode_archive_module(const bytecode_archive* archive, const char* name);
+
+/// @brief Gets the name and .lbc file of a module.
+/// @param archive The archive that holds the module.
+/// @param index The index of the module.
+/// @param module The module to fill, its name and file point into the archive.
+void get_bytecode_archive_module(const bytecode_archive* archive, uint32_t index, bytecode_archive_module* module);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,318 @@
+#include "bytecode_file.h"
+
+/// @brief Where the header checksum is, it is read as zero while the checksum is computed.
+#define HEADER_CHECKSUM_OFFSET 8
+
+static uint32_t align_bytecode_offset(uint32_t offset)
+{
+    return (offset + BYTECODE_ALIGNMENT - 1) & ~(uint32_t)(BYTECODE_ALIGNMENT - 1);
+}
+
+/// @brief Computes the header checksum, which covers the header and the section table with the checksum itself read as zero.
+static uint32_t get_header_checksum(const unsigned char* data, int section_count)
+{
+    static const unsigned char zero_checksum[4] = { 0 };
+    uint32_t checksum = update_crc32c(0, data, HEADER_CHECKSUM_OFFSET);
+    checksum = update_crc32c(checksum, zero_checksum, sizeof(zero_checksum));
+
+    size_t rest = BYTECODE_HEADER_SIZE + (size_t)section_count * BYTECODE_SECTION_ENTRY_SIZE - HEADER_CHECKSUM_OFFSET - 4;
+    return update_crc32c(checksum, data + HEADER_CHECKSUM_OFFSET + 4, rest);
+}
+
+bool is_native_bytecode_layout()
+{
+    uint16_t probe = 1;
+    unsigned char first_byte;
+    memcpy(&first_byte, &probe, 1);
+
+    return first_byte == 1
+        && sizeof(instruction) == BYTECODE_INSTRUCTION_SIZE
+        && sizeof(op_code) == sizeof(int32_t) && sizeof(op_type) == sizeof(int32_t)
+        && offsetof(instruction, operand) == 8 && offsetof(instruction, op_type) == 16
+        && sizeof(bytecode_string) == BYTECODE_STRING_SIZE;
+}
+
+void encode_bytecode_instruction(const instruction* source, unsigned char* record)
+{
+    /* the reserved bytes and the unused part of the operand are always zero, so identical programs give identical files */
+    memset(record, 0, BYTECODE_INSTRUCTION_SIZE);
+    write_u32(record, (uint32_t)source->op_code);
+    write_u32(record + 16, (uint32_t)source->op_type);
+
+    unsigned char* operand = record + 8;
+    switch (source->op_type)
+    {
+        case OP_TYPE_NULL:
+        {
+            /* jumps and calls keep their 32-bit offset or index in the same place as every other integer operand */
+            write_u32(operand, (uint32_t)source->operand.i);
+            break;
+        }
+        case OP_TYPE_NUMBER:
+        {
+            uint64_t bits;
+            memcpy(&bits, &source->operand.d, sizeof(bits));
+            write_u64(operand, bits);
+            break;
+        }
+        case OP_TYPE_BIT:
+        {
+            operand[0] = source->operand.b;
+            break;
+        }
+        case OP_TYPE_VARIABLE:
+        {
+            write_u32(operand, (uint32_t)source->operand.variable.variable_index);
+            write_u32(operand + 4, (uint32_t)source->operand.variable.variable_type);
+            break;
+        }
+        default:
+        {
+            write_u32(operand, (uint32_t)source->operand.i);
+            break;
+        }
+    }
+}
+
+void decode_bytecode_instruction(const unsigned char* record, instruction* destination)
+{
+    memset(destination, 0, sizeof(instruction));
+    destination->op_code = (op_code)read_u32(record);
+    destination->op_type = (op_type)read_u32(record + 16);
+
+    const unsigned char* operand = record + 8;
+    switch (destination->op_type)
+    {
+        case OP_TYPE_NUMBER:
+        {
+            uint64_t bits = read_u64(operand);
+            memcpy(&destination->operand.d, &bits, sizeof(bits));
+            break;
+        }
+        case OP_TYPE_BIT:
+        {
+            destination->operand.b = operand[0];
+            break;
+        }
+        case OP_TYPE_VARIABLE:
+        {
+            destination->operand.variable.variable_index = (int)read_u32(operand);
+            destination->operand.variable.variable_type = (symbol_type)read_u32(operand + 4);
+            break;
+        }
+        default:
+        {
+            destination->operand.i = (int32_t)read_u32(operand);
+            break;
+        }
+    }
+}
+
+void encode_bytecode_string(const bytecode_string* source, unsigned char* record)
+{
+    write_u32(record, source->offset);
+    write_u32(record + 4, source->length);
+}
+
+void decode_bytecode_string(const unsigned char* record, bytecode_string* destination)
+{
+    destination->offset = read_u32(record);
+    destination->length = read_u32(record + 4);
+}
+
+/// @brief Compresses a section that asks for it, and clears its flag if compressing doesn't make it smaller.
+/// @return The compressed contents that replace the section data, which the caller frees, or `NULL` if the section is stored as it is.
+static unsigned char* compress_bytecode_section(bytecode_section* section)
+{
+    if ((section->flags & BYTECODE_SECTION_COMPRESSED) == 0)
+    {
+        return NULL;
+    }
+
+    size_t capacity = get_maximum_compressed_size(section->size);
+    unsigned char* compressed = (unsigned char*)safe_malloc(sizeof(uint32_t) + capacity);
+    write_u32(compressed, section->size);
+    size_t compressed_size = compress_lz(section->data, section->size, compressed + sizeof(uint32_t), capacity);
+    if (compressed_size == 0 || sizeof(uint32_t) + compressed_size >= section->size)
+    {
+        safe_free(compressed);
+        section->flags &= ~BYTECODE_SECTION_COMPRESSED;
+        return NULL;
+    }
+
+    section->data = compressed;
+    section->size = (uint32_t)(sizeof(uint32_t) + compressed_size);
+    return compressed;
+}
+
+unsigned char* pack_bytecode_container(int variable_count, bytecode_section* sections, int section_count, size_t* size)
+{
+    unsigned char* compressed[BYTECODE_MAXIMUM_SECTIONS];
+
+    /* lay the sections out one after the other, each aligned */
+    uint32_t offset = align_bytecode_offset(BYTECODE_HEADER_SIZE + (uint32_t)section_count * BYTECODE_SECTION_ENTRY_SIZE);
+    for (int i = 0; i < section_count; i++)
+    {
+        compressed[i] = compress_bytecode_section(&sections[i]);
+        sections[i].offset = offset;
+        sections[i].checksum = get_crc32c(sections[i].data, sections[i].size);
+        offset = align_bytecode_offset(offset + sections[i].size);
+    }
+
+    /* zeroed, so the padding between sections is too */
+    *size = offset;
+    unsigned char* data = (unsigned char*)safe_malloc(offset);
+    memset(data, 0, offset);
+
+    memcpy(data, BYTECODE_MAGIC, 4);
+    write_u16(data + 4, BYTECODE_VERSION_MAJOR);
+    write_u16(data + 6, BYTECODE_VERSION_MINOR);
+    write_u32(data + 12, offset);
+    write_u32(data + 16, (uint32_t)section_count);
+    write_u32(data + 20, (uint32_t)variable_count);
+
+    for (int i = 0; i < section_count; i++)
+    {
+        unsigned char* entry = data + BYTECODE_HEADER_SIZE + (size_t)i * BYTECODE_SECTION_ENTRY_SIZE;
+        write_u32(entry, (uint32_t)sections[i].kind);
+        write_u32(entry + 4, sections[i].flags);
+        write_u32(entry + 8, sections[i].offset);
+        write_u32(entry + 12, sections[i].size);
+        write_u32(entry + 16, sections[i].count);
+        write_u32(entry + 20, sections[i].checksum);
+        if (sections[i].size > 0)
+        {
+            memcpy(data + sections[i].offset, sections[i].data, sections[i].size);
+        }
+    }
+    write_u32(data + HEADER_CHECKSUM_OFFSET, get_header_checksum(data, section_count));
+
+    for (int i = 0; i < section_count; i++)
+    {
+        if (compressed[i] != NULL)
+        {
+            safe_free(compressed[i]);
+        }
+    }
+
+    return data;
+}
+
+bytecode_file_status read_bytecode_container(const void* data, size_t size, bytecode_container* container)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    if (size < BYTECODE_HEADER_SIZE || memcmp(bytes, BYTECODE_MAGIC, 4) != 0)
+    {
+        return BYTECODE_FILE_NOT_BYTECODE;
+    }
+
+    container->data = bytes;
+    container->version_major = read_u16(bytes + 4);
+    container->version_minor = read_u16(bytes + 6);
+    if (container->version_major != BYTECODE_VERSION_MAJOR)
+    {
+        return BYTECODE_FILE_UNSUPPORTED_VERSION;
+    }
+
+    container->file_size = read_u32(bytes + 12);
+    uint32_t section_count = read_u32(bytes + 16);
+    container->variable_count = (int32_t)read_u32(bytes + 20);
+    if (container->file_size != size || section_count > BYTECODE_MAXIMUM_SECTIONS || container->variable_count < 0
+        || BYTECODE_HEADER_SIZE + (size_t)section_count * BYTECODE_SECTION_ENTRY_SIZE > size)
+    {
+        return BYTECODE_FILE_CORRUPT;
+    }
+    container->section_count = (int)section_count;
+
+    /* a damaged header or section table is caught before any offset in it is trusted */
+    if (read_u32(bytes + HEADER_CHECKSUM_OFFSET) != get_header_checksum(bytes, container->section_count))
+    {
+        return BYTECODE_FILE_CORRUPT;
+    }
+
+    for (int i = 0; i < container->section_count; i++)
+    {
+        const unsigned char* entry = bytes + BYTECODE_HEADER_SIZE + (size_t)i * BYTECODE_SECTION_ENTRY_SIZE;
+        bytecode_section* section = &container->sections[i];
+        section->kind = (bytecode_section_kind)read_u32(entry);
+        section->flags = read_u32(entry + 4);
+        section->offset = read_u32(entry + 8);
+        section->size = read_u32(entry + 12);
+        section->count = read_u32(entry + 16);
+        section->checksum = read_u32(entry + 20);
+        section->data = NULL;
+
+        if (section->offset % BYTECODE_ALIGNMENT != 0 || (uint64_t)section->offset + section->size > size)
+        {
+            return BYTECODE_FILE_CORRUPT;
+        }
+        if ((section->flags & ~BYTECODE_KNOWN_SECTION_FLAGS) != 0)
+        {
+            return BYTECODE_FILE_UNSUPPORTED_VERSION;
+        }
+    }
+
+    return BYTECODE_FILE_VALID;
+}
+
+const bytecode_section* find_bytecode_section(const bytecode_container* container, bytecode_section_kind kind)
+{
+    for (int i = 0; i < container->section_count; i++)
+    {
+        if (container->sections[i].kind == kind)
+        {
+            return &container->sections[i];
+        }
+    }
+
+    return NULL;
+}
+
+bool verify_bytecode_section(const bytecode_container* container, const bytecode_section* section)
+{
+    return get_crc32c(container->data + section->offset, section->size) == section->checksum;
+}
+
+const unsigned char* load_bytecode_section(const bytecode_container* container, const bytecode_section* section, size_t maximum_size, unsigned char** allocation, size_t* size)
+{
+    *allocation = NULL;
+    *size = 0;
+    if (verify_bytecode_section(container, section) == false)
+    {
+        return NULL;
+    }
+
+    const unsigned char* stored = get_bytecode_section_data(container, section);
+    if ((section->flags & BYTECODE_SECTION_COMPRESSED) == 0)
+    {
+        *size = section->size;
+        return stored;
+    }
+
+    if (section->size < sizeof(uint32_t))
+    {
+        return NULL;
+    }
+    /* the size comes from the file, so it is checked before anything is allocated for it */
+    size_t decompressed_size = read_u32(stored);
+    *allocation = decompressed_size <= maximum_size ? (unsigned char*)try_malloc(decompressed_size > 0 ? decompressed_size : 1) : NULL;
+    if (*allocation == NULL)
+    {
+        *size = decompressed_size;
+        return NULL;
+    }
+    if (decompress_lz(stored + sizeof(uint32_t), section->size - sizeof(uint32_t), *allocation, decompressed_size) == false)
+    {
+        safe_free(*allocation);
+        *allocation = NULL;
+        return NULL;
+    }
+
+    *size = decompressed_size;
+    return *allocation;
+}
+
+const unsigned char* get_bytecode_section_data(const bytecode_container* container, const bytecode_section* section)
+{
+    return container->data + section->offset;
+}
\ No newline at end of file
@@ -0,0 +1,192 @@
+#ifndef BYTECODE_FILE
+#define BYTECODE_FILE
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "../extensions/byte_extensions.h"
+#include "../extensions/compression_extensions.h"
+#include "../extensions/hash_extensions.h"
+#include "../extensions/memory_extensions.h"
+#include "bytecode.h"
+
+/**
+ * An .lbc file is a container of sections, laid out so the runtime can execute it straight from a memory mapping:
+ *   header           BYTECODE_HEADER_SIZE bytes: magic, version, header checksum, file size, section count, variable count
+ *   section table    section_count entries of BYTECODE_SECTION_ENTRY_SIZE bytes: kind, flags, offset, size, count, checksum
+ *   sections         each starting at a multiple of BYTECODE_ALIGNMENT
+ * Every number is little-endian. Checksums are CRC32C, the header checksum covers the header and the section table
+ * with the checksum itself read as zero, and every section has its own checksum so a reader only verifies what it uses.
+ * A section flagged BYTECODE_SECTION_COMPRESSED holds the size of its contents as a 32-bit number, followed by the
+ * contents compressed with compress_lz. Its size and checksum are those of the stored bytes.
+ *
+ * The sections a program has:
+ *   code             instruction records of BYTECODE_INSTRUCTION_SIZE bytes: op code, reserved, operand, op type, reserved
+ *   constants        string views of BYTECODE_STRING_SIZE bytes: offset into the strings section, length
+ *   strings          the text of every string constant, each followed by a null terminator
+ *   debug info       optional
+ *   metadata         optional, null-terminated key and value pairs describing how the file was made
+ */
+
+/// @brief The first four bytes of every .lbc file.
+#define BYTECODE_MAGIC "LSBC"
+
+/// @brief Files with a different major version can't be read.
+#define BYTECODE_VERSION_MAJOR 1
+
+/// @brief Files with a newer minor version only add things an older reader can skip or reject by their flags.
+#define BYTECODE_VERSION_MINOR 2
+
+#define BYTECODE_HEADER_SIZE 32
+#define BYTECODE_SECTION_ENTRY_SIZE 24
+#define BYTECODE_MAXIMUM_SECTIONS 16
+
+/// @brief The alignment of every section, relative to the start of the file.
+#define BYTECODE_ALIGNMENT 8
+
+/// @brief The section is stored compressed, when packing it asks for the section to be compressed if that makes it smaller.
+#define BYTECODE_SECTION_COMPRESSED 0x1u
+
+/// @brief Every section flag this reader understands, a section with any other flag can't be read.
+#define BYTECODE_KNOWN_SECTION_FLAGS BYTECODE_SECTION_COMPRESSED
+
+#define BYTECODE_INSTRUCTION_SIZE 24
+#define BYTECODE_STRING_SIZE 8
+
+/// @enum bytecode_section_kind
+/// @brief What a section of an .lbc file holds.
+typedef enum bytecode_section_kind
+{
+    BYTECODE_SECTION_CODE = 1,
+    BYTECODE_SECTION_CONSTANTS = 2,
+    BYTECODE_SECTION_STRINGS = 3,
+    BYTECODE_SECTION_DEBUG = 4,
+    BYTECODE_SECTION_METADATA = 5
+} bytecode_section_kind;
+
+/// @enum bytecode_file_status
+/// @brief The result of reading the header and section table of an .lbc file.
+typedef enum bytecode_file_status
+{
+    BYTECODE_FILE_VALID,
+    /// @brief The file doesn't start with the magic number.
+    BYTECODE_FILE_NOT_BYTECODE,
+    /// @brief The file was written with a major version this reader doesn't know.
+    BYTECODE_FILE_UNSUPPORTED_VERSION,
+    /// @brief The file is truncated, its checksum doesn't match, or its sections don't fit in it.
+    BYTECODE_FILE_CORRUPT
+} bytecode_file_status;
+
+/// @struct bytecode_section
+/// @brief A section of an .lbc file.
+typedef struct bytecode_section bytecode_section;
+
+/// @struct bytecode_container
+/// @brief The header and section table of an .lbc file.
+typedef struct bytecode_container bytecode_container;
+
+/// @struct bytecode_string
+/// @brief A string constant, as a view into the strings section.
+typedef struct bytecode_string bytecode_string;
+
+struct bytecode_section
+{
+    bytecode_section_kind kind;
+    uint32_t flags;
+    uint32_t offset;
+    uint32_t size;
+    /// @brief The amount of entries in the section, such as instructions or string views.
+    uint32_t count;
+    uint32_t checksum;
+    /// @brief The contents of the section when packing a file, unused when reading one.
+    const void* data;
+};
+
+struct bytecode_container
+{
+    uint16_t version_major;
+    uint16_t version_minor;
+    int32_t variable_count;
+    uint32_t file_size;
+    int section_count;
+    bytecode_section sections[BYTECODE_MAXIMUM_SECTIONS];
+    /// @brief The whole file, sections are at their offsets from it.
+    const unsigned char* data;
+};
+
+struct bytecode_string
+{
+    /// @brief Where the text starts, relative to the strings section.
+    uint32_t offset;
+    /// @brief The amount of characters in the text, not counting its null terminator.
+    uint32_t length;
+};
+
+/// @brief Determines if this host lays out instructions and string views exactly like an .lbc file does, so they can be used straight from a mapped file.
+/// @return `true` if sections can be used in place, `false` if they have to be decoded.
+bool is_native_bytecode_layout();
+
+/// @brief Writes an `instruction` as an instruction record, encoding the operand by its op type so the record is the same on every host.
+/// @param source The instruction to encode.
+/// @param record The `BYTECODE_INSTRUCTION_SIZE` bytes to write the record to.
+void encode_bytecode_instruction(const instruction* source, unsigned char* record);
+
+/// @brief Reads an instruction record into an `instruction`.
+/// @param record The `BYTECODE_INSTRUCTION_SIZE` bytes of the record.
+/// @param destination The instruction to fill.
+void decode_bytecode_instruction(const unsigned char* record, instruction* destination);
+
+/// @brief Writes a string view as `BYTECODE_STRING_SIZE` bytes.
+/// @param source The string view to encode.
+/// @param record The bytes to write the view to.
+void encode_bytecode_string(const bytecode_string* source, unsigned char* record);
+
+/// @brief Reads `BYTECODE_STRING_SIZE` bytes into a string view.
+/// @param record The bytes of the view.
+/// @param destination The string view to fill.
+void decode_bytecode_string(const unsigned char* record, bytecode_string* destination);
+
+/// @brief Packs sections into a complete .lbc file, filling in their offsets and checksums.
+/// @param variable_count The number of variable slots the program needs.
+/// @param sections The sections to pack, with their `kind`, `flags`, `count`, `size` and `data` filled, a section flagged `BYTECODE_SECTION_COMPRESSED` keeps the flag only if compressing made it smaller.
+/// @param section_count The number of sections.
+/// @param size The size of the packed file.
+/// @return The packed file, which the caller frees.
+unsigned char* pack_bytecode_container(int variable_count, bytecode_section* sections, int section_count, size_t* size);
+
+/// @brief Reads and checks the header and section table of an .lbc file, without touching the sections themselves.
+/// @param data The whole file.
+/// @param size The size of the file.
+/// @param container The container to fill.
+/// @return `BYTECODE_FILE_VALID` if the header and section table are sound, the reason they aren't otherwise.
+bytecode_file_status read_bytecode_container(const void* data, size_t size, bytecode_container* container);
+
+/// @brief Finds the section of a `kind`.
+/// @param container The container to search.
+/// @param kind The kind of section.
+/// @return The section, or `NULL` if the container doesn't have one.
+const bytecode_section* find_bytecode_section(const bytecode_container* container, bytecode_section_kind kind);
+
+/// @brief Determines if the contents of a section match its checksum.
+/// @param container The container that holds the section.
+/// @param section The section to verify.
+/// @return `true` if the section is intact, `false` otherwise.
+bool verify_bytecode_section(const bytecode_container* container, const bytecode_section* section);
+
+/// @brief Verifies a section and gets its contents, decompressing them if the section is stored compressed.
+/// @param container The container that holds the section.
+/// @param section The section to load.
+/// @param maximum_size The most bytes a compressed section may decompress to, `SIZE_MAX` for no limit.
+/// @param allocation Set to the decompressed contents, which the caller frees, or `NULL` if the contents are used from the file in place.
+/// @param size Set to the size of the contents, or when they can't be loaded, to `0` if the section is corrupt and to the size they
+/// needed if they are larger than `maximum_size` or there isn't enough memory for them.
+/// @return The contents of the section, or `NULL` if they can't be loaded.
+const unsigned char* load_bytecode_section(const bytecode_container* container, const bytecode_section* section, size_t maximum_size, unsigned char** allocation, size_t* size);
+
+/// @brief Gets the stored bytes of a section, compressed or not.
+/// @param container The container that holds the section.
+/// @param section The section.
+/// @return The first byte of the section.
+const unsigned char* get_bytecode_section_data(const bytecode_container* container, const bytecode_section* section);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "line_table.h"
+
+/// @brief The most bytes a varint of a 64-bit number takes.
+#define MAXIMUM_VARINT_SIZE 10
+
+/// @brief A line table being encoded, which is only measured while `data` is `NULL`.
+typedef struct
+{
+    unsigned char* data;
+    size_t size;
+} LINE_TABLE_WRITER;
+
+/// @brief The rest of an encoded line table being decoded.
+typedef struct
+{
+    const unsigned char* data;
+    size_t size;
+    size_t position;
+} LINE_TABLE_READER;
+
+static void write_varint(LINE_TABLE_WRITER* writer, uint64_t number)
+{
+    do
+    {
+        unsigned char byte = (unsigned char)(number & 0x7F);
+        number >>= 7;
+        if (number != 0)
+        {
+            byte |= 0x80;
+        }
+        if (writer->data != NULL)
+        {
+            writer->data[writer->size] = byte;
+        }
+        writer->size++;
+    } while (number != 0);
+}
+
+/// @brief Writes a signed difference, so small differences either way take a single byte.
+static void write_zigzag(LINE_TABLE_WRITER* writer, int64_t number)
+{
+    write_varint(writer, ((uint64_t)number << 1) ^ (uint64_t)(number >> 63));
+}
+
+static bool read_varint(LINE_TABLE_READER* reader, uint64_t* number)
+{
+    *number = 0;
+    for (int i = 0; i < MAXIMUM_VARINT_SIZE && reader->position < reader->size; i++)
+    {
+        unsigned char byte = reader->data[reader->position++];
+        *number |= (uint64_t)(byte & 0x7F) << (7 * i);
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool read_zigzag(LINE_TABLE_READER* reader, int64_t* number)
+{
+    uint64_t encoded;
+    if (read_varint(reader, &encoded) == false)
+    {
+        return false;
+    }
+    *number = (int64_t)(encoded >> 1) ^ -(int64_t)(encoded & 1);
+
+    return true;
+}
+
+static bool is_same_location(const source_location* first, const source_location* second)
+{
+    return first->file == second->file && first->line == second->line && first->column == second->column;
+}
+
+/// @brief Writes the whole table, or only measures it while the writer has no data.
+static uint32_t write_line_table(LINE_TABLE_WRITER* writer, const source_location* locations, int instruction_count, const char* const* files, int file_count)
+{
+    write_varint(writer, (uint64_t)file_count);
+    for (int i = 0; i < file_count; i++)
+    {
+        size_t length = strlen(files[i]) + 1;
+        if (writer->data != NULL)
+        {
+            memcpy(writer->data + writer->size, files[i], length);
+        }
+        writer->size += length;
+    }
+
+    /* a row only starts where the place an instruction was compiled from changes */
+    uint32_t row_count = 0;
+    int program_counter = 0;
+    source_location previous = { 0, 0, 0 };
+    for (int i = 0; i < instruction_count; i++)
+    {
+        if (i > 0 && is_same_location(&locations[i], &locations[i - 1]) == true)
+        {
+            continue;
+        }
+
+        bool is_new_file = locations[i].file != previous.file;
+        write_varint(writer, (uint64_t)(i - program_counter) << 1 | (is_new_file == true ? 1 : 0));
+        if (is_new_file == true)
+        {
+            write_varint(writer, (uint64_t)locations[i].file);
+        }
+        write_zigzag(writer, (int64_t)locations[i].line - previous.line);
+        write_zigzag(writer, (int64_t)locations[i].column - previous.column);
+        program_counter = i;
+        previous = locations[i];
+        row_count++;
+    }
+
+    return row_count;
+}
+
+unsigned char* encode_line_table(const source_location* locations, int instruction_count, const char* const* files, int file_count, uint32_t* row_count, size_t* size)
+{
+    LINE_TABLE_WRITER writer = { NULL, 0 };
+    write_line_table(&writer, locations, instruction_count, files, file_count);
+
+    *size = writer.size;
+    writer.data = (unsigned char*)safe_malloc(writer.size > 0 ? writer.size : 1);
+    writer.size = 0;
+    *row_count = write_line_table(&writer, locations, instruction_count, files, file_count);
+
+    return writer.data;
+}
+
+bool decode_line_table(const unsigned char* data, size_t size, uint32_t row_count, size_t maximum_size, line_table* table)
+{
+    table->files = NULL;
+    table->file_count = 0;
+    table->rows = NULL;
+    table->row_count = 0;
+    table->allocated_size = 0;
+
+    /* every file takes at least its null terminator and every row at least three bytes, which bounds both counts */
+    LINE_TABLE_READER reader = { data, size, 0 };
+    uint64_t file_count;
+    if (read_varint(&reader, &file_count) == false || file_count > size || (uint64_t)row_count * 3 > size)
+    {
+        return false;
+    }
+
+    size_t files_size = (file_count > 0 ? (size_t)file_count : 1) * sizeof(const char*);
+    size_t rows_size = (row_count > 0 ? (size_t)row_count : 1) * sizeof(line_table_row);
+    if (files_size + rows_size <= maximum_size)
+    {
+        table->files = (const char**)try_malloc(files_size);
+        table->rows = (line_table_row*)try_malloc(rows_size);
+    }
+    if (table->files == NULL || table->rows == NULL)
+    {
+        free_line_table(table);
+        table->allocated_size = files_size + rows_size;
+        return false;
+    }
+    table->allocated_size = files_size + rows_size;
+
+    for (uint64_t i = 0; i < file_count; i++)
+    {
+        const char* file = (const char*)data + reader.position;
+        const char* terminator = (const char*)memchr(file, '\0', size - reader.position);
+        if (terminator == NULL)
+        {
+            free_line_table(table);
+            return false;
+        }
+        table->files[table->file_count++] = file;
+        reader.position += (size_t)(terminator - file) + 1;
+    }
+
+    line_table_row row = { 0, { 0, 0, 0 } };
+    for (uint32_t i = 0; i < row_count; i++)
+    {
+        uint64_t distance, file = (uint64_t)row.location.file;
+        int64_t line_difference, column_difference;
+        if (read_varint(&reader, &distance) == false || ((distance & 1) == 1 && read_varint(&reader, &file) == false)
+            || read_zigzag(&reader, &line_difference) == false || read_zigzag(&reader, &column_difference) == false)
+        {
+            free_line_table(table);
+            return false;
+        }
+
+        /* rows have to move forward, except for the first one, and stay inside of the files and numbers they can hold */
+        int64_t program_counter = (int64_t)row.program_counter + (int64_t)(distance >> 1);
+        int64_t line = (int64_t)row.location.line + line_difference;
+        int64_t column = (int64_t)row.location.column + column_difference;
+        if ((i > 0 && (distance >> 1) == 0) || program_counter > INT32_MAX || file >= file_count
+            || line < 0 || line > INT32_MAX || column < 0 || column > INT32_MAX)
+        {
+            free_line_table(table);
+            return false;
+        }
+        row = (line_table_row){ (int)program_counter, { (int)file, (int)line, (int)column } };
+        table->rows[table->row_count++] = row;
+    }
+
+    if (reader.position != size)
+    {
+        free_line_table(table);
+        return false;
+    }
+
+    return true;
+}
+
+bool find_source_location(const line_table* table, int program_counter, source_location* location)
+{
+    /* the row an instruction belongs to is the last one that starts at or before it */
+    int low = 0;
+    int high = table->row_count - 1;
+    int found = -1;
+    while (low <= high)
+    {
+        int middle = low + (high - low) / 2;
+        if (table->rows[middle].program_counter <= program_counter)
+        {
+            found = middle;
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+
+    if (found < 0 || table->rows[found].location.line == 0)
+    {
+        return false;
+    }
+    *location = table->rows[found].location;
+
+    return true;
+}
+
+void free_line_table(line_table* table)
+{
+    if (table->files != NULL)
+    {
+        safe_free((void*)table->files);
+    }
+    if (table->rows != NULL)
+    {
+        safe_free(table->rows);
+    }
+    table->files = NULL;
+    table->file_count = 0;
+    table->rows = NULL;
+    table->row_count = 0;
+    table->allocated_size = 0;
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#ifndef LINE_TABLE
+#define LINE_TABLE
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "../extensions/memory_extensions.h"
+
+/**
+ * A line table maps every instruction of a program to the place in its source it was compiled from. It is stored in
+ * the debug info section of an .lbc file, which the runtime only reads once it has something to report, so it never
+ * weighs on the instructions themselves:
+ *   file count       a varint
+ *   files            the path of every source file, each followed by a null terminator
+ *   rows             one for every run of instructions from the same place: a varint of the distance to the
+ *                    previous row's instruction shifted left once, its lowest bit set when a varint file index
+ *                    follows, then the zigzag varint differences to the previous row's line and column
+ * A varint is a number in groups of 7 bits, lowest first, where every byte but the last has its highest bit set. Rows
+ * start from instruction 0 of file 0, at line 0 and column 0, and a line of 0 is a place that isn't known.
+ */
+
+/// @struct source_location
+/// @brief A place in the source of a program.
+typedef struct source_location source_location;
+
+/// @struct line_table_row
+/// @brief The first instruction of a run of instructions compiled from the same place.
+typedef struct line_table_row line_table_row;
+
+/// @struct line_table
+/// @brief A decoded line table.
+typedef struct line_table line_table;
+
+struct source_location
+{
+    /// @brief The index of the source file in the line table, programs linked from several chunks have several.
+    int file;
+    /// @brief The line in the source file, starting at 1, `0` if it isn't known.
+    int line;
+    /// @brief The column in the line, starting at 1.
+    int column;
+};
+
+struct line_table_row
+{
+    int program_counter;
+    source_location location;
+};
+
+struct line_table
+{
+    /// @brief The path of every source file, pointing into the encoded table.
+    const char** files;
+    int file_count;
+    /// @brief The rows, by ascending program counter.
+    line_table_row* rows;
+    int row_count;
+    /// @brief The bytes the files and rows take.
+    size_t allocated_size;
+};
+
+/// @brief Encodes the source location of every instruction into a line table.
+/// @param locations The source location of every instruction.
+/// @param instruction_count The amount of instructions.
+/// @param files The path of every source file the locations refer to.
+/// @param file_count The amount of source files.
+/// @param row_count Set to the amount of rows in the table.
+/// @param size Set to the size of the encoded table.
+/// @return The encoded table, which the caller frees.
+unsigned char* encode_line_table(const source_location* locations, int instruction_count, const char* const* files, int file_count, uint32_t* row_count, size_t* size);
+
+/// @brief Decodes a line table, checking that every row and file in it is sound.
+/// @param data The encoded table, which has to outlive the decoded one.
+/// @param size The size of the encoded table.
+/// @param row_count The amount of rows the table should have.
+/// @param maximum_size The most bytes the files and rows may take, `SIZE_MAX` for no limit.
+/// @param table The line table to fill. When it can't be decoded, its allocated size is left at `0` if the table is corrupt and at
+/// the bytes its files and rows needed if they are larger than `maximum_size` or there isn't enough memory for them.
+/// @return `true` if the table was decoded, `false` if it can't be.
+bool decode_line_table(const unsigned char* data, size_t size, uint32_t row_count, size_t maximum_size, line_table* table);
+
+/// @brief Finds where an instruction was compiled from.
+/// @param table The line table to search.
+/// @param program_counter The index of the instruction.
+/// @param location The source location to fill.
+/// @return `true` if the place the instruction was compiled from is known, `false` otherwise.
+bool find_source_location(const line_table* table, int program_counter, source_location* location);
+
+/// @brief Deallocates the rows and files of a line table, but not the table itself or the encoded table it points into.
+/// @param table The line table to free the members of.
+void free_line_table(line_table* table);
+
+#endif
\ No newline at end of file
@@ -1,27 +1,112 @@
 #include "main.h"
 
+/// @brief Gets the exit code of the runtime for how the program ended, so a caller can tell a program that failed
+/// from one that used up its fuel or its byte budget.
+static int get_exit_code(vm_status status)
+{
+    switch (status)
+    {
+        case VM_STATUS_FINISHED: return 0;
+        case VM_STATUS_OUT_OF_FUEL: return 2;
+        case VM_STATUS_OUT_OF_MEMORY: return 3;
+        default: return 1;
+    }
+}
+
 int main(int argc, const char* argv[])
 {
-    if (argc != 2)
+    uint64_t start_time = get_monotonic_time();
+    runtime_options options;
+    if (parse_runtime_options(argc, argv, &options) == false || options.input_path == NULL)
     {
-        log_error("Usage: vm <bytecode_file>");
+        log_error("Usage: vm [--log-level=debug|info|warning|error] [--log-async[=block|drop]] [--log-format=console|json|binary] [--snapshot-out=<path>|--snapshot-in=<path>] [--profile=<path>] [--profile-rate=<samples>] [--perf-map] [--metrics=<path>] [--metrics-format=json|prometheus] [--fuel=<instructions>] [--memory-limit=<bytes>] <bytecode_file|->");
         return 1;
     }
 
+    set_log_sink(get_log_sink(options.log_format));
+
+    /* the queue is drained when the runtime exits, however it exits */
+    if (options.use_async_logger == true && start_async_logger(DEFAULT_ASYNC_LOG_CAPACITY, options.log_overflow_policy) == false)
+    {
+        log_warning("Runtime warning: Unable to start the asynchronous logger, logging synchronously.");
+    }
+
+    /* only allocations from here on are the program's */
+    if (options.metrics_path != NULL)
+    {
+        count_allocations();
+    }
+
     virtual_machine vm;
     create_virtual_machine(&vm);
-    if (load_bytecode_from_file(&vm, argv[1]) == false)
+    vm.minimum_log_level = options.minimum_log_level;
+    vm.is_measured = options.metrics_path != NULL;
+    vm.fuel = options.fuel;
+    vm.memory_limit = options.memory_limit;
+    uint64_t load_start_time = get_monotonic_time();
+    if (load_bytecode_from_file(&vm, options.input_path) == false)
+    {
+        log_error("Runtime error: Failed to load \"%s\" bytecode file.", options.input_path);
+        return vm.is_out_of_memory == true ? get_exit_code(VM_STATUS_OUT_OF_MEMORY) : 1;
+    }
+
+    /* without trampolines the program still runs, only native profilers can't tell its programs apart */
+    if (options.use_perf_map == true && start_perf_map() == false)
+    {
+        log_warning("Runtime warning: Running \"%s\" without a perf map.", options.input_path);
+    }
+    if (options.profile_path != NULL && start_vm_profiler(&vm, options.profile_rate) == false)
     {
-        log_error("Runtime error: Failed to load \"%s\" bytecode file.", argv[1]);
         return 1;
     }
-    if(run_vm(&vm) == false)
+
+    /* a missing or stale snapshot only costs the initialization it would have skipped */
+    if (options.snapshot_in_path != NULL && restore_vm_snapshot(&vm, options.snapshot_in_path) == false)
+    {
+        log_warning("Runtime warning: Snapshot \"%s\" can't be restored into \"%s\", running it from the start.", options.snapshot_in_path, options.input_path);
+    }
+    uint64_t execution_start_time = get_monotonic_time();
+    if (options.snapshot_out_path != NULL)
+    {
+        vm_status initialization_status = initialize_vm(&vm);
+        if (initialization_status != VM_STATUS_FINISHED)
+        {
+            log_error("Runtime error: Failed to initialize \"%s\" bytecode.", options.input_path);
+            return get_exit_code(initialization_status);
+        }
+        if (save_vm_snapshot(&vm, options.snapshot_out_path) == false)
+        {
+            return 1;
+        }
+    }
+    vm_status status = run_vm(&vm);
+    uint64_t execution_end_time = get_monotonic_time();
+    PRINT_OP_STATISTICS();
+    stop_perf_map();
+
+    bool is_measured = true;
+    if (options.metrics_path != NULL)
+    {
+        run_metrics metrics = { vm.metrics, execution_start_time - load_start_time, execution_end_time - execution_start_time, 0, { 0, 0 }, 0, status == VM_STATUS_FINISHED };
+        get_allocation_statistics(&metrics.allocations);
+        metrics.peak_resident_size = get_peak_resident_size();
+        metrics.wall_nanoseconds = get_elapsed_time(start_time);
+        is_measured = write_run_metrics(options.metrics_path, options.metrics_format, &metrics);
+    }
+
+    /* a failed run is profiled too, up to where it failed, while its modules are still loaded */
+    bool is_profiled = options.profile_path == NULL || stop_vm_profiler(options.profile_path) == true;
+    if (status != VM_STATUS_FINISHED)
+    {
+        log_error("Runtime error: Failed to run \"%s\" bytecode.", options.input_path);
+        return get_exit_code(status);
+    }
+    if (is_profiled == false || is_measured == false)
     {
-        log_error("Runtime error: Failed to run \"%s\" bytecode.", argv[1]);
         return 1;
     }
 
-    safe_free(&vm);
+    free_virtual_machine(&vm);
 
     return 0;
 }
\ No newline at end of file
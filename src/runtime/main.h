@@ -3,6 +3,10 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include "profiler/vm_profiler.h"
+#include "metrics/run_metrics.h"
+#include "snapshot/vm_snapshot.h"
+#include "types/runtime_options.h"
 #include "virtual_machine/virtual_machine.h"
 
 /// @brief The main entry point of the L# runtime.
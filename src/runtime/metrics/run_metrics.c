@@ -0,0 +1,92 @@
+#include "run_metrics.h"
+
+/// @brief A metric as both formats write it.
+typedef struct
+{
+    const char* name;
+    const char* type;
+    const char* help;
+    double value;
+} METRIC;
+
+bool parse_metrics_format(const char* name, metrics_format* format)
+{
+    if (strcmp(name, "json") == 0)
+    {
+        *format = METRICS_FORMAT_JSON;
+        return true;
+    }
+    if (strcmp(name, "prometheus") == 0)
+    {
+        *format = METRICS_FORMAT_PROMETHEUS;
+        return true;
+    }
+
+    return false;
+}
+
+/// @brief Formats a count as the whole number it is, and a time with the digits that matter.
+static void format_metric_value(char* buffer, size_t size, double value)
+{
+    snprintf(buffer, size, value == (double)(uint64_t)value ? "%.0f" : "%.9g", value);
+}
+
+bool write_run_metrics(const char* path, metrics_format format, const run_metrics* metrics)
+{
+    /* a double holds every count exactly up to 2^53 */
+    const METRIC table[] = {
+        { "success", "gauge", "1 if the program ran to its end, 0 if it failed.", metrics->is_successful == true ? 1 : 0 },
+        { "instructions_total", "counter", "Instructions run.", (double)metrics->vm.instruction_count },
+        { "peak_stack_depth", "gauge", "Most values on the stack of one virtual machine at once.", metrics->vm.peak_stack_depth },
+        { "objects_total", "counter", "String objects loaded.", (double)metrics->vm.object_count },
+        { "modules_total", "counter", "Modules run.", (double)metrics->vm.module_count },
+        { "allocations_total", "counter", "Allocations made by the runtime.", (double)metrics->allocations.count },
+        { "allocated_bytes_total", "counter", "Bytes allocated by the runtime.", (double)metrics->allocations.bytes },
+        { "peak_resident_bytes", "gauge", "Most memory the process held at once.", (double)metrics->peak_resident_size },
+        { "gc_cycles_total", "counter", "Garbage collections.", (double)metrics->vm.gc_cycle_count },
+        { "gc_pause_seconds_total", "counter", "Time spent collecting garbage.", metrics->vm.gc_pause_nanoseconds / 1e9 },
+        { "gc_longest_pause_seconds", "gauge", "Longest single garbage collection.", metrics->vm.gc_longest_pause_nanoseconds / 1e9 },
+        { "builtin_calls_total", "counter", "Prints and builtin logging calls that wrote something.", (double)metrics->vm.builtin_call_count },
+        { "builtin_seconds_total", "counter", "Time spent in prints and builtin logging calls.", metrics->vm.builtin_nanoseconds / 1e9 },
+        { "load_seconds", "gauge", "Time spent loading the program.", metrics->load_nanoseconds / 1e9 },
+        { "execution_seconds", "gauge", "Time spent running the program.", metrics->execution_nanoseconds / 1e9 },
+        { "wall_seconds", "gauge", "Time since the runtime started.", metrics->wall_nanoseconds / 1e9 }
+    };
+    int metric_count = (int)(sizeof(table) / sizeof(table[0]));
+
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+    {
+        log_error("Runtime error: Cannot write the metrics \"%s\".", path);
+        return false;
+    }
+
+    if (format == METRICS_FORMAT_PROMETHEUS)
+    {
+        for (int i = 0; i < metric_count; i++)
+        {
+            char value[32];
+            format_metric_value(value, sizeof(value), table[i].value);
+            fprintf(file, "# HELP lsr_%s %s\n# TYPE lsr_%s %s\nlsr_%s %s\n", table[i].name, table[i].help, table[i].name, table[i].type, table[i].name, value);
+        }
+    }
+    else
+    {
+        fprintf(file, "{");
+        for (int i = 0; i < metric_count; i++)
+        {
+            char value[32];
+            format_metric_value(value, sizeof(value), table[i].value);
+            fprintf(file, "%s\"%s\":%s", i > 0 ? "," : "", table[i].name, value);
+        }
+        fprintf(file, "}\n");
+    }
+
+    if (fclose(file) != 0)
+    {
+        log_error("Runtime error: Cannot write the metrics \"%s\".", path);
+        return false;
+    }
+
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef RUN_METRICS
+#define RUN_METRICS
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "../../core/extensions/memory_extensions.h"
+#include "../../core/logger/logger.h"
+#include "../virtual_machine/virtual_machine.h"
+
+/**
+ * The metrics of a run are what the virtual machine counted as it ran, and what the runtime measured around it: how
+ * long loading the program took against running it, and what the process allocated. They are written once the run
+ * ends, whether or not it succeeded, as one JSON object or in the Prometheus text exposition format, every metric
+ * named `lsr_<metric>`. Modules are loaded as they are grabbed, so loading them counts towards running the program.
+ */
+
+/// @enum metrics_format
+/// @brief The formats the metrics of a run can be written in.
+typedef enum metrics_format
+{
+    METRICS_FORMAT_JSON,
+    METRICS_FORMAT_PROMETHEUS
+} metrics_format;
+
+/// @struct run_metrics
+/// @brief What a run of the runtime took.
+typedef struct run_metrics run_metrics;
+
+struct run_metrics
+{
+    /// @brief What the virtual machine counted, including the modules it grabbed.
+    vm_metrics vm;
+    /// @brief The time spent loading the program and restoring its snapshot, in nanoseconds.
+    uint64_t load_nanoseconds;
+    /// @brief The time spent running the program, in nanoseconds.
+    uint64_t execution_nanoseconds;
+    /// @brief The time since the runtime started, in nanoseconds.
+    uint64_t wall_nanoseconds;
+    /// @brief The allocations the runtime made.
+    allocation_statistics allocations;
+    /// @brief The most memory the process held at once, in bytes.
+    size_t peak_resident_size;
+    /// @brief `true` if the program ran to its end, `false` if it failed.
+    bool is_successful;
+};
+
+/// @brief Parses the name of a metrics format.
+/// @param name `json` or `prometheus`.
+/// @param format The format to set.
+/// @return `true` if the name is a metrics format, `false` otherwise.
+bool parse_metrics_format(const char* name, metrics_format* format);
+
+/// @brief Writes the metrics of a run to a file.
+/// @param path The path of the file, which is replaced.
+/// @param format The format to write the metrics in.
+/// @param metrics The metrics of the run.
+/// @return `true` if the metrics were written, `false` otherwise.
+bool write_run_metrics(const char* path, metrics_format format, const run_metrics* metrics);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "op_statistics.h"
+
+/// @brief A pair of operations that ran one after the other, and how often it did.
+typedef struct
+{
+    op_code first;
+    op_code second;
+    uint64_t count;
+} OP_PAIR;
+
+static uint64_t op_counts[OP_CODE_COUNT];
+static uint64_t op_pair_counts[OP_CODE_COUNT][OP_CODE_COUNT];
+static uint64_t type_check_failures[OP_CODE_COUNT];
+static int previous_op_code = -1;
+
+void count_op(op_code op_code)
+{
+    /* an unknown operation stops the run, the report leaves it out */
+    if ((int)op_code < 0 || op_code >= OP_CODE_COUNT)
+    {
+        previous_op_code = -1;
+        return;
+    }
+
+    op_counts[op_code]++;
+    if (previous_op_code >= 0)
+    {
+        op_pair_counts[previous_op_code][op_code]++;
+    }
+    previous_op_code = op_code;
+}
+
+void count_type_check_failure(op_code op_code)
+{
+    if ((int)op_code >= 0 && op_code < OP_CODE_COUNT)
+    {
+        type_check_failures[op_code]++;
+    }
+}
+
+static int compare_op_pairs(const void* left, const void* right)
+{
+    uint64_t left_count = ((const OP_PAIR*)left)->count;
+    uint64_t right_count = ((const OP_PAIR*)right)->count;
+
+    return (left_count < right_count) - (left_count > right_count);
+}
+
+void print_op_statistics()
+{
+    uint64_t total = 0;
+    for (int i = 0; i < OP_CODE_COUNT; i++)
+    {
+        total += op_counts[i];
+    }
+
+    /* build one message so the report stays together in the log */
+    char report[8192];
+    int length = snprintf(report, sizeof(report), "Operation statistics, %" PRIu64 " operations run:\n   %-20s %14s %7s %14s", total,
+        "operation", "runs", "share", "type failures");
+    for (int i = 0; i < OP_CODE_COUNT; i++)
+    {
+        if (op_counts[i] == 0 && type_check_failures[i] == 0)
+        {
+            continue;
+        }
+        length += snprintf(report + length, sizeof(report) - length, "\n   %-20s %14" PRIu64 " %6.2f%% %14" PRIu64, get_op_code_name((op_code)i),
+            op_counts[i], total > 0 ? 100.0 * op_counts[i] / total : 0.0, type_check_failures[i]);
+    }
+
+    OP_PAIR pairs[OP_CODE_COUNT * OP_CODE_COUNT];
+    int pair_count = 0;
+    uint64_t pair_total = 0;
+    for (int first = 0; first < OP_CODE_COUNT; first++)
+    {
+        for (int second = 0; second < OP_CODE_COUNT; second++)
+        {
+            if (op_pair_counts[first][second] > 0)
+            {
+                pairs[pair_count++] = (OP_PAIR){ (op_code)first, (op_code)second, op_pair_counts[first][second] };
+                pair_total += op_pair_counts[first][second];
+            }
+        }
+    }
+    qsort(pairs, pair_count, sizeof(OP_PAIR), compare_op_pairs);
+
+    length += snprintf(report + length, sizeof(report) - length, "\n   %-41s %14s %7s", "most frequent pairs", "runs", "share");
+    for (int i = 0; i < pair_count && i < OP_STATISTICS_PAIR_COUNT && length < (int)sizeof(report); i++)
+    {
+        length += snprintf(report + length, sizeof(report) - length, "\n   %-20s %-20s %14" PRIu64 " %6.2f%%", get_op_code_name(pairs[i].first),
+            get_op_code_name(pairs[i].second), pairs[i].count, 100.0 * pairs[i].count / pair_total);
+    }
+    log_info("%s", report);
+}
\ No newline at end of file
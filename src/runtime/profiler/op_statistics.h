@@ -0,0 +1,42 @@
+#ifndef OP_STATISTICS
+#define OP_STATISTICS
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../../core/logger/logger.h"
+#include "../../core/types/bytecode.h"
+
+/**
+ * A runtime built with `PROFILE_OPS` defined, by `make runtime PROFILE_OPS=1`, counts every operation it runs, every
+ * pair of operations that run one after the other, and every operation that fails its check of its operand types, and
+ * reports them as it exits. That is the evidence for which pairs are worth fusing into one instruction and which
+ * operations are worth specializing. Without `PROFILE_OPS` the counting macros expand to nothing, so a release runtime
+ * runs exactly the instructions it would without them.
+ */
+
+#ifdef PROFILE_OPS
+#define COUNT_OP(op_code) count_op(op_code)
+#define COUNT_TYPE_CHECK_FAILURE(op_code) count_type_check_failure(op_code)
+#define PRINT_OP_STATISTICS() print_op_statistics()
+#else
+#define COUNT_OP(op_code) ((void)0)
+#define COUNT_TYPE_CHECK_FAILURE(op_code) ((void)0)
+#define PRINT_OP_STATISTICS() ((void)0)
+#endif
+
+/// @brief The amount of opcode pairs the report lists, most frequent first.
+#define OP_STATISTICS_PAIR_COUNT 20
+
+/// @brief Counts an operation that is about to run, and the pair it makes with the one that ran before it.
+/// @param op_code The operation code.
+void count_op(op_code op_code);
+
+/// @brief Counts an operation whose operands had types it can't work with.
+/// @param op_code The operation code.
+void count_type_check_failure(op_code op_code);
+
+/// @brief Logs how often every operation and the most frequent pairs of operations ran, as an informational message.
+void print_op_statistics();
+
+#endif
\ No newline at end of file
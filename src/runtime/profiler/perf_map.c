@@ -0,0 +1,123 @@
+/* MAP_ANONYMOUS isn't POSIX, which strict C17 hides unless asked for */
+#define _DEFAULT_SOURCE
+#include "perf_map.h"
+
+/// @brief A trampoline, and the program it is named after.
+typedef struct
+{
+    char* name;
+    perf_trampoline trampoline;
+} NAMED_TRAMPOLINE;
+
+/* push the frame pointer, call the function with the argument the trampoline was given, and return what it returns */
+#if defined(__x86_64__)
+static const unsigned char trampoline_code[] = {
+    0x55,             /* push %rbp */
+    0x48, 0x89, 0xe5, /* mov %rsp, %rbp */
+    0xff, 0xd6,       /* call *%rsi */
+    0x5d,             /* pop %rbp */
+    0xc3              /* ret */
+};
+#elif defined(__aarch64__)
+static const unsigned char trampoline_code[] = {
+    0xfd, 0x7b, 0xbf, 0xa9, /* stp x29, x30, [sp, #-16]! */
+    0xfd, 0x03, 0x00, 0x91, /* mov x29, sp */
+    0x20, 0x00, 0x3f, 0xd6, /* blr x1 */
+    0xfd, 0x7b, 0xc1, 0xa8, /* ldp x29, x30, [sp], #16 */
+    0xc0, 0x03, 0x5f, 0xd6  /* ret */
+};
+#else
+static const unsigned char trampoline_code[] = { 0 };
+#endif
+
+static FILE* perf_map = NULL;
+static unsigned char* arena = NULL;
+static NAMED_TRAMPOLINE trampolines[PERF_TRAMPOLINE_ARENA_SIZE / PERF_TRAMPOLINE_SIZE];
+static int trampoline_count = 0;
+
+bool start_perf_map()
+{
+#if !defined(__x86_64__) && !defined(__aarch64__)
+    log_warning("Runtime warning: Perf map trampolines aren't made on this architecture, programs run without them.");
+    return false;
+#endif
+
+    void* memory = mmap(NULL, PERF_TRAMPOLINE_ARENA_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+        log_error("Runtime error: Unable to map memory for perf map trampolines.");
+        return false;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/perf-%ld.map", (long)getpid());
+    perf_map = fopen(path, "w");
+    if (perf_map == NULL)
+    {
+        log_error("Runtime error: Cannot write the perf map \"%s\".", path);
+        munmap(memory, PERF_TRAMPOLINE_ARENA_SIZE);
+        return false;
+    }
+    arena = (unsigned char*)memory;
+
+    return true;
+}
+
+perf_trampoline get_perf_trampoline(const char* name)
+{
+    if (perf_map == NULL)
+    {
+        return NULL;
+    }
+
+    const char* program_name = name != NULL ? name : "<unknown>";
+    for (int i = 0; i < trampoline_count; i++)
+    {
+        if (strcmp(trampolines[i].name, program_name) == 0)
+        {
+            return trampolines[i].trampoline;
+        }
+    }
+    if (trampoline_count == PERF_TRAMPOLINE_ARENA_SIZE / PERF_TRAMPOLINE_SIZE)
+    {
+        return NULL;
+    }
+
+    /* the arena is only ever writable or executable, never both at once */
+    unsigned char* code = arena + trampoline_count * PERF_TRAMPOLINE_SIZE;
+    if (mprotect(arena, PERF_TRAMPOLINE_ARENA_SIZE, PROT_READ | PROT_WRITE) != 0)
+    {
+        return NULL;
+    }
+    memcpy(code, trampoline_code, sizeof(trampoline_code));
+    if (mprotect(arena, PERF_TRAMPOLINE_ARENA_SIZE, PROT_READ | PROT_EXEC) != 0)
+    {
+        return NULL;
+    }
+    __builtin___clear_cache((char*)code, (char*)code + sizeof(trampoline_code));
+
+    /* data and function pointers can't be converted into each other in strict C, their bytes can be copied */
+    perf_trampoline trampoline;
+    memcpy(&trampoline, &code, sizeof(trampoline));
+    trampolines[trampoline_count++] = (NAMED_TRAMPOLINE){ duplicate_string(program_name), trampoline };
+    fprintf(perf_map, "%" PRIxPTR " %zx lsharp:%s\n", (uintptr_t)code, sizeof(trampoline_code), program_name);
+    fflush(perf_map);
+
+    return trampoline;
+}
+
+void stop_perf_map()
+{
+    if (perf_map == NULL)
+    {
+        return;
+    }
+
+    fclose(perf_map);
+    perf_map = NULL;
+    for (int i = 0; i < trampoline_count; i++)
+    {
+        safe_free(trampolines[i].name);
+    }
+    trampoline_count = 0;
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef PERF_MAP
+#define PERF_MAP
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "../../core/extensions/memory_extensions.h"
+#include "../../core/extensions/string_extensions.h"
+#include "../../core/logger/logger.h"
+
+/**
+ * Every sample a native profiler such as `perf` takes in the runtime lands in the loop that runs instructions, whatever
+ * program runs. With a perf map, every program is run through a trampoline of its own instead: a few instructions
+ * copied into executable memory that only call the loop, named after the source of the program in
+ * `/tmp/perf-<pid>.map`, the file `perf report` reads the names of code it has no symbols for from. Samples in the loop
+ * then have the trampoline of their program as their caller, so an unwinder that reaches it, with
+ * `perf record --call-graph=dwarf` or a runtime built with frame pointers, attributes them to that program.
+ *   <start> <size> lsharp:<source path>
+ * The trampolines are written for x86-64 and AArch64, elsewhere programs are run directly.
+ */
+
+/// @brief The size of the executable memory the trampolines are copied into, they are never freed.
+#define PERF_TRAMPOLINE_ARENA_SIZE 65536
+
+/// @brief The space every trampoline takes in the arena.
+#define PERF_TRAMPOLINE_SIZE 16
+
+/// @brief A trampoline, which calls `function` with `argument` and returns what it returns.
+typedef int (*perf_trampoline)(void* argument, int (*function)(void* argument));
+
+/// @brief Creates `/tmp/perf-<pid>.map` and the executable memory for trampolines, so programs run through them from now on.
+/// @return `true` if the perf map was started, `false` if it can't be created or trampolines can't be made on this host.
+bool start_perf_map();
+
+/// @brief Finds the trampoline of a program, creating it and adding it to the perf map the first time.
+/// @param name The source path of the program.
+/// @return The trampoline, or `NULL` if there is no perf map or no room for another trampoline.
+perf_trampoline get_perf_trampoline(const char* name);
+
+/// @brief Closes the perf map, the trampolines stay as they are for the rest of the run.
+void stop_perf_map();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,373 @@
+/* sigaction and setitimer are POSIX, which strict C17 hides unless asked for */
+#define _POSIX_C_SOURCE 200809L
+#include "vm_profiler.h"
+
+/// @brief A program samples are taken in, identified by the bytecode it runs from.
+typedef struct
+{
+    const unsigned char* data;
+    size_t size;
+    const char* source_path;
+} PROFILED_PROGRAM;
+
+/// @brief A place in the source samples were taken in, with the samples taken there.
+typedef struct
+{
+    const char* file;
+    int line;
+    /// @brief The instruction, for a program without debug info, `-1` otherwise.
+    int program_counter;
+    uint64_t self_count;
+    uint64_t total_count;
+} PROFILED_LINE;
+
+/// @brief A call stack as the folded format writes it, with the samples taken in it.
+typedef struct
+{
+    char* frames;
+    uint64_t count;
+} FOLDED_STACK;
+
+static virtual_machine* volatile profiled_vm = NULL;
+static const char* profiled_source_path = NULL;
+static int profile_rate = DEFAULT_PROFILE_RATE;
+static struct sigaction previous_action;
+
+/* the signal handler only ever adds to these, and never allocates */
+static PROFILED_PROGRAM programs[PROFILE_MAXIMUM_PROGRAMS];
+static atomic_int program_count = 0;
+static int* samples = NULL;
+static atomic_size_t sample_size = 0;
+static atomic_size_t sample_count = 0;
+static atomic_size_t dropped_count = 0;
+
+/// @brief Finds the index of the program a virtual machine runs, adding it the first time it is sampled.
+/// @return The index of the program, `-1` if there are too many programs to add it.
+static int find_profiled_program(const virtual_machine* vm)
+{
+    int count = atomic_load(&program_count);
+    for (int i = 0; i < count && i < PROFILE_MAXIMUM_PROGRAMS; i++)
+    {
+        if (programs[i].data == vm->program_data)
+        {
+            return i;
+        }
+    }
+
+    int index = atomic_fetch_add(&program_count, 1);
+    if (index >= PROFILE_MAXIMUM_PROGRAMS)
+    {
+        return -1;
+    }
+    programs[index] = (PROFILED_PROGRAM){ vm->program_data, vm->program_size, vm->source_path };
+
+    return index;
+}
+
+/// @brief Copies the program counter of every module being run into the sample buffer, which is all a signal handler can safely do.
+static void record_sample(int signal_number)
+{
+    (void)signal_number;
+    int frames[PROFILE_MAXIMUM_DEPTH * 2];
+    int depth = 0;
+    for (const virtual_machine* vm = profiled_vm; vm != NULL && depth < PROFILE_MAXIMUM_DEPTH; vm = vm->running_module)
+    {
+        int program = find_profiled_program(vm);
+        if (program < 0)
+        {
+            break;
+        }
+        frames[depth * 2] = program;
+        frames[depth * 2 + 1] = vm->program_counter;
+        depth++;
+    }
+    if (depth == 0)
+    {
+        return;
+    }
+
+    size_t size = 1 + (size_t)depth * 2;
+    size_t start = atomic_fetch_add(&sample_size, size);
+    if (start + size > PROFILE_BUFFER_CAPACITY)
+    {
+        atomic_fetch_add(&dropped_count, 1);
+        return;
+    }
+    samples[start] = depth;
+    for (int i = 0; i < depth * 2; i++)
+    {
+        samples[start + 1 + i] = frames[i];
+    }
+    atomic_fetch_add(&sample_count, 1);
+}
+
+bool start_vm_profiler(virtual_machine* vm, int rate)
+{
+    if (rate <= 0 || rate > 1000000)
+    {
+        log_error("Runtime error: A profile rate of %d samples a second can't be used.", rate);
+        return false;
+    }
+
+    /* the pages of the buffer are only touched as samples fill it */
+    samples = (int*)safe_malloc(PROFILE_BUFFER_CAPACITY * sizeof(int));
+    profiled_vm = vm;
+    profiled_source_path = vm->source_path;
+    profile_rate = rate;
+
+    /* interrupted reads and writes carry on, so the program behaves the same with or without the profiler */
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = record_sample;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    struct timeval interval = { (1000000 / rate) / 1000000, (1000000 / rate) % 1000000 };
+    struct itimerval timer = { interval, interval };
+    if (sigaction(SIGPROF, &action, &previous_action) != 0 || setitimer(ITIMER_PROF, &timer, NULL) != 0)
+    {
+        log_error("Runtime error: Unable to start the profiler.");
+        profiled_vm = NULL;
+        safe_free(samples);
+        samples = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+/// @brief Finds the line a frame was sampled in, adding it the first time.
+static int find_profiled_line(PROFILED_LINE** lines, int* line_count, int* line_capacity, virtual_machine* shadows, int program, int program_counter)
+{
+    /* the program counter already moved past the instruction that runs, or the grab that ran the next frame */
+    int instruction = program_counter > 0 ? program_counter - 1 : 0;
+    source_location location;
+    const char* file;
+    PROFILED_LINE found = { programs[program].source_path, 0, instruction, 0, 0 };
+    if (get_vm_source_location(&shadows[program], instruction, &location, &file) == true && location.line > 0)
+    {
+        found = (PROFILED_LINE){ file, location.line, -1, 0, 0 };
+    }
+
+    for (int i = 0; i < *line_count; i++)
+    {
+        if ((*lines)[i].line == found.line && (*lines)[i].program_counter == found.program_counter && strcmp((*lines)[i].file, found.file) == 0)
+        {
+            return i;
+        }
+    }
+    if (*line_count == *line_capacity)
+    {
+        *line_capacity *= 2;
+        *lines = (PROFILED_LINE*)realloc(*lines, *line_capacity * sizeof(PROFILED_LINE));
+    }
+    (*lines)[*line_count] = found;
+
+    return (*line_count)++;
+}
+
+static int format_profiled_line(char* buffer, size_t size, const PROFILED_LINE* line)
+{
+    if (line->program_counter >= 0)
+    {
+        return snprintf(buffer, size, "%s:instruction %d", line->file, line->program_counter);
+    }
+
+    return snprintf(buffer, size, "%s:%d", line->file, line->line);
+}
+
+static int compare_samples(const void* left, const void* right)
+{
+    const int* left_sample = samples + *(const size_t*)left;
+    const int* right_sample = samples + *(const size_t*)right;
+    int left_size = 1 + left_sample[0] * 2;
+    int right_size = 1 + right_sample[0] * 2;
+    if (left_size != right_size)
+    {
+        return left_size - right_size;
+    }
+
+    return memcmp(left_sample, right_sample, left_size * sizeof(int));
+}
+
+static int compare_lines(const void* left, const void* right)
+{
+    const PROFILED_LINE* left_line = (const PROFILED_LINE*)left;
+    const PROFILED_LINE* right_line = (const PROFILED_LINE*)right;
+    if (left_line->self_count != right_line->self_count)
+    {
+        return left_line->self_count < right_line->self_count ? 1 : -1;
+    }
+    if (left_line->total_count != right_line->total_count)
+    {
+        return left_line->total_count < right_line->total_count ? 1 : -1;
+    }
+
+    return 0;
+}
+
+static int compare_folded_stacks(const void* left, const void* right)
+{
+    return strcmp(((const FOLDED_STACK*)left)->frames, ((const FOLDED_STACK*)right)->frames);
+}
+
+static bool write_line_report(const char* path, PROFILED_LINE* lines, int line_count, size_t count, size_t dropped)
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+    {
+        log_error("Runtime error: Cannot write the profile \"%s\".", path);
+        return false;
+    }
+
+    qsort(lines, line_count, sizeof(PROFILED_LINE), compare_lines);
+    fprintf(file, "L# profile of \"%s\": %zu samples at %d a second, %zu dropped\n", profiled_source_path, count, profile_rate, dropped);
+    fprintf(file, "%10s %7s %10s %7s  %s\n", "self", "self %", "total", "total %", "line");
+    for (int i = 0; i < line_count; i++)
+    {
+        char label[512];
+        format_profiled_line(label, sizeof(label), &lines[i]);
+        fprintf(file, "%10" PRIu64 " %6.2f%% %10" PRIu64 " %6.2f%%  %s\n", lines[i].self_count, 100.0 * lines[i].self_count / count,
+            lines[i].total_count, 100.0 * lines[i].total_count / count, label);
+    }
+
+    return fclose(file) == 0;
+}
+
+static bool write_folded_stacks(const char* path, FOLDED_STACK* stacks, int stack_count)
+{
+    char* folded_path = (char*)safe_malloc(strlen(path) + strlen(".folded") + 1);
+    sprintf(folded_path, "%s.folded", path);
+    FILE* file = fopen(folded_path, "w");
+    if (file == NULL)
+    {
+        log_error("Runtime error: Cannot write the profile \"%s\".", folded_path);
+        safe_free(folded_path);
+        return false;
+    }
+    safe_free(folded_path);
+
+    /* call stacks whose instructions differ but whose lines don't are one stack */
+    qsort(stacks, stack_count, sizeof(FOLDED_STACK), compare_folded_stacks);
+    for (int i = 0; i < stack_count; i++)
+    {
+        uint64_t count = stacks[i].count;
+        while (i + 1 < stack_count && strcmp(stacks[i].frames, stacks[i + 1].frames) == 0)
+        {
+            count += stacks[++i].count;
+        }
+        fprintf(file, "%s %" PRIu64 "\n", stacks[i].frames, count);
+    }
+
+    return fclose(file) == 0;
+}
+
+bool stop_vm_profiler(const char* path)
+{
+    struct itimerval timer = { { 0, 0 }, { 0, 0 } };
+    setitimer(ITIMER_PROF, &timer, NULL);
+    sigaction(SIGPROF, &previous_action, NULL);
+    profiled_vm = NULL;
+
+    size_t count = atomic_load(&sample_count);
+    size_t dropped = atomic_load(&dropped_count);
+    int sampled_program_count = atomic_load(&program_count);
+    if (sampled_program_count > PROFILE_MAXIMUM_PROGRAMS)
+    {
+        log_warning("Runtime warning: More than %d programs were sampled, the samples in the others are left out of the profile.", PROFILE_MAXIMUM_PROGRAMS);
+        sampled_program_count = PROFILE_MAXIMUM_PROGRAMS;
+    }
+
+    /* every program gets a virtual machine of its own that only reads its debug info */
+    virtual_machine* shadows = (virtual_machine*)safe_malloc((sampled_program_count > 0 ? sampled_program_count : 1) * sizeof(virtual_machine));
+    for (int i = 0; i < sampled_program_count; i++)
+    {
+        create_virtual_machine(&shadows[i]);
+        shadows[i].program_data = programs[i].data;
+        shadows[i].program_size = programs[i].size;
+        shadows[i].source_path = programs[i].source_path;
+    }
+
+    /* identical samples are mapped to their lines once */
+    size_t* offsets = (size_t*)safe_malloc((count > 0 ? count : 1) * sizeof(size_t));
+    size_t offset = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        offsets[i] = offset;
+        offset += 1 + (size_t)samples[offset] * 2;
+    }
+    qsort(offsets, count, sizeof(size_t), compare_samples);
+
+    int line_count = 0, line_capacity = 16;
+    PROFILED_LINE* lines = (PROFILED_LINE*)safe_malloc(line_capacity * sizeof(PROFILED_LINE));
+    int stack_count = 0, stack_capacity = 16;
+    FOLDED_STACK* stacks = (FOLDED_STACK*)safe_malloc(stack_capacity * sizeof(FOLDED_STACK));
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t stack_samples = 1;
+        while (i + 1 < count && compare_samples(&offsets[i], &offsets[i + 1]) == 0)
+        {
+            stack_samples++;
+            i++;
+        }
+
+        const int* sample = samples + offsets[i];
+        int depth = sample[0];
+        int stack_lines[PROFILE_MAXIMUM_DEPTH];
+        char frames[PROFILE_MAXIMUM_DEPTH * 128];
+        size_t frames_length = 0;
+        for (int frame = 0; frame < depth; frame++)
+        {
+            stack_lines[frame] = find_profiled_line(&lines, &line_count, &line_capacity, shadows, sample[1 + frame * 2], sample[2 + frame * 2]);
+            if (frames_length < sizeof(frames))
+            {
+                frames_length += snprintf(frames + frames_length, sizeof(frames) - frames_length, frame > 0 ? ";" : "");
+            }
+            if (frames_length < sizeof(frames))
+            {
+                frames_length += format_profiled_line(frames + frames_length, sizeof(frames) - frames_length, &lines[stack_lines[frame]]);
+            }
+
+            /* a line a module grabs itself back from only counts once towards its total */
+            bool is_repeated = false;
+            for (int previous = 0; previous < frame; previous++)
+            {
+                is_repeated = is_repeated || stack_lines[previous] == stack_lines[frame];
+            }
+            if (is_repeated == false)
+            {
+                lines[stack_lines[frame]].total_count += stack_samples;
+            }
+        }
+        lines[stack_lines[depth - 1]].self_count += stack_samples;
+
+        if (stack_count == stack_capacity)
+        {
+            stack_capacity *= 2;
+            stacks = (FOLDED_STACK*)realloc(stacks, stack_capacity * sizeof(FOLDED_STACK));
+        }
+        stacks[stack_count++] = (FOLDED_STACK){ duplicate_string(frames), stack_samples };
+    }
+
+    bool is_written = write_line_report(path, lines, line_count, count, dropped) == true && write_folded_stacks(path, stacks, stack_count) == true;
+    if (is_written == true && dropped > 0)
+    {
+        log_warning("Runtime warning: The profile buffer filled up, %zu samples were dropped.", dropped);
+    }
+
+    for (int i = 0; i < stack_count; i++)
+    {
+        safe_free(stacks[i].frames);
+    }
+    safe_free(stacks);
+    safe_free(lines);
+    for (int i = 0; i < sampled_program_count; i++)
+    {
+        free_virtual_machine(&shadows[i]);
+    }
+    safe_free(shadows);
+    safe_free(offsets);
+    safe_free(samples);
+    samples = NULL;
+
+    return is_written;
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef VM_PROFILER
+#define VM_PROFILER
+#include <inttypes.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "../../core/extensions/memory_extensions.h"
+#include "../../core/extensions/string_extensions.h"
+#include "../../core/logger/logger.h"
+#include "../../core/types/line_table.h"
+#include "../virtual_machine/virtual_machine.h"
+
+/**
+ * The profiler samples a running program on a timer of the CPU time the process uses. Every sample records the
+ * program counter of the virtual machine that runs, and of every module it was grabbed from, outermost first, which is
+ * the call stack of a program until functions can be called. Samples are only copied into a buffer while the program
+ * runs, and are mapped to their place in the source through the line table of each program once it has ended:
+ *   <path>           the samples of every source line, most sampled first, both the samples taken in the line
+ *                    itself and the ones taken in modules it grabbed
+ *   <path>.folded    one line for every distinct call stack, its frames separated by `;` and followed by its
+ *                    samples, as flame graph tools read them
+ * A full buffer drops samples instead of growing, which is reported with the rest.
+ */
+
+/// @brief The samples a second taken unless another rate is asked for.
+#define DEFAULT_PROFILE_RATE 1000
+
+/// @brief The most modules deep a sample follows grabs, deeper ones are left out of the sample.
+#define PROFILE_MAXIMUM_DEPTH 64
+
+/// @brief The most distinct programs, the entry one and every module of an archive, the samples can be taken in.
+#define PROFILE_MAXIMUM_PROGRAMS 256
+
+/// @brief The amount of numbers the sample buffer holds, a sample takes one and two for every frame.
+#define PROFILE_BUFFER_CAPACITY (1 << 22)
+
+/// @brief Starts sampling a virtual machine and the modules it grabs.
+/// @param vm The virtual machine of the program, which has to stay alive until the profiler is stopped.
+/// @param rate The amount of samples a second of CPU time.
+/// @return `true` if the profiler was started, `false` otherwise.
+bool start_vm_profiler(virtual_machine* vm, int rate);
+
+/// @brief Stops sampling, and writes the per-line report and the folded call stacks of the samples taken.
+/// Every program that was sampled has to still be loaded, its debug info is read from it.
+/// @param path The path of the per-line report, the folded call stacks are written next to it with a `.folded` extension.
+/// @return `true` if both reports were written, `false` otherwise.
+bool stop_vm_profiler(const char* path);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,182 @@
+/* getpid is POSIX, which strict C17 hides unless asked for */
+#define _POSIX_C_SOURCE 200809L
+#include "vm_snapshot.h"
+
+/// @brief Where the checksum is, it is read as zero while the checksum is computed.
+#define SNAPSHOT_CHECKSUM_OFFSET 8
+
+static uint32_t get_snapshot_checksum(const unsigned char* data, size_t size)
+{
+    static const unsigned char zero_checksum[4] = { 0 };
+    uint32_t checksum = update_crc32c(0, data, SNAPSHOT_CHECKSUM_OFFSET);
+    checksum = update_crc32c(checksum, zero_checksum, sizeof(zero_checksum));
+
+    return update_crc32c(checksum, data + SNAPSHOT_CHECKSUM_OFFSET + 4, size - SNAPSHOT_CHECKSUM_OFFSET - 4);
+}
+
+/// @brief Writes a value by its type, so the record is the same on every host.
+static void encode_snapshot_value(const value* source, unsigned char* record)
+{
+    memset(record, 0, VM_SNAPSHOT_VALUE_SIZE);
+    write_u32(record, (uint32_t)source->type);
+    switch (source->type)
+    {
+        case VAL_INT:
+        case VAL_STRING:
+        {
+            write_u32(record + 8, (uint32_t)source->as.i);
+            break;
+        }
+        case VAL_DOUBLE:
+        {
+            uint64_t bits;
+            memcpy(&bits, &source->as.d, sizeof(bits));
+            write_u64(record + 8, bits);
+            break;
+        }
+        case VAL_BOOL:
+        {
+            record[8] = source->as.b;
+            break;
+        }
+        default: break;
+    }
+}
+
+/// @brief Reads a value record, checking that a string value refers to an object the program has.
+static bool decode_snapshot_value(const virtual_machine* vm, const unsigned char* record, value* destination)
+{
+    destination->type = (value_type)read_u32(record);
+    switch (destination->type)
+    {
+        case VAL_INT:
+        {
+            destination->as.i = (int32_t)read_u32(record + 8);
+            return true;
+        }
+        case VAL_STRING:
+        {
+            destination->as.i = (int32_t)read_u32(record + 8);
+            return destination->as.i >= 0 && destination->as.i < vm->object_count;
+        }
+        case VAL_DOUBLE:
+        {
+            uint64_t bits = read_u64(record + 8);
+            memcpy(&destination->as.d, &bits, sizeof(bits));
+            return true;
+        }
+        case VAL_BOOL:
+        {
+            destination->as.b = record[8];
+            return true;
+        }
+        case VAL_NULL: return true;
+        default: return false;
+    }
+}
+
+/// @brief Computes the checksum of the bytecode file a virtual machine has loaded, which identifies its program.
+static uint32_t get_program_checksum(const virtual_machine* vm)
+{
+    return get_crc32c(vm->bytecode.data, vm->bytecode.size);
+}
+
+bool save_vm_snapshot(const virtual_machine* vm, const char* path)
+{
+    size_t size = VM_SNAPSHOT_HEADER_SIZE + ((size_t)vm->variable_count + (size_t)vm->stack_pointer) * VM_SNAPSHOT_VALUE_SIZE;
+    unsigned char* data = (unsigned char*)safe_malloc(size);
+    memset(data, 0, VM_SNAPSHOT_HEADER_SIZE);
+    memcpy(data, VM_SNAPSHOT_MAGIC, 4);
+    write_u16(data + 4, VM_SNAPSHOT_VERSION_MAJOR);
+    write_u16(data + 6, VM_SNAPSHOT_VERSION_MINOR);
+    write_u32(data + 12, (uint32_t)size);
+    write_u32(data + 16, get_program_checksum(vm));
+    write_u32(data + 20, (uint32_t)vm->program_counter);
+    write_u32(data + 24, (uint32_t)vm->stack_pointer);
+    write_u32(data + 28, (uint32_t)vm->variable_count);
+
+    unsigned char* record = data + VM_SNAPSHOT_HEADER_SIZE;
+    for (int i = 0; i < vm->variable_count; i++, record += VM_SNAPSHOT_VALUE_SIZE)
+    {
+        encode_snapshot_value(&vm->variables[i], record);
+    }
+    for (int i = 0; i < vm->stack_pointer; i++, record += VM_SNAPSHOT_VALUE_SIZE)
+    {
+        encode_snapshot_value(&vm->stack[i], record);
+    }
+    write_u32(data + SNAPSHOT_CHECKSUM_OFFSET, get_snapshot_checksum(data, size));
+
+    /* every runtime writes its own temporary file, so concurrent runs never mix and nobody restores half a snapshot */
+    size_t capacity = strlen(path) + 32;
+    char* temporary_path = (char*)safe_malloc(capacity);
+    snprintf(temporary_path, capacity, "%s.%ld.tmp", path, (long)getpid());
+    FILE* file = fopen(temporary_path, "wb");
+    bool is_saved = file != NULL && fwrite(data, 1, size, file) == size;
+    if (file != NULL && fclose(file) != 0)
+    {
+        is_saved = false;
+    }
+    is_saved = is_saved == true && rename(temporary_path, path) == 0;
+    if (is_saved == false)
+    {
+        remove(temporary_path);
+        log_error("Runtime error: Cannot write the snapshot \"%s\".", path);
+    }
+    safe_free(temporary_path);
+    safe_free(data);
+
+    return is_saved;
+}
+
+/// @brief Checks the header of a snapshot against itself and against the program the `vm` has loaded.
+static bool is_snapshot_of_program(const virtual_machine* vm, const unsigned char* data, size_t size)
+{
+    if (size < VM_SNAPSHOT_HEADER_SIZE || memcmp(data, VM_SNAPSHOT_MAGIC, 4) != 0
+        || read_u16(data + 4) != VM_SNAPSHOT_VERSION_MAJOR || read_u32(data + 12) != size
+        || read_u32(data + SNAPSHOT_CHECKSUM_OFFSET) != get_snapshot_checksum(data, size))
+    {
+        return false;
+    }
+
+    uint32_t program_counter = read_u32(data + 20);
+    uint32_t stack_pointer = read_u32(data + 24);
+    uint32_t variable_count = read_u32(data + 28);
+    return read_u32(data + 16) == get_program_checksum(vm)
+        && program_counter <= (uint32_t)vm->instruction_count
+        && stack_pointer <= (uint32_t)vm->stack_size
+        && variable_count == (uint32_t)vm->variable_count
+        && VM_SNAPSHOT_HEADER_SIZE + ((uint64_t)variable_count + stack_pointer) * VM_SNAPSHOT_VALUE_SIZE == size;
+}
+
+bool restore_vm_snapshot(virtual_machine* vm, const char* path)
+{
+    mapped_file snapshot;
+    if (map_file(path, &snapshot) == false)
+    {
+        return false;
+    }
+
+    const unsigned char* data = (const unsigned char*)snapshot.data;
+    bool is_restored = is_snapshot_of_program(vm, data, snapshot.size);
+    int stack_pointer = is_restored == true ? (int)read_u32(data + 24) : 0;
+
+    /* every value is decoded before any is kept, so a bad one leaves the vm untouched */
+    value* values = (value*)safe_malloc(((size_t)vm->variable_count + (size_t)stack_pointer + 1) * sizeof(value));
+    const unsigned char* record = data + VM_SNAPSHOT_HEADER_SIZE;
+    for (int i = 0; i < vm->variable_count + stack_pointer && is_restored == true; i++, record += VM_SNAPSHOT_VALUE_SIZE)
+    {
+        is_restored = decode_snapshot_value(vm, record, &values[i]);
+    }
+
+    if (is_restored == true)
+    {
+        memcpy(vm->variables, values, (size_t)vm->variable_count * sizeof(value));
+        memcpy(vm->stack, values + vm->variable_count, (size_t)stack_pointer * sizeof(value));
+        vm->stack_pointer = stack_pointer;
+        vm->program_counter = (int)read_u32(data + 20);
+    }
+    safe_free(values);
+    unmap_file(&snapshot);
+
+    return is_restored;
+}
\ No newline at end of file
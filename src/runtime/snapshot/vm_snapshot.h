@@ -0,0 +1,51 @@
+#ifndef VM_SNAPSHOT
+#define VM_SNAPSHOT
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "../../core/extensions/byte_extensions.h"
+#include "../../core/extensions/hash_extensions.h"
+#include "../../core/extensions/memory_extensions.h"
+#include "../../core/file/map_file.h"
+#include "../../core/logger/logger.h"
+#include "../virtual_machine/virtual_machine.h"
+
+/**
+ * A snapshot is the state of a virtual machine once its program is initialized, so a later run of the same program
+ * can start where initialization ended instead of running it again:
+ *   header           VM_SNAPSHOT_HEADER_SIZE bytes: magic, version, checksum, file size, program checksum,
+ *                    program counter, stack pointer, variable count
+ *   variables        variable_count values of VM_SNAPSHOT_VALUE_SIZE bytes: type, reserved, payload
+ *   stack            stack_pointer values of VM_SNAPSHOT_VALUE_SIZE bytes
+ * Every number is little-endian. The checksum is a CRC32C over the whole snapshot with the checksum itself read as
+ * zero, and the program checksum is a CRC32C over the bytecode file the snapshot was taken from, so a snapshot is
+ * never restored into another program. String objects are views into the bytecode file, so string values are stored
+ * as the index of their object and the snapshot holds no text of its own.
+ */
+
+/// @brief The first four bytes of every snapshot.
+#define VM_SNAPSHOT_MAGIC "LSVS"
+
+/// @brief Snapshots with a different major version can't be restored.
+#define VM_SNAPSHOT_VERSION_MAJOR 1
+
+#define VM_SNAPSHOT_VERSION_MINOR 0
+#define VM_SNAPSHOT_HEADER_SIZE 32
+#define VM_SNAPSHOT_VALUE_SIZE 16
+
+/// @brief Writes the state of an initialized virtual machine to a snapshot, replacing it all at once so a reader never sees half of it.
+/// @param vm The virtual machine, stopped where its initialization ended.
+/// @param path The path of the snapshot.
+/// @return `true` if the snapshot was written, `false` otherwise.
+bool save_vm_snapshot(const virtual_machine* vm, const char* path);
+
+/// @brief Maps a snapshot into memory and restores the state in it, if it was taken from the program the `vm` has loaded.
+/// @param vm The virtual machine, with its bytecode loaded and nothing run yet.
+/// @param path The path of the snapshot.
+/// @return `true` if the state was restored, `false` if the snapshot is missing, corrupt or of another program, leaving the `vm` as it was.
+bool restore_vm_snapshot(virtual_machine* vm, const char* path);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "runtime_options.h"
+
+void create_runtime_options(runtime_options* options)
+{
+    options->input_path = NULL;
+    options->minimum_log_level = LOG_LEVEL_DEBUG;
+    options->use_async_logger = false;
+    options->log_overflow_policy = LOG_OVERFLOW_BLOCK;
+    options->log_format = LOG_FORMAT_CONSOLE;
+    options->snapshot_out_path = NULL;
+    options->snapshot_in_path = NULL;
+    options->profile_path = NULL;
+    options->profile_rate = DEFAULT_PROFILE_RATE;
+    options->use_perf_map = false;
+    options->metrics_path = NULL;
+    options->metrics_format = METRICS_FORMAT_JSON;
+    options->fuel = VM_UNLIMITED;
+    options->memory_limit = VM_UNLIMITED;
+}
+
+/// @brief Parses the amount that follows `prefix` in `argument`, a positive whole number without a sign.
+/// @return `true` if the amount was parsed, `false` otherwise.
+static bool parse_limit(const char* argument, const char* prefix, uint64_t* limit)
+{
+    const char* digits = argument + strlen(prefix);
+    char* end;
+    errno = 0;
+    unsigned long long amount = strtoull(digits, &end, 10);
+    if (digits[0] < '0' || digits[0] > '9' || *end != '\0' || errno == ERANGE || amount == 0)
+    {
+        return false;
+    }
+
+    *limit = (uint64_t)amount;
+    return true;
+}
+
+bool parse_runtime_options(int argc, const char* argv[], runtime_options* options)
+{
+    create_runtime_options(options);
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* argument = argv[i];
+
+        if (strncmp(argument, "--log-level=", strlen("--log-level=")) == 0)
+        {
+            const char* level_name = argument + strlen("--log-level=");
+            if (parse_log_level(level_name, &options->minimum_log_level) == false)
+            {
+                log_error("Runtime error: Unknown log level \"%s\", expected debug, info, warning or error.", level_name);
+                return false;
+            }
+            continue;
+        }
+
+        if (strncmp(argument, "--log-format=", strlen("--log-format=")) == 0)
+        {
+            const char* format_name = argument + strlen("--log-format=");
+            if (parse_log_format(format_name, &options->log_format) == false)
+            {
+                log_error("Runtime error: Unknown log format \"%s\", expected console, json or binary.", format_name);
+                return false;
+            }
+            continue;
+        }
+
+        if (strcmp(argument, "--log-async") == 0 || strcmp(argument, "--log-async=block") == 0)
+        {
+            options->use_async_logger = true;
+            options->log_overflow_policy = LOG_OVERFLOW_BLOCK;
+            continue;
+        }
+
+        if (strcmp(argument, "--log-async=drop") == 0)
+        {
+            options->use_async_logger = true;
+            options->log_overflow_policy = LOG_OVERFLOW_DROP;
+            continue;
+        }
+
+        if (strncmp(argument, "--snapshot-out=", strlen("--snapshot-out=")) == 0)
+        {
+            options->snapshot_out_path = argument + strlen("--snapshot-out=");
+            if (strlen(options->snapshot_out_path) == 0)
+            {
+                log_error("Runtime error: --snapshot-out= must be followed by a path.");
+                return false;
+            }
+            continue;
+        }
+
+        if (strncmp(argument, "--snapshot-in=", strlen("--snapshot-in=")) == 0)
+        {
+            options->snapshot_in_path = argument + strlen("--snapshot-in=");
+            if (strlen(options->snapshot_in_path) == 0)
+            {
+                log_error("Runtime error: --snapshot-in= must be followed by a path.");
+                return false;
+            }
+            continue;
+        }
+
+        if (strncmp(argument, "--profile=", strlen("--profile=")) == 0)
+        {
+            options->profile_path = argument + strlen("--profile=");
+            if (strlen(options->profile_path) == 0)
+            {
+                log_error("Runtime error: --profile= must be followed by a path.");
+                return false;
+            }
+            continue;
+        }
+
+        if (strncmp(argument, "--profile-rate=", strlen("--profile-rate=")) == 0)
+        {
+            char* end;
+            long rate = strtol(argument + strlen("--profile-rate="), &end, 10);
+            if (end == argument + strlen("--profile-rate=") || *end != '\0' || rate <= 0 || rate > 1000000)
+            {
+                log_error("Runtime error: --profile-rate= must be followed by an amount of samples a second, up to 1000000.");
+                return false;
+            }
+            options->profile_rate = (int)rate;
+            continue;
+        }
+
+        if (strncmp(argument, "--metrics=", strlen("--metrics=")) == 0)
+        {
+            options->metrics_path = argument + strlen("--metrics=");
+            if (strlen(options->metrics_path) == 0)
+            {
+                log_error("Runtime error: --metrics= must be followed by a path.");
+                return false;
+            }
+            continue;
+        }
+
+        if (strncmp(argument, "--metrics-format=", strlen("--metrics-format=")) == 0)
+        {
+            const char* format_name = argument + strlen("--metrics-format=");
+            if (parse_metrics_format(format_name, &options->metrics_format) == false)
+            {
+                log_error("Runtime error: Unknown metrics format \"%s\", expected json or prometheus.", format_name);
+                return false;
+            }
+            continue;
+        }
+
+        if (strncmp(argument, "--fuel=", strlen("--fuel=")) == 0)
+        {
+            if (parse_limit(argument, "--fuel=", &options->fuel) == false)
+            {
+                log_error("Runtime error: --fuel= must be followed by an amount of instructions.");
+                return false;
+            }
+            continue;
+        }
+
+        if (strncmp(argument, "--memory-limit=", strlen("--memory-limit=")) == 0)
+        {
+            if (parse_limit(argument, "--memory-limit=", &options->memory_limit) == false)
+            {
+                log_error("Runtime error: --memory-limit= must be followed by an amount of bytes.");
+                return false;
+            }
+            continue;
+        }
+
+        if (strcmp(argument, "--perf-map") == 0)
+        {
+            options->use_perf_map = true;
+            continue;
+        }
+
+        /* anything that isn't an option is the bytecode file, `-` reads it from stdin */
+        if ((argument[0] != '-' || strcmp(argument, "-") == 0) && options->input_path == NULL)
+        {
+            options->input_path = argument;
+            continue;
+        }
+
+        log_error("Runtime error: Unknown argument \"%s\".", argument);
+        return false;
+    }
+
+    if (options->snapshot_out_path != NULL && options->snapshot_in_path != NULL)
+    {
+        log_error("Runtime error: --snapshot-out= and --snapshot-in= can't be used together.");
+        return false;
+    }
+
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef RUNTIME_OPTIONS
+#define RUNTIME_OPTIONS
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../core/logger/logger.h"
+#include "../metrics/run_metrics.h"
+#include "../profiler/vm_profiler.h"
+
+/// @struct runtime_options
+/// @brief The command-line options that change how the L# runtime behaves.
+typedef struct runtime_options runtime_options;
+
+struct runtime_options
+{
+    /// @brief The path to the L# bytecode file, `-` to read it from stdin.
+    const char* input_path;
+    /// @brief Builtin logging instructions below this level are skipped.
+    log_level minimum_log_level;
+    /// @brief `true` if log messages should be written by a background thread.
+    bool use_async_logger;
+    /// @brief What the asynchronous logger does when its queue is full.
+    log_overflow_policy log_overflow_policy;
+    /// @brief The format log messages are written in.
+    log_format log_format;
+    /// @brief The path to save the state of the program to once it is initialized, `NULL` to not save it.
+    const char* snapshot_out_path;
+    /// @brief The path to restore the state of the initialized program from, `NULL` to run it from the start.
+    const char* snapshot_in_path;
+    /// @brief The path to write the profile of the run to, `NULL` to not profile it.
+    const char* profile_path;
+    /// @brief The amount of samples a second the profiler takes.
+    int profile_rate;
+    /// @brief `true` if every program should run through a trampoline named after it in `/tmp/perf-<pid>.map`.
+    bool use_perf_map;
+    /// @brief The path to write the metrics of the run to, `NULL` to not write them.
+    const char* metrics_path;
+    /// @brief The format the metrics are written in.
+    metrics_format metrics_format;
+    /// @brief The most instructions the program may run, `VM_UNLIMITED` for no limit.
+    uint64_t fuel;
+    /// @brief The most bytes the runtime may allocate for the program, `VM_UNLIMITED` for no limit.
+    uint64_t memory_limit;
+};
+
+/// @brief Fills `options` with the default runtime options.
+/// @param options The runtime options to fill.
+void create_runtime_options(runtime_options* options);
+
+/// @brief Parses the command-line arguments of the L# runtime into `options`.
+/// @param argc The number of command-line arguments.
+/// @param argv An array of command-line arguments.
+/// @param options The runtime options to fill.
+/// @return `true` if all arguments were understood, `false` otherwise.
+bool parse_runtime_options(int argc, const char* argv[], runtime_options* options);
+
+#endif
\ No newline at end of file
@@ -21,113 +21,753 @@ static void mark_object(virtual_machine* vm, int index)
 
 bool create_virtual_machine(virtual_machine* vm)
 {
-    /* initialize VM components */
-    vm->stack_size = 256;
-    vm->stack = (value*)safe_malloc(vm->stack_size * sizeof(value));
+    /* will be set by load_bytecode_from_file, once the instructions say how deep the stack gets */
+    vm->stack_size = 0;
+    vm->stack = NULL;
     vm->stack_pointer = 0;
 
     /* will be set by load_bytecode_from_file */
     vm->instruction_capacity = 0;
     vm->instruction_count = 0;
     vm->instructions = NULL;
+    vm->decoded_instructions = NULL;
 
-    vm->variable_count = 256;
-    vm->variables = (value*)safe_malloc(vm->variable_count * sizeof(value));
+    /* will be set by load_bytecode_from_file */
+    vm->variable_count = 0;
+    vm->variables = NULL;
 
     /* will be set by load_bytecode_from_file */
     vm->object_capacity = 0;
     vm->object_count = 0;
     vm->objects = NULL;
+    vm->decoded_objects = NULL;
+    vm->string_data = NULL;
 
     vm->object_flags = (char*)calloc(vm->object_capacity, sizeof(char));
 
     vm->program_counter = 0;
+    vm->bytecode = (mapped_file){ NULL, 0, false };
+    vm->decompressed_section_count = 0;
+    vm->source_path = NULL;
+    vm->minimum_log_level = LOG_LEVEL_DEBUG;
+    vm->archive = NULL;
+    vm->module_states = NULL;
+    vm->owns_archive = false;
+    vm->is_initializing = false;
+    vm->program_data = NULL;
+    vm->program_size = 0;
+    vm->line_table = NULL;
+    vm->debug_info_allocation = NULL;
+    vm->is_debug_info_read = false;
+    vm->running_module = NULL;
+    vm->metrics = (vm_metrics){ 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    vm->is_measured = false;
+    vm->fuel = VM_UNLIMITED;
+    vm->memory_limit = VM_UNLIMITED;
+    vm->allocated_bytes = 0;
+    vm->is_out_of_memory = false;
 
     return true;
 }
 
-bool load_bytecode_from_file(virtual_machine* vm, const char* filename)
+const char* get_object_text(const virtual_machine* vm, int index)
+{
+    return vm->string_data + vm->objects[index].offset;
+}
+
+/// @brief Counts `size` more bytes towards the byte budget of the virtual machine.
+/// @return `true` if they fit in it, `false` if they don't, which marks the virtual machine as out of memory.
+static bool charge_vm_memory(virtual_machine* vm, size_t size)
 {
-    /* open in binary read mode */
-    FILE* file = fopen(filename, "rb");
-    if (file == NULL)
+    if (size > vm->memory_limit - vm->allocated_bytes)
     {
-        log_error("Runtime error: Cannot open \"%s\" bytecode file for reading.", filename);
+        vm->is_out_of_memory = true;
         return false;
     }
 
-    /* read object_count */
-    int object_count;
-    fread(&object_count, sizeof(int), 1, file);
+    vm->allocated_bytes += size;
+    return true;
+}
+
+/// @brief Allocates memory for the program within the byte budget of the virtual machine, without exiting when the host runs out.
+/// @return The memory, which is freed with `free`, or `NULL` if it doesn't fit, which marks the virtual machine as out of memory.
+static void* allocate_vm_memory(virtual_machine* vm, size_t size)
+{
+    if (charge_vm_memory(vm, size) == false)
+    {
+        return NULL;
+    }
+
+    void* memory = try_malloc(size);
+    if (memory == NULL)
+    {
+        vm->is_out_of_memory = true;
+    }
+
+    return memory;
+}
+
+/// @brief Frees the decompressed sections, which instructions and string objects may point into.
+static void free_decompressed_sections(virtual_machine* vm)
+{
+    for (int i = 0; i < vm->decompressed_section_count; i++)
+    {
+        safe_free(vm->decompressed_sections[i]);
+    }
+    vm->decompressed_section_count = 0;
+}
+
+/// @brief Reports why a bytecode file can't be run, and releases it.
+static bool reject_bytecode_file(virtual_machine* vm, const char* filename, const char* reason)
+{
+    log_error("Runtime error: \"%s\" %s.", filename, reason);
+    free_decompressed_sections(vm);
+    unmap_file(&vm->bytecode);
+    return false;
+}
 
-    /* read objects */
-    vm->object_count = object_count;
-    vm->instruction_capacity = object_count;
-    vm->objects = (char**)safe_malloc(object_count * sizeof(char*));
-    if (vm->objects == NULL)
+/// @brief Verifies a section and gets its contents, keeping them if they had to be decompressed.
+/// @return The contents of the section, or `NULL` if it is corrupt or doesn't fit in the byte budget, which marks the virtual machine as out of memory.
+static const unsigned char* load_section(virtual_machine* vm, const bytecode_container* container, const bytecode_section* section, size_t* size)
+{
+    unsigned char* allocation;
+    const unsigned char* data = load_bytecode_section(container, section, (size_t)(vm->memory_limit - vm->allocated_bytes), &allocation, size);
+    if (data == NULL && *size > 0)
     {
-        log_error("Runtime error: Error allocating memory for objects.");
-        fclose(file);
-        safe_free(vm);
+        vm->is_out_of_memory = true;
         return NULL;
     }
+    if (allocation != NULL)
+    {
+        vm->decompressed_sections[vm->decompressed_section_count++] = allocation;
+        charge_vm_memory(vm, *size);
+    }
+
+    return data;
+}
+
+/// @brief Points the string objects at the constants and strings, checking every view once so using one never reads past the strings.
+static bool load_string_objects(virtual_machine* vm, const unsigned char* views, int view_count, const char* strings, size_t strings_size)
+{
+    vm->object_count = view_count;
+    vm->metrics.object_count += (uint64_t)view_count;
+    vm->string_data = strings;
+    if (is_native_bytecode_layout() == true)
+    {
+        vm->objects = (const bytecode_string*)views;
+    }
+    else
+    {
+        vm->decoded_objects = (bytecode_string*)allocate_vm_memory(vm, (vm->object_count > 0 ? vm->object_count : 1) * sizeof(bytecode_string));
+        if (vm->decoded_objects == NULL)
+        {
+            return false;
+        }
+        for (int i = 0; i < vm->object_count; i++)
+        {
+            decode_bytecode_string(views + (size_t)i * BYTECODE_STRING_SIZE, &vm->decoded_objects[i]);
+        }
+        vm->objects = vm->decoded_objects;
+    }
 
     for (int i = 0; i < vm->object_count; i++)
     {
-        int string_length;
-        fread(&string_length, sizeof(int), 1, file);
-        /* +1 for null terminator */
-        vm->objects[i] = (char*)malloc((string_length + 1) * sizeof(char));
-        if (vm->objects[i] == NULL)
+        uint64_t end = (uint64_t)vm->objects[i].offset + vm->objects[i].length;
+        if (end >= strings_size || vm->string_data[end] != '\0')
         {
-            log_error("Runtime error: Error allocating memory for object.");
-            fclose(file);
-            safe_free(vm);
-            return NULL;
+            return false;
         }
-        fread(vm->objects[i], sizeof(char), string_length, file);
-        /* null-terminate the string */
-        vm->objects[i][string_length] = '\0';
     }
 
-    /* read instruction count */
-    int instruction_count;
-    fread(&instruction_count, sizeof(int), 1, file);
+    return true;
+}
 
-    /* read instructions */
-    vm->instruction_count = instruction_count;
-    vm->instruction_capacity = instruction_count;
-    vm->instructions = (instruction*)safe_malloc(instruction_count * sizeof(instruction));
-    if (vm->instructions == NULL)
+/// @brief Points the instructions at the instruction records, unless this host lays them out differently than the file does.
+/// @return `true` if the instructions are loaded, `false` if decoding them doesn't fit in the byte budget.
+static bool load_instructions(virtual_machine* vm, const unsigned char* records, int record_count)
+{
+    vm->instruction_count = record_count;
+    vm->instruction_capacity = vm->instruction_count;
+    if (is_native_bytecode_layout() == true)
     {
-        log_error("Runtime error: Error allocating memory for instructions.");
-        fclose(file);
-        safe_free(vm);
-        return NULL;
+        vm->instructions = (const instruction*)records;
+        return true;
     }
 
-    for (int i = 0; i < instruction_count; i++)
+    vm->decoded_instructions = (instruction*)allocate_vm_memory(vm, (vm->instruction_count > 0 ? vm->instruction_count : 1) * sizeof(instruction));
+    if (vm->decoded_instructions == NULL)
     {
+        return false;
+    }
+    for (int i = 0; i < vm->instruction_count; i++)
+    {
+        decode_bytecode_instruction(records + (size_t)i * BYTECODE_INSTRUCTION_SIZE, &vm->decoded_instructions[i]);
+    }
+    vm->instructions = vm->decoded_instructions;
+
+    return true;
+}
+
+/// @brief Gets how many values an instruction takes off the stack and puts back on it, as the run loop runs it.
+/// @return `true` if the operation is known, `false` otherwise.
+static bool get_stack_effect(op_code op_code, int* pops, int* pushes)
+{
+    *pops = 0;
+    *pushes = 0;
+    switch (op_code)
+    {
+        case OP_LOAD_CONST:
+        case OP_LOAD_VAR: *pushes = 1; return true;
+        case OP_DUP: *pops = 1; *pushes = 2; return true;
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+        case OP_DIV:
+        case OP_EQ: *pops = 2; *pushes = 1; return true;
+        case OP_STORE_VAR:
+        case OP_POP:
+        case OP_JMP_IF_FALSE:
+        case OP_PRINT:
+        case OP_BUILTIN_ERROR:
+        case OP_BUILTIN_WARNING:
+        case OP_BUILTIN_DEBUG:
+        case OP_BUILTIN_INFO: *pops = 1; return true;
+        /* the comparisons, logic and calls aren't implemented yet, so they leave the stack alone */
+        case OP_NEQ:
+        case OP_GT:
+        case OP_LT:
+        case OP_AND:
+        case OP_OR:
+        case OP_NOT:
+        case OP_JMP:
+        case OP_CALL:
+        case OP_RETURN:
+        case OP_HALT:
+        case OP_GRAB: return true;
+        default: return false;
+    }
+}
+
+/// @brief Checks that every variable, string constant and jump target an instruction refers to is part of the program, so the run loop never has to.
+/// @return The reason the instructions can't be run, or `NULL` if they can.
+static const char* verify_operands(const virtual_machine* vm)
+{
+    for (int i = 0; i < vm->instruction_count; i++)
+    {
+        instruction current = vm->instructions[i];
+        int pops, pushes;
+        if (get_stack_effect(current.op_code, &pops, &pushes) == false)
+        {
+            return "has an unknown operation";
+        }
 
-        fread(&vm->instructions[i].op_code, sizeof(op_code), 1, file);
+        bool is_string = (current.op_code == OP_LOAD_CONST && (current.op_type == OP_TYPE_INDEX || current.op_type == OP_TYPE_TEXT)) || current.op_code == OP_GRAB;
+        if ((current.op_code == OP_LOAD_VAR || current.op_code == OP_STORE_VAR)
+            && (current.operand.variable.variable_index < 0 || current.operand.variable.variable_index >= vm->variable_count))
+        {
+            return "has an instruction that uses a variable outside of the program";
+        }
+        if (is_string == true && (current.operand.i < 0 || current.operand.i >= vm->object_count))
+        {
+            return "has an instruction that uses a string constant outside of the program";
+        }
 
-        size_t size_of_operand = 0;
-        fread(&size_of_operand, sizeof(size_t), 1, file);
-        fread(&vm->instructions[i].operand, size_of_operand, 1, file);
+        /* a jump may land right past the last instruction, which the run loop reports as a program without a halt */
+        if (is_jump_op_code(current.op_code) == true)
+        {
+            int64_t target = (int64_t)i + 1 + current.operand.jump.jump_offset;
+            if (target < 0 || target > vm->instruction_count)
+            {
+                return "has a jump outside of the program";
+            }
+        }
+    }
+
+    return NULL;
+}
 
-        fread(&vm->instructions[i].op_type, sizeof(op_type), 1, file);
+/// @brief Follows every path through the instructions to find the deepest the stack gets, checking that no instruction
+/// takes more values off the stack than are on it and that every path into an instruction leaves the stack as deep.
+/// @return The reason the instructions can't be run, or `NULL` if they can.
+static const char* measure_stack_depth(virtual_machine* vm, int* maximum_depth)
+{
+    *maximum_depth = 0;
+    int* depths = (int*)try_malloc(((size_t)vm->instruction_count + 1) * sizeof(int));
+    int* pending = (int*)try_malloc(((size_t)vm->instruction_count + 1) * sizeof(int));
+    if (depths == NULL || pending == NULL)
+    {
+        free(depths);
+        free(pending);
+        vm->is_out_of_memory = true;
+        return "needs more memory than its byte budget allows";
+    }
+    for (int i = 0; i <= vm->instruction_count; i++)
+    {
+        depths[i] = -1;
+    }
+
+    /* every instruction is queued at most once, the first time a path reaches it */
+    const char* reason = NULL;
+    int pending_count = 0;
+    depths[0] = 0;
+    pending[pending_count++] = 0;
+    while (reason == NULL && pending_count > 0)
+    {
+        int index = pending[--pending_count];
+        if (index == vm->instruction_count)
+        {
+            continue;
+        }
+
+        instruction current = vm->instructions[index];
+        int pops, pushes;
+        get_stack_effect(current.op_code, &pops, &pushes);
+        if (depths[index] < pops)
+        {
+            reason = "has an instruction that takes more values than are on the stack";
+            break;
+        }
+        int depth = depths[index] - pops + pushes;
+        *maximum_depth = depth > *maximum_depth ? depth : *maximum_depth;
+
+        int successors[2];
+        int successor_count = 0;
+        if (is_jump_op_code(current.op_code) == true)
+        {
+            successors[successor_count++] = get_jump_target(vm->instructions, index);
+        }
+        if (current.op_code != OP_JMP && current.op_code != OP_RETURN && current.op_code != OP_HALT)
+        {
+            successors[successor_count++] = index + 1;
+        }
+        for (int i = 0; i < successor_count; i++)
+        {
+            if (depths[successors[i]] == -1)
+            {
+                depths[successors[i]] = depth;
+                pending[pending_count++] = successors[i];
+            }
+            else if (depths[successors[i]] != depth)
+            {
+                reason = "has paths that leave the stack at different depths";
+            }
+        }
+    }
+
+    free(depths);
+    free(pending);
+    return reason;
+}
+
+/// @brief Reports why the header of a bytecode file can't be read, and releases it.
+static bool reject_unreadable_file(virtual_machine* vm, const char* filename, bytecode_file_status status)
+{
+    switch (status)
+    {
+        case BYTECODE_FILE_NOT_BYTECODE: return reject_bytecode_file(vm, filename, "is not an L# bytecode file");
+        case BYTECODE_FILE_UNSUPPORTED_VERSION: return reject_bytecode_file(vm, filename, "was written for a different version of the L# runtime");
+        default: return reject_bytecode_file(vm, filename, "is corrupt");
+    }
+}
+
+/// @brief Loads an .lbc file that is already in memory, either the mapped file itself or a module inside a mapped archive.
+static bool load_bytecode(virtual_machine* vm, const unsigned char* data, size_t size, const char* filename)
+{
+    bytecode_container container;
+    bytecode_file_status status = read_bytecode_container(data, size, &container);
+    if (status != BYTECODE_FILE_VALID)
+    {
+        return reject_unreadable_file(vm, filename, status);
+    }
+
+    const bytecode_section* code = find_bytecode_section(&container, BYTECODE_SECTION_CODE);
+    const bytecode_section* constants = find_bytecode_section(&container, BYTECODE_SECTION_CONSTANTS);
+    const bytecode_section* strings = find_bytecode_section(&container, BYTECODE_SECTION_STRINGS);
+    if (code == NULL || constants == NULL || strings == NULL)
+    {
+        return reject_bytecode_file(vm, filename, "is missing its code, constants or strings section");
+    }
+
+    /* only the sections the runtime uses are verified, so the pages of the others are never touched */
+    size_t code_size, constants_size, strings_size;
+    const unsigned char* records = load_section(vm, &container, code, &code_size);
+    const unsigned char* views = load_section(vm, &container, constants, &constants_size);
+    const unsigned char* text = load_section(vm, &container, strings, &strings_size);
+    if (vm->is_out_of_memory == true)
+    {
+        return reject_bytecode_file(vm, filename, "needs more memory than its byte budget allows");
+    }
+    if (records == NULL || views == NULL || text == NULL
+        || code_size != (size_t)code->count * BYTECODE_INSTRUCTION_SIZE || constants_size != (size_t)constants->count * BYTECODE_STRING_SIZE)
+    {
+        return reject_bytecode_file(vm, filename, "is corrupt");
+    }
+
+    if (load_string_objects(vm, views, (int)constants->count, (const char*)text, strings_size) == false)
+    {
+        if (vm->decoded_objects != NULL)
+        {
+            safe_free(vm->decoded_objects);
+            vm->decoded_objects = NULL;
+        }
+        return reject_bytecode_file(vm, filename, vm->is_out_of_memory == true ? "needs more memory than its byte budget allows" : "has a string constant outside of its strings section");
+    }
+    if (load_instructions(vm, records, (int)code->count) == false)
+    {
+        return reject_bytecode_file(vm, filename, "needs more memory than its byte budget allows");
+    }
+
+    /* the debug info is left alone until a source location is needed */
+    vm->program_data = data;
+    vm->program_size = size;
+
+    /* the operands and the stack are checked once here, so the run loop can trust them */
+    vm->variable_count = container.variable_count;
+    int maximum_depth;
+    const char* reason = verify_operands(vm);
+    if (reason == NULL)
+    {
+        reason = measure_stack_depth(vm, &maximum_depth);
+    }
+    if (reason != NULL)
+    {
+        return reject_bytecode_file(vm, filename, reason);
+    }
+
+    /* allocate exactly the stack and the variable slots the program needs */
+    vm->stack_size = maximum_depth;
+    vm->stack = (value*)allocate_vm_memory(vm, (vm->stack_size > 0 ? vm->stack_size : 1) * sizeof(value));
+    if (vm->stack == NULL)
+    {
+        return reject_bytecode_file(vm, filename, "needs more memory than its byte budget allows");
+    }
+    vm->variables = (value*)allocate_vm_memory(vm, (vm->variable_count > 0 ? vm->variable_count : 1) * sizeof(value));
+    if (vm->variables == NULL)
+    {
+        return reject_bytecode_file(vm, filename, "needs more memory than its byte budget allows");
+    }
+    for (int i = 0; i < vm->variable_count; i++)
+    {
+        vm->variables[i].type = VAL_NULL;
     }
 
-    fclose(file);
     return true;
 }
 
-bool run_vm(virtual_machine* vm)
+/// @brief Opens the index of an archive, and loads its entry module.
+static bool load_archive(virtual_machine* vm, const char* filename)
+{
+    vm->archive = (bytecode_archive*)allocate_vm_memory(vm, sizeof(bytecode_archive));
+    if (vm->archive == NULL)
+    {
+        return reject_bytecode_file(vm, filename, "needs more memory than its byte budget allows");
+    }
+    vm->owns_archive = true;
+    bytecode_file_status status = read_bytecode_archive(vm->bytecode.data, vm->bytecode.size, vm->archive);
+    if (status != BYTECODE_FILE_VALID)
+    {
+        return reject_unreadable_file(vm, filename, status);
+    }
+
+    /* the entry module is running from here on, so a module that grabs it back doesn't run it again */
+    vm->module_states = (module_state*)allocate_vm_memory(vm, (vm->archive->module_count > 0 ? vm->archive->module_count : 1) * sizeof(module_state));
+    if (vm->module_states == NULL)
+    {
+        return reject_bytecode_file(vm, filename, "needs more memory than its byte budget allows");
+    }
+    for (uint32_t i = 0; i < vm->archive->module_count; i++)
+    {
+        vm->module_states[i] = MODULE_NOT_RUN;
+    }
+    vm->module_states[vm->archive->entry_module] = MODULE_RUNNING;
+
+    bytecode_archive_module entry;
+    get_bytecode_archive_module(vm->archive, vm->archive->entry_module, &entry);
+    return load_bytecode(vm, entry.bytecode, entry.size, filename);
+}
+
+bool load_bytecode_from_file(virtual_machine* vm, const char* filename)
+{
+    vm->source_path = filename;
+    if (map_file(filename, &vm->bytecode) == false)
+    {
+        log_error("Runtime error: Cannot open \"%s\" bytecode file for reading.", filename);
+        return false;
+    }
+
+    const unsigned char* data = (const unsigned char*)vm->bytecode.data;
+    if (is_bytecode_archive(data, vm->bytecode.size) == true)
+    {
+        return load_archive(vm, filename);
+    }
+
+    return load_bytecode(vm, data, vm->bytecode.size, filename);
+}
+
+/// @brief Adds what running a grabbed module took to the metrics of the virtual machine that grabbed it.
+static void add_vm_metrics(vm_metrics* metrics, const vm_metrics* module_metrics)
+{
+    metrics->instruction_count += module_metrics->instruction_count;
+    metrics->peak_stack_depth = module_metrics->peak_stack_depth > metrics->peak_stack_depth ? module_metrics->peak_stack_depth : metrics->peak_stack_depth;
+    metrics->object_count += module_metrics->object_count;
+    metrics->module_count += module_metrics->module_count + 1;
+    metrics->gc_cycle_count += module_metrics->gc_cycle_count;
+    metrics->gc_pause_nanoseconds += module_metrics->gc_pause_nanoseconds;
+    if (module_metrics->gc_longest_pause_nanoseconds > metrics->gc_longest_pause_nanoseconds)
+    {
+        metrics->gc_longest_pause_nanoseconds = module_metrics->gc_longest_pause_nanoseconds;
+    }
+    metrics->builtin_call_count += module_metrics->builtin_call_count;
+    metrics->builtin_nanoseconds += module_metrics->builtin_nanoseconds;
+}
+
+/// @brief Runs a module of the archive the first time it is grabbed, in a virtual machine of its own so its variables and objects stay its own.
+/// The module runs on what is left of the fuel and the byte budget of the virtual machine that grabbed it.
+/// @return How the module ended, `VM_STATUS_FINISHED` if it ran, already ran, or is one the archive doesn't have.
+static vm_status grab_module(virtual_machine* vm, const char* module_name)
+{
+    /* a module that is still running was grabbed back by a module it grabbed, and carries on once that one is done */
+    int index = vm->archive != NULL ? find_bytecode_archive_module(vm->archive, module_name) : -1;
+    if (index < 0 || vm->module_states[index] != MODULE_NOT_RUN)
+    {
+        return VM_STATUS_FINISHED;
+    }
+
+    /* fuel is only checked at backward jumps and calls, so the grabbing module can already be past its fuel */
+    if (vm->fuel != VM_UNLIMITED && vm->metrics.instruction_count >= vm->fuel)
+    {
+        log_error("Runtime error: Out of fuel after %" PRIu64 " instructions, before module \"%s\" grabbed by \"%s\" could run.", vm->metrics.instruction_count, module_name, vm->source_path);
+        return VM_STATUS_OUT_OF_FUEL;
+    }
+
+    /* the module's sections are only verified now, so modules that are never grabbed are never read */
+    bytecode_archive_module module;
+    get_bytecode_archive_module(vm->archive, (uint32_t)index, &module);
+    vm->module_states[index] = MODULE_RUNNING;
+
+    virtual_machine module_vm;
+    create_virtual_machine(&module_vm);
+    module_vm.source_path = module.name;
+    module_vm.minimum_log_level = vm->minimum_log_level;
+    module_vm.archive = vm->archive;
+    module_vm.module_states = vm->module_states;
+    module_vm.is_measured = vm->is_measured;
+    module_vm.fuel = vm->fuel == VM_UNLIMITED ? VM_UNLIMITED : vm->fuel - vm->metrics.instruction_count;
+    module_vm.memory_limit = vm->memory_limit == VM_UNLIMITED ? VM_UNLIMITED : vm->memory_limit - vm->allocated_bytes;
+    vm_status status = VM_STATUS_FAILED;
+    if (load_bytecode(&module_vm, module.bytecode, module.size, module.name) == true)
+    {
+        vm->running_module = &module_vm;
+        status = run_vm(&module_vm);
+        vm->running_module = NULL;
+    }
+    else if (module_vm.is_out_of_memory == true)
+    {
+        status = VM_STATUS_OUT_OF_MEMORY;
+    }
+    add_vm_metrics(&vm->metrics, &module_vm.metrics);
+    free_virtual_machine(&module_vm);
+    vm->module_states[index] = MODULE_RAN;
+
+    if (status != VM_STATUS_FINISHED)
+    {
+        log_error("Runtime error: Failed to run module \"%s\" grabbed by \"%s\".", module_name, vm->source_path);
+    }
+
+    return status;
+}
+
+/// @brief Warns that the debug info of the program is ignored, and releases it.
+static void ignore_debug_info(virtual_machine* vm, bool does_fit)
+{
+    if (does_fit == false)
+    {
+        log_warning("Runtime warning: \"%s\" has more debug info than its byte budget allows, which is ignored.", vm->source_path);
+    }
+    else
+    {
+        log_warning("Runtime warning: \"%s\" has corrupt debug info, which is ignored.", vm->source_path);
+    }
+    free(vm->debug_info_allocation);
+    vm->debug_info_allocation = NULL;
+}
+
+/// @brief Verifies and decodes the line table of the program within the byte budget, unless the program has no debug info.
+static void read_debug_info(virtual_machine* vm)
+{
+    vm->is_debug_info_read = true;
+    bytecode_container container;
+    if (vm->program_data == NULL || read_bytecode_container(vm->program_data, vm->program_size, &container) != BYTECODE_FILE_VALID)
+    {
+        return;
+    }
+
+    const bytecode_section* debug = find_bytecode_section(&container, BYTECODE_SECTION_DEBUG);
+    if (debug == NULL)
+    {
+        return;
+    }
+
+    /* the debug info is only read to report an error, so debug info that doesn't fit leaves the error without a location instead of running out of memory */
+    size_t remaining_size = (size_t)(vm->memory_limit - vm->allocated_bytes);
+    size_t debug_info_size;
+    const unsigned char* debug_info = load_bytecode_section(&container, debug, remaining_size, &vm->debug_info_allocation, &debug_info_size);
+    if (debug_info == NULL)
+    {
+        ignore_debug_info(vm, debug_info_size == 0);
+        return;
+    }
+
+    size_t charged_size = (vm->debug_info_allocation != NULL ? debug_info_size : 0) + sizeof(line_table);
+    line_table table;
+    bool does_fit = charged_size <= remaining_size;
+    if (does_fit == false || decode_line_table(debug_info, debug_info_size, debug->count, remaining_size - charged_size, &table) == false)
+    {
+        ignore_debug_info(vm, does_fit == true && table.allocated_size == 0);
+        return;
+    }
+
+    vm->line_table = (line_table*)try_malloc(sizeof(line_table));
+    if (vm->line_table == NULL)
+    {
+        free_line_table(&table);
+        ignore_debug_info(vm, false);
+        return;
+    }
+    *vm->line_table = table;
+    vm->allocated_bytes += charged_size + table.allocated_size;
+}
+
+bool get_vm_source_location(virtual_machine* vm, int program_counter, source_location* location, const char** file)
+{
+    if (vm->is_debug_info_read == false)
+    {
+        read_debug_info(vm);
+    }
+    if (vm->line_table == NULL || find_source_location(vm->line_table, program_counter, location) == false)
+    {
+        return false;
+    }
+
+    *file = vm->line_table->files[location->file];
+    return true;
+}
+
+/// @brief Reports an error of the instruction that just ran, at the place in the source it was compiled from if that is known.
+/// @return `VM_STATUS_FAILED`, so the instruction can return it as the result of the run.
+static vm_status report_runtime_error(virtual_machine* vm, const char* format, ...)
+{
+    char message[256];
+    va_list arguments;
+    va_start(arguments, format);
+    vsnprintf(message, sizeof(message), format, arguments);
+    va_end(arguments);
+
+    /* the program counter already moved past the instruction */
+    source_location location;
+    const char* file;
+    if (get_vm_source_location(vm, vm->program_counter - 1, &location, &file) == true)
+    {
+        log_error("Runtime error: %s at \"%s\" line %d, column %d.", message, file, location.line, location.column);
+    }
+    else
+    {
+        log_error("Runtime error: %s at instruction %d of \"%s\".", message, vm->program_counter - 1, vm->source_path);
+    }
+
+    return VM_STATUS_FAILED;
+}
+
+/// @brief Reports a program that used up its fuel, at the backward jump or call it got to.
+/// @return `VM_STATUS_OUT_OF_FUEL`, so the instruction can return it as the result of the run.
+static vm_status report_out_of_fuel(virtual_machine* vm)
+{
+    report_runtime_error(vm, "Out of fuel after %" PRIu64 " instructions", vm->metrics.instruction_count);
+    return VM_STATUS_OUT_OF_FUEL;
+}
+
+/// @brief Determines if a value is a string that refers to one of the string objects of the program.
+static bool is_string_object(const virtual_machine* vm, value value)
+{
+    return value.type == VAL_STRING && value.as.i >= 0 && value.as.i < vm->object_count;
+}
+
+/// @brief Writes a value as a log message, a string object as-is instead of using it as a format, and any other value formatted as text.
+/// @return `true` if the value was logged, `false` if it is a string that isn't one of the string objects of the program.
+static bool write_builtin_log(virtual_machine* vm, log_level level, value log_value)
+{
+    uint64_t start = vm->is_measured == true ? get_monotonic_time() : 0;
+
+    char text[32];
+    log_record record = { level, text, 0, get_log_timestamp(), vm->source_path, 0, vm->program_counter - 1 };
+    switch (log_value.type)
+    {
+        case VAL_STRING:
+        {
+            if (is_string_object(vm, log_value) == false)
+            {
+                return false;
+            }
+            record.message = get_object_text(vm, log_value.as.i);
+            record.length = vm->objects[log_value.as.i].length;
+            break;
+        }
+        case VAL_DOUBLE: record.length = (size_t)snprintf(text, sizeof(text), "%.15g", log_value.as.d); break;
+        case VAL_INT: record.length = (size_t)snprintf(text, sizeof(text), "%d", log_value.as.i); break;
+        case VAL_BOOL: record.length = (size_t)snprintf(text, sizeof(text), "%s", log_value.as.b ? "true" : "false"); break;
+        default: record.length = (size_t)snprintf(text, sizeof(text), "null"); break;
+    }
+
+    /* the program counter already moved past the builtin instruction */
+    write_log_record(&record);
+
+    vm->metrics.builtin_call_count++;
+    if (vm->is_measured == true)
+    {
+        vm->metrics.builtin_nanoseconds += get_elapsed_time(start);
+    }
+
+    return true;
+}
+
+/// @brief Determines if an instruction has an effect outside the virtual machine, which ends the initialization of a program.
+static bool has_outside_effect(const instruction* instruction)
+{
+    switch (instruction->op_code)
+    {
+        /* a grab traces the module it grabs, and runs it when it is a module of the archive */
+        case OP_GRAB:
+        case OP_PRINT:
+        case OP_CALL:
+        case OP_RETURN:
+        case OP_HALT:
+        case OP_BUILTIN_ERROR:
+        case OP_BUILTIN_WARNING:
+        case OP_BUILTIN_DEBUG:
+        case OP_BUILTIN_INFO:
+            return true;
+        default: return false;
+    }
+}
+
+/// @brief Runs instructions until the program halts, returns, fails or runs out of fuel.
+static vm_status execute_vm(virtual_machine* vm)
 {
     while (vm->program_counter < vm->instruction_count)
     {
+        /* the stack is as deep as it gets between instructions, which only the first one doesn't follow */
+        if (vm->stack_pointer > vm->metrics.peak_stack_depth)
+        {
+            vm->metrics.peak_stack_depth = vm->stack_pointer;
+        }
         instruction instruction = vm->instructions[vm->program_counter];
+        if (vm->is_initializing == true && has_outside_effect(&instruction) == true)
+        {
+            return VM_STATUS_FINISHED;
+        }
         vm->program_counter++;
+        vm->metrics.instruction_count++;
+        COUNT_OP(instruction.op_code);
 
         switch (instruction.op_code)
         {
@@ -154,6 +794,12 @@ bool run_vm(virtual_machine* vm)
                     {
                         new_value.type = VAL_BOOL;
                         new_value.as.b = instruction.operand.b;
+                        break;
+                    }
+                    case OP_TYPE_NULL:
+                    {
+                        new_value.type = VAL_NULL;
+                        break;
                     }
                     default:
                     {
@@ -180,6 +826,12 @@ bool run_vm(virtual_machine* vm)
                 vm->stack_pointer--;
                 break;
             }
+            case OP_DUP:
+            {
+                vm->stack[vm->stack_pointer] = vm->stack[vm->stack_pointer - 1];
+                vm->stack_pointer++;
+                break;
+            }
             case OP_ADD:
             {
                 value b = vm->stack[--vm->stack_pointer];
@@ -190,8 +842,8 @@ bool run_vm(virtual_machine* vm)
                 }
                 else
                 {
-                    log_error("Error: Invalid operand types for ADD.");
-                    return false;
+                    COUNT_TYPE_CHECK_FAILURE(OP_ADD);
+                    return report_runtime_error(vm, "Invalid operand types for ADD");
                 }
                 break;
             }
@@ -205,8 +857,8 @@ bool run_vm(virtual_machine* vm)
                 }
                 else
                 {
-                    log_error("Error: Invalid operand types for SUB.");
-                    return false;
+                    COUNT_TYPE_CHECK_FAILURE(OP_SUB);
+                    return report_runtime_error(vm, "Invalid operand types for SUB");
                 }
                 break;
             }
@@ -220,8 +872,8 @@ bool run_vm(virtual_machine* vm)
                 }
                 else
                 {
-                    log_error("Error: Invalid operand types for MUL.\n");
-                    return false;
+                    COUNT_TYPE_CHECK_FAILURE(OP_MUL);
+                    return report_runtime_error(vm, "Invalid operand types for MUL");
                 }
                 break;
             }
@@ -233,15 +885,14 @@ bool run_vm(virtual_machine* vm)
                 {
                     if (b.as.d == 0.0)
                     {
-                        log_error("Error: Division by zero.");
-                        return false;
+                        return report_runtime_error(vm, "Division by zero");
                     }
                     vm->stack[vm->stack_pointer++] = (value){VAL_DOUBLE, {.d = a.as.d / b.as.d}};
                 }
                 else
                 {
-                    log_error("Error: Invalid operand types for DIV.");
-                    return false;
+                    COUNT_TYPE_CHECK_FAILURE(OP_DIV);
+                    return report_runtime_error(vm, "Invalid operand types for DIV");
                 }
                 break;
             }
@@ -264,8 +915,8 @@ bool run_vm(virtual_machine* vm)
                 }
                 else
                 {
-                    log_error("Error: Invalid operand types for EQ.");
-                    return false;
+                    COUNT_TYPE_CHECK_FAILURE(OP_EQ);
+                    return report_runtime_error(vm, "Invalid operand types for EQ");
                 }
                 break;
             }
@@ -301,6 +952,11 @@ bool run_vm(virtual_machine* vm)
             }
             case OP_JMP:
             {
+                /* only a backward jump can run an instruction again, so only it has to check the fuel */
+                if (instruction.operand.jump.jump_offset < 0 && vm->metrics.instruction_count > vm->fuel)
+                {
+                    return report_out_of_fuel(vm);
+                }
                 vm->program_counter += instruction.operand.jump.jump_offset;
                 break;
             }
@@ -309,27 +965,36 @@ bool run_vm(virtual_machine* vm)
                 value condition = vm->stack[--vm->stack_pointer];
                 if (condition.type == VAL_BOOL && condition.as.b == 0)
                 {
+                    if (instruction.operand.jump.jump_offset < 0 && vm->metrics.instruction_count > vm->fuel)
+                    {
+                        return report_out_of_fuel(vm);
+                    }
                     vm->program_counter += instruction.operand.jump.jump_offset;
                 }
                 break;
             }
             case OP_CALL:
             {
+                if (vm->metrics.instruction_count > vm->fuel)
+                {
+                    return report_out_of_fuel(vm);
+                }
                 // Implement CALL
                 break;
             }
             case OP_RETURN:
             {
-                // Implement RETURN
-                break;
+                /* there are no call frames yet, so a return always leaves the program */
+                return VM_STATUS_FINISHED;
             }
             case OP_HALT:
             {
                 /* stop execution */
-                return true;
+                return VM_STATUS_FINISHED;
             }
             case OP_PRINT:
             {
+                uint64_t start = vm->is_measured == true ? get_monotonic_time() : 0;
                 value value = vm->stack[--vm->stack_pointer];
                 if (value.type == VAL_DOUBLE)
                 {
@@ -337,67 +1002,157 @@ bool run_vm(virtual_machine* vm)
                 }
                 else if (value.type == VAL_STRING)
                 {
+                    if (is_string_object(vm, value) == false)
+                    {
+                        return report_runtime_error(vm, "Invalid string constant %d for PRINT", value.as.i);
+                    }
+
                     /* retrieve string from objects array using the index */
-                    char* string_to_print = (char*)vm->objects[value.as.i];
+                    const char* string_to_print = get_object_text(vm, value.as.i);
                     printf("%s\n", string_to_print);
                 }
                 else if (value.type == VAL_BOOL)
                 {
                     printf("%s\n", value.as.b ? "true" : "false");
                 }
+                vm->metrics.builtin_call_count++;
+                if (vm->is_measured == true)
+                {
+                    vm->metrics.builtin_nanoseconds += get_elapsed_time(start);
+                }
                 break;
             }
             case OP_GRAB:
             {
                 int module_name_index = instruction.operand.i;
-                char* module_name = vm->objects[module_name_index];
-                log_debug("[run_vm]: OP_GRAB operand.i is %d (string index)", module_name_index);
-
-                log_debug("[run_vm]: grabbing moudule: %s", module_name);
-
+                const char* module_name = get_object_text(vm, module_name_index);
+                vm_status status = grab_module(vm, module_name);
+                if (status != VM_STATUS_FINISHED)
+                {
+                    return status;
+                }
                 break;
             }
             case OP_BUILTIN_ERROR:
             {
                 value log_value = vm->stack[--vm->stack_pointer];
-                char* log_message = vm->objects[log_value.as.i];
-                log_error(log_message);
+                if (LOG_LEVEL_ERROR < vm->minimum_log_level)
+                {
+                    /* skipped before the object table is touched, the argument is still popped */
+                    break;
+                }
+                if (write_builtin_log(vm, LOG_LEVEL_ERROR, log_value) == false)
+                {
+                    return report_runtime_error(vm, "Invalid string constant %d for BUILTIN_ERROR", log_value.as.i);
+                }
                 break;
             }
             case OP_BUILTIN_WARNING:
             {
                 value log_value = vm->stack[--vm->stack_pointer];
-                char* log_message = vm->objects[log_value.as.i];
-                log_warning(log_message);
+                if (LOG_LEVEL_WARNING < vm->minimum_log_level)
+                {
+                    /* skipped before the object table is touched, the argument is still popped */
+                    break;
+                }
+                if (write_builtin_log(vm, LOG_LEVEL_WARNING, log_value) == false)
+                {
+                    return report_runtime_error(vm, "Invalid string constant %d for BUILTIN_WARNING", log_value.as.i);
+                }
                 break;
             }
             case OP_BUILTIN_DEBUG:
             {
                 value log_value = vm->stack[--vm->stack_pointer];
-                char* log_message = vm->objects[log_value.as.i];
-                log_debug(log_message);
+                if (LOG_LEVEL_DEBUG < vm->minimum_log_level)
+                {
+                    /* skipped before the object table is touched, the argument is still popped */
+                    break;
+                }
+                if (write_builtin_log(vm, LOG_LEVEL_DEBUG, log_value) == false)
+                {
+                    return report_runtime_error(vm, "Invalid string constant %d for BUILTIN_DEBUG", log_value.as.i);
+                }
                 break;
             }
             case OP_BUILTIN_INFO:
             {
                 value log_value = vm->stack[--vm->stack_pointer];
-                char* log_message = vm->objects[log_value.as.i];
-                log_info(log_message);
+                if (LOG_LEVEL_INFO < vm->minimum_log_level)
+                {
+                    /* skipped before the object table is touched, the argument is still popped */
+                    break;
+                }
+                if (write_builtin_log(vm, LOG_LEVEL_INFO, log_value) == false)
+                {
+                    return report_runtime_error(vm, "Invalid string constant %d for BUILTIN_INFO", log_value.as.i);
+                }
                 break;
             }
             default:
             {
-                log_error("Runtime error: Unknown operation %d.", instruction.op_code);
-                return false;
+                return report_runtime_error(vm, "Unknown operation %d", instruction.op_code);
             }
         }
     }
 
-    return false;
+    /* a program always ends with a halt, so running past its last instruction means it is broken */
+    return VM_STATUS_FAILED;
+}
+
+static int execute_vm_argument(void* vm)
+{
+    return (int)execute_vm((virtual_machine*)vm);
+}
+
+vm_status run_vm(virtual_machine* vm)
+{
+    /* with a perf map, every program runs through a trampoline named after it, so native profilers can tell them apart */
+    perf_trampoline trampoline = get_perf_trampoline(vm->source_path);
+    if (trampoline != NULL)
+    {
+        return (vm_status)trampoline(vm, execute_vm_argument);
+    }
+
+    return execute_vm(vm);
+}
+
+vm_status initialize_vm(virtual_machine* vm)
+{
+    vm->is_initializing = true;
+    vm_status status = run_vm(vm);
+    vm->is_initializing = false;
+
+    return status;
+}
+
+void free_virtual_machine(virtual_machine* vm)
+{
+    /* the string objects and instructions are views into the bytecode file or its decompressed sections, unless they were decoded */
+    free_decompressed_sections(vm);
+    unmap_file(&vm->bytecode);
+    free(vm->object_flags);
+    free(vm->decoded_instructions);
+    free(vm->decoded_objects);
+    free(vm->variables);
+    free(vm->stack);
+    if (vm->line_table != NULL)
+    {
+        free_line_table(vm->line_table);
+        free(vm->line_table);
+    }
+    free(vm->debug_info_allocation);
+    if (vm->owns_archive == true)
+    {
+        free(vm->module_states);
+        free(vm->archive);
+    }
 }
 
 void garbage_collect(virtual_machine* virtual_machine)
 {
+    uint64_t start = get_monotonic_time();
+
     /* mark objects reachable from the stack */
     for (int i = 0; i < virtual_machine->stack_pointer; i++)
     {
@@ -406,7 +1161,7 @@ void garbage_collect(virtual_machine* virtual_machine)
             /* find the index of the string in the objects array */
             for (int j = 0; j < virtual_machine->object_count; j++)
             {
-                if (virtual_machine->objects[j] == virtual_machine->stack[i].as.s)
+                if (get_object_text(virtual_machine, j) == virtual_machine->stack[i].as.s)
                 {
                     mark_object(virtual_machine, j);
                     break;
@@ -423,7 +1178,7 @@ void garbage_collect(virtual_machine* virtual_machine)
             /* find the index of the string in the objects array */
             for (int j = 0; j < virtual_machine->object_count; j++)
             {
-                if (virtual_machine->objects[j] == virtual_machine->variables[i].as.s)
+                if (get_object_text(virtual_machine, j) == virtual_machine->variables[i].as.s)
                 {
                     mark_object(virtual_machine, j);
                     break;
@@ -432,24 +1187,17 @@ void garbage_collect(virtual_machine* virtual_machine)
         }
     }
 
-    /* sweep objects when they are marked */
-    int new_object_count = 0;
+    /* every object is a view into the bytecode file, so sweeping only unmarks them for the next GC */
     for (int i = 0; i < virtual_machine->object_count; i++)
     {
-        if (virtual_machine->object_flags[i] == 1)
-        {
-            /* marked, keep it */
-            virtual_machine->objects[new_object_count] = virtual_machine->objects[i];
-            /* unmark it for the next GC */
-            virtual_machine->object_flags[new_object_count] = 0;
-            new_object_count++;
-            continue;
-        }
-
-        /* not marked, free it */
-        safe_free(virtual_machine->objects[i]);
+        virtual_machine->object_flags[i] = 0;
     }
 
-    /* update object count post-sweep */
-    virtual_machine->object_count = new_object_count;
+    uint64_t pause = get_elapsed_time(start);
+    virtual_machine->metrics.gc_cycle_count++;
+    virtual_machine->metrics.gc_pause_nanoseconds += pause;
+    if (pause > virtual_machine->metrics.gc_longest_pause_nanoseconds)
+    {
+        virtual_machine->metrics.gc_longest_pause_nanoseconds = pause;
+    }
 }
\ No newline at end of file
@@ -1,12 +1,74 @@
 #ifndef VIRTUAL_MACHINE
 #define VIRTUAL_MACHINE
+#include <inttypes.h>
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "../../core/extensions/memory_extensions.h"
+#include "../../core/extensions/time_extensions.h"
 #include "../../core/logger/logger.h"
 #include "../../core/types/bytecode.h"
+#include "../../core/types/bytecode_archive.h"
+#include "../../core/types/bytecode_file.h"
+#include "../../core/types/line_table.h"
+#include "../../core/file/map_file.h"
+#include "../profiler/op_statistics.h"
+#include "../profiler/perf_map.h"
+
+/// @enum module_state
+/// @brief How far a module of an archive has come, so every module runs once however often it is grabbed.
+typedef enum module_state
+{
+    MODULE_NOT_RUN,
+    MODULE_RUNNING,
+    MODULE_RAN
+} module_state;
+
+/// @enum vm_status
+/// @brief How a run of a program ended.
+typedef enum vm_status
+{
+    /// @brief The program halted or returned, or its initialization ended.
+    VM_STATUS_FINISHED,
+    /// @brief The program failed with a runtime error.
+    VM_STATUS_FAILED,
+    /// @brief The program ran more instructions than its fuel allows.
+    VM_STATUS_OUT_OF_FUEL,
+    /// @brief The program needed more memory than its byte budget allows, or than the host has.
+    VM_STATUS_OUT_OF_MEMORY
+} vm_status;
+
+/// @brief The fuel or byte budget of a virtual machine that has none.
+#define VM_UNLIMITED UINT64_MAX
+
+/// @struct vm_metrics
+/// @brief What running a program took, counted by the virtual machine as it runs, including the modules it grabbed.
+typedef struct vm_metrics vm_metrics;
+
+struct vm_metrics
+{
+    /// @brief The amount of instructions run.
+    uint64_t instruction_count;
+    /// @brief The most values the stack of any one virtual machine held at once.
+    int peak_stack_depth;
+    /// @brief The amount of string objects loaded, which every string value is a view of.
+    uint64_t object_count;
+    /// @brief The amount of modules run.
+    uint64_t module_count;
+    /// @brief The amount of garbage collections.
+    uint64_t gc_cycle_count;
+    /// @brief The time spent collecting garbage, in nanoseconds.
+    uint64_t gc_pause_nanoseconds;
+    /// @brief The longest single garbage collection, in nanoseconds.
+    uint64_t gc_longest_pause_nanoseconds;
+    /// @brief The amount of prints and builtin logging calls that wrote something.
+    uint64_t builtin_call_count;
+    /// @brief The time spent in those calls, in nanoseconds, only measured when `is_measured` is set.
+    uint64_t builtin_nanoseconds;
+};
 
 /// @struct virtual_machine
 /// @brief The virtual machine that runs L# instructions, and manages the stack.
@@ -17,34 +79,109 @@ struct virtual_machine
     value* stack;
     int stack_size;
     int stack_pointer;
-    instruction* instructions;
+    /// @brief The instructions, which point straight into the bytecode file when its layout matches this host.
+    const instruction* instructions;
+    /// @brief The instructions decoded from the bytecode file when they can't run from it in place, `NULL` otherwise.
+    instruction* decoded_instructions;
     int instruction_count;
     int instruction_capacity;
     value* variables;
     int variable_count;
-    /// @brief An array of pointers to managed objects.
-    char** objects;
+    /// @brief The string objects, as views into `string_data`.
+    const bytecode_string* objects;
+    /// @brief The string views decoded from the bytecode file when they can't be used from it in place, `NULL` otherwise.
+    bytecode_string* decoded_objects;
+    /// @brief The null-terminated text of every string object.
+    const char* string_data;
     int object_count;
     int object_capacity;
     /// @brief The flags for garbage collection.
     char* object_flags;
     int program_counter;
+    /// @brief The bytecode file, which instructions and string objects are read from in place.
+    mapped_file bytecode;
+    /// @brief The contents of the compressed sections of the bytecode file, which are read from here instead.
+    unsigned char* decompressed_sections[BYTECODE_MAXIMUM_SECTIONS];
+    int decompressed_section_count;
+    /// @brief The path of the bytecode file, which builtin logging instructions report as their source.
+    const char* source_path;
+    /// @brief Builtin logging instructions below this level only pop their argument.
+    log_level minimum_log_level;
+    /// @brief The archive the program was loaded from, which grabs find their modules in, `NULL` for an .lbc file.
+    bytecode_archive* archive;
+    /// @brief The state of every module of the archive, shared by the virtual machines of every module.
+    module_state* module_states;
+    /// @brief `true` if this virtual machine opened the archive and releases it, `false` for the virtual machine of a grabbed module.
+    bool owns_archive;
+    /// @brief `true` while the program is initialized, which stops before the first instruction with an effect outside the virtual machine.
+    bool is_initializing;
+    /// @brief The .lbc file the instructions were loaded from, whose debug info is only read once a source location is needed.
+    const unsigned char* program_data;
+    size_t program_size;
+    /// @brief The line table, decoded the first time a source location is needed, `NULL` until then or if there is none.
+    line_table* line_table;
+    /// @brief The debug info section the line table points into, if it had to be decompressed.
+    unsigned char* debug_info_allocation;
+    /// @brief `true` once the debug info has been looked for, whether or not the file has any.
+    bool is_debug_info_read;
+    /// @brief The virtual machine of the module this one grabbed while that module runs, `NULL` otherwise, so the
+    /// modules being run can be walked from the outermost one, as a call stack.
+    virtual_machine* volatile running_module;
+    /// @brief What running the program took so far, with the modules it grabbed added once they ran.
+    vm_metrics metrics;
+    /// @brief `true` if the time spent in builtins is measured, which reads the clock around every one of them.
+    bool is_measured;
+    /// @brief The most instructions the program may run, checked against `metrics.instruction_count` on backward
+    /// jumps and calls only, since a program without either always ends. `VM_UNLIMITED` by default.
+    uint64_t fuel;
+    /// @brief The most bytes the virtual machine may allocate for its programs, counting the modules it grabs while
+    /// they run. `VM_UNLIMITED` by default.
+    uint64_t memory_limit;
+    /// @brief The bytes the virtual machine allocated for its program so far.
+    uint64_t allocated_bytes;
+    /// @brief `true` once an allocation didn't fit in the byte budget or the host's memory.
+    bool is_out_of_memory;
 };
 
 /// @brief Creates a `virtual_machine` and fills it with default data.
 /// @return `true` if the virtual machine was created successfully, `false` otherwise.
 bool create_virtual_machine(virtual_machine* vm);
 
-/// @brief Loads bytecode from a file.
+/// @brief Gets the text of a string object.
+/// @param vm The virtual machine that holds the object.
+/// @param index The index of the object.
+/// @return The null-terminated text of the object.
+const char* get_object_text(const virtual_machine* vm, int index);
+
+/// @brief Loads bytecode from a file, by mapping it into memory and verifying the sections the runtime uses, decompressing the ones stored compressed.
+/// An .lba archive loads its entry module, and its other modules are only loaded once they are grabbed.
 /// @param vm The virtual machine to load the bytecode into.
-/// @param filename The name of the bytecode file.
-/// @return `true` if the bytecode file is loaded, `false` otherwise.
+/// @param filename The name of the .lbc or .lba file.
+/// @return `true` if the bytecode file is loaded, `false` otherwise, with `is_out_of_memory` set if it didn't fit in the byte budget.
 bool load_bytecode_from_file(virtual_machine* vm, const char* filename);
 
+/// @brief Finds where in the source an instruction was compiled from, reading the debug info of the program the first time.
+/// @param vm The virtual machine that runs the instruction.
+/// @param program_counter The index of the instruction.
+/// @param location The source location to fill.
+/// @param file Set to the path of the source file.
+/// @return `true` if the place the instruction was compiled from is known, `false` if it isn't or the program has no debug info.
+bool get_vm_source_location(virtual_machine* vm, int program_counter, source_location* location, const char** file);
+
 /// @brief Runs the `vm`.
 /// @param vm The virtual machine to run.
-/// @return `true` if the virtual machine was run, `false` otherwise.
-bool run_vm(virtual_machine* vm);
+/// @return How the run ended.
+vm_status run_vm(virtual_machine* vm);
+
+/// @brief Runs the initialization of the program in the `vm`: every instruction before the first one that prints, logs,
+/// calls, halts or grabs a module, so the state it leaves behind can be saved and the program resumed from it.
+/// @param vm The virtual machine to initialize.
+/// @return How the initialization ended, `VM_STATUS_FINISHED` if the program was initialized.
+vm_status initialize_vm(virtual_machine* vm);
+
+/// @brief Deallocates the memory owned by the `vm`, but not the `vm` itself.
+/// @param vm The virtual machine to free the members of.
+void free_virtual_machine(virtual_machine* vm);
 
 /// @brief Marks and sweep objects that can be cleaned.
 /// @param virtual_machine The L# virtual machine.
@@ -0,0 +1,184 @@
+/* mkdtemp and rmdir are POSIX, which strict C17 hides unless asked for */
+#define _POSIX_C_SOURCE 200809L
+#include "../../src/compiler/chunks/build_chunks.h"
+#include "../../src/runtime/virtual_machine/virtual_machine.h"
+#include <assert.h>
+#include <locale.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <wchar.h>
+
+/* --------- */
+/* utilities */
+/* --------- */
+
+static char directory[] = "/tmp/lsc-chunks-XXXXXX";
+static char entry_path[64];
+static char build_path[64];
+static char logged[64];
+
+/// @brief Writes an L# chunk named `module_name` into the test directory.
+void write_chunk(const char* module_name, const char* source)
+{
+	char path[64];
+	snprintf(path, sizeof(path), "%s/%s.ls", directory, module_name);
+	FILE* file = fopen(path, "w");
+	assert(file != NULL && "Validate the chunk can be written to the test directory.");
+	fputs(source, file);
+	fclose(file);
+}
+
+/// @brief Builds the test program with a build directory.
+/// @return The statistics of the build.
+chunk_build_statistics build_program()
+{
+	compiler_options options;
+	create_compiler_options(&options);
+	options.input_path = entry_path;
+	options.build_directory = build_path;
+
+	chunk_build_statistics build_statistics;
+	create_chunk_build_statistics(&build_statistics);
+	size_t size;
+	unsigned char* bytecode = build_chunks(&options, NULL, &build_statistics, &size);
+	assert(bytecode != NULL && size > 0 && "Validate the test program builds.");
+	safe_free(bytecode);
+
+	return build_statistics;
+}
+
+/// @brief Encodes nothing, but keeps every message the program logs, in order.
+size_t record_message(const log_record* record, char* buffer, size_t capacity)
+{
+	strncat(logged, record->message, record->length);
+	return 0;
+}
+
+static const log_sink recording_sink = { "recording", false, record_message };
+
+/// @brief Builds the test program into one linked file or an archive of its chunks, then runs it.
+/// @return Every message the program logged, in order.
+const char* run_program(bool write_archive)
+{
+	compiler_options options;
+	create_compiler_options(&options);
+	options.input_path = entry_path;
+	options.write_archive = write_archive;
+
+	chunk_build_statistics build_statistics;
+	create_chunk_build_statistics(&build_statistics);
+	size_t size;
+	unsigned char* bytecode = build_chunks(&options, NULL, &build_statistics, &size);
+	assert(bytecode != NULL && "Validate the test program builds.");
+	char path[64];
+	snprintf(path, sizeof(path), "%s/program", directory);
+	FILE* file = fopen(path, "wb");
+	assert(file != NULL && fwrite(bytecode, 1, size, file) == size && "Validate the test program can be written to the test directory.");
+	fclose(file);
+	safe_free(bytecode);
+
+	virtual_machine vm;
+	create_virtual_machine(&vm);
+	assert(load_bytecode_from_file(&vm, path) == true && "Validate the test program loads.");
+	logged[0] = '\0';
+	set_log_sink(&recording_sink);
+	vm_status status = run_vm(&vm);
+	set_log_sink(get_log_sink(LOG_FORMAT_CONSOLE));
+	free_virtual_machine(&vm);
+	assert(status == VM_STATUS_FINISHED && "Validate the test program runs.");
+
+	return logged;
+}
+
+/// @brief Removes the test directory and everything the tests wrote into it.
+void remove_test_directory()
+{
+	const char* files[] = { "main.ls", "middle.ls", "leaf.ls", "other.ls", "build/main.lbc", "build/middle.lbc", "build/leaf.lbc", "build/other.lbc", "build/" CHUNK_MANIFEST_NAME, "program" };
+	char path[64];
+	for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++)
+	{
+		snprintf(path, sizeof(path), "%s/%s", directory, files[i]);
+		remove(path);
+	}
+	rmdir(build_path);
+	rmdir(directory);
+}
+
+/* ----- */
+/* tests */
+/* ----- */
+
+void buildchunks_shouldcompileeverychunk_withemptybuilddirectory()
+{
+	chunk_build_statistics build_statistics = build_program();
+
+	assert(build_statistics.chunk_count == 4 && "Validate every chunk the entry file grabs, however indirectly, is found.");
+	assert(build_statistics.compiled_count == 4 && "Validate every chunk is compiled when nothing was built before.");
+}
+
+void buildchunks_shouldcompilenothing_withunchangedchunks()
+{
+	chunk_build_statistics build_statistics = build_program();
+
+	assert(build_statistics.chunk_count == 4 && "Validate a rebuild finds the same chunks.");
+	assert(build_statistics.compiled_count == 0 && "Validate every chunk is reused when nothing changed.");
+}
+
+void buildchunks_shouldcompiledependents_withchangeddependency()
+{
+	/* main grabs middle and other, and middle grabs leaf, so changing leaf changes everything but other */
+	write_chunk("leaf", "number leaf = 2\nlog(leaf)\n");
+	chunk_build_statistics build_statistics = build_program();
+
+	assert(build_statistics.compiled_count == 3 && "Validate a changed chunk is compiled again, along with every chunk that depends on it.");
+	assert(build_program().compiled_count == 0 && "Validate the manifest records the rebuild, so the next build reuses every chunk.");
+}
+
+void buildchunks_shouldcompileonlychunk_withchangedentry()
+{
+	write_chunk("main", "grab middle\ngrab other\nnumber main = 4\nlog(main)\n");
+	chunk_build_statistics build_statistics = build_program();
+
+	assert(build_statistics.compiled_count == 1 && "Validate a changed chunk that nothing depends on is the only one compiled again.");
+}
+
+void buildchunks_shouldrunchunkswheregrabbed_withlinkedandarchivedprogram()
+{
+	/* leaf is grabbed by middle and again by other, where it doesn't run again */
+	write_chunk("main", "info('a')\ngrab middle\ninfo('d')\ngrab other\ninfo('f')\n");
+	write_chunk("middle", "info('b')\ngrab leaf\n");
+	write_chunk("leaf", "info('c')\n");
+	write_chunk("other", "grab leaf\ninfo('e')\n");
+
+	char linked[64];
+	snprintf(linked, sizeof(linked), "%s", run_program(false));
+	assert(strcmp(linked, "abcdef") == 0 && "Validate a linked chunk runs where it is first grabbed.");
+	assert(strcmp(run_program(true), linked) == 0 && "Validate an archive runs its modules in the same order as the linked program.");
+}
+
+/* ------ */
+/* runner */
+/* ------ */
+
+int main()
+{
+	setlocale(LC_ALL, "");
+	wprintf(L"%lc %lc %lc\tbuild chunks tests running\n", (wchar_t)187, (wchar_t)187, (wchar_t)187);
+	char* created = mkdtemp(directory);
+	assert(created != NULL && "Validate the test directory can be created.");
+	snprintf(entry_path, sizeof(entry_path), "%s/main.ls", directory);
+	snprintf(build_path, sizeof(build_path), "%s/build", directory);
+	write_chunk("main", "grab middle\ngrab other\nnumber main = 3\nlog(main)\n");
+	write_chunk("middle", "grab leaf\nnumber middle = 2\nlog(middle)\n");
+	write_chunk("leaf", "number leaf = 1\nlog(leaf)\n");
+	write_chunk("other", "number other = 1\nlog(other)\n");
+
+	buildchunks_shouldcompileeverychunk_withemptybuilddirectory();
+	buildchunks_shouldcompilenothing_withunchangedchunks();
+	buildchunks_shouldcompiledependents_withchangeddependency();
+	buildchunks_shouldcompileonlychunk_withchangedentry();
+	buildchunks_shouldrunchunkswheregrabbed_withlinkedandarchivedprogram();
+	remove_test_directory();
+	wprintf(L"%lc %lc %lc\tbuild chunks tests passed\n", (wchar_t)164, (wchar_t)164, (wchar_t)164);
+}
\ No newline at end of file
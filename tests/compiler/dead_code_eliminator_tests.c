@@ -0,0 +1,161 @@
+#include "../../src/compiler/optimizer/dead_code_eliminator.h"
+#include <assert.h>
+#include <locale.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <wchar.h>
+
+/* --------- */
+/* utilities */
+/* --------- */
+
+#define LOAD_NUMBER(number) ((instruction){OP_LOAD_CONST, {.d = number}, OP_TYPE_NUMBER})
+#define LOAD_VAR(index) ((instruction){OP_LOAD_VAR, {.variable = {index}}, OP_TYPE_VARIABLE})
+#define STORE_VAR(index) ((instruction){OP_STORE_VAR, {.variable = {index}}, OP_TYPE_VARIABLE})
+#define OPERATION(op_code) ((instruction){op_code, {0}, OP_TYPE_NULL})
+
+/// @brief Creates a straight-line program of `variable_count` declarations, each one built from the one before it, whose last one is printed.
+bytecode_generator* create_declaration_chain(int variable_count)
+{
+	bytecode_generator* generator = create_bytecode_generator();
+	emit_instruction(generator, LOAD_NUMBER(1));
+	emit_instruction(generator, STORE_VAR(0));
+	for (int i = 1; i < variable_count; i++)
+	{
+		emit_instruction(generator, LOAD_VAR(i - 1));
+		emit_instruction(generator, LOAD_NUMBER(i % 7));
+		emit_instruction(generator, OPERATION(OP_ADD));
+		emit_instruction(generator, STORE_VAR(i));
+	}
+	emit_instruction(generator, LOAD_VAR(variable_count - 1));
+	emit_instruction(generator, OPERATION(OP_PRINT));
+	emit_instruction(generator, OPERATION(OP_HALT));
+	generator->variable_count = variable_count;
+
+	return generator;
+}
+
+/// @brief Eliminates the dead code of a program of `count` instructions that uses `variable_count` variables.
+bytecode_generator* eliminate_program(const instruction* instructions, int count, int variable_count)
+{
+	bytecode_generator* generator = create_bytecode_generator();
+	for (int i = 0; i < count; i++)
+	{
+		emit_instruction(generator, instructions[i]);
+	}
+	generator->variable_count = variable_count;
+	eliminate_dead_code(generator, NULL);
+
+	return generator;
+}
+
+/// @brief Determines if the instructions of the `generator` have exactly the `expected` op codes.
+bool has_op_codes(const bytecode_generator* generator, const op_code* expected, int count)
+{
+	if (generator->instruction_count != count)
+	{
+		return false;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		if (generator->instructions[i].op_code != expected[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/// @brief Eliminates the dead code of a declaration chain.
+/// @return The amount of bytes the elimination allocated.
+uint64_t measure_dead_code_elimination(int variable_count)
+{
+	bytecode_generator* generator = create_declaration_chain(variable_count);
+	int instruction_count = generator->instruction_count;
+
+	allocation_statistics before;
+	allocation_statistics after;
+	get_allocation_statistics(&before);
+	int removed_count = eliminate_dead_code(generator, NULL);
+	get_allocation_statistics(&after);
+
+	assert(removed_count == 0 && "Validate eliminate_dead_code keeps every store that a later declaration loads.");
+	assert(generator->instruction_count == instruction_count && "Validate eliminate_dead_code keeps the whole declaration chain.");
+	free_bytecode_generator(generator);
+
+	return after.bytes - before.bytes;
+}
+
+/* ----- */
+/* tests */
+/* ----- */
+
+void eliminatedeadcode_shouldremovestore_withdivisionbynonzeroconstant()
+{
+	instruction program[] = { LOAD_NUMBER(6), LOAD_NUMBER(2), OPERATION(OP_DIV), STORE_VAR(0), OPERATION(OP_HALT) };
+	bytecode_generator* generator = eliminate_program(program, 5, 1);
+
+	op_code expected[] = { OP_HALT };
+	assert(has_op_codes(generator, expected, 1) == true && "Validate an unused division that can't fail is removed along with its store.");
+	free_bytecode_generator(generator);
+}
+
+void eliminatedeadcode_shouldkeepdivision_withdivisionbyzero()
+{
+	instruction program[] = { LOAD_NUMBER(6), LOAD_NUMBER(0), OPERATION(OP_DIV), STORE_VAR(0), OPERATION(OP_HALT) };
+	bytecode_generator* generator = eliminate_program(program, 5, 1);
+
+	/* the value is still unused, but dividing by zero is a runtime error the program has to report */
+	op_code expected[] = { OP_LOAD_CONST, OP_LOAD_CONST, OP_DIV, OP_POP, OP_HALT };
+	assert(has_op_codes(generator, expected, 5) == true && "Validate an unused division by zero is kept, only its store is removed.");
+	free_bytecode_generator(generator);
+}
+
+void eliminatedeadcode_shouldkeepdivision_withvariabledivisor()
+{
+	instruction program[] = { LOAD_NUMBER(0), STORE_VAR(1), LOAD_NUMBER(6), LOAD_VAR(1), OPERATION(OP_DIV), STORE_VAR(0), OPERATION(OP_HALT) };
+	bytecode_generator* generator = eliminate_program(program, 7, 2);
+
+	op_code expected[] = { OP_LOAD_CONST, OP_STORE_VAR, OP_LOAD_CONST, OP_LOAD_VAR, OP_DIV, OP_POP, OP_HALT };
+	assert(has_op_codes(generator, expected, 7) == true && "Validate an unused division by a variable is kept, along with the store of the divisor.");
+	free_bytecode_generator(generator);
+}
+
+void eliminatedeadcode_shouldremove_withunreachableinstructions()
+{
+	instruction program[] = { LOAD_NUMBER(1), OPERATION(OP_PRINT), OPERATION(OP_HALT), LOAD_NUMBER(2), OPERATION(OP_PRINT) };
+	bytecode_generator* generator = eliminate_program(program, 5, 0);
+
+	op_code expected[] = { OP_LOAD_CONST, OP_PRINT, OP_HALT };
+	assert(has_op_codes(generator, expected, 3) == true && "Validate the instructions after a halt are removed.");
+	free_bytecode_generator(generator);
+}
+
+void eliminatedeadcode_shouldscalelinearly_withmanyvariables()
+{
+	/* liveness that is kept per instruction grows with the square of the program, sixteen times over for four times the variables */
+	uint64_t small_bytes = measure_dead_code_elimination(10000);
+	uint64_t large_bytes = measure_dead_code_elimination(40000);
+
+	assert(large_bytes < small_bytes * 6 && "Validate eliminate_dead_code allocates in proportion to the size of the program.");
+	/* every declaration of the chain is four instructions */
+	assert(large_bytes < (uint64_t)40000 * 4 * 64 && "Validate eliminate_dead_code allocates a few bytes per instruction of a straight-line program.");
+}
+
+/* ------ */
+/* runner */
+/* ------ */
+
+int main()
+{
+	count_allocations();
+	setlocale(LC_ALL, "");
+	wprintf(L"%lc %lc %lc\tdead code eliminator tests running\n", (wchar_t)187, (wchar_t)187, (wchar_t)187);
+	eliminatedeadcode_shouldremovestore_withdivisionbynonzeroconstant();
+	eliminatedeadcode_shouldkeepdivision_withdivisionbyzero();
+	eliminatedeadcode_shouldkeepdivision_withvariabledivisor();
+	eliminatedeadcode_shouldremove_withunreachableinstructions();
+	eliminatedeadcode_shouldscalelinearly_withmanyvariables();
+	wprintf(L"%lc %lc %lc\tdead code eliminator tests passed\n", (wchar_t)164, (wchar_t)164, (wchar_t)164);
+}
\ No newline at end of file
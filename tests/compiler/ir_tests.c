@@ -0,0 +1,255 @@
+#include "../../src/compiler/ir/build_ir.h"
+#include "../../src/compiler/ir/optimize_ir.h"
+#include "../../src/compiler/lsc.h"
+#include <assert.h>
+#include <locale.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <wchar.h>
+
+/* --------- */
+/* utilities */
+/* --------- */
+
+/// @brief Builds the IR of an L# program.
+ir_function* build_program(const char* source)
+{
+	char text[1024];
+	snprintf(text, sizeof(text), "%s", source);
+	size_t token_count = 0;
+	token** tokens = get_tokens(text, &token_count);
+	abstract_syntax_node* ast = get_abstract_syntax_tree(tokens, token_count);
+	free_tokens(tokens);
+
+	ir_function* function = build_ir(ast, LOG_LEVEL_DEBUG, NULL);
+	free_ast(ast);
+	assert(function != NULL && "Validate the test program builds.");
+	return function;
+}
+
+/// @brief Finds the `occurrence`th value of the entry block with an `opcode`, counting from 0.
+ir_value* find_value(ir_function* function, ir_opcode opcode, int occurrence)
+{
+	ir_block* block = function->blocks[0];
+	for (int i = 0; i < block->value_count; i++)
+	{
+		if (block->values[i]->opcode == opcode && occurrence-- == 0)
+		{
+			return block->values[i];
+		}
+	}
+
+	return NULL;
+}
+
+ir_value* create_number(ir_function* function, ir_block* block, double number)
+{
+	ir_value* value = create_ir_value(function, block, IR_CONST_NUMBER, IR_TYPE_NUMBER);
+	value->constant.number = number;
+	return value;
+}
+
+ir_value* create_operation(ir_function* function, ir_block* block, ir_opcode opcode, ir_value* left, ir_value* right)
+{
+	ir_value* value = create_ir_value(function, block, opcode, IR_TYPE_NUMBER);
+	add_ir_operand(value, left);
+	add_ir_operand(value, right);
+	return value;
+}
+
+/// @brief Logs a value, which gives it a use with a side effect so dead code elimination keeps it.
+void use_value(ir_function* function, ir_block* block, ir_value* value)
+{
+	ir_value* call = create_ir_value(function, block, IR_BUILTIN_INFO, IR_TYPE_NONE);
+	add_ir_operand(call, value);
+}
+
+void end_block(ir_function* function, ir_block* block, ir_opcode opcode, ir_block* first_target, ir_block* second_target)
+{
+	ir_value* terminator = create_ir_value(function, block, opcode, IR_TYPE_NONE);
+	terminator->targets[0] = first_target;
+	terminator->targets[1] = second_target;
+	if (opcode == IR_BRANCH)
+	{
+		ir_value* condition = create_ir_value(function, block, IR_CONST_BIT, IR_TYPE_BIT);
+		block->values[block->value_count - 1] = terminator;
+		block->values[block->value_count - 2] = condition;
+		add_ir_operand(terminator, condition);
+	}
+	if (first_target != NULL)
+	{
+		add_ir_block_edge(block, first_target);
+	}
+	if (second_target != NULL)
+	{
+		add_ir_block_edge(block, second_target);
+	}
+}
+
+/// @brief A diamond: the entry block branches to a left and a right block, which both jump to the join block.
+typedef struct
+{
+	ir_function* function;
+	ir_block* entry;
+	ir_block* left;
+	ir_block* right;
+	ir_block* join;
+} DIAMOND;
+
+DIAMOND create_diamond()
+{
+	DIAMOND diamond;
+	diamond.function = create_ir_function();
+	diamond.entry = create_ir_block(diamond.function);
+	diamond.left = create_ir_block(diamond.function);
+	diamond.right = create_ir_block(diamond.function);
+	diamond.join = create_ir_block(diamond.function);
+	return diamond;
+}
+
+void end_diamond(DIAMOND* diamond)
+{
+	end_block(diamond->function, diamond->entry, IR_BRANCH, diamond->left, diamond->right);
+	end_block(diamond->function, diamond->left, IR_JUMP, diamond->join, NULL);
+	end_block(diamond->function, diamond->right, IR_JUMP, diamond->join, NULL);
+	end_block(diamond->function, diamond->join, IR_HALT, NULL, NULL);
+}
+
+/* ----- */
+/* tests */
+/* ----- */
+
+void buildir_shouldreadnewvariable_withredeclaredvariable()
+{
+	/* the second declaration hides the first before its initializer is built, like the bytecode generator's new slot */
+	ir_function* function = build_program("number x = 2\nnumber x = x * 3\ninfo(x)\n");
+
+	ir_value* product = find_value(function, IR_MUL, 0);
+	assert(product != NULL && resolve_ir_value(product->operands[0])->opcode == IR_UNDEFINED && "Validate a redeclared variable's initializer reads the new, undefined variable.");
+	ir_value* call = find_value(function, IR_BUILTIN_INFO, 0);
+	assert(call != NULL && resolve_ir_value(call->operands[0]) == product && "Validate a read after a redeclaration reads the latest declaration.");
+	free_ir_function(function);
+}
+
+void buildir_shouldreadassignedvalue_withassignment()
+{
+	ir_function* function = build_program("number x = 2\nx = 5\ninfo(x)\n");
+
+	ir_value* argument = resolve_ir_value(find_value(function, IR_BUILTIN_INFO, 0)->operands[0]);
+	assert(argument->opcode == IR_CONST_NUMBER && argument->constant.number == 5 && "Validate a read after an assignment reads the assigned value, without a phi in a single block.");
+	assert(function->blocks[0]->phi_count == 0 && "Validate straight-line code places no phi.");
+	free_ir_function(function);
+}
+
+void computeirdominators_shouldfindbranch_withdiamond()
+{
+	DIAMOND diamond = create_diamond();
+	end_diamond(&diamond);
+	compute_ir_dominators(diamond.function);
+
+	assert(diamond.entry->immediate_dominator == NULL && "Validate the entry block has no dominator.");
+	assert(diamond.left->immediate_dominator == diamond.entry && diamond.right->immediate_dominator == diamond.entry && "Validate both sides of a branch are dominated by the branch.");
+	assert(diamond.join->immediate_dominator == diamond.entry && "Validate the join of a branch is dominated by the branch, not by either side.");
+	free_ir_function(diamond.function);
+}
+
+void optimizeir_shouldremovetrivialphi_withsameoperands()
+{
+	DIAMOND diamond = create_diamond();
+	ir_value* first = create_number(diamond.function, diamond.entry, 1);
+	ir_value* second = create_number(diamond.function, diamond.right, 2);
+
+	/* a variable defined on one side of the branch merges two values, one defined above it only one */
+	ir_value* merged = create_ir_phi(diamond.function, diamond.join, 0);
+	add_ir_operand(merged, first);
+	add_ir_operand(merged, second);
+	ir_value* unchanged = create_ir_phi(diamond.function, diamond.join, 1);
+	add_ir_operand(unchanged, first);
+	add_ir_operand(unchanged, first);
+	use_value(diamond.function, diamond.join, merged);
+	use_value(diamond.function, diamond.join, unchanged);
+	end_diamond(&diamond);
+
+	optimization_statistics statistics;
+	create_optimization_statistics(&statistics);
+	optimize_ir(diamond.function, &statistics);
+	assert(merged->is_removed == false && "Validate a phi that merges two values is kept.");
+	assert(unchanged->is_removed == true && resolve_ir_value(unchanged) == first && "Validate a phi of one value is forwarded to that value.");
+	assert(statistics.ir_phis_removed == 1 && "Validate the trivial phi is counted.");
+	free_ir_function(diamond.function);
+}
+
+void optimizeir_shouldremovetrivialphi_withselfreference()
+{
+	/* a loop that never changes the variable: the header's phi merges the value from before the loop and itself */
+	ir_function* function = create_ir_function();
+	ir_block* entry = create_ir_block(function);
+	ir_block* header = create_ir_block(function);
+	ir_block* exit = create_ir_block(function);
+	ir_value* before = create_number(function, entry, 4);
+	end_block(function, entry, IR_JUMP, header, NULL);
+
+	ir_value* phi = create_ir_phi(function, header, 0);
+	add_ir_operand(phi, before);
+	add_ir_operand(phi, phi);
+	use_value(function, header, phi);
+	end_block(function, header, IR_BRANCH, header, exit);
+	end_block(function, exit, IR_HALT, NULL, NULL);
+
+	optimize_ir(function, NULL);
+	assert(phi->is_removed == true && resolve_ir_value(phi) == before && "Validate a phi of one value and itself is forwarded to that value.");
+	free_ir_function(function);
+}
+
+void optimizeir_shouldkeepsignedzerosapart_withcommonsubexpressions()
+{
+	ir_function* function = create_ir_function();
+	ir_block* entry = create_ir_block(function);
+	ir_value* zero = create_number(function, entry, 0.0);
+	ir_value* negative_zero = create_number(function, entry, -0.0);
+	ir_value* other_zero = create_number(function, entry, 0.0);
+	use_value(function, entry, zero);
+	use_value(function, entry, negative_zero);
+	use_value(function, entry, other_zero);
+	end_block(function, entry, IR_HALT, NULL, NULL);
+
+	optimize_ir(function, NULL);
+	assert(other_zero->is_removed == true && resolve_ir_value(other_zero) == zero && "Validate an equal constant is replaced by the first one.");
+	assert(negative_zero->is_removed == false && "Validate -0 isn't merged with 0, dividing by them gives different infinities.");
+	free_ir_function(function);
+}
+
+void optimizeir_shouldkeepdeaddivision_withnonconstantdivisor()
+{
+	ir_function* function = create_ir_function();
+	ir_block* entry = create_ir_block(function);
+	ir_value* dividend = create_number(function, entry, 6);
+	ir_value* divisor = create_operation(function, entry, IR_SUB, create_number(function, entry, 2), create_number(function, entry, 2));
+	ir_value* unknown_division = create_operation(function, entry, IR_DIV, dividend, divisor);
+	ir_value* known_division = create_operation(function, entry, IR_DIV, dividend, create_number(function, entry, 3));
+	end_block(function, entry, IR_HALT, NULL, NULL);
+
+	/* neither quotient is used, but the first one can divide by zero, which the runtime has to report */
+	optimize_ir(function, NULL);
+	assert(unknown_division->is_removed == false && divisor->is_removed == false && "Validate an unused division by a value that isn't a constant is kept, along with its divisor.");
+	assert(known_division->is_removed == true && "Validate an unused division by a non-zero constant is removed.");
+	free_ir_function(function);
+}
+
+/* ------ */
+/* runner */
+/* ------ */
+
+int main()
+{
+	setlocale(LC_ALL, "");
+	wprintf(L"%lc %lc %lc\tir tests running\n", (wchar_t)187, (wchar_t)187, (wchar_t)187);
+	buildir_shouldreadnewvariable_withredeclaredvariable();
+	buildir_shouldreadassignedvalue_withassignment();
+	computeirdominators_shouldfindbranch_withdiamond();
+	optimizeir_shouldremovetrivialphi_withsameoperands();
+	optimizeir_shouldremovetrivialphi_withselfreference();
+	optimizeir_shouldkeepsignedzerosapart_withcommonsubexpressions();
+	optimizeir_shouldkeepdeaddivision_withnonconstantdivisor();
+	wprintf(L"%lc %lc %lc\tir tests passed\n", (wchar_t)164, (wchar_t)164, (wchar_t)164);
+}
\ No newline at end of file
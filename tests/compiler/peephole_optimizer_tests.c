@@ -0,0 +1,177 @@
+#include "../../src/compiler/optimizer/peephole_optimizer.h"
+#include <assert.h>
+#include <locale.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <wchar.h>
+
+/* --------- */
+/* utilities */
+/* --------- */
+
+#define LOAD_NUMBER(number) ((instruction){OP_LOAD_CONST, {.d = number}, OP_TYPE_NUMBER})
+#define LOAD_BIT(bit) ((instruction){OP_LOAD_CONST, {.b = bit}, OP_TYPE_BIT})
+#define LOAD_VAR(index) ((instruction){OP_LOAD_VAR, {.variable = {index}}, OP_TYPE_VARIABLE})
+#define STORE_VAR(index) ((instruction){OP_STORE_VAR, {.variable = {index}}, OP_TYPE_VARIABLE})
+#define JUMP(op_code, offset) ((instruction){op_code, {.jump = {offset}}, OP_TYPE_NULL})
+#define OPERATION(op_code) ((instruction){op_code, {0}, OP_TYPE_NULL})
+
+static optimization_statistics statistics;
+
+/// @brief Optimizes a program of `count` instructions that uses one variable.
+bytecode_generator* optimize_program(const instruction* instructions, int count)
+{
+	bytecode_generator* generator = create_bytecode_generator();
+	for (int i = 0; i < count; i++)
+	{
+		emit_instruction(generator, instructions[i]);
+	}
+	generator->variable_count = 1;
+
+	create_optimization_statistics(&statistics);
+	optimize_peephole(generator, &statistics);
+	return generator;
+}
+
+/// @brief Determines if the instructions of the `generator` have exactly the `expected` op codes.
+bool has_op_codes(const bytecode_generator* generator, const op_code* expected, int count)
+{
+	if (generator->instruction_count != count)
+	{
+		return false;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		if (generator->instructions[i].op_code != expected[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* ----- */
+/* tests */
+/* ----- */
+
+void optimizepeephole_shouldrewritetodup_withstorethenload()
+{
+	instruction program[] = { LOAD_NUMBER(1), STORE_VAR(0), LOAD_VAR(0), OPERATION(OP_PRINT), OPERATION(OP_HALT) };
+	bytecode_generator* generator = optimize_program(program, 5);
+
+	op_code expected[] = { OP_LOAD_CONST, OP_DUP, OP_STORE_VAR, OP_PRINT, OP_HALT };
+	assert(has_op_codes(generator, expected, 5) == true && "Validate a store followed by a load of the same variable becomes a dup and a store.");
+	assert(statistics.peephole_rule_hits[PEEPHOLE_STORE_LOAD_TO_DUP] == 1 && "Validate the store-load rule is counted.");
+	free_bytecode_generator(generator);
+}
+
+void optimizepeephole_shouldremove_withloadthenstoresamevariable()
+{
+	instruction program[] = { LOAD_VAR(0), STORE_VAR(0), OPERATION(OP_HALT) };
+	bytecode_generator* generator = optimize_program(program, 3);
+
+	op_code expected[] = { OP_HALT };
+	assert(has_op_codes(generator, expected, 1) == true && "Validate storing a variable into itself is removed.");
+	assert(statistics.peephole_rule_hits[PEEPHOLE_LOAD_STORE_SAME_VARIABLE] == 1 && "Validate the load-store rule is counted.");
+	free_bytecode_generator(generator);
+}
+
+void optimizepeephole_shouldremove_withloadconstthenpop()
+{
+	instruction program[] = { LOAD_NUMBER(1), OPERATION(OP_POP), OPERATION(OP_HALT) };
+	bytecode_generator* generator = optimize_program(program, 3);
+
+	op_code expected[] = { OP_HALT };
+	assert(has_op_codes(generator, expected, 1) == true && "Validate a constant that is only popped is removed.");
+	assert(statistics.peephole_rule_hits[PEEPHOLE_LOAD_CONST_POP] == 1 && "Validate the constant-pop rule is counted.");
+	free_bytecode_generator(generator);
+}
+
+void optimizepeephole_shouldremove_withloadvarthenpop()
+{
+	instruction program[] = { LOAD_VAR(0), OPERATION(OP_POP), OPERATION(OP_HALT) };
+	bytecode_generator* generator = optimize_program(program, 3);
+
+	op_code expected[] = { OP_HALT };
+	assert(has_op_codes(generator, expected, 1) == true && "Validate a variable that is only popped is removed.");
+	assert(statistics.peephole_rule_hits[PEEPHOLE_LOAD_VAR_POP] == 1 && "Validate the variable-pop rule is counted.");
+	free_bytecode_generator(generator);
+}
+
+void optimizepeephole_shouldremove_withdupthenpop()
+{
+	instruction program[] = { LOAD_NUMBER(1), OPERATION(OP_DUP), OPERATION(OP_POP), OPERATION(OP_PRINT), OPERATION(OP_HALT) };
+	bytecode_generator* generator = optimize_program(program, 5);
+
+	op_code expected[] = { OP_LOAD_CONST, OP_PRINT, OP_HALT };
+	assert(has_op_codes(generator, expected, 3) == true && "Validate a dup that is only popped is removed.");
+	assert(statistics.peephole_rule_hits[PEEPHOLE_DUP_POP] == 1 && "Validate the dup-pop rule is counted.");
+	free_bytecode_generator(generator);
+}
+
+void optimizepeephole_shouldremove_withjumptonext()
+{
+	instruction program[] = { JUMP(OP_JMP, 0), OPERATION(OP_HALT) };
+	bytecode_generator* generator = optimize_program(program, 2);
+
+	op_code expected[] = { OP_HALT };
+	assert(has_op_codes(generator, expected, 1) == true && "Validate a jump to the next instruction is removed.");
+	assert(statistics.peephole_rule_hits[PEEPHOLE_JUMP_TO_NEXT] == 1 && "Validate the jump-to-next rule is counted.");
+	free_bytecode_generator(generator);
+}
+
+void optimizepeephole_shouldpopcondition_withconditionaljumptonext()
+{
+	instruction program[] = { LOAD_BIT(0), JUMP(OP_JMP_IF_FALSE, 0), OPERATION(OP_HALT) };
+	bytecode_generator* generator = optimize_program(program, 3);
+
+	/* the condition is popped instead, and then the constant-pop rule removes both */
+	op_code expected[] = { OP_HALT };
+	assert(has_op_codes(generator, expected, 1) == true && "Validate a conditional jump to the next instruction only pops its condition.");
+	assert(statistics.peephole_rule_hits[PEEPHOLE_CONDITIONAL_JUMP_TO_NEXT] == 1 && "Validate the conditional-jump-to-next rule is counted.");
+	assert(statistics.peephole_rule_hits[PEEPHOLE_LOAD_CONST_POP] == 1 && "Validate the popped condition is removed in a later pass.");
+	free_bytecode_generator(generator);
+}
+
+void optimizepeephole_shouldthreadjump_withjumptojump()
+{
+	instruction program[] = { JUMP(OP_JMP, 1), OPERATION(OP_HALT), JUMP(OP_JMP, 1), OPERATION(OP_HALT), OPERATION(OP_HALT) };
+	bytecode_generator* generator = optimize_program(program, 5);
+
+	assert(generator->instruction_count == 5 && "Validate threading a jump removes no instruction.");
+	assert(get_jump_target(generator->instructions, 0) == 4 && "Validate a jump to a jump goes straight to the final target.");
+	assert(statistics.peephole_rule_hits[PEEPHOLE_JUMP_THREADING] == 1 && "Validate the jump threading rule is counted.");
+	free_bytecode_generator(generator);
+}
+
+void optimizepeephole_shouldkeepwindow_withjumpintowindow()
+{
+	/* the load is jumped to, so it can't become part of a dup that only the store before it reaches */
+	instruction program[] = { LOAD_NUMBER(1), STORE_VAR(0), LOAD_VAR(0), JUMP(OP_JMP, -2), OPERATION(OP_HALT) };
+	bytecode_generator* generator = optimize_program(program, 5);
+
+	op_code expected[] = { OP_LOAD_CONST, OP_STORE_VAR, OP_LOAD_VAR, OP_JMP, OP_HALT };
+	assert(has_op_codes(generator, expected, 5) == true && "Validate a window that a jump lands inside is left alone.");
+	free_bytecode_generator(generator);
+}
+
+/* ------ */
+/* runner */
+/* ------ */
+
+int main()
+{
+	setlocale(LC_ALL, "");
+	wprintf(L"%lc %lc %lc\tpeephole optimizer tests running\n", (wchar_t)187, (wchar_t)187, (wchar_t)187);
+	optimizepeephole_shouldrewritetodup_withstorethenload();
+	optimizepeephole_shouldremove_withloadthenstoresamevariable();
+	optimizepeephole_shouldremove_withloadconstthenpop();
+	optimizepeephole_shouldremove_withloadvarthenpop();
+	optimizepeephole_shouldremove_withdupthenpop();
+	optimizepeephole_shouldremove_withjumptonext();
+	optimizepeephole_shouldpopcondition_withconditionaljumptonext();
+	optimizepeephole_shouldthreadjump_withjumptojump();
+	optimizepeephole_shouldkeepwindow_withjumpintowindow();
+	wprintf(L"%lc %lc %lc\tpeephole optimizer tests passed\n", (wchar_t)164, (wchar_t)164, (wchar_t)164);
+}
\ No newline at end of file
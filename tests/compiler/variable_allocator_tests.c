@@ -0,0 +1,124 @@
+#include "../../src/compiler/optimizer/variable_allocator.h"
+#include <assert.h>
+#include <locale.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <wchar.h>
+
+/* --------- */
+/* utilities */
+/* --------- */
+
+#define LOAD_NUMBER(number) ((instruction){OP_LOAD_CONST, {.d = number}, OP_TYPE_NUMBER})
+#define LOAD_VAR(index) ((instruction){OP_LOAD_VAR, {.variable = {index}}, OP_TYPE_VARIABLE})
+#define STORE_VAR(index) ((instruction){OP_STORE_VAR, {.variable = {index}}, OP_TYPE_VARIABLE})
+#define JUMP(offset) ((instruction){OP_JMP, {.jump = {offset}}, OP_TYPE_NULL})
+#define OPERATION(op_code) ((instruction){op_code, {0}, OP_TYPE_NULL})
+
+static optimization_statistics statistics;
+
+/// @brief Creates a program of `count` instructions that uses `variable_count` variables.
+bytecode_generator* create_program(const instruction* instructions, int count, int variable_count)
+{
+	bytecode_generator* generator = create_bytecode_generator();
+	for (int i = 0; i < count; i++)
+	{
+		emit_instruction(generator, instructions[i]);
+	}
+	generator->variable_count = variable_count;
+	create_optimization_statistics(&statistics);
+
+	return generator;
+}
+
+int get_slot(const bytecode_generator* generator, int index)
+{
+	return generator->instructions[index].operand.variable.variable_index;
+}
+
+/* ----- */
+/* tests */
+/* ----- */
+
+void getliveintervals_shouldspanfirsttolastuse_withstraightlinecode()
+{
+	instruction program[] = { LOAD_NUMBER(1), STORE_VAR(0), LOAD_NUMBER(2), STORE_VAR(1), LOAD_VAR(0), OPERATION(OP_PRINT), LOAD_VAR(1), OPERATION(OP_PRINT), OPERATION(OP_HALT) };
+	bytecode_generator* generator = create_program(program, 9, 2);
+
+	int interval_count = 0;
+	live_interval* intervals = get_live_intervals(generator, &interval_count);
+	assert(interval_count == 2 && "Validate get_live_intervals finds an interval for every variable.");
+	assert(intervals[0].variable_index == 0 && intervals[0].start == 1 && intervals[0].end == 4 && "Validate the first variable lives from its store to its load.");
+	assert(intervals[1].variable_index == 1 && intervals[1].start == 3 && intervals[1].end == 6 && "Validate the second variable lives from its store to its load.");
+
+	safe_free(intervals);
+	free_bytecode_generator(generator);
+}
+
+void allocatevariableslots_shouldreuseslot_withvariablenolongerlive()
+{
+	instruction program[] = { LOAD_NUMBER(1), STORE_VAR(0), LOAD_VAR(0), OPERATION(OP_PRINT), LOAD_NUMBER(2), STORE_VAR(1), LOAD_VAR(1), OPERATION(OP_PRINT), OPERATION(OP_HALT) };
+	bytecode_generator* generator = create_program(program, 9, 2);
+
+	int slot_count = allocate_variable_slots(generator, &statistics);
+	assert(slot_count == 1 && generator->variable_count == 1 && "Validate a variable declared after the last use of another takes over its slot.");
+	assert(get_slot(generator, 1) == get_slot(generator, 5) && "Validate both variables are stored in the same slot.");
+	assert(statistics.variables_before == 2 && statistics.variable_slots_after == 1 && "Validate the slot reuse is counted.");
+	free_bytecode_generator(generator);
+}
+
+void allocatevariableslots_shouldkeepslotsapart_withoverlappingvariables()
+{
+	instruction program[] = { LOAD_NUMBER(1), STORE_VAR(0), LOAD_NUMBER(2), STORE_VAR(1), LOAD_VAR(1), OPERATION(OP_PRINT), LOAD_VAR(0), OPERATION(OP_PRINT), OPERATION(OP_HALT) };
+	bytecode_generator* generator = create_program(program, 9, 2);
+
+	int slot_count = allocate_variable_slots(generator, &statistics);
+	assert(slot_count == 2 && "Validate variables that are live at the same time need a slot each.");
+	assert(get_slot(generator, 1) != get_slot(generator, 3) && "Validate variables that are live at the same time get different slots.");
+	assert(get_slot(generator, 1) == get_slot(generator, 6) && get_slot(generator, 3) == get_slot(generator, 4) && "Validate every load reads the slot its variable was stored in.");
+	free_bytecode_generator(generator);
+}
+
+void allocatevariableslots_shouldkeepslotsapart_withvariablelivearoundloop()
+{
+	/* the first variable is loaded at the top of a loop, so the second one can't take its slot inside the loop */
+	instruction program[] = { LOAD_NUMBER(1), STORE_VAR(0), LOAD_VAR(0), OPERATION(OP_PRINT), LOAD_NUMBER(2), STORE_VAR(1), LOAD_VAR(1), OPERATION(OP_PRINT), JUMP(-7), OPERATION(OP_HALT) };
+	bytecode_generator* generator = create_program(program, 10, 2);
+
+	int slot_count = allocate_variable_slots(generator, &statistics);
+	assert(slot_count == 2 && "Validate a variable that is live around a loop keeps its slot for the whole loop.");
+	assert(get_slot(generator, 2) != get_slot(generator, 5) && "Validate a variable inside the loop doesn't overwrite one that is loaded again.");
+	free_bytecode_generator(generator);
+}
+
+void allocatevariableslots_shouldkeepslotsapart_withvariableloadedbeforestore()
+{
+	/* the second variable is read before anything is stored in it, so it has to read null instead of the first variable's value */
+	instruction program[] = { LOAD_NUMBER(1), STORE_VAR(0), LOAD_VAR(0), OPERATION(OP_PRINT), LOAD_VAR(1), STORE_VAR(1), LOAD_VAR(1), OPERATION(OP_PRINT), OPERATION(OP_HALT) };
+	bytecode_generator* generator = create_program(program, 9, 2);
+
+	int interval_count = 0;
+	live_interval* intervals = get_live_intervals(generator, &interval_count);
+	assert(intervals[0].variable_index == 1 && intervals[0].start == 0 && "Validate a variable loaded before it is stored lives from the start of the program.");
+	safe_free(intervals);
+
+	int slot_count = allocate_variable_slots(generator, &statistics);
+	assert(slot_count == 2 && get_slot(generator, 1) != get_slot(generator, 4) && "Validate a variable loaded before it is stored doesn't take over a released slot.");
+	free_bytecode_generator(generator);
+}
+
+/* ------ */
+/* runner */
+/* ------ */
+
+int main()
+{
+	setlocale(LC_ALL, "");
+	wprintf(L"%lc %lc %lc\tvariable allocator tests running\n", (wchar_t)187, (wchar_t)187, (wchar_t)187);
+	getliveintervals_shouldspanfirsttolastuse_withstraightlinecode();
+	allocatevariableslots_shouldreuseslot_withvariablenolongerlive();
+	allocatevariableslots_shouldkeepslotsapart_withoverlappingvariables();
+	allocatevariableslots_shouldkeepslotsapart_withvariablelivearoundloop();
+	allocatevariableslots_shouldkeepslotsapart_withvariableloadedbeforestore();
+	wprintf(L"%lc %lc %lc\tvariable allocator tests passed\n", (wchar_t)164, (wchar_t)164, (wchar_t)164);
+}
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include "../../src/core/types/bytecode_file.h"
+#include <assert.h>
+#include <locale.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <wchar.h>
+
+/* --------- */
+/* utilities */
+/* --------- */
+
+static const char code[] = "instruction records of the program";
+static const char strings[] = "first\0second";
+
+/// @brief Packs a container with a code and a strings section.
+unsigned char* pack_test_container(size_t* size)
+{
+	bytecode_section sections[] =
+	{
+		{ BYTECODE_SECTION_CODE, 0, 0, sizeof(code), 1, 0, code },
+		{ BYTECODE_SECTION_STRINGS, 0, 0, sizeof(strings), 2, 0, strings },
+	};
+
+	return pack_bytecode_container(7, sections, 2, size);
+}
+
+/* ----- */
+/* tests */
+/* ----- */
+
+void getcrc32c_shouldmatch_withknownvectors()
+{
+	unsigned char zeros[32] = { 0 };
+	unsigned char ones[32];
+	unsigned char ascending[32];
+	for (int i = 0; i < 32; i++)
+	{
+		ones[i] = 0xFF;
+		ascending[i] = (unsigned char)i;
+	}
+
+	/* the check value of CRC-32C, and the test vectors of RFC 3720 */
+	assert(get_crc32c("123456789", 9) == 0xE3069283 && "Validate get_crc32c matches the CRC-32C check value.");
+	assert(get_crc32c(zeros, sizeof(zeros)) == 0x8A9136AA && "Validate get_crc32c matches the RFC 3720 vector of 32 zero bytes.");
+	assert(get_crc32c(ones, sizeof(ones)) == 0x62A8AB43 && "Validate get_crc32c matches the RFC 3720 vector of 32 0xFF bytes.");
+	assert(get_crc32c(ascending, sizeof(ascending)) == 0x46DD794E && "Validate get_crc32c matches the RFC 3720 vector of 32 ascending bytes.");
+	assert(get_crc32c(NULL, 0) == 0 && "Validate get_crc32c of no bytes is zero.");
+}
+
+void updatecrc32c_shouldmatchwholechecksum_withpieces()
+{
+	const char* text = "checksummed in pieces of different sizes, across word boundaries";
+	size_t length = strlen(text);
+	for (size_t split = 0; split <= length; split++)
+	{
+		uint32_t checksum = update_crc32c(update_crc32c(0, text, split), text + split, length - split);
+		assert(checksum == get_crc32c(text, length) && "Validate update_crc32c over two pieces matches the checksum of the whole.");
+	}
+}
+
+void readbytecodecontainer_shouldroundtrip_withpackedcontainer()
+{
+	size_t size;
+	unsigned char* file = pack_test_container(&size);
+	assert(size % BYTECODE_ALIGNMENT == 0 && "Validate a packed container ends aligned.");
+
+	bytecode_container container;
+	assert(read_bytecode_container(file, size, &container) == BYTECODE_FILE_VALID && "Validate a packed container reads back.");
+	assert(container.variable_count == 7 && container.section_count == 2 && "Validate the header reads back.");
+	assert(container.version_major == BYTECODE_VERSION_MAJOR && container.version_minor == BYTECODE_VERSION_MINOR && "Validate the version reads back.");
+
+	const bytecode_section* strings_section = find_bytecode_section(&container, BYTECODE_SECTION_STRINGS);
+	assert(strings_section != NULL && strings_section->count == 2 && "Validate a section is found by its kind.");
+	assert(strings_section->offset % BYTECODE_ALIGNMENT == 0 && "Validate every section is aligned.");
+	assert(find_bytecode_section(&container, BYTECODE_SECTION_DEBUG) == NULL && "Validate a missing section isn't found.");
+
+	unsigned char* allocation;
+	size_t section_size;
+	const unsigned char* contents = load_bytecode_section(&container, strings_section, SIZE_MAX, &allocation, &section_size);
+	assert(contents != NULL && allocation == NULL && "Validate an uncompressed section is used in place.");
+	assert(section_size == sizeof(strings) && memcmp(contents, strings, sizeof(strings)) == 0 && "Validate the contents of a section read back.");
+
+	safe_free(file);
+}
+
+void loadbytecodesection_shoulddecompress_withcompressedsection()
+{
+	char text[4096];
+	for (size_t i = 0; i < sizeof(text); i++)
+	{
+		text[i] = "repetitive text "[i % 16];
+	}
+	bytecode_section sections[] = { { BYTECODE_SECTION_STRINGS, BYTECODE_SECTION_COMPRESSED, 0, sizeof(text), 1, 0, text } };
+	size_t size;
+	unsigned char* file = pack_bytecode_container(0, sections, 1, &size);
+
+	bytecode_container container;
+	assert(read_bytecode_container(file, size, &container) == BYTECODE_FILE_VALID && "Validate a container with a compressed section reads back.");
+	assert((container.sections[0].flags & BYTECODE_SECTION_COMPRESSED) != 0 && container.sections[0].size < sizeof(text) && "Validate a section that compresses is stored compressed.");
+
+	unsigned char* allocation;
+	size_t section_size;
+	const unsigned char* contents = load_bytecode_section(&container, &container.sections[0], SIZE_MAX, &allocation, &section_size);
+	assert(contents != NULL && allocation != NULL && "Validate a compressed section is decompressed into an allocation.");
+	assert(section_size == sizeof(text) && memcmp(contents, text, sizeof(text)) == 0 && "Validate a compressed section decompresses to its contents.");
+	safe_free(allocation);
+
+	contents = load_bytecode_section(&container, &container.sections[0], sizeof(text) - 1, &allocation, &section_size);
+	assert(contents == NULL && allocation == NULL && "Validate a section that decompresses past the maximum size isn't allocated.");
+	assert(section_size == sizeof(text) && "Validate a section past the maximum size reports the size it needed.");
+
+	safe_free(file);
+}
+
+void readbytecodecontainer_shouldreject_withtruncatedfile()
+{
+	size_t size;
+	unsigned char* file = pack_test_container(&size);
+
+	bytecode_container container;
+	assert(read_bytecode_container(file, size - 1, &container) == BYTECODE_FILE_CORRUPT && "Validate a file missing its last byte is corrupt.");
+	assert(read_bytecode_container(file, BYTECODE_HEADER_SIZE + 1, &container) == BYTECODE_FILE_CORRUPT && "Validate a file cut off in its section table is corrupt.");
+	assert(read_bytecode_container(file, BYTECODE_HEADER_SIZE - 1, &container) == BYTECODE_FILE_NOT_BYTECODE && "Validate a file shorter than a header isn't bytecode.");
+
+	safe_free(file);
+}
+
+void readbytecodecontainer_shouldreject_withcorruptheader()
+{
+	size_t size;
+	unsigned char* file = pack_test_container(&size);
+	bytecode_container container;
+
+	/* a damaged variable count is caught by the header checksum */
+	file[20] ^= 0x01;
+	assert(read_bytecode_container(file, size, &container) == BYTECODE_FILE_CORRUPT && "Validate a damaged header is corrupt.");
+	file[20] ^= 0x01;
+
+	/* so is a section that is moved outside of the file */
+	unsigned char* offset = file + BYTECODE_HEADER_SIZE + 8;
+	offset[1] ^= 0x10;
+	assert(read_bytecode_container(file, size, &container) == BYTECODE_FILE_CORRUPT && "Validate a damaged section table is corrupt.");
+	offset[1] ^= 0x10;
+
+	file[0] = 'X';
+	assert(read_bytecode_container(file, size, &container) == BYTECODE_FILE_NOT_BYTECODE && "Validate a file without the magic number isn't bytecode.");
+	file[0] = BYTECODE_MAGIC[0];
+
+	file[4] = BYTECODE_VERSION_MAJOR + 1;
+	assert(read_bytecode_container(file, size, &container) == BYTECODE_FILE_UNSUPPORTED_VERSION && "Validate a newer major version is unsupported.");
+	file[4] = BYTECODE_VERSION_MAJOR;
+
+	assert(read_bytecode_container(file, size, &container) == BYTECODE_FILE_VALID && "Validate the file reads again once it is restored.");
+	safe_free(file);
+}
+
+void readbytecodecontainer_shouldreject_withunknownsectionflag()
+{
+	size_t size;
+	unsigned char* file = pack_test_container(&size);
+	bytecode_container container;
+
+	/* a flag from a newer writer, with the header checksum fixed up so only the flag is wrong */
+	write_u32(file + BYTECODE_HEADER_SIZE + 4, 0x80);
+	write_u32(file + 8, 0);
+	unsigned char header[BYTECODE_HEADER_SIZE + 2 * BYTECODE_SECTION_ENTRY_SIZE];
+	memcpy(header, file, sizeof(header));
+	write_u32(file + 8, get_crc32c(header, sizeof(header)));
+	assert(read_bytecode_container(file, size, &container) == BYTECODE_FILE_UNSUPPORTED_VERSION && "Validate a section with an unknown flag is unsupported.");
+
+	safe_free(file);
+}
+
+void loadbytecodesection_shouldreject_withcorruptsection()
+{
+	size_t size;
+	unsigned char* file = pack_test_container(&size);
+	bytecode_container container;
+	assert(read_bytecode_container(file, size, &container) == BYTECODE_FILE_VALID && "Validate the container reads before it is damaged.");
+
+	/* sections are only verified when they are used, so the container still reads */
+	const bytecode_section* code_section = find_bytecode_section(&container, BYTECODE_SECTION_CODE);
+	file[code_section->offset + 3] ^= 0x20;
+	assert(read_bytecode_container(file, size, &container) == BYTECODE_FILE_VALID && "Validate a damaged section doesn't fail the header.");
+	assert(verify_bytecode_section(&container, code_section) == false && "Validate a damaged section fails its checksum.");
+
+	unsigned char* allocation;
+	size_t section_size;
+	assert(load_bytecode_section(&container, code_section, SIZE_MAX, &allocation, &section_size) == NULL && allocation == NULL && "Validate a damaged section isn't loaded.");
+
+	safe_free(file);
+}
+
+/* ------ */
+/* runner */
+/* ------ */
+
+int main()
+{
+	setlocale(LC_ALL, "");
+	wprintf(L"%lc %lc %lc\tbytecode file tests running\n", (wchar_t)187, (wchar_t)187, (wchar_t)187);
+	getcrc32c_shouldmatch_withknownvectors();
+	updatecrc32c_shouldmatchwholechecksum_withpieces();
+	readbytecodecontainer_shouldroundtrip_withpackedcontainer();
+	loadbytecodesection_shoulddecompress_withcompressedsection();
+	readbytecodecontainer_shouldreject_withtruncatedfile();
+	readbytecodecontainer_shouldreject_withcorruptheader();
+	readbytecodecontainer_shouldreject_withunknownsectionflag();
+	loadbytecodesection_shouldreject_withcorruptsection();
+	wprintf(L"%lc %lc %lc\tbytecode file tests passed\n", (wchar_t)164, (wchar_t)164, (wchar_t)164);
+}
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "../../src/core/extensions/compression_extensions.h"
+#include <assert.h>
+#include <locale.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <wchar.h>
+
+/* --------- */
+/* utilities */
+/* --------- */
+
+/// @brief Fills `size` bytes with a repeating phrase, which compresses well.
+void fill_repetitive(unsigned char* bytes, size_t size)
+{
+	const char* phrase = "grab module; log info(value); ";
+	size_t length = strlen(phrase);
+	for (size_t i = 0; i < size; i++)
+	{
+		bytes[i] = (unsigned char)phrase[i % length];
+	}
+}
+
+/// @brief Fills `size` bytes from a linear congruential generator, which doesn't compress at all.
+void fill_random(unsigned char* bytes, size_t size)
+{
+	uint32_t state = 2463534242u;
+	for (size_t i = 0; i < size; i++)
+	{
+		state = state * 1664525u + 1013904223u;
+		bytes[i] = (unsigned char)(state >> 24);
+	}
+}
+
+/// @brief Compresses `size` bytes and decompresses them again.
+/// @return The amount of compressed bytes.
+size_t round_trip(const unsigned char* bytes, size_t size)
+{
+	size_t capacity = get_maximum_compressed_size(size);
+	unsigned char* compressed = (unsigned char*)safe_malloc(capacity);
+	unsigned char* decompressed = (unsigned char*)safe_malloc(size + 1);
+
+	size_t compressed_size = compress_lz(bytes, size, compressed, capacity);
+	assert(compressed_size > 0 && compressed_size <= capacity && "Validate compress_lz always fits in the maximum compressed size.");
+	assert(decompress_lz(compressed, compressed_size, decompressed, size) == true && "Validate decompress_lz accepts what compress_lz wrote.");
+	assert(memcmp(decompressed, bytes, size) == 0 && "Validate decompress_lz restores the original bytes.");
+
+	safe_free(decompressed);
+	safe_free(compressed);
+	return compressed_size;
+}
+
+/* ----- */
+/* tests */
+/* ----- */
+
+void compresslz_shouldroundtrip_withrepetitivedata()
+{
+	unsigned char bytes[100000];
+	fill_repetitive(bytes, sizeof(bytes));
+
+	size_t compressed_size = round_trip(bytes, sizeof(bytes));
+	assert(compressed_size < sizeof(bytes) / 20 && "Validate repetitive data compresses to a fraction of its size.");
+}
+
+void compresslz_shouldroundtrip_withrandomdata()
+{
+	unsigned char bytes[100000];
+	fill_random(bytes, sizeof(bytes));
+
+	size_t compressed_size = round_trip(bytes, sizeof(bytes));
+	assert(compressed_size > sizeof(bytes) && "Validate data that doesn't compress grows only by its literal lengths.");
+}
+
+void compresslz_shouldroundtrip_withshortdata()
+{
+	unsigned char bytes[32];
+	fill_repetitive(bytes, sizeof(bytes));
+
+	/* every size around the end margin, where no match is searched for */
+	for (size_t size = 0; size <= sizeof(bytes); size++)
+	{
+		round_trip(bytes, size);
+	}
+}
+
+void compresslz_shouldfail_withsmalldestination()
+{
+	unsigned char bytes[1000];
+	unsigned char compressed[100];
+	fill_random(bytes, sizeof(bytes));
+
+	assert(compress_lz(bytes, sizeof(bytes), compressed, sizeof(compressed)) == 0 && "Validate compress_lz reports data that doesn't fit in the destination.");
+}
+
+void decompresslz_shouldfail_withwrongsize()
+{
+	unsigned char bytes[4096];
+	unsigned char compressed[4096];
+	unsigned char decompressed[4097];
+	fill_repetitive(bytes, sizeof(bytes));
+	size_t compressed_size = compress_lz(bytes, sizeof(bytes), compressed, sizeof(compressed));
+
+	assert(decompress_lz(compressed, compressed_size, decompressed, sizeof(bytes) - 1) == false && "Validate decompress_lz rejects data longer than the destination.");
+	assert(decompress_lz(compressed, compressed_size, decompressed, sizeof(bytes) + 1) == false && "Validate decompress_lz rejects data shorter than the decompressed size.");
+}
+
+void decompresslz_shouldfail_withtruncatedinput()
+{
+	unsigned char bytes[4096];
+	unsigned char compressed[4096];
+	unsigned char decompressed[4096];
+	fill_repetitive(bytes, sizeof(bytes));
+	size_t compressed_size = compress_lz(bytes, sizeof(bytes), compressed, sizeof(compressed));
+
+	for (size_t size = 0; size < compressed_size; size++)
+	{
+		assert(decompress_lz(compressed, size, decompressed, sizeof(bytes)) == false && "Validate decompress_lz rejects every truncation of its input.");
+	}
+}
+
+void decompresslz_shouldfail_withoffsetbeforestart()
+{
+	/* one literal, then a match that reaches two bytes back */
+	unsigned char compressed[] = { 0x10, 'a', 0x02, 0x00 };
+	unsigned char decompressed[16];
+
+	assert(decompress_lz(compressed, sizeof(compressed), decompressed, 1 + LZ_MINIMUM_MATCH) == false && "Validate decompress_lz rejects a match before the start of the output.");
+}
+
+/* ------ */
+/* runner */
+/* ------ */
+
+int main()
+{
+	setlocale(LC_ALL, "");
+	wprintf(L"%lc %lc %lc\tcompression extensions tests running\n", (wchar_t)187, (wchar_t)187, (wchar_t)187);
+	compresslz_shouldroundtrip_withrepetitivedata();
+	compresslz_shouldroundtrip_withrandomdata();
+	compresslz_shouldroundtrip_withshortdata();
+	compresslz_shouldfail_withsmalldestination();
+	decompresslz_shouldfail_withwrongsize();
+	decompresslz_shouldfail_withtruncatedinput();
+	decompresslz_shouldfail_withoffsetbeforestart();
+	wprintf(L"%lc %lc %lc\tcompression extensions tests passed\n", (wchar_t)164, (wchar_t)164, (wchar_t)164);
+}
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "../../src/core/types/line_table.h"
+#include <assert.h>
+#include <locale.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <wchar.h>
+
+/* --------- */
+/* utilities */
+/* --------- */
+
+/// @brief Decodes a hand-written table of one file named "a", whose rows follow its file table.
+bool decode_rows(const unsigned char* rows, size_t rows_size, uint32_t row_count)
+{
+	unsigned char data[64] = { 1, 'a', '\0' };
+	memcpy(data + 3, rows, rows_size);
+
+	line_table table;
+	bool is_decoded = decode_line_table(data, 3 + rows_size, row_count, SIZE_MAX, &table);
+	free_line_table(&table);
+	return is_decoded;
+}
+
+/* ----- */
+/* tests */
+/* ----- */
+
+void decodelinetable_shouldroundtrip_withencodedtable()
+{
+	/* two chunks linked together, and an instruction whose place isn't known */
+	const char* files[] = { "main.ls", "leaf.ls" };
+	source_location locations[] = { { 0, 1, 1 }, { 0, 1, 1 }, { 0, 2, 5 }, { 1, 300, 2 }, { 1, 0, 0 }, { 0, 2, 1 } };
+	uint32_t row_count;
+	size_t size;
+	unsigned char* data = encode_line_table(locations, 6, files, 2, &row_count, &size);
+	assert(row_count == 5 && "Validate instructions from the same place share a row.");
+
+	line_table table;
+	assert(decode_line_table(data, size, row_count, SIZE_MAX, &table) == true && "Validate an encoded line table decodes.");
+	assert(table.file_count == 2 && strcmp(table.files[0], "main.ls") == 0 && strcmp(table.files[1], "leaf.ls") == 0 && "Validate the files decode.");
+	for (int i = 0; i < 6; i++)
+	{
+		source_location location;
+		bool is_found = find_source_location(&table, i, &location);
+		if (locations[i].line == 0)
+		{
+			assert(is_found == false && "Validate an instruction whose place isn't known isn't found.");
+			continue;
+		}
+		assert(is_found == true && location.file == locations[i].file && location.line == locations[i].line && location.column == locations[i].column && "Validate every instruction decodes to the place it was compiled from.");
+	}
+
+	free_line_table(&table);
+	safe_free(data);
+}
+
+void decodelinetable_shouldreject_withtruncatedtable()
+{
+	const char* files[] = { "main.ls" };
+	source_location locations[] = { { 0, 1, 1 }, { 0, 200, 70 }, { 0, 100000, 3 } };
+	uint32_t row_count;
+	size_t size;
+	unsigned char* data = encode_line_table(locations, 3, files, 1, &row_count, &size);
+
+	line_table table;
+	for (size_t truncated_size = 0; truncated_size < size; truncated_size++)
+	{
+		assert(decode_line_table(data, truncated_size, row_count, SIZE_MAX, &table) == false && "Validate every truncation of a line table is corrupt.");
+	}
+	assert(decode_line_table(data, size, row_count + 1, SIZE_MAX, &table) == false && "Validate a table with fewer rows than its section says is corrupt.");
+
+	safe_free(data);
+}
+
+void decodelinetable_shouldreject_withtablelargerthanmaximumsize()
+{
+	const char* files[] = { "main.ls" };
+	source_location locations[] = { { 0, 1, 1 }, { 0, 2, 1 }, { 0, 3, 1 } };
+	uint32_t row_count;
+	size_t size;
+	unsigned char* data = encode_line_table(locations, 3, files, 1, &row_count, &size);
+
+	line_table table;
+	assert(decode_line_table(data, size, row_count, SIZE_MAX, &table) == true && "Validate the table decodes without a maximum size.");
+	size_t allocated_size = table.allocated_size;
+	free_line_table(&table);
+	assert(allocated_size == sizeof(const char*) + row_count * sizeof(line_table_row) && "Validate the allocated size counts the files and rows.");
+
+	assert(decode_line_table(data, size, row_count, allocated_size, &table) == true && "Validate a table that takes exactly the maximum size decodes.");
+	free_line_table(&table);
+	assert(decode_line_table(data, size, row_count, allocated_size - 1, &table) == false && table.files == NULL && table.rows == NULL && "Validate a table larger than the maximum size isn't allocated.");
+	assert(table.allocated_size == allocated_size && "Validate a table larger than the maximum size reports the size it needed.");
+	assert(decode_line_table(data, size - 1, row_count, SIZE_MAX, &table) == false && table.allocated_size == 0 && "Validate a corrupt table reports no size.");
+
+	safe_free(data);
+}
+
+void decodelinetable_shouldreject_withtruncatedvarint()
+{
+	unsigned char rows[] = { 0x00, 0x02, 0x80 };
+	assert(decode_rows(rows, 2, 0) == false && "Validate bytes after the last row are corrupt.");
+	assert(decode_rows(rows, 3, 1) == false && "Validate a varint whose continuation bit runs past the end is corrupt.");
+
+	unsigned char long_varint[] = { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x02, 0x02 };
+	assert(decode_rows(long_varint, sizeof(long_varint), 1) == false && "Validate a varint longer than a 64-bit number is corrupt.");
+}
+
+void decodelinetable_shouldreject_withfileoutofrange()
+{
+	/* the lowest bit of the distance says a file index follows */
+	unsigned char first_file[] = { 0x01, 0x00, 0x02, 0x02 };
+	unsigned char second_file[] = { 0x01, 0x01, 0x02, 0x02 };
+
+	assert(decode_rows(first_file, sizeof(first_file), 1) == true && "Validate a row in the only file decodes.");
+	assert(decode_rows(second_file, sizeof(second_file), 1) == false && "Validate a row in a file the table doesn't have is corrupt.");
+}
+
+void decodelinetable_shouldreject_withnonincreasingprogramcounter()
+{
+	/* a distance of 1, shifted left once, moves the second row to the next instruction */
+	unsigned char increasing[] = { 0x00, 0x02, 0x02, 0x02, 0x02, 0x02 };
+	unsigned char repeated[] = { 0x00, 0x02, 0x02, 0x00, 0x02, 0x02 };
+
+	assert(decode_rows(increasing, sizeof(increasing), 2) == true && "Validate rows at increasing instructions decode.");
+	assert(decode_rows(repeated, sizeof(repeated), 2) == false && "Validate a row at the same instruction as the one before it is corrupt.");
+}
+
+void decodelinetable_shouldreject_withnegativeline()
+{
+	/* a zigzag of 3 is -2 */
+	unsigned char rows[] = { 0x00, 0x03, 0x02 };
+	assert(decode_rows(rows, sizeof(rows), 1) == false && "Validate a row that moves before the first line is corrupt.");
+}
+
+/* ------ */
+/* runner */
+/* ------ */
+
+int main()
+{
+	setlocale(LC_ALL, "");
+	wprintf(L"%lc %lc %lc\tline table tests running\n", (wchar_t)187, (wchar_t)187, (wchar_t)187);
+	decodelinetable_shouldroundtrip_withencodedtable();
+	decodelinetable_shouldreject_withtruncatedtable();
+	decodelinetable_shouldreject_withtablelargerthanmaximumsize();
+	decodelinetable_shouldreject_withtruncatedvarint();
+	decodelinetable_shouldreject_withfileoutofrange();
+	decodelinetable_shouldreject_withnonincreasingprogramcounter();
+	decodelinetable_shouldreject_withnegativeline();
+	wprintf(L"%lc %lc %lc\tline table tests passed\n", (wchar_t)164, (wchar_t)164, (wchar_t)164);
+}
\ No newline at end of file
@@ -1,58 +1,43 @@
 #include "../../src/core/logger/logger.h"
 #include <assert.h>
 #include <locale.h>
-#include <setjmp.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 #include <wchar.h>
 
 /* --------- */
 /* utilities */
 /* --------- */
 
-jmp_buf test_state;
+static log_record captured_record;
+static char captured_message[1024];
 
-const char* listen_to_output()
+/// @brief Keeps the record it is given instead of encoding it, so nothing is written to stdout.
+static size_t capture_record(const log_record* record, char* buffer, size_t capacity)
 {
-	const char* buffer;
-	if(fscanf(stdout, "%s", buffer) != 1)
-	{
-		puts("fscanf not successful.");
-		return NULL;
-	}
-
-	return buffer;
-}
-
-bool run_log_test(void(*log_function)(const char*,...), const char* message, ...)
-{
-	va_list args;
-	va_start(args, message);
+	captured_record = *record;
+	size_t length = record->length < sizeof(captured_message) - 1 ? record->length : sizeof(captured_message) - 1;
+	memcpy(captured_message, record->message, length);
+	captured_message[length] = '\0';
+	captured_record.message = captured_message;
 
-	log_function(message, args);
-
-	va_end(args);
-	return true;
+	return 0;
 }
 
+static const log_sink capturing_sink = { "capture", true, capture_record };
+
 /* ----- */
 /* tests */
 /* ----- */
 
-void logdebug_shouldthrow_withnullmessage()
-{
-	bool result = run_log_test(log_debug, NULL);
-	assert(result == false && "Validate log_debug does not throw when provided a null message.");
-}
-
 void logdebug_shouldsucceed_withvalidmessage()
 {
 	const char* message = "test message";
-	const char* log_output = listen_to_output();
-	bool result = run_log_test(log_debug, message);
+	log_debug(message);
 
-	assert(result == true && "Validate log_debug does not throw when provided a valid message.");
-	assert(log_output == message && "Validate log_debug output matches provided valid message.");
+	assert(captured_record.level == LOG_LEVEL_DEBUG && "Validate log_debug logs at the debug level.");
+	assert(strcmp(captured_message, message) == 0 && "Validate log_debug output matches provided valid message.");
 }
 
 void logdebug_shouldsucceed_withvariadricmessage()
@@ -60,12 +45,43 @@ void logdebug_shouldsucceed_withvariadricmessage()
 	const char* message = "test message is %s";
 	char expected[1024];
 	sprintf(expected, message, "testable");
-	const char* log_output = listen_to_output();
 
-	bool result = run_log_test(log_debug, message, "testable");
+	log_debug(message, "testable");
+
+	assert(strcmp(captured_message, expected) == 0 && "Validate log_debug output matches provided variadric args message.");
+	assert(captured_record.length == strlen(expected) && "Validate log_debug records the length of the formatted message.");
+}
+
+void logerror_shouldrecordlocation_withvalidmessage()
+{
+	int line = __LINE__ + 1;
+	log_error("located message");
+
+	assert(captured_record.level == LOG_LEVEL_ERROR && "Validate log_error logs at the error level.");
+	assert(strcmp(captured_record.file, __FILE__) == 0 && "Validate log_error records the file that logged the message.");
+	assert(captured_record.line == line && "Validate log_error records the line that logged the message.");
+	assert(captured_record.program_counter == -1 && "Validate log_error records that no L# program logged the message.");
+}
+
+void logmessage_shouldsucceed_withlongmessage()
+{
+	char message[2048];
+	memset(message, 'x', sizeof(message) - 1);
+	message[sizeof(message) - 1] = '\0';
+
+	log_info("%s", message);
+
+	assert(captured_record.length == sizeof(message) - 1 && "Validate log_info formats a message longer than the thread buffer.");
+}
+
+void logwrite_shouldsucceed_withunterminatedmessage()
+{
+	const char message[] = { 'a', 'b', 'c', 'd' };
+	log_write(LOG_LEVEL_WARNING, message, 3);
 
-	assert(result == true && "Validate log_debug does not throw when provided a variadric args message.");
-	assert(log_output == expected && "Validate log_debug output matches provided variadric args message.");
+	assert(captured_record.level == LOG_LEVEL_WARNING && "Validate log_write logs at the given level.");
+	assert(strcmp(captured_message, "abc") == 0 && "Validate log_write only logs the given length of the message.");
+	assert(captured_record.file == NULL && "Validate log_write records that the file is unknown.");
 }
 
 /* ------ */
@@ -74,10 +90,13 @@ void logdebug_shouldsucceed_withvariadricmessage()
 
 int main()
 {
-    setlocale(LC_ALL, "");
+	set_log_sink(&capturing_sink);
+	setlocale(LC_ALL, "");
 	wprintf(L"%lc %lc %lc\tlogger tests running\n", (wchar_t)187, (wchar_t)187, (wchar_t)187);
-	//logdebug_shouldthrow_withnullmessage();
 	logdebug_shouldsucceed_withvalidmessage();
 	logdebug_shouldsucceed_withvariadricmessage();
-	wprintf(L"%lc %lc %lc\tlog debug tests passed\n", (wchar_t)164, (wchar_t)164, (wchar_t)164);
+	logerror_shouldrecordlocation_withvalidmessage();
+	logmessage_shouldsucceed_withlongmessage();
+	logwrite_shouldsucceed_withunterminatedmessage();
+	wprintf(L"%lc %lc %lc\tlogger tests passed\n", (wchar_t)164, (wchar_t)164, (wchar_t)164);
 }
\ No newline at end of file